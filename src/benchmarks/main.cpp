@@ -0,0 +1,1812 @@
+#include "engine/container/Utils.hpp"
+#include "engine/noise/Rand.hpp"
+#include "engine/render/Culler.hpp"
+#include "engine/texture/BlockCompression.hpp"
+#include "engine/texture/MipMap.hpp"
+#include "gfx/DrawArea.hpp"
+#include "gfx/DrawBatch.hpp"
+#include "gfx/DrawItem.hpp"
+#include "gfx/Geometry.hpp"
+#include "gfx/Null/NullLayer.hpp"
+#include "gfx/OpenGL/OpenGLLayer.hpp"
+#include "gfx/RasterTests.hpp"
+#include "gfx/ShadingParameters.hpp"
+#include "platform/MultiThreading.hpp"
+#include "platform/Platform.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <GL/gl.h>
+
+/// <summary>
+/// Prototype of a benchmark function.
+/// It receives a gfxLayer ready to use, and returns the average time in
+/// microseconds of one iteration, or a negative value if the benchmark
+/// could not run.
+/// </summary>
+typedef double (*BenchmarkFunction)(Gfx::IGraphicLayer* gfxLayer);
+
+struct Benchmark
+{
+	const char*			name;
+	BenchmarkFunction	function;
+};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+/// <summary>
+/// Waits for the GPU to be done with all the commands issued so far, so
+/// a measure only includes the work it is meant to.
+/// </summary>
+static void waitForGPU()
+{
+	glFinish();
+}
+
+static double elapsedMicroseconds(const Clock::time_point& start)
+{
+	return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+//
+// Helpers to set up minimal scenes.
+//
+
+static Gfx::ShaderID createFlatColorShader(Gfx::IGraphicLayer* gfxLayer)
+{
+	const char* vertexShaderSource = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main() {
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
+	const char* fragmentShaderSource = R"(
+        #version 330 core
+        out vec4 color;
+        void main() {
+            color = vec4(1.0);
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+
+	Gfx::ShaderID shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shader, shaderStages, ARRAY_LEN(shaderStages));
+	return shader;
+}
+
+static const Gfx::DrawArea benchmarkDrawArea = { Gfx::FrameBufferID::InvalidID, { 0, 0, 64, 64 } };
+
+static Gfx::VertexBufferID createTriangle(Gfx::IGraphicLayer* gfxLayer)
+{
+	// Static, as the layer keeps a pointer to the attributes when VAOs
+	// are disabled.
+	static const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = {
+		-0.1f, -0.1f, 0.f,
+		 0.1f, -0.1f, 0.f,
+		 0.f,   0.1f, 0.f,
+	};
+	const unsigned short indices[] = { 0, 1, 2 };
+
+	Gfx::VertexBufferID vertexBuffer = gfxLayer->CreateVertexBuffer();
+	gfxLayer->LoadVertexBuffer(vertexBuffer, Gfx::PrimitiveType::Triangles,
+							   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+							   sizeof(vertices), vertices,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+	return vertexBuffer;
+}
+
+//
+// Benchmarks.
+//
+
+/// <summary>
+/// Cost of switching between two meshes with different vertex layouts
+/// at every draw call.
+/// </summary>
+double AlternatingMeshesBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	const int numberOfDraws = 20000;
+
+	// Two tiny triangles: one with positions only, one with positions
+	// and normals, so each switch changes the vertex layout.
+	const Gfx::VertexAttribute positionOnly[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float positionOnlyData[] = {
+		-0.1f, -0.1f, 0.f,
+		 0.1f, -0.1f, 0.f,
+		 0.f,   0.1f, 0.f,
+	};
+	const Gfx::VertexAttribute positionAndNormal[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+		{ "normal", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float positionAndNormalData[] = {
+		-0.1f, -0.1f, 0.f,   0.f, 0.f, 1.f,
+		 0.1f, -0.1f, 0.f,   0.f, 0.f, 1.f,
+		 0.f,   0.1f, 0.f,   0.f, 0.f, 1.f,
+	};
+	const unsigned short indices[] = { 0, 1, 2 };
+
+	Gfx::VertexBufferID meshes[2] = {
+		gfxLayer->CreateVertexBuffer(),
+		gfxLayer->CreateVertexBuffer(),
+	};
+	gfxLayer->LoadVertexBuffer(meshes[0], Gfx::PrimitiveType::Triangles,
+							   positionOnly, ARRAY_LEN(positionOnly), 3 * sizeof(float),
+							   sizeof(positionOnlyData), positionOnlyData,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+	gfxLayer->LoadVertexBuffer(meshes[1], Gfx::PrimitiveType::Triangles,
+							   positionAndNormal, ARRAY_LEN(positionAndNormal), 6 * sizeof(float),
+							   sizeof(positionAndNormalData), positionAndNormalData,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = createFlatColorShader(gfxLayer);
+	if (shadingParameters.shader == Gfx::ShaderID::InvalidID)
+	{
+		return -1.;
+	}
+
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.numberOfIndices = ARRAY_LEN(indices);
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < numberOfDraws; ++i)
+	{
+		geometry.vertexBuffer = meshes[i & 1];
+		gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+	}
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	gfxLayer->DestroyVertexBuffer(meshes[0]);
+	gfxLayer->DestroyVertexBuffer(meshes[1]);
+
+	return duration / numberOfDraws;
+}
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET
+/// <summary>
+/// Many small meshes stored in a single vertex buffer, each with its
+/// own position stored in a storage buffer.
+/// </summary>
+struct ManyMeshesScene
+{
+	static const int numberOfMeshes = 1000;
+
+	Gfx::VertexBufferID		vertexBuffer;
+	Gfx::StorageBufferID	perDrawData;
+	Gfx::ShadingParameters	shadingParameters;
+
+	bool Create(Gfx::IGraphicLayer* gfxLayer)
+	{
+		// The same triangle, repeated for every mesh so each one uses
+		// its own range of the index buffer. The attributes are static,
+		// as the layer keeps a pointer to them when VAOs are disabled.
+		static const Gfx::VertexAttribute attributes[] = {
+			{ "position", 3, Gfx::VertexAttributeType::Float },
+		};
+		const float vertices[] = {
+			-0.01f, -0.01f, 0.f,
+			 0.01f, -0.01f, 0.f,
+			 0.f,    0.01f, 0.f,
+		};
+		unsigned short indices[3 * numberOfMeshes];
+		float offsets[4 * numberOfMeshes];
+		for (int i = 0; i < numberOfMeshes; ++i)
+		{
+			indices[3 * i + 0] = 0;
+			indices[3 * i + 1] = 1;
+			indices[3 * i + 2] = 2;
+			offsets[4 * i + 0] = -0.9f + 1.8f * (i % 32) / 32.f;
+			offsets[4 * i + 1] = -0.9f + 1.8f * (i / 32) / 32.f;
+			offsets[4 * i + 2] = 0.f;
+			offsets[4 * i + 3] = 0.f;
+		}
+
+		vertexBuffer = gfxLayer->CreateVertexBuffer();
+		gfxLayer->LoadVertexBuffer(vertexBuffer, Gfx::PrimitiveType::Triangles,
+								   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+								   sizeof(vertices), vertices,
+								   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+
+		perDrawData = gfxLayer->CreateStorageBuffer();
+		gfxLayer->LoadStorageBuffer(perDrawData, sizeof(offsets), offsets);
+
+		// drawOffset is 0 for a batch, where gl_DrawID gives the index
+		// of the draw, and the index of the mesh for individual draws.
+		const char* vertexShaderSource = R"(
+            #version 460 core
+            layout(location = 0) in vec3 position;
+            layout(std430) buffer PerDrawData {
+                vec4 offsets[];
+            };
+            uniform int drawOffset;
+            void main() {
+                gl_Position = vec4(position + offsets[drawOffset + gl_DrawID].xyz, 1.0);
+            }
+        )";
+		const char* fragmentShaderSource = R"(
+            #version 460 core
+            out vec4 color;
+            void main() {
+                color = vec4(1.0);
+            }
+        )";
+		const Gfx::ShaderStage shaderStages[] = {
+			{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+			{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+		};
+		shadingParameters.shader = gfxLayer->CreateShader();
+		gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+		shadingParameters.uniforms.add(Gfx::Uniform::StorageBufferInput1("PerDrawData", perDrawData));
+		shadingParameters.uniforms.add(Gfx::Uniform::Int1("drawOffset", 0));
+
+		return shadingParameters.shader != Gfx::ShaderID::InvalidID;
+	}
+
+	Gfx::Geometry Mesh(int i) const
+	{
+		Gfx::Geometry geometry = Gfx::Geometry();
+		geometry.vertexBuffer = vertexBuffer;
+		geometry.numberOfIndices = 3;
+		geometry.firstIndexOffset = 3 * i * sizeof(unsigned short);
+		return geometry;
+	}
+
+	void Destroy(Gfx::IGraphicLayer* gfxLayer)
+	{
+		gfxLayer->DestroyShader(shadingParameters.shader);
+		gfxLayer->DestroyStorageBuffer(perDrawData);
+		gfxLayer->DestroyVertexBuffer(vertexBuffer);
+	}
+};
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+/// <summary>
+/// Cost of drawing many meshes of a shared vertex buffer one draw call
+/// at a time, as a reference for BatchedDrawsBenchmark.
+/// </summary>
+double IndividualDrawsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	const int numberOfFrames = 100;
+
+	ManyMeshesScene scene;
+	if (!scene.Create(gfxLayer))
+	{
+		return -1.;
+	}
+	Gfx::Uniform& drawOffset = scene.shadingParameters.uniforms.last();
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < numberOfFrames; ++frame)
+	{
+		for (int i = 0; i < ManyMeshesScene::numberOfMeshes; ++i)
+		{
+			drawOffset.iValue[0] = i;
+			gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, scene.Mesh(i), scene.shadingParameters);
+		}
+	}
+	const double submissionDuration = elapsedMicroseconds(start);
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	scene.Destroy(gfxLayer);
+
+	LOG_INFO("Individual draws: %d draw calls per frame, %.3f us of CPU submission per frame.",
+			 ManyMeshesScene::numberOfMeshes, submissionDuration / numberOfFrames);
+	return duration / numberOfFrames;
+#else // !(GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET)
+	return -1.;
+#endif // !(GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET)
+}
+
+/// <summary>
+/// Cost of drawing many meshes of a shared vertex buffer as a single
+/// draw batch.
+/// </summary>
+double BatchedDrawsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	const int numberOfFrames = 100;
+
+	ManyMeshesScene scene;
+	if (!scene.Create(gfxLayer))
+	{
+		return -1.;
+	}
+
+	int numberOfDrawCalls = 0;
+	Gfx::DrawBatch batch;
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < numberOfFrames; ++frame)
+	{
+		numberOfDrawCalls = 0;
+		batch.Clear();
+		for (int i = 0; i < ManyMeshesScene::numberOfMeshes; ++i)
+		{
+			const Gfx::Geometry mesh = scene.Mesh(i);
+			if (!batch.Add(mesh))
+			{
+				gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, batch, scene.shadingParameters);
+				++numberOfDrawCalls;
+				batch.Clear();
+				batch.Add(mesh);
+			}
+		}
+		gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, batch, scene.shadingParameters);
+		++numberOfDrawCalls;
+	}
+	const double submissionDuration = elapsedMicroseconds(start);
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	scene.Destroy(gfxLayer);
+
+	LOG_INFO("Batched draws: %d draw call(s) per frame, %.3f us of CPU submission per frame.",
+			 numberOfDrawCalls, submissionDuration / numberOfFrames);
+	return duration / numberOfFrames;
+#else // !(GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET)
+	return -1.;
+#endif // !(GFX_ENABLE_MULTI_DRAW_INDIRECT && GFX_ENABLE_STORAGE_BUFFER_OBJECT && GFX_ENABLE_VERTEX_BUFFER_OFFSET)
+}
+
+/// <summary>
+/// Cost of setting a few float and int uniforms at every draw call.
+/// The vertex shader declares them either as plain uniforms, or in the
+/// DrawUniforms block, in which case they go through the uniform ring.
+/// </summary>
+static double perDrawUniformsBenchmark(Gfx::IGraphicLayer* gfxLayer,
+									   const char* uniformDeclarations,
+									   const char* name)
+{
+	const int numberOfDraws = 20000;
+	const int drawsPerFrame = 1000;
+
+	char vertexShaderSource[1024];
+	snprintf(vertexShaderSource, sizeof(vertexShaderSource), R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        %s
+        out vec4 vertexColor;
+        void main() {
+            gl_Position = vec4(position * scale + vec3(offset, 0.0), 1.0);
+            vertexColor = (invert != 0 ? vec4(1.0) - tint : tint);
+        }
+    )", uniformDeclarations);
+	const char* fragmentShaderSource = R"(
+        #version 330 core
+        in vec4 vertexColor;
+        out vec4 color;
+        void main() {
+            color = vertexColor;
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+	if (shadingParameters.shader == Gfx::ShaderID::InvalidID)
+	{
+		return -1.;
+	}
+	shadingParameters.uniforms.add(Gfx::Uniform::Float2("offset", 0.f, 0.f));
+	shadingParameters.uniforms.add(Gfx::Uniform::Float1("scale", 1.f));
+	shadingParameters.uniforms.add(Gfx::Uniform::Float4("tint", 1.f, 1.f, 1.f, 1.f));
+	shadingParameters.uniforms.add(Gfx::Uniform::Int1("invert", 0));
+	Gfx::Uniform& offset = shadingParameters.uniforms[0];
+	Gfx::Uniform& tint = shadingParameters.uniforms[2];
+
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.vertexBuffer = createTriangle(gfxLayer);
+	geometry.numberOfIndices = 3;
+
+	// The offset and the tint change at every draw, the rest is constant.
+	waitForGPU();
+#if GFX_COUNT_DRIVER_CALLS
+	const int driverCallsBefore = Gfx::OpenGLLayer::GetNumberOfDriverCalls();
+#endif // GFX_COUNT_DRIVER_CALLS
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < numberOfDraws; ++i)
+	{
+		offset.fValue[0] = -0.9f + 1.8f * (i % 32) / 32.f;
+		offset.fValue[1] = -0.9f + 1.8f * ((i / 32) % 32) / 32.f;
+		tint.fValue[0] = (i % 256) / 255.f;
+		gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+		if ((i + 1) % drawsPerFrame == 0)
+		{
+			gfxLayer->EndFrame();
+		}
+	}
+#if GFX_COUNT_DRIVER_CALLS
+	const int driverCalls = Gfx::OpenGLLayer::GetNumberOfDriverCalls() - driverCallsBefore;
+#endif // GFX_COUNT_DRIVER_CALLS
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	gfxLayer->DestroyVertexBuffer(geometry.vertexBuffer);
+
+#if GFX_COUNT_DRIVER_CALLS
+	LOG_INFO("%s: %.2f driver calls per draw.", name, (double)driverCalls / numberOfDraws);
+#else // !GFX_COUNT_DRIVER_CALLS
+	(void)name;
+#endif // !GFX_COUNT_DRIVER_CALLS
+	return duration / numberOfDraws;
+}
+
+/// <summary>
+/// Per draw uniforms set with one API call each, as a reference for
+/// UniformRingBenchmark.
+/// </summary>
+double PlainUniformsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	return perDrawUniformsBenchmark(gfxLayer, R"(
+        uniform vec2 offset;
+        uniform float scale;
+        uniform vec4 tint;
+        uniform int invert;
+    )", "Plain uniforms");
+}
+
+/// <summary>
+/// Per draw uniforms copied to the uniform ring, and bound with a
+/// single call.
+/// </summary>
+double UniformRingBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	return perDrawUniformsBenchmark(gfxLayer, R"(
+        layout(std140) uniform DrawUniforms {
+            vec2 offset;
+            float scale;
+            vec4 tint;
+            int invert;
+        };
+    )", "Uniform ring");
+#else // !GFX_ENABLE_UNIFORM_BUFFER_RING
+	return -1.;
+#endif // !GFX_ENABLE_UNIFORM_BUFFER_RING
+}
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+/// <summary>
+/// Cost of submitting many draws sorted by mesh, each with its own
+/// offset, either with one Draw() call each or as a single array given
+/// to SubmitDraws(). Filling the arguments is measured in both cases.
+/// </summary>
+static double drawSubmissionBenchmark(Gfx::IGraphicLayer* gfxLayer, bool submitDraws)
+{
+	const int numberOfDraws = 100000;
+	const int numberOfMeshes = 4;
+
+	const char* vertexShaderSource = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        uniform vec2 offset;
+        void main() {
+            gl_Position = vec4(position + vec3(offset, 0.0), 1.0);
+        }
+    )";
+	const char* fragmentShaderSource = R"(
+        #version 330 core
+        out vec4 color;
+        void main() {
+            color = vec4(1.0);
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+	if (shadingParameters.shader == Gfx::ShaderID::InvalidID)
+	{
+		return -1.;
+	}
+	shadingParameters.uniforms.add(Gfx::Uniform::Float2("offset", 0.f, 0.f));
+
+	Gfx::VertexBufferID meshes[numberOfMeshes];
+	for (int i = 0; i < numberOfMeshes; ++i)
+	{
+		meshes[i] = createTriangle(gfxLayer);
+	}
+
+	// What the engine would have computed for each draw.
+	Gfx::Uniform* offsets = new Gfx::Uniform[numberOfDraws];
+	for (int i = 0; i < numberOfDraws; ++i)
+	{
+		offsets[i] = Gfx::Uniform::Float2("offset",
+										  -0.9f + 1.8f * (i % 32) / 32.f,
+										  -0.9f + 1.8f * ((i / 32) % 32) / 32.f);
+	}
+	Gfx::DrawItem* items = new Gfx::DrawItem[numberOfDraws];
+	Gfx::DrawState state;
+	state.drawArea = benchmarkDrawArea;
+	state.rasterTests = Gfx::RasterTests::NoDepthTest;
+	state.blendingMode = shadingParameters.blendingMode;
+	state.polygonMode = shadingParameters.polygonMode;
+
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.numberOfIndices = 3;
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	if (submitDraws)
+	{
+		for (int i = 0; i < numberOfDraws; ++i)
+		{
+			Gfx::DrawItem& item = items[i];
+			item = Gfx::DrawItem();
+			item.state = &state;
+			item.uniforms = &offsets[i];
+			item.numberOfUniforms = 1;
+			item.shader = shadingParameters.shader;
+			item.vertexBuffer = meshes[i * numberOfMeshes / numberOfDraws];
+			item.numberOfIndices = 3;
+			item.numberOfInstances = 1;
+		}
+		gfxLayer->SubmitDraws(items, numberOfDraws);
+	}
+	else
+	{
+		for (int i = 0; i < numberOfDraws; ++i)
+		{
+			shadingParameters.uniforms[0] = offsets[i];
+			geometry.vertexBuffer = meshes[i * numberOfMeshes / numberOfDraws];
+			gfxLayer->Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+		}
+	}
+	gfxLayer->EndFrame();
+	const double submissionDuration = elapsedMicroseconds(start);
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	delete[] items;
+	delete[] offsets;
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	for (int i = 0; i < numberOfMeshes; ++i)
+	{
+		gfxLayer->DestroyVertexBuffer(meshes[i]);
+	}
+
+	LOG_INFO("%s: %.3f us of CPU submission per draw.", (submitDraws ? "Submitted draws" : "Per call draws"),
+			 submissionDuration / numberOfDraws);
+	return duration / numberOfDraws;
+}
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+/// <summary>
+/// 100K draws with one Draw() call each, as a reference for
+/// SubmittedDrawsBenchmark.
+/// </summary>
+double PerCallDrawsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_SUBMIT_DRAWS
+	return drawSubmissionBenchmark(gfxLayer, false);
+#else // !GFX_ENABLE_SUBMIT_DRAWS
+	(void)gfxLayer;
+	return -1.;
+#endif // !GFX_ENABLE_SUBMIT_DRAWS
+}
+
+/// <summary>
+/// The same 100K draws given to a single SubmitDraws() call.
+/// </summary>
+double SubmittedDrawsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_SUBMIT_DRAWS
+	return drawSubmissionBenchmark(gfxLayer, true);
+#else // !GFX_ENABLE_SUBMIT_DRAWS
+	(void)gfxLayer;
+	return -1.;
+#endif // !GFX_ENABLE_SUBMIT_DRAWS
+}
+
+/// <summary>
+/// Cost of loading resources: texture uploads interleaved with vertex
+/// buffer loads, on a few resources reloaded over and over. With
+/// GFX_ENABLE_DIRECT_STATE_ACCESS, they are edited without binding.
+/// </summary>
+double ResourceLoadsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	const int numberOfLoads = 1000;
+	const int numberOfResources = 16;
+	const int textureSize = 64;
+	const int vertexDataSize = 4096;
+
+	static unsigned char textureData[textureSize * textureSize * 4];
+	static float vertexData[vertexDataSize / sizeof(float)];
+	for (size_t i = 0; i < ARRAY_LEN(textureData); ++i)
+	{
+		textureData[i] = (unsigned char)i;
+	}
+	for (size_t i = 0; i < ARRAY_LEN(vertexData); ++i)
+	{
+		vertexData[i] = (float)i;
+	}
+
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const Gfx::TextureSampling textureSampling = {
+		Gfx::TextureFilter::LinearMipmapLinear,
+		Gfx::TextureFilter::Linear,
+		1.f,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+	};
+
+	Gfx::TextureID textures[numberOfResources];
+	Gfx::VertexBufferID vertexBuffers[numberOfResources];
+	for (int i = 0; i < numberOfResources; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+		vertexBuffers[i] = gfxLayer->CreateVertexBuffer();
+	}
+
+	waitForGPU();
+#if GFX_COUNT_DRIVER_CALLS
+	const int driverCallsBefore = Gfx::OpenGLLayer::GetNumberOfDriverCalls();
+#endif // GFX_COUNT_DRIVER_CALLS
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < numberOfLoads; ++i)
+	{
+		gfxLayer->LoadTexture(textures[i % numberOfResources],
+							  textureSize, textureSize,
+							  Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+							  0, -1, textureData, textureSampling);
+		gfxLayer->LoadVertexBuffer(vertexBuffers[i % numberOfResources], Gfx::PrimitiveType::Triangles,
+								   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+								   vertexDataSize, vertexData,
+								   0, nullptr, Gfx::VertexIndexType::UInt16);
+	}
+#if GFX_COUNT_DRIVER_CALLS
+	const int driverCalls = Gfx::OpenGLLayer::GetNumberOfDriverCalls() - driverCallsBefore;
+#endif // GFX_COUNT_DRIVER_CALLS
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	for (int i = 0; i < numberOfResources; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+		gfxLayer->DestroyVertexBuffer(vertexBuffers[i]);
+	}
+
+#if GFX_COUNT_DRIVER_CALLS
+	LOG_INFO("Resource loads: %.2f driver calls per load.", (double)driverCalls / (2 * numberOfLoads));
+#endif // GFX_COUNT_DRIVER_CALLS
+	return duration / (2 * numberOfLoads);
+}
+
+//
+// Texture loading: procedural textures generated on the CPU, then
+// uploaded.
+//
+
+static const int loadingNumberOfTextures = 64;
+static const int loadingTextureSize = 256;
+static const int loadingTextureDataSize = loadingTextureSize * loadingTextureSize * 4;
+
+struct TextureGenerationJob
+{
+	unsigned char*	data;
+	int				seed;
+};
+
+// A few octaves of sine waves, as a stand-in for procedural textures.
+static void generateTexture(unsigned char* data, int seed)
+{
+	for (int j = 0; j < loadingTextureSize; ++j)
+	{
+		for (int i = 0; i < loadingTextureSize; ++i)
+		{
+			float value = 0.f;
+			float frequency = 0.05f;
+			for (int octave = 0; octave < 6; ++octave)
+			{
+				value += std::sin(frequency * (i + seed)) * std::cos(frequency * (j - seed)) / (1 + octave);
+				frequency *= 2.f;
+			}
+			const unsigned char c = (unsigned char)(127.f + 60.f * value);
+			unsigned char* texel = data + 4 * (j * loadingTextureSize + i);
+			texel[0] = c;
+			texel[1] = c;
+			texel[2] = (unsigned char)(255 - c);
+			texel[3] = 255;
+		}
+	}
+}
+
+static void __cdecl generateTextureJob(void* arg)
+{
+	const TextureGenerationJob* job = (const TextureGenerationJob*)arg;
+	generateTexture(job->data, job->seed);
+}
+
+static const Gfx::TextureSampling loadingTextureSampling = {
+	Gfx::TextureFilter::LinearMipmapLinear,
+	Gfx::TextureFilter::Linear,
+	1.f,
+	Gfx::TextureWrap::Repeat,
+	Gfx::TextureWrap::Repeat,
+	Gfx::TextureWrap::Repeat,
+};
+
+/// <summary>
+/// Generates each texture then loads it, one after the other, as a
+/// reference for OverlappedTextureLoadingBenchmark.
+/// </summary>
+double SerialTextureLoadingBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	static unsigned char data[loadingTextureDataSize];
+	Gfx::TextureID textures[loadingNumberOfTextures];
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+	}
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		generateTexture(data, i);
+		gfxLayer->LoadTexture(textures[i], loadingTextureSize, loadingTextureSize,
+							  Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+							  0, -1, data, loadingTextureSampling);
+	}
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+	}
+	return duration / loadingNumberOfTextures;
+}
+
+/// <summary>
+/// Generates textures on worker threads, directly in the upload
+/// buffers, while the textures generated before are copied by the GPU.
+/// </summary>
+double OverlappedTextureLoadingBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	// Each batch uses half of the upload buffers, so it can be generated
+	// while the previous batch is copied from the other half.
+	const int batchSize = (GFX_TEXTURE_UPLOAD_BUFFERS > 1 ? GFX_TEXTURE_UPLOAD_BUFFERS / 2 : 1);
+	platform::ThreadData threads[GFX_TEXTURE_UPLOAD_BUFFERS];
+	TextureGenerationJob jobs[GFX_TEXTURE_UPLOAD_BUFFERS];
+
+	Gfx::TextureID textures[loadingNumberOfTextures];
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+	}
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int first = 0; first < loadingNumberOfTextures; first += batchSize)
+	{
+		const int count = (first + batchSize <= loadingNumberOfTextures ? batchSize : loadingNumberOfTextures - first);
+		for (int i = 0; i < count; ++i)
+		{
+			// Waits for the buffer to be released by the batch before
+			// the previous one.
+			void* data = nullptr;
+			while (data == nullptr)
+			{
+				data = gfxLayer->MapTextureUpload(textures[first + i], loadingTextureDataSize);
+			}
+			jobs[i].data = (unsigned char*)data;
+			jobs[i].seed = first + i;
+			platform::MultiThreading::StartThread(&threads[i], generateTextureJob, &jobs[i]);
+		}
+		platform::MultiThreading::WaitAllThreads(threads, count);
+
+		for (int i = 0; i < count; ++i)
+		{
+			gfxLayer->LoadTextureAsync(textures[first + i], loadingTextureSize, loadingTextureSize,
+									   Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+									   0, -1, loadingTextureSampling);
+		}
+	}
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		while (!gfxLayer->IsTextureReady(textures[i]))
+		{
+		}
+	}
+	const double duration = elapsedMicroseconds(start);
+
+	for (int i = 0; i < loadingNumberOfTextures; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+	}
+	return duration / loadingNumberOfTextures;
+#else // !GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	return -1.;
+#endif // !GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+}
+
+//
+// Readback: a histogram computed by the GPU every frame, and used by
+// the CPU, as for auto-exposure.
+//
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+static const int readbackNumberOfFrames = 200;
+static const int readbackNumberOfBins = 256;
+
+// Returns the average frame time, with the readbacks either waited for
+// right away, or retrieved once the GPU is done with them. Frames that
+// find every staging buffer busy skip their readback, as a game would
+// keep the previous histogram.
+static double readbackBenchmark(Gfx::IGraphicLayer* gfxLayer, bool async)
+{
+	const char* computeShaderSource = R"(
+        #version 450
+        layout(local_size_x = 16, local_size_y = 16) in;
+        layout(std430) buffer Histogram {
+            uint bins[];
+        };
+        uniform int frame;
+        void main() {
+            uint x = gl_GlobalInvocationID.x * 1973u + gl_GlobalInvocationID.y * 9277u + uint(frame) * 26699u;
+            x = (x ^ (x >> 13u)) * 0x5bd1e995u;
+            atomicAdd(bins[(x ^ (x >> 15u)) & 255u], 1u);
+        }
+    )";
+	const Gfx::ShaderStage shaderStage = { Gfx::ShaderType::ComputeShader, computeShaderSource, __FILE__ };
+	const Gfx::ShaderID shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shader, &shaderStage, 1);
+
+	unsigned int bins[readbackNumberOfBins] = {};
+	const Gfx::StorageBufferID histogram = gfxLayer->CreateStorageBuffer();
+	gfxLayer->LoadStorageBuffer(histogram, sizeof(bins), bins);
+	Gfx::Uniform histogramUniform = { "Histogram", 1, Gfx::UniformType::StorageBufferOutput, {} };
+	histogramUniform.storageBufferId = histogram;
+	Gfx::ComputeParameters computeParameters = Gfx::ComputeParameters();
+	computeParameters.uniforms.add(histogramUniform);
+	computeParameters.uniforms.add(Gfx::Uniform::Int1("frame", 0));
+
+#if GFX_ENABLE_ASYNC_READBACK
+	// Requested in order, so they are retrieved in order.
+	Gfx::ReadbackID readbacks[GFX_READBACK_BUFFERS];
+	int firstReadback = 0;
+	int numberOfReadbacks = 0;
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < readbackNumberOfFrames; ++i)
+	{
+		// A 1024x1024 image.
+		computeParameters.uniforms[1] = Gfx::Uniform::Int1("frame", i);
+		gfxLayer->Compute(shader, computeParameters, 64, 64);
+
+		if (!async)
+		{
+			gfxLayer->ReadStorageBuffer(histogram, sizeof(bins), bins);
+		}
+#if GFX_ENABLE_ASYNC_READBACK
+		else
+		{
+			while (numberOfReadbacks > 0 && gfxLayer->TryGetReadback(readbacks[firstReadback], bins))
+			{
+				firstReadback = (firstReadback + 1) % GFX_READBACK_BUFFERS;
+				--numberOfReadbacks;
+			}
+			const Gfx::ReadbackID readback = gfxLayer->RequestReadback(histogram, 0, sizeof(bins));
+			if (readback != Gfx::ReadbackID::InvalidID)
+			{
+				readbacks[(firstReadback + numberOfReadbacks) % GFX_READBACK_BUFFERS] = readback;
+				++numberOfReadbacks;
+			}
+		}
+#endif // GFX_ENABLE_ASYNC_READBACK
+		gfxLayer->EndFrame();
+	}
+#if GFX_ENABLE_ASYNC_READBACK
+	// The last histograms are part of the work.
+	for (; numberOfReadbacks > 0; --numberOfReadbacks)
+	{
+		while (!gfxLayer->TryGetReadback(readbacks[firstReadback], bins))
+		{
+		}
+		firstReadback = (firstReadback + 1) % GFX_READBACK_BUFFERS;
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+	const double duration = elapsedMicroseconds(start);
+
+	gfxLayer->DestroyStorageBuffer(histogram);
+	gfxLayer->DestroyShader(shader);
+	return duration / readbackNumberOfFrames;
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+/// <summary>
+/// Reads the histogram back as soon as it is computed, which waits for
+/// the GPU every frame, as a reference for AsyncReadbackBenchmark.
+/// </summary>
+double SyncReadbackBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	return readbackBenchmark(gfxLayer, false);
+#else // !(GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+	return -1.;
+#endif // !(GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+}
+
+/// <summary>
+/// Retrieves each histogram a few frames after it is computed, so the
+/// CPU and the GPU work on different frames.
+/// </summary>
+double AsyncReadbackBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_ASYNC_READBACK && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	return readbackBenchmark(gfxLayer, true);
+#else // !(GFX_ENABLE_ASYNC_READBACK && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+	return -1.;
+#endif // !(GFX_ENABLE_ASYNC_READBACK && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+}
+
+//
+// Shader compilation: many different shaders, as at startup.
+//
+
+static const int compilationNumberOfShaders = 200;
+
+// Each shader gets a different constant, so the driver can't reuse a
+// previous compilation.
+static void loadNumberedShader(Gfx::IGraphicLayer* gfxLayer, Gfx::ShaderID shader, int number, bool async)
+{
+	const char* vertexShaderSource = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main() {
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
+	char fragmentShaderSource[1024];
+	snprintf(fragmentShaderSource, sizeof(fragmentShaderSource), R"(
+        #version 330 core
+        out vec4 color;
+        void main() {
+            vec2 p = gl_FragCoord.xy * %d.0;
+            float value = 0.0;
+            for (int i = 0; i < 8; ++i) {
+                value += sin(p.x * float(i)) * cos(p.y / float(i + 1));
+            }
+            color = vec4(value);
+        }
+    )", number);
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	if (async)
+	{
+		gfxLayer->LoadShaderAsync(shader, shaderStages, ARRAY_LEN(shaderStages));
+		return;
+	}
+#else // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	(void)async;
+#endif // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	gfxLayer->LoadShader(shader, shaderStages, ARRAY_LEN(shaderStages));
+}
+
+/// <summary>
+/// Compiles and links shaders one after the other, as a reference for
+/// ParallelShaderCompilationBenchmark.
+/// </summary>
+double SerialShaderCompilationBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	Gfx::ShaderID shaders[compilationNumberOfShaders];
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		shaders[i] = gfxLayer->CreateShader();
+	}
+
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		loadNumberedShader(gfxLayer, shaders[i], i + 1, false);
+	}
+	const double duration = elapsedMicroseconds(start);
+
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		gfxLayer->DestroyShader(shaders[i]);
+	}
+	return duration / compilationNumberOfShaders;
+}
+
+/// <summary>
+/// Submits all the shaders, then waits until they are all ready.
+/// </summary>
+double ParallelShaderCompilationBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	Gfx::ShaderID shaders[compilationNumberOfShaders];
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		shaders[i] = gfxLayer->CreateShader();
+	}
+
+	// Other numbers than in the serial benchmark, so nothing is cached.
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		loadNumberedShader(gfxLayer, shaders[i], compilationNumberOfShaders + i + 1, true);
+	}
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		while (!gfxLayer->IsShaderReady(shaders[i]))
+		{
+		}
+	}
+	const double duration = elapsedMicroseconds(start);
+
+	for (int i = 0; i < compilationNumberOfShaders; ++i)
+	{
+		gfxLayer->DestroyShader(shaders[i]);
+	}
+	return duration / compilationNumberOfShaders;
+#else // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	return -1.;
+#endif // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+}
+
+//
+// Block compression: an RGBA8 image compressed on the CPU, the quality
+// measured by decoding it back.
+//
+
+static const int compressionImageSize = 1024;
+static const int compressionNumberOfTextures = 16;
+
+// Each channel has its own pattern, so a format can't get away with
+// encoding correlated channels, and alpha is a smooth gradient.
+static void generateCompressionImage(unsigned char* pixels, int size)
+{
+	for (int j = 0; j < size; ++j)
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			const float x = float(i);
+			const float y = float(j);
+			unsigned char* texel = pixels + 4 * (j * size + i);
+			texel[0] = (unsigned char)(127.f + 120.f * std::sin(0.02f * x) * std::cos(0.03f * y));
+			texel[1] = (unsigned char)(127.f + 120.f * std::sin(0.011f * (x + y)));
+			texel[2] = (unsigned char)(127.f + 60.f * std::cos(0.05f * x) + 60.f * std::sin(0.17f * y));
+			texel[3] = (unsigned char)(255 * i / (size - 1));
+		}
+	}
+}
+
+// Peak signal to noise ratio, in dB, over the first channels.
+static double computePSNR(const unsigned char* reference, const unsigned char* pixels,
+						  int numberOfPixels, int numberOfChannels)
+{
+	double squaredError = 0.;
+	for (int i = 0; i < numberOfPixels; ++i)
+	{
+		for (int c = 0; c < numberOfChannels; ++c)
+		{
+			const double difference = double(reference[4 * i + c]) - double(pixels[4 * i + c]);
+			squaredError += difference * difference;
+		}
+	}
+	const double meanSquaredError = squaredError / (double(numberOfPixels) * numberOfChannels);
+	if (meanSquaredError == 0.)
+	{
+		return 99.;
+	}
+	return 10. * std::log10(255. * 255. / meanSquaredError);
+}
+
+struct CompressionJob
+{
+	Texture::BlockFormat::Enum format;
+	const unsigned char* pixels;
+	int				size;
+	int				firstBlockRow;
+	int				numberOfBlockRows;
+	void*			output;
+};
+
+static void __cdecl compressionJob(void* arg)
+{
+	const CompressionJob* job = (const CompressionJob*)arg;
+	Texture::CompressBlockRows(job->format, job->pixels, job->size, job->size,
+							   job->firstBlockRow, job->numberOfBlockRows, job->output);
+}
+
+/// <summary>
+/// Compresses the image on one core to measure the quality and the
+/// throughput per core, then on all the cores.
+/// Returns the time per megapixel on all the cores.
+/// </summary>
+static double compressionBenchmark(Texture::BlockFormat::Enum format, int numberOfChannels)
+{
+	const int size = compressionImageSize;
+	const int numberOfPixels = size * size;
+	unsigned char* pixels = new unsigned char[4 * numberOfPixels];
+	unsigned char* decoded = new unsigned char[4 * numberOfPixels];
+	char* blocks = new char[Texture::GetCompressedSize(format, size, size)];
+	generateCompressionImage(pixels, size);
+
+	Clock::time_point start = Clock::now();
+	Texture::Compress(format, pixels, size, size, blocks);
+	const double singleThreadDuration = elapsedMicroseconds(start);
+
+	Texture::Decompress(format, blocks, size, size, decoded);
+	const double psnr = computePSNR(pixels, decoded, numberOfPixels, numberOfChannels);
+
+	// Block rows are split evenly between the threads.
+	const int maxThreads = 64;
+	const int numberOfBlockRows = (size + 3) / 4;
+	int numberOfThreads = platform::MultiThreading::GetNumberOfCores();
+	numberOfThreads = (numberOfThreads < 1 ? 1 : (numberOfThreads > maxThreads ? maxThreads : numberOfThreads));
+	platform::ThreadData threads[maxThreads];
+	CompressionJob jobs[maxThreads];
+
+	start = Clock::now();
+	for (int i = 0; i < numberOfThreads; ++i)
+	{
+		const int firstBlockRow = numberOfBlockRows * i / numberOfThreads;
+		jobs[i].format = format;
+		jobs[i].pixels = pixels;
+		jobs[i].size = size;
+		jobs[i].firstBlockRow = firstBlockRow;
+		jobs[i].numberOfBlockRows = numberOfBlockRows * (i + 1) / numberOfThreads - firstBlockRow;
+		jobs[i].output = blocks;
+		platform::MultiThreading::StartThread(&threads[i], compressionJob, &jobs[i]);
+	}
+	platform::MultiThreading::WaitAllThreads(threads, numberOfThreads);
+	const double duration = elapsedMicroseconds(start);
+
+	LOG_INFO("PSNR: %.2f dB, %.1f MPix/s per core, %.1f MPix/s on %d cores.",
+			 psnr, numberOfPixels / singleThreadDuration,
+			 numberOfPixels / duration, numberOfThreads);
+
+	delete[] blocks;
+	delete[] decoded;
+	delete[] pixels;
+	return duration / (numberOfPixels / 1000000.);
+}
+
+double BC1CompressionBenchmark(Gfx::IGraphicLayer*)
+{
+	return compressionBenchmark(Texture::BlockFormat::BC1, 3);
+}
+
+double BC4CompressionBenchmark(Gfx::IGraphicLayer*)
+{
+	return compressionBenchmark(Texture::BlockFormat::BC4, 1);
+}
+
+double BC5CompressionBenchmark(Gfx::IGraphicLayer*)
+{
+	return compressionBenchmark(Texture::BlockFormat::BC5, 2);
+}
+
+double BC7CompressionBenchmark(Gfx::IGraphicLayer*)
+{
+	return compressionBenchmark(Texture::BlockFormat::BC7, 4);
+}
+
+// Averages 2x2 pixels; the sizes are powers of two.
+static void downsample(const unsigned char* pixels, int size, unsigned char* output)
+{
+	const int outputSize = size / 2;
+	for (int j = 0; j < outputSize; ++j)
+	{
+		for (int i = 0; i < outputSize; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				const unsigned char* texel = pixels + 4 * (2 * j * size + 2 * i) + c;
+				const int sum = texel[0] + texel[4] + texel[4 * size] + texel[4 * size + 4];
+				output[4 * (j * outputSize + i) + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Loads BC7 textures with their whole mip chain, compressed beforehand,
+/// and reports the video memory it saves compared to RGBA8.
+/// </summary>
+double CompressedTextureLoadingBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+	const int maxLevels = 16;
+	char* levels[maxLevels];
+	int levelSizes[maxLevels];
+	int numberOfLevels = 0;
+	int compressedSize = 0;
+	int uncompressedSize = 0;
+
+	unsigned char* pixels = new unsigned char[4 * compressionImageSize * compressionImageSize];
+	unsigned char* nextLevel = new unsigned char[compressionImageSize * compressionImageSize];
+	generateCompressionImage(pixels, compressionImageSize);
+	for (int size = compressionImageSize; size >= 1; size /= 2)
+	{
+		levelSizes[numberOfLevels] = Texture::GetCompressedSize(Texture::BlockFormat::BC7, size, size);
+		levels[numberOfLevels] = new char[levelSizes[numberOfLevels]];
+		Texture::Compress(Texture::BlockFormat::BC7, pixels, size, size, levels[numberOfLevels]);
+		compressedSize += levelSizes[numberOfLevels];
+		uncompressedSize += 4 * size * size;
+		++numberOfLevels;
+
+		if (size > 1)
+		{
+			downsample(pixels, size, nextLevel);
+			unsigned char* swap = pixels;
+			pixels = nextLevel;
+			nextLevel = swap;
+		}
+	}
+	delete[] nextLevel;
+	delete[] pixels;
+
+	Gfx::TextureID textures[compressionNumberOfTextures];
+	for (int i = 0; i < compressionNumberOfTextures; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+	}
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < compressionNumberOfTextures; ++i)
+	{
+		int size = compressionImageSize;
+		for (int level = 0; level < numberOfLevels; ++level)
+		{
+			gfxLayer->LoadCompressedTexture(textures[i], size, size,
+											Gfx::TextureFormat::BC7, level,
+											levelSizes[level], levels[level],
+											loadingTextureSampling);
+			size /= 2;
+		}
+	}
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	LOG_INFO("Video memory per texture: %d KB in BC7 instead of %d KB in RGBA8, %d KB saved.",
+			 compressedSize / 1024, uncompressedSize / 1024,
+			 (uncompressedSize - compressedSize) / 1024);
+
+	for (int i = 0; i < compressionNumberOfTextures; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+	}
+	for (int level = 0; level < numberOfLevels; ++level)
+	{
+		delete[] levels[level];
+	}
+	return duration / compressionNumberOfTextures;
+#else // !GFX_ENABLE_COMPRESSED_TEXTURES
+	(void)gfxLayer;
+	return -1.;
+#endif // !GFX_ENABLE_COMPRESSED_TEXTURES
+}
+
+//
+// Mipmaps: a 4K half float texture, with its mip chain generated by the
+// GPU, or computed on the CPU with a better filter.
+//
+
+static const int mipMapTextureSize = 4096;
+
+static void generateFloatTexture(float* pixels, int size)
+{
+	for (int j = 0; j < size; ++j)
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			float* texel = pixels + 4 * (j * size + i);
+			const float x = 0.01f * i;
+			const float y = 0.01f * j;
+			texel[0] = std::sin(x) * std::cos(y);
+			texel[1] = std::sin(7.f * x + 3.f * y);
+			texel[2] = std::cos(31.f * x) * std::sin(29.f * y);
+			texel[3] = 1.f;
+		}
+	}
+}
+
+struct DownsampleJob
+{
+	const float*	source;
+	int				size;
+	int				firstRow;
+	int				numberOfRows;
+	float*			destination;
+};
+
+static void __cdecl downsampleJob(void* arg)
+{
+	const DownsampleJob* job = (const DownsampleJob*)arg;
+	Texture::DownsampleRows(job->source, job->size, job->size, true,
+							job->firstRow, job->numberOfRows, job->destination);
+}
+
+/// <summary>
+/// Loads the texture, and lets the driver generate the mipmaps with
+/// glGenerateMipmap.
+/// </summary>
+double GPUMipMapsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+	const int size = mipMapTextureSize;
+	float* pixels = new float[4 * size * size];
+	generateFloatTexture(pixels, size);
+	Gfx::TextureID texture = gfxLayer->CreateTexture();
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	gfxLayer->LoadTexture(texture, size, size,
+						  Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA16f,
+						  0, -1, pixels, loadingTextureSampling);
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	gfxLayer->DestroyTexture(texture);
+	delete[] pixels;
+	return duration;
+}
+
+/// <summary>
+/// Computes the mip chain on worker threads, one level after the
+/// other, while the previous level is uploaded to immutable storage.
+/// </summary>
+double CPUMipMapsBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_TEXTURE_STORAGE
+	const int size = mipMapTextureSize;
+	const int maxLevels = 16;
+	const int numberOfLevels = Texture::GetNumberOfMipLevels(size, size);
+	float* levels[maxLevels];
+	for (int level = 0; level < numberOfLevels; ++level)
+	{
+		const int levelSize = Texture::GetMipLevelSize(size, level);
+		levels[level] = new float[4 * levelSize * levelSize];
+	}
+	generateFloatTexture(levels[0], size);
+	Gfx::TextureID texture = gfxLayer->CreateTexture();
+
+	const int maxThreads = 64;
+	int numberOfThreads = platform::MultiThreading::GetNumberOfCores();
+	numberOfThreads = (numberOfThreads < 1 ? 1 : (numberOfThreads > maxThreads ? maxThreads : numberOfThreads));
+	platform::ThreadData threads[maxThreads];
+	DownsampleJob jobs[maxThreads];
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	gfxLayer->AllocateTexture(texture, size, size, numberOfLevels,
+							  Gfx::TextureFormat::RGBA16f, loadingTextureSampling);
+	for (int level = 1; level < numberOfLevels; ++level)
+	{
+		// The rows of the level are split between the threads.
+		const int sourceSize = Texture::GetMipLevelSize(size, level - 1);
+		const int numberOfRows = Texture::GetMipLevelSize(size, level);
+		const int count = (numberOfRows < numberOfThreads ? numberOfRows : numberOfThreads);
+		for (int i = 0; i < count; ++i)
+		{
+			const int firstRow = numberOfRows * i / count;
+			jobs[i].source = levels[level - 1];
+			jobs[i].size = sourceSize;
+			jobs[i].firstRow = firstRow;
+			jobs[i].numberOfRows = numberOfRows * (i + 1) / count - firstRow;
+			jobs[i].destination = levels[level];
+			platform::MultiThreading::StartThread(&threads[i], downsampleJob, &jobs[i]);
+		}
+
+		gfxLayer->LoadTextureLevel(texture, level - 1, levels[level - 1]);
+		platform::MultiThreading::WaitAllThreads(threads, count);
+	}
+	gfxLayer->LoadTextureLevel(texture, numberOfLevels - 1, levels[numberOfLevels - 1]);
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	LOG_INFO("%d levels computed on %d threads.", numberOfLevels, numberOfThreads);
+
+	gfxLayer->DestroyTexture(texture);
+	for (int level = 0; level < numberOfLevels; ++level)
+	{
+		delete[] levels[level];
+	}
+	return duration;
+#else // !GFX_ENABLE_TEXTURE_STORAGE
+	(void)gfxLayer;
+	return -1.;
+#endif // !GFX_ENABLE_TEXTURE_STORAGE
+}
+
+//
+// Frustum culling: boxes spread around a camera, culled on the CPU with
+// Render::Culler.
+//
+
+// A camera looking down -z, with a 90 degrees field of view.
+static const float cullingPlanes[6][4] = {
+	{  0.70710678f,  0.f, -0.70710678f,   0.f },
+	{ -0.70710678f,  0.f, -0.70710678f,   0.f },
+	{  0.f,  0.70710678f, -0.70710678f,   0.f },
+	{  0.f, -0.70710678f, -0.70710678f,   0.f },
+	{  0.f,  0.f, -1.f,  -1.f },
+	{  0.f,  0.f,  1.f, 100.f },
+};
+
+// Runs the jobs of Render::Culler on threads, the first one on the
+// calling thread rather than waiting.
+static void runCullingJobs(void*, Render::Culler::Job job, void* const* args, int numberOfJobs)
+{
+	platform::ThreadData threads[MAX_THREADS_CULLING];
+	for (int i = 1; i < numberOfJobs; ++i)
+	{
+		platform::MultiThreading::StartThread(&threads[i - 1], job, args[i]);
+	}
+	job(args[0]);
+	platform::MultiThreading::WaitAllThreads(threads, numberOfJobs - 1);
+}
+
+/// <summary>
+/// Culls the objects on one thread, then on all the cores, with about
+/// ten million objects tested in each case.
+/// Returns the time per call on all the cores.
+/// </summary>
+static double cullingBenchmark(int numberOfObjects)
+{
+	Render::Culler culler;
+	culler.Init(numberOfObjects);
+	Noise::Rand rand(numberOfObjects);
+	for (int i = 0; i < numberOfObjects; ++i)
+	{
+		const float center[3] = { rand.fgen(-100.f, 100.f), rand.fgen(-100.f, 100.f), rand.fgen(-200.f, 20.f) };
+		const float halfSize = rand.fgen(0.5f, 3.f);
+		const float boundsMin[3] = { center[0] - halfSize, center[1] - halfSize, center[2] - halfSize };
+		const float boundsMax[3] = { center[0] + halfSize, center[1] + halfSize, center[2] + halfSize };
+		culler.Add(center, 1.7320508f * halfSize, boundsMin, boundsMax);
+	}
+	int* visible = new int[numberOfObjects];
+	const int numberOfCalls = (numberOfObjects < 1000000 ? 10000000 / numberOfObjects : 10);
+
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < numberOfCalls; ++i)
+	{
+		culler.Cull(cullingPlanes, visible);
+	}
+	const double singleThreadDuration = elapsedMicroseconds(start) / numberOfCalls;
+
+	const int numberOfCores = platform::MultiThreading::GetNumberOfCores();
+	int numberOfVisible = 0;
+	start = Clock::now();
+	for (int i = 0; i < numberOfCalls; ++i)
+	{
+		numberOfVisible = culler.Cull(cullingPlanes, visible, runCullingJobs, nullptr, numberOfCores);
+	}
+	const double duration = elapsedMicroseconds(start) / numberOfCalls;
+
+	LOG_INFO("%d visible, %.1f M objects/s on one thread, %.1f M objects/s on all the cores.",
+			 numberOfVisible, numberOfObjects / singleThreadDuration, numberOfObjects / duration);
+
+	delete[] visible;
+	culler.Shutdown();
+	return duration;
+}
+
+double Culling10KBenchmark(Gfx::IGraphicLayer*)
+{
+	return cullingBenchmark(10000);
+}
+
+double Culling100KBenchmark(Gfx::IGraphicLayer*)
+{
+	return cullingBenchmark(100000);
+}
+
+double Culling1MBenchmark(Gfx::IGraphicLayer*)
+{
+	return cullingBenchmark(1000000);
+}
+
+//
+// Render passes: a G-buffer at 1080p, with two RGBA16f color targets
+// and a depth buffer, filled by a full screen draw every frame. Nothing
+// but memory bandwidth limits it on a software rasterizer.
+//
+
+#if GFX_ENABLE_RENDER_PASSES
+static const int renderPassWidth = 1920;
+static const int renderPassHeight = 1080;
+static const int renderPassNumberOfFrames = 100;
+
+// Returns the average frame time, with the G-buffer either entirely
+// cleared with ClearFrameBuffer, or in a render pass that only clears
+// the depth, and discards it at the end.
+static double renderPassBenchmark(Gfx::IGraphicLayer* gfxLayer, bool renderPass)
+{
+	const char* vertexShaderSource = R"(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        void main() {
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
+	const char* fragmentShaderSource = R"(
+        #version 330 core
+        layout(location = 0) out vec4 albedo;
+        layout(location = 1) out vec4 normal;
+        void main() {
+            albedo = vec4(gl_FragCoord.xy / vec2(1920.0, 1080.0), 0.5, 1.0);
+            normal = vec4(0.0, 0.0, 1.0, 0.0);
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+
+	// A triangle covering the screen.
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = {
+		-1.f, -1.f, 0.f,
+		 3.f, -1.f, 0.f,
+		-1.f,  3.f, 0.f,
+	};
+	const unsigned short indices[] = { 0, 1, 2 };
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.vertexBuffer = gfxLayer->CreateVertexBuffer();
+	geometry.numberOfIndices = 3;
+	gfxLayer->LoadVertexBuffer(geometry.vertexBuffer, Gfx::PrimitiveType::Triangles,
+							   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+							   sizeof(vertices), vertices,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+
+	const Gfx::TextureFormat::Enum formats[] = {
+		Gfx::TextureFormat::RGBA16f,
+		Gfx::TextureFormat::RGBA16f,
+		Gfx::TextureFormat::Depth,
+	};
+	Gfx::TextureID textures[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+		gfxLayer->LoadTexture(textures[i], renderPassWidth, renderPassHeight,
+							  Gfx::TextureType::Texture2D, formats[i],
+							  0, 0, nullptr, loadingTextureSampling);
+	}
+	const Gfx::DrawArea drawArea = {
+		gfxLayer->CreateFrameBuffer(textures, 3, 0, 0),
+		{ 0, 0, renderPassWidth, renderPassHeight }
+	};
+
+	// The draw covers the colors, so only the depth needs clearing, and
+	// nothing reads it after the pass.
+	const Gfx::LoadOp::Enum loadOps[] = { Gfx::LoadOp::DontCare, Gfx::LoadOp::DontCare, Gfx::LoadOp::Clear };
+	const Gfx::ClearValue clearValues[] = {
+		{ { 0.f, 0.f, 0.f, 0.f }, 0.f, 0 },
+		{ { 0.f, 0.f, 0.f, 0.f }, 0.f, 0 },
+		{ { 0.f, 0.f, 0.f, 0.f }, 1.f, 0 },
+	};
+	const Gfx::StoreOp::Enum storeOps[] = { Gfx::StoreOp::Store, Gfx::StoreOp::Store, Gfx::StoreOp::DontCare };
+
+	waitForGPU();
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < renderPassNumberOfFrames; ++i)
+	{
+		if (renderPass)
+		{
+			gfxLayer->BeginRenderPass(drawArea.frameBuffer, loadOps, clearValues, 3);
+			gfxLayer->Draw(drawArea, Gfx::RasterTests::RegularDepthTest, geometry, shadingParameters);
+			gfxLayer->EndRenderPass(storeOps, 3);
+		}
+		else
+		{
+			gfxLayer->ClearFrameBuffer(drawArea.frameBuffer, 0.f, 0.f, 0.f, true);
+			gfxLayer->Draw(drawArea, Gfx::RasterTests::RegularDepthTest, geometry, shadingParameters);
+		}
+		gfxLayer->EndFrame();
+	}
+	waitForGPU();
+	const double duration = elapsedMicroseconds(start);
+
+	gfxLayer->DestroyFrameBuffer(drawArea.frameBuffer);
+	for (int i = 0; i < 3; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+	}
+	gfxLayer->DestroyVertexBuffer(geometry.vertexBuffer);
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	return duration / renderPassNumberOfFrames;
+}
+#endif // GFX_ENABLE_RENDER_PASSES
+
+/// <summary>
+/// Clears all the attachments every frame, and keeps them all, as a
+/// reference for RenderPassBenchmark.
+/// </summary>
+double ClearedGBufferBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_RENDER_PASSES
+	return renderPassBenchmark(gfxLayer, false);
+#else // !GFX_ENABLE_RENDER_PASSES
+	return -1.;
+#endif // !GFX_ENABLE_RENDER_PASSES
+}
+
+/// <summary>
+/// Only clears the depth, and discards it at the end of the pass.
+/// </summary>
+double RenderPassBenchmark(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_RENDER_PASSES
+	return renderPassBenchmark(gfxLayer, true);
+#else // !GFX_ENABLE_RENDER_PASSES
+	return -1.;
+#endif // !GFX_ENABLE_RENDER_PASSES
+}
+
+/// <summary>
+/// Engine side cost of submitting draws, on a null layer: no driver is
+/// involved, so the result only depends on the CPU and is stable from
+/// one run to the next.
+/// </summary>
+double NullLayerSubmissionBenchmark(Gfx::IGraphicLayer*)
+{
+#if GFX_MULTI_API
+	const int numberOfDraws = 200000;
+	const int drawsPerFrame = 1000;
+
+	Gfx::NullLayer nullLayer;
+	nullLayer.CreateRenderingContext();
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = createFlatColorShader(&nullLayer);
+	shadingParameters.uniforms.add(Gfx::Uniform::Float2("offset", 0.f, 0.f));
+	shadingParameters.uniforms.add(Gfx::Uniform::Float4("tint", 1.f, 1.f, 1.f, 1.f));
+	Gfx::Uniform& offset = shadingParameters.uniforms[0];
+
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.vertexBuffer = createTriangle(&nullLayer);
+	geometry.numberOfIndices = 3;
+
+	const Clock::time_point start = Clock::now();
+	for (int i = 0; i < numberOfDraws; ++i)
+	{
+		offset.fValue[0] = -0.9f + 1.8f * (i % 32) / 32.f;
+		nullLayer.Draw(benchmarkDrawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+		if ((i + 1) % drawsPerFrame == 0)
+		{
+			nullLayer.EndFrame();
+		}
+	}
+	const double duration = elapsedMicroseconds(start);
+
+	nullLayer.DestroyRenderingContext();
+	return duration / numberOfDraws;
+#else // !GFX_MULTI_API
+	return -1.;
+#endif // !GFX_MULTI_API
+}
+
+Benchmark benchmarks[] = {
+	{ "Alternating meshes (per draw)", AlternatingMeshesBenchmark },
+	{ "Individual draws (per frame)", IndividualDrawsBenchmark },
+	{ "Batched draws (per frame)", BatchedDrawsBenchmark },
+	{ "Plain uniforms (per draw)", PlainUniformsBenchmark },
+	{ "Uniform ring (per draw)", UniformRingBenchmark },
+	{ "Per call draws (per draw)", PerCallDrawsBenchmark },
+	{ "Submitted draws (per draw)", SubmittedDrawsBenchmark },
+	{ "Resource loads (per load)", ResourceLoadsBenchmark },
+	{ "Serial texture loading (per texture)", SerialTextureLoadingBenchmark },
+	{ "Overlapped texture loading (per texture)", OverlappedTextureLoadingBenchmark },
+	{ "Synchronous readback (per frame)", SyncReadbackBenchmark },
+	{ "Asynchronous readback (per frame)", AsyncReadbackBenchmark },
+	{ "Serial shader compilation (per shader)", SerialShaderCompilationBenchmark },
+	{ "Parallel shader compilation (per shader)", ParallelShaderCompilationBenchmark },
+	{ "BC1 compression (per megapixel)", BC1CompressionBenchmark },
+	{ "BC4 compression (per megapixel)", BC4CompressionBenchmark },
+	{ "BC5 compression (per megapixel)", BC5CompressionBenchmark },
+	{ "BC7 compression (per megapixel)", BC7CompressionBenchmark },
+	{ "Compressed texture loading (per texture)", CompressedTextureLoadingBenchmark },
+	{ "Mipmaps generated by the GPU (per 4K RGBA16f texture)", GPUMipMapsBenchmark },
+	{ "Mipmaps computed on the CPU (per 4K RGBA16f texture)", CPUMipMapsBenchmark },
+	{ "Frustum culling of 10K objects (per call)", Culling10KBenchmark },
+	{ "Frustum culling of 100K objects (per call)", Culling100KBenchmark },
+	{ "Frustum culling of 1M objects (per call)", Culling1MBenchmark },
+	{ "Cleared 1080p G-buffer (per frame)", ClearedGBufferBenchmark },
+	{ "1080p G-buffer render pass (per frame)", RenderPassBenchmark },
+	{ "Draw submission on a null layer (per draw)", NullLayerSubmissionBenchmark },
+};
+
+/// <summary>
+/// Run all benchmarks and log their results.
+/// The return value is negative if the setup failed, zero otherwise.
+/// </summary>
+int RunAllBenchmarks()
+{
+	platform::Platform platform("Benchmarks",
+								1024, 768, 0, 0, 1920, 1080, false);
+
+	Gfx::IGraphicLayer* gfxLayer = new Gfx::OpenGLLayer();
+	if (!gfxLayer->CreateRenderingContext())
+	{
+#if _HAS_EXCEPTIONS
+		Debug::TerminateOnFatalError("Could not load graphics API.");
+#endif
+		return -1;
+	}
+
+	for (size_t i = 0; i < ARRAY_LEN(benchmarks); ++i)
+	{
+		const Benchmark& benchmark = benchmarks[i];
+		const double result = benchmark.function(gfxLayer);
+		if (result < 0.)
+		{
+			LOG_INFO("%s: could not run.", benchmark.name);
+		}
+		else
+		{
+			LOG_INFO("%s: %.3f us", benchmark.name, result);
+		}
+	}
+
+	gfxLayer->DestroyRenderingContext();
+	return 0;
+}
+
+int __cdecl main()
+{
+	LOG_INFO("Starting Benchmarks");
+	int result = 0;
+
+#if _HAS_EXCEPTIONS
+	try
+	{
+		result = RunAllBenchmarks();
+	}
+	catch (std::exception* e)
+	{
+		LOG_FATAL(e->what());
+		result = -1;
+	}
+#else // !_HAS_EXCEPTIONS
+	result = RunAllBenchmarks();
+#endif // !_HAS_EXCEPTIONS
+
+	LOG_INFO("End of Benchmarks");
+	return result;
+}
@@ -84,6 +84,12 @@
 #	define ENABLE_AABB_CULLING 1
 #endif
 
+// Enable the settings of dynamic resolution, which scales the render
+// resolution to keep the frame time within a budget.
+#ifndef ENABLE_DYNAMIC_RESOLUTION
+#	define ENABLE_DYNAMIC_RESOLUTION 0
+#endif
+
 // Controls inclusion of position attribute in vertex structure
 #ifndef VERTEX_ATTR_POSITION
 #	define VERTEX_ATTR_POSITION 1
@@ -112,6 +118,11 @@
 #	define MAX_NUMBER_OF_SHOTS 512
 #endif
 
+// Maximum number of threads for frustum culling.
+#ifndef MAX_THREADS_CULLING
+#	define MAX_THREADS_CULLING 64
+#endif
+
 // Maximum number of threads for heightmap operations.
 #ifndef MAX_THREADS_HEIGHTMAP
 #	define MAX_THREADS_HEIGHTMAP 64 // At 128 we hit the __chkstk link error.
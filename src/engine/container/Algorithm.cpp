@@ -3,6 +3,16 @@
 
 using namespace Container;
 
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<int>;
+
+#endif
+
 int Container::fltcmp(const float* fptr1, const float* fptr2, size_t n)
 {
 	if (!n)
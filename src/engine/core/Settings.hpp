@@ -28,6 +28,12 @@ namespace Core
 			windowWidth(1280),
 			windowHeight(720),
 			fullscreen(true)
+#if ENABLE_DYNAMIC_RESOLUTION
+			,
+			frameTimeBudget(16.6f),
+			minRenderScale(0.5f),
+			maxRenderScale(1.f)
+#endif // ENABLE_DYNAMIC_RESOLUTION
 #if ENABLE_QUALITY_OPTION
 			,
 			m_textureSizeMultiplier(2),
@@ -58,6 +64,16 @@ namespace Core
 
 		bool			fullscreen;
 
+#if ENABLE_DYNAMIC_RESOLUTION
+		// The render resolution is scaled between these bounds to keep
+		// the frame time, in milliseconds, within the budget; see
+		// Render::ResolutionController. renderWidth and renderHeight are
+		// the resolution at scale 1.
+		float			frameTimeBudget;
+		float			minRenderScale;
+		float			maxRenderScale;
+#endif // ENABLE_DYNAMIC_RESOLUTION
+
 #if DEBUG
 		Debug::DebugSettings	debug;
 #endif // DEBUG
@@ -0,0 +1,310 @@
+#include "Culler.hpp"
+
+#include "engine/debug/Assert.hpp"
+#include <cmath>
+#include <cstring>
+
+// Objects are tested 8 at a time with AVX, 4 at a time with SSE, and
+// one at a time otherwise.
+#if defined(__AVX__)
+#define USE_AVX 1
+#define USE_SSE 0
+#define BLOCK_SIZE 8
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_AVX 0
+#define USE_SSE 1
+#define BLOCK_SIZE 4
+#include <xmmintrin.h>
+#else
+#define USE_AVX 0
+#define USE_SSE 0
+#define BLOCK_SIZE 1
+#endif
+
+// Below this number of objects per job, starting a thread costs more
+// than the tests it saves.
+#define MIN_OBJECTS_PER_JOB 16384
+
+using namespace Render;
+
+//
+// Notes:
+//
+// A sphere is outside of the frustum if its center is further than its
+// radius behind one of the planes. A box is outside if its corner the
+// furthest along the normal of a plane is behind it; the distance of
+// that corner is the distance of the center, plus the half sizes
+// weighted by the absolute values of the normal.
+//
+// Both tests are conservative: an object outside of the frustum but
+// near a corner can be kept.
+//
+
+Culler::Culler():
+	m_data(nullptr),
+	m_sphereX(nullptr),
+	m_sphereY(nullptr),
+	m_sphereZ(nullptr),
+	m_sphereRadius(nullptr),
+	m_boxX(nullptr),
+	m_boxY(nullptr),
+	m_boxZ(nullptr),
+	m_boxHalfX(nullptr),
+	m_boxHalfY(nullptr),
+	m_boxHalfZ(nullptr),
+	m_capacity(0),
+	m_size(0)
+{
+}
+
+Culler::~Culler()
+{
+	Shutdown();
+}
+
+void Culler::Init(int capacity)
+{
+	ASSERT(m_data == nullptr);
+	ASSERT(capacity > 0);
+
+	// A block that starts on the last object still reads padding, so a
+	// range can start anywhere.
+	const int stride = (capacity + 2 * BLOCK_SIZE - 2) / BLOCK_SIZE * BLOCK_SIZE;
+	m_data = new float[10 * stride];
+	memset(m_data, 0, 10 * stride * sizeof(float));
+	m_sphereX = m_data;
+	m_sphereY = m_data + stride;
+	m_sphereZ = m_data + 2 * stride;
+	m_sphereRadius = m_data + 3 * stride;
+	m_boxX = m_data + 4 * stride;
+	m_boxY = m_data + 5 * stride;
+	m_boxZ = m_data + 6 * stride;
+	m_boxHalfX = m_data + 7 * stride;
+	m_boxHalfY = m_data + 8 * stride;
+	m_boxHalfZ = m_data + 9 * stride;
+	m_capacity = capacity;
+	m_size = 0;
+}
+
+void Culler::Shutdown()
+{
+	delete[] m_data;
+	m_data = nullptr;
+	m_capacity = 0;
+	m_size = 0;
+}
+
+int Culler::Add(const float sphereCenter[3], float sphereRadius,
+				const float boundsMin[3], const float boundsMax[3])
+{
+	ASSERT(m_size < m_capacity);
+	const int index = m_size++;
+	Update(index, sphereCenter, sphereRadius, boundsMin, boundsMax);
+	return index;
+}
+
+void Culler::Update(int index,
+					const float sphereCenter[3], float sphereRadius,
+					const float boundsMin[3], const float boundsMax[3])
+{
+	ASSERT(index >= 0 && index < m_size);
+	ASSERT(sphereRadius >= 0.f);
+
+	m_sphereX[index] = sphereCenter[0];
+	m_sphereY[index] = sphereCenter[1];
+	m_sphereZ[index] = sphereCenter[2];
+	m_sphereRadius[index] = sphereRadius;
+	m_boxX[index] = 0.5f * (boundsMax[0] + boundsMin[0]);
+	m_boxY[index] = 0.5f * (boundsMax[1] + boundsMin[1]);
+	m_boxZ[index] = 0.5f * (boundsMax[2] + boundsMin[2]);
+	m_boxHalfX[index] = 0.5f * (boundsMax[0] - boundsMin[0]);
+	m_boxHalfY[index] = 0.5f * (boundsMax[1] - boundsMin[1]);
+	m_boxHalfZ[index] = 0.5f * (boundsMax[2] - boundsMin[2]);
+}
+
+void Culler::Clear()
+{
+	m_size = 0;
+}
+
+int Culler::CullRange(const float planes[6][4],
+					  int first, int count,
+					  int* visible) const
+{
+	ASSERT(first >= 0 && count >= 0 && first + count <= m_size);
+	ASSERT(count == 0 || visible != nullptr);
+
+	int numberOfVisible = 0;
+	const int end = first + count;
+
+#if USE_AVX || USE_SSE
+#if USE_AVX
+	typedef __m256 Vector;
+#define LOAD(p) _mm256_loadu_ps(p)
+#define SET1(x) _mm256_set1_ps(x)
+#define ADD(a, b) _mm256_add_ps(a, b)
+#define MUL(a, b) _mm256_mul_ps(a, b)
+#define AND(a, b) _mm256_and_ps(a, b)
+#define IS_POSITIVE(a) _mm256_cmp_ps(a, zero, _CMP_GE_OQ)
+#define MOVE_MASK(a) _mm256_movemask_ps(a)
+	const Vector allLanes = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	const Vector zero = _mm256_setzero_ps();
+#else // !USE_AVX
+	typedef __m128 Vector;
+#define LOAD(p) _mm_loadu_ps(p)
+#define SET1(x) _mm_set1_ps(x)
+#define ADD(a, b) _mm_add_ps(a, b)
+#define MUL(a, b) _mm_mul_ps(a, b)
+#define AND(a, b) _mm_and_ps(a, b)
+#define IS_POSITIVE(a) _mm_cmpge_ps(a, zero)
+#define MOVE_MASK(a) _mm_movemask_ps(a)
+	const Vector allLanes = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+	const Vector zero = _mm_setzero_ps();
+#endif // !USE_AVX
+
+	Vector a[6], b[6], c[6], d[6];
+	Vector absA[6], absB[6], absC[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		a[p] = SET1(planes[p][0]);
+		b[p] = SET1(planes[p][1]);
+		c[p] = SET1(planes[p][2]);
+		d[p] = SET1(planes[p][3]);
+		absA[p] = SET1(fabsf(planes[p][0]));
+		absB[p] = SET1(fabsf(planes[p][1]));
+		absC[p] = SET1(fabsf(planes[p][2]));
+	}
+
+	for (int i = first; i < end; i += BLOCK_SIZE)
+	{
+		Vector inside = allLanes;
+#if ENABLE_SPHERE_CULLING
+		{
+			const Vector x = LOAD(m_sphereX + i);
+			const Vector y = LOAD(m_sphereY + i);
+			const Vector z = LOAD(m_sphereZ + i);
+			const Vector r = LOAD(m_sphereRadius + i);
+			for (int p = 0; p < 6; ++p)
+			{
+				const Vector distance = ADD(ADD(ADD(MUL(a[p], x), MUL(b[p], y)), MUL(c[p], z)), d[p]);
+				inside = AND(inside, IS_POSITIVE(ADD(distance, r)));
+			}
+		}
+#endif // ENABLE_SPHERE_CULLING
+#if ENABLE_AABB_CULLING
+		{
+			const Vector x = LOAD(m_boxX + i);
+			const Vector y = LOAD(m_boxY + i);
+			const Vector z = LOAD(m_boxZ + i);
+			const Vector hx = LOAD(m_boxHalfX + i);
+			const Vector hy = LOAD(m_boxHalfY + i);
+			const Vector hz = LOAD(m_boxHalfZ + i);
+			for (int p = 0; p < 6; ++p)
+			{
+				const Vector distance = ADD(ADD(ADD(MUL(a[p], x), MUL(b[p], y)), MUL(c[p], z)), d[p]);
+				const Vector extent = ADD(ADD(MUL(absA[p], hx), MUL(absB[p], hy)), MUL(absC[p], hz));
+				inside = AND(inside, IS_POSITIVE(ADD(distance, extent)));
+			}
+		}
+#endif // ENABLE_AABB_CULLING
+
+		// Every lane is written, and the count only moves past the
+		// visible ones, which avoids a branch per object.
+		const int mask = MOVE_MASK(inside);
+		const int lanes = (end - i < BLOCK_SIZE ? end - i : BLOCK_SIZE);
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			visible[numberOfVisible] = i + lane;
+			numberOfVisible += (mask >> lane) & 1;
+		}
+	}
+
+#undef LOAD
+#undef SET1
+#undef ADD
+#undef MUL
+#undef AND
+#undef IS_POSITIVE
+#undef MOVE_MASK
+#else // !(USE_AVX || USE_SSE)
+	for (int i = first; i < end; ++i)
+	{
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; ++p)
+		{
+			const float* plane = planes[p];
+#if ENABLE_SPHERE_CULLING
+			const float sphereDistance = plane[0] * m_sphereX[i] + plane[1] * m_sphereY[i] + plane[2] * m_sphereZ[i] + plane[3];
+			inside = inside && (sphereDistance + m_sphereRadius[i] >= 0.f);
+#endif // ENABLE_SPHERE_CULLING
+#if ENABLE_AABB_CULLING
+			const float boxDistance = plane[0] * m_boxX[i] + plane[1] * m_boxY[i] + plane[2] * m_boxZ[i] + plane[3];
+			const float extent = fabsf(plane[0]) * m_boxHalfX[i] + fabsf(plane[1]) * m_boxHalfY[i] + fabsf(plane[2]) * m_boxHalfZ[i];
+			inside = inside && (boxDistance + extent >= 0.f);
+#endif // ENABLE_AABB_CULLING
+		}
+		if (inside)
+		{
+			visible[numberOfVisible++] = i;
+		}
+	}
+#endif // !(USE_AVX || USE_SSE)
+
+	return numberOfVisible;
+}
+
+struct CullJob
+{
+	const Culler*		culler;
+	const float			(*planes)[4];
+	int					first;
+	int					count;
+	int*				visible;
+	int					numberOfVisible;
+};
+
+static void cullJob(void* arg)
+{
+	CullJob* job = (CullJob*)arg;
+	job->numberOfVisible = job->culler->CullRange(job->planes, job->first, job->count, job->visible);
+}
+
+int Culler::Cull(const float planes[6][4], int* visible,
+				 JobRunner runJobs, void* runnerContext, int maxJobs) const
+{
+	ASSERT(maxJobs > 0);
+
+	int numberOfJobs = (runJobs != nullptr ? maxJobs : 1);
+	numberOfJobs = (numberOfJobs < MAX_THREADS_CULLING ? numberOfJobs : MAX_THREADS_CULLING);
+	numberOfJobs = (numberOfJobs < m_size / MIN_OBJECTS_PER_JOB ? numberOfJobs : m_size / MIN_OBJECTS_PER_JOB);
+	if (numberOfJobs <= 1)
+	{
+		return CullRange(planes, 0, m_size, visible);
+	}
+
+	// Each chunk writes its indices where its objects start, so the
+	// chunks don't overlap; they are moved next to each other after.
+	CullJob jobs[MAX_THREADS_CULLING];
+	void* args[MAX_THREADS_CULLING];
+	for (int i = 0; i < numberOfJobs; ++i)
+	{
+		const int first = m_size * i / numberOfJobs;
+		jobs[i].culler = this;
+		jobs[i].planes = planes;
+		jobs[i].first = first;
+		jobs[i].count = m_size * (i + 1) / numberOfJobs - first;
+		jobs[i].visible = visible + first;
+		jobs[i].numberOfVisible = 0;
+		args[i] = &jobs[i];
+	}
+	runJobs(runnerContext, cullJob, args, numberOfJobs);
+
+	int numberOfVisible = jobs[0].numberOfVisible;
+	for (int i = 1; i < numberOfJobs; ++i)
+	{
+		memmove(visible + numberOfVisible, jobs[i].visible, jobs[i].numberOfVisible * sizeof(int));
+		numberOfVisible += jobs[i].numberOfVisible;
+	}
+	return numberOfVisible;
+}
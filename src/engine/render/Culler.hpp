@@ -0,0 +1,114 @@
+#pragma once
+
+#include "engine/EngineConfig.hpp"
+
+namespace Render
+{
+	/// <summary>
+	/// Frustum culling of many objects on the CPU.
+	///
+	/// The bounding volumes are stored as structures of arrays, so 4
+	/// objects (8 with AVX) are tested against a plane at once. Each
+	/// object has a bounding sphere, tested if ENABLE_SPHERE_CULLING is
+	/// set, and a world space axis aligned bounding box, tested if
+	/// ENABLE_AABB_CULLING is set. An object is visible if it passes the
+	/// enabled tests.
+	/// </summary>
+	class Culler
+	{
+	public:
+		/// <summary>
+		/// Culls one chunk of the objects.
+		/// </summary>
+		typedef void (*Job)(void* arg);
+
+		/// <summary>
+		/// Runs job(args[i]) for each of the jobs, possibly on other
+		/// threads at the same time, and returns once they are all
+		/// done. The engine has no threads of its own, so the
+		/// application provides it.
+		/// </summary>
+		typedef void (*JobRunner)(void* runnerContext, Job job,
+								  void* const* args, int numberOfJobs);
+
+		Culler();
+		~Culler();
+
+		/// <summary>
+		/// Allocates the arrays for a maximum number of objects.
+		/// </summary>
+		void		Init(int capacity);
+		void		Shutdown();
+
+		/// <summary>
+		/// Adds an object, and returns its index, which is what Cull
+		/// writes if it is visible.
+		/// </summary>
+		int			Add(const float sphereCenter[3], float sphereRadius,
+						const float boundsMin[3], const float boundsMax[3]);
+
+		/// <summary>
+		/// Changes the bounding volumes of an object that moved.
+		/// </summary>
+		void		Update(int index,
+						   const float sphereCenter[3], float sphereRadius,
+						   const float boundsMin[3], const float boundsMax[3]);
+
+		void		Clear();
+		int			Size() const { return m_size; }
+
+		/// <summary>
+		/// Culls a range of objects, and writes the indices of those
+		/// that are visible in increasing order. Ranges can be culled on
+		/// different threads, since they only read the culler.
+		/// </summary>
+		///
+		/// <param name="planes">The six planes of the frustum, as
+		///     (a, b, c, d) such that a point is inside when
+		///     a x + b y + c z + d >= 0 for all planes. The normals
+		///     should be of unit length for the sphere test.</param>
+		/// <param name="visible">Receives up to count indices.</param>
+		/// <returns>The number of visible objects of the range.</returns>
+		int			CullRange(const float planes[6][4],
+							  int first, int count,
+							  int* visible) const;
+
+		/// <summary>
+		/// Culls all the objects, split in chunks run as jobs, and
+		/// writes the indices of those that are visible in increasing
+		/// order. Few objects are culled on the calling thread, since
+		/// starting jobs would cost more than the test.
+		/// </summary>
+		///
+		/// <param name="visible">Receives up to Size() indices.</param>
+		/// <param name="runJobs">Runs the chunks; if null, all the
+		///     objects are culled on the calling thread.</param>
+		/// <param name="maxJobs">Maximum number of chunks, typically
+		///     the number of cores, up to MAX_THREADS_CULLING.</param>
+		/// <returns>The number of visible objects.</returns>
+		int			Cull(const float planes[6][4], int* visible,
+						 JobRunner runJobs = nullptr, void* runnerContext = nullptr,
+						 int maxJobs = MAX_THREADS_CULLING) const;
+
+	private:
+		// No culler copy.
+		Culler(const Culler& src);
+		Culler& operator = (const Culler& src);
+
+		// One array per coordinate, padded to a whole number of SIMD
+		// blocks. The boxes are stored as center and half size.
+		float*		m_data;
+		float*		m_sphereX;
+		float*		m_sphereY;
+		float*		m_sphereZ;
+		float*		m_sphereRadius;
+		float*		m_boxX;
+		float*		m_boxY;
+		float*		m_boxZ;
+		float*		m_boxHalfX;
+		float*		m_boxHalfY;
+		float*		m_boxHalfZ;
+		int			m_capacity;
+		int			m_size;
+	};
+}
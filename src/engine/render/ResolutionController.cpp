@@ -0,0 +1,104 @@
+#include "ResolutionController.hpp"
+
+#include "engine/debug/Assert.hpp"
+#include <cmath>
+
+// Weight of the last frame in the average frame time.
+#define FRAME_TIME_SMOOTHING 0.1f
+
+// Number of frames to wait after a change, before another one.
+#define FRAMES_BETWEEN_CHANGES 15
+
+// The scale goes down when the average frame time is above the budget
+// by 5%, and up when it is below it by 15%. In between, it stays as it
+// is; the new scale aims for the middle of the band.
+#define HIGH_THRESHOLD 1.05f
+#define LOW_THRESHOLD 0.85f
+#define TARGET_RATIO 0.95f
+
+// The scale goes up by 10% at most at once, since a frame that got
+// lighter doesn't say much about how heavy a larger one would be. It
+// goes down as much as needed.
+#define MAX_INCREASE 1.1f
+
+// Smaller changes aren't worth a change of viewport.
+#define MIN_CHANGE 0.01f
+
+using namespace Render;
+
+ResolutionController::ResolutionController():
+	m_frameTimeBudget(0.f),
+	m_minScale(1.f),
+	m_maxScale(1.f),
+	m_scale(1.f),
+	m_averageFrameTime(0.f),
+	m_numberOfFrames(0),
+	m_framesSinceChange(0),
+	m_numberOfChanges(0)
+{
+}
+
+void ResolutionController::Init(float frameTimeBudget, float minScale, float maxScale)
+{
+	ASSERT(frameTimeBudget > 0.f);
+	ASSERT(minScale > 0.f && minScale <= maxScale);
+
+	m_frameTimeBudget = frameTimeBudget;
+	m_minScale = minScale;
+	m_maxScale = maxScale;
+	m_scale = maxScale;
+	m_averageFrameTime = 0.f;
+	m_numberOfFrames = 0;
+	m_framesSinceChange = 0;
+	m_numberOfChanges = 0;
+}
+
+float ResolutionController::Update(float frameTime)
+{
+	ASSERT(m_frameTimeBudget > 0.f);
+	ASSERT(frameTime >= 0.f);
+
+	m_averageFrameTime = (m_numberOfFrames == 0 ? frameTime :
+						  m_averageFrameTime + FRAME_TIME_SMOOTHING * (frameTime - m_averageFrameTime));
+	++m_numberOfFrames;
+	if (++m_framesSinceChange < FRAMES_BETWEEN_CHANGES ||
+		(m_averageFrameTime <= HIGH_THRESHOLD * m_frameTimeBudget &&
+		 m_averageFrameTime >= LOW_THRESHOLD * m_frameTimeBudget))
+	{
+		return m_scale;
+	}
+
+	// The number of pixels goes with the square of the scale.
+	float scale = m_maxScale;
+	if (m_averageFrameTime > 0.f)
+	{
+		scale = m_scale * sqrtf(TARGET_RATIO * m_frameTimeBudget / m_averageFrameTime);
+	}
+	scale = (scale < MAX_INCREASE * m_scale ? scale : MAX_INCREASE * m_scale);
+	scale = (scale < m_maxScale ? scale : m_maxScale);
+	scale = (scale > m_minScale ? scale : m_minScale);
+	if (fabsf(scale - m_scale) < MIN_CHANGE)
+	{
+		return m_scale;
+	}
+
+	// The average is of frames at the previous scale: it is corrected
+	// with the same assumption, rather than waiting for it to catch up,
+	// which would bring the scale further than needed.
+	m_averageFrameTime *= (scale * scale) / (m_scale * m_scale);
+	m_scale = scale;
+	m_framesSinceChange = 0;
+	++m_numberOfChanges;
+	return m_scale;
+}
+
+void ResolutionController::GetRenderSize(int width, int height,
+										 int* scaledWidth, int* scaledHeight) const
+{
+	ASSERT(scaledWidth != nullptr && scaledHeight != nullptr);
+
+	*scaledWidth = (int)(m_scale * width + 0.5f);
+	*scaledHeight = (int)(m_scale * height + 0.5f);
+	*scaledWidth = (*scaledWidth > 1 ? *scaledWidth : 1);
+	*scaledHeight = (*scaledHeight > 1 ? *scaledHeight : 1);
+}
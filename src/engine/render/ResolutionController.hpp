@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Render
+{
+	/// <summary>
+	/// Dynamic resolution: picks the scale of the render resolution from
+	/// the measured frame time, so the frame time stays within a budget.
+	///
+	/// The frame times are averaged over several frames, and the scale
+	/// only changes when the average leaves a band around the budget, and
+	/// after a few frames since the last change. The cost of a frame is
+	/// assumed to follow its number of pixels, so the new scale is chosen
+	/// for the average to come back in the middle of the band.
+	///
+	/// The scene is then rendered at the scaled size into a target of the
+	/// size at the maximum scale, and upscaled to the screen; see
+	/// Gfx::ScaledRenderTarget.
+	/// </summary>
+	class ResolutionController
+	{
+	public:
+		ResolutionController();
+
+		/// <summary>
+		/// Starts at the maximum scale.
+		/// </summary>
+		///
+		/// <param name="frameTimeBudget">Target frame time, in the unit
+		///     given to Update(), typically milliseconds.</param>
+		/// <param name="minScale">Smallest scale of the width and
+		///     height of the render resolution.</param>
+		/// <param name="maxScale">Largest scale, usually 1.</param>
+		void		Init(float frameTimeBudget, float minScale, float maxScale);
+
+		/// <summary>
+		/// Takes the time of the last frame, from the CPU or from a GPU
+		/// timer query, and returns the scale for the next frame.
+		/// </summary>
+		float		Update(float frameTime);
+
+		float		GetScale() const { return m_scale; }
+		float		GetAverageFrameTime() const { return m_averageFrameTime; }
+		int			GetNumberOfChanges() const { return m_numberOfChanges; }
+
+		/// <summary>
+		/// Size to render at for the current scale, from the size at
+		/// scale 1. It is at least one pixel.
+		/// </summary>
+		void		GetRenderSize(int width, int height,
+								  int* scaledWidth, int* scaledHeight) const;
+
+	private:
+		float		m_frameTimeBudget;
+		float		m_minScale;
+		float		m_maxScale;
+
+		float		m_scale;
+		float		m_averageFrameTime;
+		int			m_numberOfFrames; // Since Init().
+		int			m_framesSinceChange;
+		int			m_numberOfChanges;
+	};
+}
@@ -0,0 +1,649 @@
+#include "BlockCompression.hpp"
+
+#include "engine/debug/Assert.hpp"
+
+// The index selection processes four pixels at once with SSE2 when the
+// target has it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define USE_SSE2 0
+#endif
+
+using namespace Texture;
+
+//
+// Notes:
+//
+// All the formats interpolate between two endpoints. The endpoints are
+// the extremes of the block pixels along their principal axis, found by
+// power iteration on the covariance matrix. Each pixel then takes the
+// closest point of the palette, by projecting it on the segment between
+// the quantized endpoints.
+//
+// Good references on the formats:
+// https://learn.microsoft.com/en-us/windows/win32/direct3d11/texture-block-compression-in-direct3d-11
+// https://www.reedbeta.com/blog/understanding-bcn-texture-compression-formats/
+//
+
+// Pixels of a block, one array per channel, so consecutive pixels of a
+// channel can be loaded together.
+struct Block
+{
+	float	channels[4][16];
+};
+
+// Weights of the 16 BC7 palette entries, out of 64.
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static int getBlockSize(BlockFormat::Enum format)
+{
+	return (format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16);
+}
+
+int Texture::GetCompressedSize(BlockFormat::Enum format, int width, int height)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+// Pixels beyond the edges of the image repeat the last row or column.
+static void loadBlock(const unsigned char* pixels, int width, int height,
+					  int blockX, int blockY, Block* block)
+{
+	for (int j = 0; j < 4; ++j)
+	{
+		const int y = (4 * blockY + j < height ? 4 * blockY + j : height - 1);
+		for (int i = 0; i < 4; ++i)
+		{
+			const int x = (4 * blockX + i < width ? 4 * blockX + i : width - 1);
+			const unsigned char* pixel = pixels + 4 * (y * width + x);
+			for (int c = 0; c < 4; ++c)
+			{
+				block->channels[c][4 * j + i] = pixel[c];
+			}
+		}
+	}
+}
+
+// Finds endpoints for count channels starting from first.
+static void fitEndpoints(const Block& block, int first, int count, float* e0, float* e1)
+{
+	ASSERT(count >= 1 && count <= 4);
+
+	float mean[4];
+	for (int c = 0; c < count; ++c)
+	{
+		float sum = 0.f;
+		for (int i = 0; i < 16; ++i)
+		{
+			sum += block.channels[first + c][i];
+		}
+		mean[c] = sum / 16.f;
+	}
+
+	float covariance[4][4];
+	for (int a = 0; a < count; ++a)
+	{
+		for (int b = a; b < count; ++b)
+		{
+			float sum = 0.f;
+			for (int i = 0; i < 16; ++i)
+			{
+				sum += (block.channels[first + a][i] - mean[a]) * (block.channels[first + b][i] - mean[b]);
+			}
+			covariance[a][b] = sum;
+			covariance[b][a] = sum;
+		}
+	}
+
+	// Starting from the row of the largest variance, which can't be
+	// orthogonal to the principal axis unless the block is flat.
+	int largest = 0;
+	for (int c = 1; c < count; ++c)
+	{
+		if (covariance[c][c] > covariance[largest][largest])
+		{
+			largest = c;
+		}
+	}
+	float axis[4];
+	for (int c = 0; c < count; ++c)
+	{
+		axis[c] = covariance[largest][c];
+	}
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4];
+		float norm = 0.f;
+		for (int a = 0; a < count; ++a)
+		{
+			next[a] = 0.f;
+			for (int b = 0; b < count; ++b)
+			{
+				next[a] += covariance[a][b] * axis[b];
+			}
+			norm = (next[a] > norm ? next[a] : (-next[a] > norm ? -next[a] : norm));
+		}
+		if (norm < 1e-6f)
+		{
+			break;
+		}
+		for (int c = 0; c < count; ++c)
+		{
+			axis[c] = next[c] / norm;
+		}
+	}
+
+	float axisLength2 = 0.f;
+	for (int c = 0; c < count; ++c)
+	{
+		axisLength2 += axis[c] * axis[c];
+	}
+	if (axisLength2 < 1e-12f)
+	{
+		for (int c = 0; c < count; ++c)
+		{
+			e0[c] = mean[c];
+			e1[c] = mean[c];
+		}
+		return;
+	}
+
+	float tMin = 1e30f;
+	float tMax = -1e30f;
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = 0.f;
+		for (int c = 0; c < count; ++c)
+		{
+			t += (block.channels[first + c][i] - mean[c]) * axis[c];
+		}
+		tMin = (t < tMin ? t : tMin);
+		tMax = (t > tMax ? t : tMax);
+	}
+	for (int c = 0; c < count; ++c)
+	{
+		const float v0 = mean[c] + axis[c] * tMin / axisLength2;
+		const float v1 = mean[c] + axis[c] * tMax / axisLength2;
+		e0[c] = (v0 < 0.f ? 0.f : (v0 > 255.f ? 255.f : v0));
+		e1[c] = (v1 < 0.f ? 0.f : (v1 > 255.f ? 255.f : v1));
+	}
+}
+
+// Gives each pixel the closest of levels evenly spaced points from e0
+// (index 0) to e1 (index levels - 1).
+static void selectIndices(const Block& block, int first, int count,
+						  const float* e0, const float* e1, int levels,
+						  int* indices)
+{
+	float direction[4];
+	float length2 = 0.f;
+	for (int c = 0; c < count; ++c)
+	{
+		direction[c] = e1[c] - e0[c];
+		length2 += direction[c] * direction[c];
+	}
+	if (length2 == 0.f)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			indices[i] = 0;
+		}
+		return;
+	}
+	const float scale = (levels - 1) / length2;
+
+#if USE_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 last = _mm_set1_ps((float)(levels - 1));
+	const __m128 scale4 = _mm_set1_ps(scale);
+	for (int i = 0; i < 16; i += 4)
+	{
+		__m128 t = zero;
+		for (int c = 0; c < count; ++c)
+		{
+			const __m128 x = _mm_loadu_ps(&block.channels[first + c][i]);
+			const __m128 offset = _mm_sub_ps(x, _mm_set1_ps(e0[c]));
+			t = _mm_add_ps(t, _mm_mul_ps(offset, _mm_set1_ps(direction[c])));
+		}
+		t = _mm_add_ps(_mm_mul_ps(t, scale4), half);
+		t = _mm_min_ps(_mm_max_ps(t, zero), last);
+		_mm_storeu_si128((__m128i*)(indices + i), _mm_cvttps_epi32(t));
+	}
+#else // !USE_SSE2
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = 0.f;
+		for (int c = 0; c < count; ++c)
+		{
+			t += (block.channels[first + c][i] - e0[c]) * direction[c];
+		}
+		t = t * scale + 0.5f;
+		t = (t < 0.f ? 0.f : (t > levels - 1 ? levels - 1 : t));
+		indices[i] = (int)t;
+	}
+#endif // !USE_SSE2
+}
+
+//
+// BC1
+//
+
+static int quantize565(const float* color)
+{
+	const int r = (int)(color[0] * 31.f / 255.f + 0.5f);
+	const int g = (int)(color[1] * 63.f / 255.f + 0.5f);
+	const int b = (int)(color[2] * 31.f / 255.f + 0.5f);
+	return (r << 11) | (g << 5) | b;
+}
+
+static void expand565(int color, int* rgb)
+{
+	const int r = (color >> 11) & 31;
+	const int g = (color >> 5) & 63;
+	const int b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void compressBC1(const Block& block, unsigned char* output)
+{
+	float e0[3];
+	float e1[3];
+	fitEndpoints(block, 0, 3, e0, e1);
+
+	// The four color mode needs color0 > color1.
+	int color0 = quantize565(e0);
+	int color1 = quantize565(e1);
+	if (color0 < color1)
+	{
+		const int swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	unsigned int bits = 0;
+	if (color0 != color1)
+	{
+		int rgb0[3];
+		int rgb1[3];
+		expand565(color0, rgb0);
+		expand565(color1, rgb1);
+		const float q0[3] = { (float)rgb0[0], (float)rgb0[1], (float)rgb0[2] };
+		const float q1[3] = { (float)rgb1[0], (float)rgb1[1], (float)rgb1[2] };
+
+		// Palette order: color0, color1, 2/3 color0 + 1/3 color1, 1/3
+		// color0 + 2/3 color1.
+		static const unsigned int paletteIndex[4] = { 0, 2, 3, 1 };
+		int indices[16];
+		selectIndices(block, 0, 3, q0, q1, 4, indices);
+		for (int i = 0; i < 16; ++i)
+		{
+			bits |= paletteIndex[indices[i]] << (2 * i);
+		}
+	}
+
+	output[0] = (unsigned char)(color0 & 0xff);
+	output[1] = (unsigned char)(color0 >> 8);
+	output[2] = (unsigned char)(color1 & 0xff);
+	output[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; ++i)
+	{
+		output[4 + i] = (unsigned char)(bits >> (8 * i));
+	}
+}
+
+static void decompressBC1(const unsigned char* input, unsigned char* pixels, int stride)
+{
+	const int color0 = input[0] | (input[1] << 8);
+	const int color1 = input[2] | (input[3] << 8);
+	int palette[4][3];
+	expand565(color0, palette[0]);
+	expand565(color1, palette[1]);
+	for (int c = 0; c < 3; ++c)
+	{
+		if (color0 > color1)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	const unsigned int bits = input[4] | (input[5] << 8) | (input[6] << 16) | ((unsigned int)input[7] << 24);
+	for (int i = 0; i < 16; ++i)
+	{
+		const int* color = palette[(bits >> (2 * i)) & 3];
+		unsigned char* pixel = pixels + (i / 4) * stride + 4 * (i % 4);
+		pixel[0] = (unsigned char)color[0];
+		pixel[1] = (unsigned char)color[1];
+		pixel[2] = (unsigned char)color[2];
+		pixel[3] = 255;
+	}
+}
+
+//
+// BC4, and BC5 which is two BC4 blocks
+//
+
+static void compressBC4(const Block& block, int channel, unsigned char* output)
+{
+	float minimum = 255.f;
+	float maximum = 0.f;
+	for (int i = 0; i < 16; ++i)
+	{
+		const float value = block.channels[channel][i];
+		minimum = (value < minimum ? value : minimum);
+		maximum = (value > maximum ? value : maximum);
+	}
+
+	// The eight values mode needs red0 > red1.
+	const int red0 = (int)(maximum + 0.5f);
+	const int red1 = (int)(minimum + 0.5f);
+	unsigned long long bits = 0;
+	if (red0 > red1)
+	{
+		// Palette order: red0, red1, then the six values in between,
+		// from red0 to red1.
+		static const unsigned long long paletteIndex[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+		const float q0 = (float)red0;
+		const float q1 = (float)red1;
+		int indices[16];
+		selectIndices(block, channel, 1, &q0, &q1, 8, indices);
+		for (int i = 0; i < 16; ++i)
+		{
+			bits |= paletteIndex[indices[i]] << (3 * i);
+		}
+	}
+
+	output[0] = (unsigned char)red0;
+	output[1] = (unsigned char)red1;
+	for (int i = 0; i < 6; ++i)
+	{
+		output[2 + i] = (unsigned char)(bits >> (8 * i));
+	}
+}
+
+static void decompressBC4(const unsigned char* input, int channel, unsigned char* pixels, int stride)
+{
+	const int red0 = input[0];
+	const int red1 = input[1];
+	int palette[8] = { red0, red1 };
+	if (red0 > red1)
+	{
+		for (int k = 2; k < 8; ++k)
+		{
+			palette[k] = ((8 - k) * red0 + (k - 1) * red1) / 7;
+		}
+	}
+	else
+	{
+		for (int k = 2; k < 6; ++k)
+		{
+			palette[k] = ((6 - k) * red0 + (k - 1) * red1) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	unsigned long long bits = 0;
+	for (int i = 0; i < 6; ++i)
+	{
+		bits |= (unsigned long long)input[2 + i] << (8 * i);
+	}
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels[(i / 4) * stride + 4 * (i % 4) + channel] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+	}
+}
+
+//
+// BC7, mode 6 only: one subset, RGBA endpoints of 7 bits plus one
+// p-bit each, and 4 bits indices.
+//
+
+static void writeBits(unsigned long long* bits, int* position, unsigned int value, int count)
+{
+	for (int i = 0; i < count; ++i, ++*position)
+	{
+		if ((value >> i) & 1)
+		{
+			bits[*position / 64] |= 1ull << (*position % 64);
+		}
+	}
+}
+
+static unsigned int readBits(const unsigned long long* bits, int* position, int count)
+{
+	unsigned int value = 0;
+	for (int i = 0; i < count; ++i, ++*position)
+	{
+		value |= (unsigned int)((bits[*position / 64] >> (*position % 64)) & 1) << i;
+	}
+	return value;
+}
+
+static void compressBC7(const Block& block, unsigned char* output)
+{
+	float endpoints[2][4];
+	fitEndpoints(block, 0, 4, endpoints[0], endpoints[1]);
+
+	// Each endpoint picks the p-bit that gets it closest.
+	int quantized[2][4];
+	int pBits[2];
+	for (int e = 0; e < 2; ++e)
+	{
+		float bestError = 1e30f;
+		for (int p = 0; p < 2; ++p)
+		{
+			int values[4];
+			float error = 0.f;
+			for (int c = 0; c < 4; ++c)
+			{
+				const int v = (int)((endpoints[e][c] - p) / 2.f + 0.5f);
+				values[c] = (v < 0 ? 0 : (v > 127 ? 127 : v));
+				const float difference = (float)(2 * values[c] + p) - endpoints[e][c];
+				error += difference * difference;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pBits[e] = p;
+				for (int c = 0; c < 4; ++c)
+				{
+					quantized[e][c] = values[c];
+				}
+			}
+		}
+	}
+
+	float q[2][4];
+	for (int e = 0; e < 2; ++e)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			q[e][c] = (float)(2 * quantized[e][c] + pBits[e]);
+		}
+	}
+	int indices[16];
+	selectIndices(block, 0, 4, q[0], q[1], 16, indices);
+
+	// The first index is stored without its highest bit, which must
+	// be 0, so the endpoints are swapped otherwise.
+	if (indices[0] & 8)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			const int swap = quantized[0][c];
+			quantized[0][c] = quantized[1][c];
+			quantized[1][c] = swap;
+		}
+		const int swap = pBits[0];
+		pBits[0] = pBits[1];
+		pBits[1] = swap;
+		for (int i = 0; i < 16; ++i)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	unsigned long long bits[2] = { 0, 0 };
+	int position = 0;
+	writeBits(bits, &position, 1 << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writeBits(bits, &position, quantized[0][c], 7);
+		writeBits(bits, &position, quantized[1][c], 7);
+	}
+	writeBits(bits, &position, pBits[0], 1);
+	writeBits(bits, &position, pBits[1], 1);
+	writeBits(bits, &position, indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+	{
+		writeBits(bits, &position, indices[i], 4);
+	}
+	ASSERT(position == 128);
+
+	for (int i = 0; i < 16; ++i)
+	{
+		output[i] = (unsigned char)(bits[i / 8] >> (8 * (i % 8)));
+	}
+}
+
+static void decompressBC7(const unsigned char* input, unsigned char* pixels, int stride)
+{
+	unsigned long long bits[2] = { 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		bits[i / 8] |= (unsigned long long)input[i] << (8 * (i % 8));
+	}
+
+	int position = 0;
+	const unsigned int mode = readBits(bits, &position, 7);
+	ASSERT(mode == (1 << 6));
+	(void)mode;
+
+	int endpoints[2][4];
+	for (int c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = readBits(bits, &position, 7) << 1;
+		endpoints[1][c] = readBits(bits, &position, 7) << 1;
+	}
+	const int pBit0 = readBits(bits, &position, 1);
+	const int pBit1 = readBits(bits, &position, 1);
+	for (int c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] |= pBit0;
+		endpoints[1][c] |= pBit1;
+	}
+
+	for (int i = 0; i < 16; ++i)
+	{
+		const int weight = bc7Weights[readBits(bits, &position, (i == 0 ? 3 : 4))];
+		unsigned char* pixel = pixels + (i / 4) * stride + 4 * (i % 4);
+		for (int c = 0; c < 4; ++c)
+		{
+			pixel[c] = (unsigned char)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+		}
+	}
+}
+
+//
+// Images
+//
+
+void Texture::CompressBlockRows(BlockFormat::Enum format,
+								const unsigned char* pixels, int width, int height,
+								int firstBlockRow, int numberOfBlockRows,
+								void* output)
+{
+	ASSERT(width > 0 && height > 0);
+	ASSERT(firstBlockRow >= 0 && firstBlockRow + numberOfBlockRows <= (height + 3) / 4);
+
+	const int blocksPerRow = (width + 3) / 4;
+	const int blockSize = getBlockSize(format);
+	unsigned char* blocks = (unsigned char*)output + firstBlockRow * blocksPerRow * blockSize;
+
+	Block block;
+	for (int blockY = firstBlockRow; blockY < firstBlockRow + numberOfBlockRows; ++blockY)
+	{
+		for (int blockX = 0; blockX < blocksPerRow; ++blockX)
+		{
+			loadBlock(pixels, width, height, blockX, blockY, &block);
+			switch (format)
+			{
+			case BlockFormat::BC1: compressBC1(block, blocks); break;
+			case BlockFormat::BC4: compressBC4(block, 0, blocks); break;
+			case BlockFormat::BC5:
+				compressBC4(block, 0, blocks);
+				compressBC4(block, 1, blocks + 8);
+				break;
+			case BlockFormat::BC7: compressBC7(block, blocks); break;
+			}
+			blocks += blockSize;
+		}
+	}
+}
+
+void Texture::Compress(BlockFormat::Enum format,
+					   const unsigned char* pixels, int width, int height,
+					   void* output)
+{
+	CompressBlockRows(format, pixels, width, height, 0, (height + 3) / 4, output);
+}
+
+void Texture::Decompress(BlockFormat::Enum format,
+						 const void* blocks, int width, int height,
+						 unsigned char* pixels)
+{
+	ASSERT(width > 0 && height > 0);
+
+	const int blockSize = getBlockSize(format);
+	const unsigned char* input = (const unsigned char*)blocks;
+	for (int blockY = 0; blockY < (height + 3) / 4; ++blockY)
+	{
+		for (int blockX = 0; blockX < (width + 3) / 4; ++blockX)
+		{
+			// Decoded in a whole block first, since the image may end in
+			// the middle of it.
+			unsigned char decoded[4 * 4 * 4];
+			for (int i = 0; i < 16; ++i)
+			{
+				decoded[4 * i + 0] = 0;
+				decoded[4 * i + 1] = 0;
+				decoded[4 * i + 2] = 0;
+				decoded[4 * i + 3] = 255;
+			}
+			switch (format)
+			{
+			case BlockFormat::BC1: decompressBC1(input, decoded, 16); break;
+			case BlockFormat::BC4: decompressBC4(input, 0, decoded, 16); break;
+			case BlockFormat::BC5:
+				decompressBC4(input, 0, decoded, 16);
+				decompressBC4(input + 8, 1, decoded, 16);
+				break;
+			case BlockFormat::BC7: decompressBC7(input, decoded, 16); break;
+			}
+			input += blockSize;
+
+			for (int j = 0; j < 4 && 4 * blockY + j < height; ++j)
+			{
+				for (int i = 0; i < 4 && 4 * blockX + i < width; ++i)
+				{
+					unsigned char* pixel = pixels + 4 * ((4 * blockY + j) * width + 4 * blockX + i);
+					for (int c = 0; c < 4; ++c)
+					{
+						pixel[c] = decoded[4 * (4 * j + i) + c];
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+namespace Texture
+{
+	/// <summary>
+	/// Block compressed formats. Each block encodes 4x4 pixels.
+	/// </summary>
+	struct BlockFormat
+	{
+		enum Enum {
+			BC1, // RGB, 8 bytes per block. DXT1 / S3TC in OpenGL.
+			BC4, // R, 8 bytes per block. RGTC1 in OpenGL.
+			BC5, // RG, 16 bytes per block. RGTC2 in OpenGL.
+			BC7, // RGBA, 16 bytes per block. BPTC in OpenGL.
+		};
+	};
+
+	/// <summary>
+	/// Size in bytes of an image once compressed. Partial blocks on the
+	/// right and bottom edges take a whole block.
+	/// </summary>
+	int		GetCompressedSize(BlockFormat::Enum format, int width, int height);
+
+	/// <summary>
+	/// Compresses a range of block rows of an RGBA8 image. Ranges can be
+	/// compressed on different threads, since blocks are independent.
+	/// BC7 blocks are all encoded in mode 6, which has a single subset.
+	/// </summary>
+	///
+	/// <param name="pixels">The whole RGBA8 image.</param>
+	/// <param name="firstBlockRow">First row of blocks to compress;
+	///     block row n covers pixel rows 4n to 4n+3.</param>
+	/// <param name="output">The compressed image, as laid out for
+	///     glCompressedTexImage2D. Only the given rows are written.</param>
+	void	CompressBlockRows(BlockFormat::Enum format,
+							  const unsigned char* pixels, int width, int height,
+							  int firstBlockRow, int numberOfBlockRows,
+							  void* output);
+
+	/// <summary>
+	/// Compresses a whole RGBA8 image on the calling thread.
+	/// </summary>
+	void	Compress(BlockFormat::Enum format,
+					 const unsigned char* pixels, int width, int height,
+					 void* output);
+
+	/// <summary>
+	/// Decodes an image compressed by Compress back to RGBA8, to measure
+	/// the quality. Missing channels are 0, and alpha 255. Only mode 6
+	/// is supported for BC7.
+	/// </summary>
+	void	Decompress(BlockFormat::Enum format,
+					   const void* blocks, int width, int height,
+					   unsigned char* pixels);
+}
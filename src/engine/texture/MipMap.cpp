@@ -0,0 +1,198 @@
+#include "MipMap.hpp"
+
+#include "engine/debug/Assert.hpp"
+#include <cmath>
+
+// The four channels of a pixel are filtered at once with SSE when the
+// target has it.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_SSE 0
+#endif
+
+using namespace Texture;
+
+//
+// Notes:
+//
+// Each pixel of the next level is centered between two pixels of the
+// source, so the filter has an even number of taps, at half-pixel
+// distances. With 8 taps, the sinc is windowed over 4 source pixels on
+// each side. The Kaiser window keeps more sharpness than a box or a
+// tent, with less ringing than Lanczos on high contrast edges.
+//
+// The filter is separable: each output row is the weighted sum of 8
+// source rows, then each output pixel the weighted sum of 8 pixels of
+// that row.
+//
+
+#define NUMBER_OF_TAPS 8
+#define FILTER_RADIUS 4.f
+#define KAISER_ALPHA 4.f
+
+static const float pi = 3.14159265358979f;
+
+// Modified Bessel function of the first kind, of order 0.
+static float besselI0(float x)
+{
+	float sum = 1.f;
+	float term = 1.f;
+	for (int k = 1; k < 16; ++k)
+	{
+		const float t = x / (2.f * k);
+		term *= t * t;
+		sum += term;
+	}
+	return sum;
+}
+
+static void computeWeights(float* weights)
+{
+	float sum = 0.f;
+	for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+	{
+		// Distance in source pixels; the sinc has its zeros at the
+		// multiples of 2, the period of the next level.
+		const float x = k - (NUMBER_OF_TAPS - 1) * 0.5f;
+		const float t = pi * x * 0.5f;
+		const float sinc = std::sin(t) / t;
+		const float u = x / FILTER_RADIUS;
+		const float window = besselI0(KAISER_ALPHA * std::sqrt(1.f - u * u)) / besselI0(KAISER_ALPHA);
+		weights[k] = sinc * window;
+		sum += weights[k];
+	}
+	for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+	{
+		weights[k] /= sum;
+	}
+}
+
+static int mapCoordinate(int x, int size, bool wrap)
+{
+	if (wrap)
+	{
+		x %= size;
+		return (x < 0 ? x + size : x);
+	}
+	return (x < 0 ? 0 : (x >= size ? size - 1 : x));
+}
+
+int Texture::GetNumberOfMipLevels(int width, int height)
+{
+	int levels = 1;
+	for (int size = (width > height ? width : height); size > 1; size /= 2)
+	{
+		++levels;
+	}
+	return levels;
+}
+
+int Texture::GetMipLevelSize(int size, int level)
+{
+	size >>= level;
+	return (size > 0 ? size : 1);
+}
+
+void Texture::DownsampleRows(const float* source, int width, int height, bool wrap,
+							 int firstRow, int numberOfRows,
+							 float* destination)
+{
+	const int destinationWidth = GetMipLevelSize(width, 1);
+	ASSERT(width > 0 && height > 0);
+	ASSERT(firstRow >= 0 && firstRow + numberOfRows <= GetMipLevelSize(height, 1));
+
+	float weights[NUMBER_OF_TAPS];
+	computeWeights(weights);
+
+	// One filtered row, with the pixels beyond the edges the horizontal
+	// pass needs on each side.
+	const int padBefore = NUMBER_OF_TAPS / 2 - 1;
+	const int padAfter = NUMBER_OF_TAPS / 2;
+	float* row = new float[4 * (padBefore + width + padAfter)];
+	float* rowStart = row + 4 * padBefore;
+
+	for (int j = firstRow; j < firstRow + numberOfRows; ++j)
+	{
+		const float* sourceRows[NUMBER_OF_TAPS];
+		for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+		{
+			const int y = mapCoordinate(2 * j + k - padBefore, height, wrap);
+			sourceRows[k] = source + 4 * y * width;
+		}
+
+		// Vertical pass.
+#if USE_SSE
+		for (int x = 0; x < width; ++x)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(sourceRows[k] + 4 * x)));
+			}
+			_mm_storeu_ps(rowStart + 4 * x, sum);
+		}
+#else // !USE_SSE
+		for (int x = 0; x < 4 * width; ++x)
+		{
+			float sum = 0.f;
+			for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+			{
+				sum += weights[k] * sourceRows[k][x];
+			}
+			rowStart[x] = sum;
+		}
+#endif // !USE_SSE
+
+		for (int x = -padBefore; x < 0; ++x)
+		{
+			const float* pixel = rowStart + 4 * mapCoordinate(x, width, wrap);
+			for (int c = 0; c < 4; ++c)
+			{
+				rowStart[4 * x + c] = pixel[c];
+			}
+		}
+		for (int x = width; x < width + padAfter; ++x)
+		{
+			const float* pixel = rowStart + 4 * mapCoordinate(x, width, wrap);
+			for (int c = 0; c < 4; ++c)
+			{
+				rowStart[4 * x + c] = pixel[c];
+			}
+		}
+
+		// Horizontal pass.
+		float* output = destination + 4 * j * destinationWidth;
+		for (int i = 0; i < destinationWidth; ++i)
+		{
+			const float* pixels = row + 4 * 2 * i;
+#if USE_SSE
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(pixels + 4 * k)));
+			}
+			_mm_storeu_ps(output + 4 * i, sum);
+#else // !USE_SSE
+			for (int c = 0; c < 4; ++c)
+			{
+				float sum = 0.f;
+				for (int k = 0; k < NUMBER_OF_TAPS; ++k)
+				{
+					sum += weights[k] * pixels[4 * k + c];
+				}
+				output[4 * i + c] = sum;
+			}
+#endif // !USE_SSE
+		}
+	}
+
+	delete[] row;
+}
+
+void Texture::Downsample(const float* source, int width, int height, bool wrap,
+						 float* destination)
+{
+	DownsampleRows(source, width, height, wrap, 0, GetMipLevelSize(height, 1), destination);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace Texture
+{
+	/// <summary>
+	/// Number of levels of a full mip chain, down to 1x1.
+	/// </summary>
+	int		GetNumberOfMipLevels(int width, int height);
+
+	/// <summary>
+	/// Size of a mip level along one axis: half of the previous level,
+	/// rounded down, and at least 1.
+	/// </summary>
+	int		GetMipLevelSize(int size, int level);
+
+	/// <summary>
+	/// Computes a range of rows of the next mip level of an RGBA float
+	/// image, with a Kaiser windowed sinc filter. Ranges can be computed
+	/// on different threads, since they only read the source image.
+	/// </summary>
+	///
+	/// <param name="source">The whole RGBA float image.</param>
+	/// <param name="wrap">True if the image tiles, so the filter wraps
+	///     around the edges; they are clamped otherwise.</param>
+	/// <param name="destination">The next level, of size
+	///     GetMipLevelSize(width, 1) by GetMipLevelSize(height, 1).
+	///     Only the given rows are written.</param>
+	void	DownsampleRows(const float* source, int width, int height, bool wrap,
+						   int firstRow, int numberOfRows,
+						   float* destination);
+
+	/// <summary>
+	/// Computes the whole next mip level on the calling thread.
+	/// </summary>
+	void	Downsample(const float* source, int width, int height, bool wrap,
+					   float* destination);
+}
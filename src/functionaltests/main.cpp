@@ -1,7 +1,29 @@
 #include "engine/container/Utils.hpp"
+#include "engine/noise/Rand.hpp"
+#include "engine/render/Culler.hpp"
+#include "engine/render/ResolutionController.hpp"
+#include "gfx/Barrier.hpp"
+#include "gfx/CaptureLayer.hpp"
+#include "gfx/CaptureReplay.hpp"
+#include "gfx/DrawArea.hpp"
+#include "gfx/DrawItem.hpp"
+#include "gfx/FrameStats.hpp"
+#include "gfx/Geometry.hpp"
+#include "gfx/GeometryHeap.hpp"
+#include "gfx/GpuCuller.hpp"
+#include "gfx/GpuProfiler.hpp"
+#include "gfx/Null/NullLayer.hpp"
 #include "gfx/OpenGL/OpenGLLayer.hpp"
+#include "gfx/RasterTests.hpp"
+#include "gfx/RecordingLayer.hpp"
+#include "gfx/RenderTargetPool.hpp"
+#include "gfx/ScaledRenderTarget.hpp"
 #include "gfx/ShadingParameters.hpp"
+#include "gfx/TextureArrayAllocator.hpp"
+#include "platform/MultiThreading.hpp"
 #include "platform/Platform.hpp"
+#include <cmath>
+#include <cstdio>
 
 #if DEBUG
 #include <iostream>
@@ -63,6 +85,111 @@ bool StorageBufferTest(Gfx::IGraphicLayer* gfxLayer)
 	return true;
 }
 
+bool AsyncReadbackTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_ASYNC_READBACK && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	std::uint32_t testData[1024];
+	for (int i = 0; i < (int)ARRAY_LEN(testData); ++i)
+	{
+		testData[i] = 7 * i + 3;
+	}
+	const Gfx::StorageBufferID storageBuffer = gfxLayer->CreateStorageBuffer();
+	gfxLayer->LoadStorageBuffer(storageBuffer, sizeof(testData), testData);
+
+	// A range in the middle of the buffer.
+	const Gfx::ReadbackID bufferReadback = gfxLayer->RequestReadback(storageBuffer, 256 * 4, 128 * 4);
+	if (bufferReadback == Gfx::ReadbackID::InvalidID)
+	{
+		return false;
+	}
+
+	// A rectangle of a cleared frame buffer.
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Nearest,
+		Gfx::TextureFilter::Nearest,
+		1.f,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+	};
+	const Gfx::TextureID texture = gfxLayer->CreateTexture();
+	gfxLayer->LoadTexture(texture, 16, 16, Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+						  0, 0, nullptr, sampling);
+	const Gfx::FrameBufferID frameBuffer = gfxLayer->CreateFrameBuffer(&texture, 1, 0, 0);
+	gfxLayer->ClearFrameBuffer(frameBuffer, 1.f, 0.f, 1.f, false);
+	const Gfx::ReadbackID pixelsReadback = gfxLayer->RequestReadback(frameBuffer, 4, 4, 8, 8);
+	if (pixelsReadback == Gfx::ReadbackID::InvalidID)
+	{
+		return false;
+	}
+
+	// Frames go by until both are done.
+	std::uint32_t readData[128];
+	unsigned char pixels[8 * 8 * 4];
+	bool bufferDone = false;
+	bool pixelsDone = false;
+	while (!bufferDone || !pixelsDone)
+	{
+		gfxLayer->EndFrame();
+		bufferDone = bufferDone || gfxLayer->TryGetReadback(bufferReadback, readData);
+		pixelsDone = pixelsDone || gfxLayer->TryGetReadback(pixelsReadback, pixels);
+	}
+	if (memcmp(readData, testData + 256, sizeof(readData)) != 0)
+	{
+		return false;
+	}
+	for (int i = 0; i < 8 * 8; ++i)
+	{
+		if (pixels[4 * i] != 255 || pixels[4 * i + 1] != 0 || pixels[4 * i + 2] != 255)
+		{
+			return false;
+		}
+	}
+
+	// Once every staging buffer holds a readback, requests fail until
+	// one is retrieved.
+	Gfx::ReadbackID readbacks[GFX_READBACK_BUFFERS];
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		readbacks[i] = gfxLayer->RequestReadback(storageBuffer, 4 * i, 4);
+		if (readbacks[i] == Gfx::ReadbackID::InvalidID)
+		{
+			return false;
+		}
+	}
+	if (gfxLayer->RequestReadback(storageBuffer, 0, 4) != Gfx::ReadbackID::InvalidID)
+	{
+		return false;
+	}
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		std::uint32_t value = 0;
+		while (!gfxLayer->TryGetReadback(readbacks[i], &value))
+		{
+			gfxLayer->EndFrame();
+		}
+		if (value != testData[i])
+		{
+			return false;
+		}
+	}
+
+	// Retrieved tickets aren't valid anymore.
+	std::uint32_t value = 0;
+	if (gfxLayer->TryGetReadback(readbacks[0], &value) ||
+		gfxLayer->TryGetReadback(Gfx::ReadbackID::InvalidID, &value))
+	{
+		return false;
+	}
+
+	gfxLayer->DestroyFrameBuffer(frameBuffer);
+	gfxLayer->DestroyTexture(texture);
+	gfxLayer->DestroyStorageBuffer(storageBuffer);
+#endif // GFX_ENABLE_ASYNC_READBACK && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	return true;
+}
+
 bool ComputeShaderTest(Gfx::IGraphicLayer* gfxLayer)
 {
 #if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
@@ -126,6 +253,444 @@ bool ComputeShaderTest(Gfx::IGraphicLayer* gfxLayer)
 	return true;
 }
 
+bool ChainedComputeTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	// Three passes chained on the GPU: the first keeps the multiples of
+	// 3 of the input, the second computes how many work groups the third
+	// needs to double them, and the third is dispatched with that number
+	// without the CPU reading it.
+	const int inputSize = 1024;
+	std::uint32_t inputData[inputSize];
+	std::uint32_t expectedCount = 0;
+	std::uint32_t expectedSum = 0;
+	for (int i = 0; i < inputSize; ++i)
+	{
+		inputData[i] = i;
+		if (i % 3 == 0)
+		{
+			++expectedCount;
+			expectedSum += 2 * i;
+		}
+	}
+
+	const char* compactShaderSource = R"(
+        #version 450
+        layout(local_size_x = 64) in;
+        layout(std430) buffer Input {
+            uint inputValues[];
+        };
+        layout(std430) buffer Counter {
+            uint count;
+        };
+        layout(std430) buffer Compacted {
+            uint compactedValues[];
+        };
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (inputValues[i] % 3 == 0) {
+                compactedValues[atomicAdd(count, 1)] = inputValues[i];
+            }
+        }
+    )";
+	const char* argumentsShaderSource = R"(
+        #version 450
+        layout(local_size_x = 1) in;
+        layout(std430) buffer Counter {
+            uint count;
+        };
+        layout(std430) buffer Arguments {
+            uint groups[3];
+        };
+        void main() {
+            groups[0] = (count + 63) / 64;
+            groups[1] = 1;
+            groups[2] = 1;
+        }
+    )";
+	const char* doubleShaderSource = R"(
+        #version 450
+        layout(local_size_x = 64) in;
+        layout(std430) buffer Counter {
+            uint count;
+        };
+        layout(std430) buffer Compacted {
+            uint compactedValues[];
+        };
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (i < count) {
+                compactedValues[i] *= 2;
+            }
+        }
+    )";
+	const char* sources[3] = { compactShaderSource, argumentsShaderSource, doubleShaderSource };
+	Gfx::ShaderID shaders[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		shaders[i] = gfxLayer->CreateShader();
+		const Gfx::ShaderStage shaderStage = { Gfx::ShaderType::ComputeShader, sources[i], __FILE__ };
+		gfxLayer->LoadShader(shaders[i], &shaderStage, 1);
+	}
+
+	const std::uint32_t zero[3] = {};
+	Gfx::StorageBufferID input = gfxLayer->CreateStorageBuffer();
+	Gfx::StorageBufferID counter = gfxLayer->CreateStorageBuffer();
+	Gfx::StorageBufferID compacted = gfxLayer->CreateStorageBuffer();
+	Gfx::StorageBufferID arguments = gfxLayer->CreateStorageBuffer();
+	gfxLayer->LoadStorageBuffer(input, sizeof(inputData), inputData);
+	gfxLayer->LoadStorageBuffer(counter, sizeof(std::uint32_t), zero);
+	gfxLayer->LoadStorageBuffer(compacted, sizeof(inputData), nullptr);
+	gfxLayer->LoadStorageBuffer(arguments, sizeof(zero), zero);
+
+	Gfx::Uniform inputUniform = { "Input", 1, Gfx::UniformType::StorageBufferInput, {} };
+	Gfx::Uniform counterInput = { "Counter", 1, Gfx::UniformType::StorageBufferInput, {} };
+	Gfx::Uniform counterOutput = { "Counter", 1, Gfx::UniformType::StorageBufferOutput, {} };
+	Gfx::Uniform compactedOutput = { "Compacted", 1, Gfx::UniformType::StorageBufferOutput, {} };
+	Gfx::Uniform argumentsOutput = { "Arguments", 1, Gfx::UniformType::StorageBufferOutput, {} };
+	inputUniform.storageBufferId = input;
+	counterInput.storageBufferId = counter;
+	counterOutput.storageBufferId = counter;
+	compactedOutput.storageBufferId = compacted;
+	argumentsOutput.storageBufferId = arguments;
+
+	Gfx::ComputeParameters computeParameters = Gfx::ComputeParameters();
+	computeParameters.uniforms.add(inputUniform);
+	computeParameters.uniforms.add(counterOutput);
+	computeParameters.uniforms.add(compactedOutput);
+	gfxLayer->Compute(shaders[0], computeParameters, inputSize / 64);
+	gfxLayer->InsertMemoryBarrier(Gfx::Barrier::StorageBuffer);
+
+	computeParameters.uniforms.clear();
+	computeParameters.uniforms.add(counterInput);
+	computeParameters.uniforms.add(argumentsOutput);
+	gfxLayer->Compute(shaders[1], computeParameters, 1);
+	gfxLayer->InsertMemoryBarrier(Gfx::Barrier::StorageBuffer | Gfx::Barrier::IndirectArguments);
+
+	computeParameters.uniforms.clear();
+	computeParameters.uniforms.add(counterInput);
+	computeParameters.uniforms.add(compactedOutput);
+	gfxLayer->ComputeIndirect(shaders[2], computeParameters, arguments, 0);
+
+	// Read back and validate: the compacted values are in no particular
+	// order.
+	std::uint32_t count = 0;
+	std::uint32_t groups[3] = {};
+	std::uint32_t outputData[inputSize];
+	gfxLayer->ReadStorageBuffer(counter, sizeof(count), &count);
+	gfxLayer->ReadStorageBuffer(arguments, sizeof(groups), groups);
+	gfxLayer->ReadStorageBuffer(compacted, sizeof(outputData), outputData);
+
+	bool result = (count == expectedCount && groups[0] == (expectedCount + 63) / 64);
+	std::uint32_t sum = 0;
+	for (std::uint32_t i = 0; result && i < count; ++i)
+	{
+		result = (outputData[i] % 6 == 0);
+		sum += outputData[i];
+	}
+	result = result && (sum == expectedSum);
+
+	gfxLayer->DestroyStorageBuffer(arguments);
+	gfxLayer->DestroyStorageBuffer(compacted);
+	gfxLayer->DestroyStorageBuffer(counter);
+	gfxLayer->DestroyStorageBuffer(input);
+	for (int i = 0; i < 3; ++i)
+	{
+		gfxLayer->DestroyShader(shaders[i]);
+	}
+	if (!result)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	return true;
+}
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+// CPU reference of the culling shader. Returns by how much the box of
+// the instance is inside of the frustum: it is visible if it isn't
+// negative.
+static float frustumMargin(const Gfx::GpuCuller::Instance& instance, const float planes[6][4])
+{
+	float center[3];
+	float halfSize[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		center[i] = 0.5f * (instance.boundsMax[i] + instance.boundsMin[i]);
+		halfSize[i] = 0.5f * (instance.boundsMax[i] - instance.boundsMin[i]);
+	}
+	float worldCenter[3];
+	float worldHalfSize[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		const float* row = instance.transform + 4 * i;
+		worldCenter[i] = row[0] * center[0] + row[1] * center[1] + row[2] * center[2] + row[3];
+		worldHalfSize[i] = fabsf(row[0]) * halfSize[0] + fabsf(row[1]) * halfSize[1] + fabsf(row[2]) * halfSize[2];
+	}
+	float margin = 1e30f;
+	for (int p = 0; p < 6; ++p)
+	{
+		const float* plane = planes[p];
+		const float distance = plane[0] * worldCenter[0] + plane[1] * worldCenter[1] + plane[2] * worldCenter[2] + plane[3] +
+			fabsf(plane[0]) * worldHalfSize[0] + fabsf(plane[1]) * worldHalfSize[1] + fabsf(plane[2]) * worldHalfSize[2];
+		margin = (distance < margin ? distance : margin);
+	}
+	return margin;
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+bool GpuCullerTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	// Boxes of random sizes and orientations, around and behind a camera
+	// looking down -z, with a 90 degrees field of view.
+	const int numberOfInstances = 1000;
+	Gfx::GpuCuller::Instance* instances = new Gfx::GpuCuller::Instance[numberOfInstances];
+	Noise::Rand rand(42);
+	for (int i = 0; i < numberOfInstances; ++i)
+	{
+		Gfx::GpuCuller::Instance& instance = instances[i];
+		const float angle = rand.fgen(0.f, 6.2831853f);
+		const float c = cosf(angle);
+		const float s = sinf(angle);
+		const float transform[12] = {
+			   c, 0.f,   s, rand.fgen(-60.f, 60.f),
+			 0.f, 1.f, 0.f, rand.fgen(-60.f, 60.f),
+			  -s, 0.f,   c, rand.fgen(-110.f, 10.f),
+		};
+		memcpy(instance.transform, transform, sizeof(transform));
+		for (int j = 0; j < 3; ++j)
+		{
+			const float halfSize = rand.fgen(0.5f, 3.f);
+			instance.boundsMin[j] = -halfSize;
+			instance.boundsMax[j] = halfSize;
+		}
+		instance.boundsMin[3] = 0.f;
+		instance.boundsMax[3] = 0.f;
+	}
+	const float n = 1.f;
+	const float f = 100.f;
+	const float projection[16] = {
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, -(f + n) / (f - n), -1.f,
+		0.f, 0.f, -2.f * f * n / (f - n), 0.f,
+	};
+	float planes[6][4];
+	Gfx::GpuCuller::ExtractPlanes(projection, planes);
+
+	Gfx::GpuCuller culler;
+	culler.Init(gfxLayer, numberOfInstances);
+	culler.SetInstances(instances, numberOfInstances);
+	culler.Cull(planes, 3);
+
+	// Each visible instance is drawn once over a small frame buffer,
+	// and marks itself as drawn.
+	const char* vertexShaderSource = R"(
+        #version 450
+        in vec3 position;
+        layout(std430) buffer VisibleInstances {
+            uint visibleInstances[];
+        };
+        flat out uint instance;
+        void main() {
+            instance = visibleInstances[gl_InstanceID];
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
+	const char* fragmentShaderSource = R"(
+        #version 450
+        flat in uint instance;
+        layout(std430) buffer Drawn {
+            uint drawn[];
+        };
+        out vec4 color;
+        void main() {
+            drawn[instance] = 1;
+            color = vec4(1.0);
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = { -1.f, -1.f, 0.f, 3.f, -1.f, 0.f, -1.f, 3.f, 0.f };
+	const unsigned short indices[] = { 0, 1, 2 };
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Nearest,
+		Gfx::TextureFilter::Nearest,
+		1.f,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+	};
+
+	const Gfx::TextureID texture = gfxLayer->CreateTexture();
+	gfxLayer->LoadTexture(texture, 4, 4, Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+						  0, 0, nullptr, sampling);
+	const Gfx::DrawArea drawArea = { gfxLayer->CreateFrameBuffer(&texture, 1, 0, 0), { 0, 0, 4, 4 } };
+	const Gfx::VertexBufferID vertexBuffer = gfxLayer->CreateVertexBuffer();
+	gfxLayer->LoadVertexBuffer(vertexBuffer, Gfx::PrimitiveType::Triangles,
+							   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+							   sizeof(vertices), vertices,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+	std::uint32_t* drawn = new std::uint32_t[numberOfInstances];
+	memset(drawn, 0, numberOfInstances * sizeof(std::uint32_t));
+	const Gfx::StorageBufferID drawnBuffer = gfxLayer->CreateStorageBuffer();
+	gfxLayer->LoadStorageBuffer(drawnBuffer, numberOfInstances * sizeof(std::uint32_t), drawn);
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+	shadingParameters.uniforms.add(Gfx::Uniform::StorageBufferInput1("VisibleInstances", culler.GetVisibleInstances()));
+	shadingParameters.uniforms.add(Gfx::Uniform::StorageBufferOutput1("Drawn", drawnBuffer));
+	gfxLayer->DrawIndirect(drawArea, Gfx::RasterTests::NoDepthTest, vertexBuffer,
+						   shadingParameters, culler.GetArguments(), 0);
+
+	// Compare with the CPU reference. The shader may round differently,
+	// so boxes that touch a plane can go either way.
+	std::uint32_t arguments[5] = {};
+	gfxLayer->ReadStorageBuffer(culler.GetArguments(), sizeof(arguments), arguments);
+	gfxLayer->ReadStorageBuffer(drawnBuffer, numberOfInstances * sizeof(std::uint32_t), drawn);
+	bool result = (arguments[0] == 3 && arguments[1] > 0 && arguments[1] < (std::uint32_t)numberOfInstances);
+	std::uint32_t numberOfDrawn = 0;
+	for (int i = 0; result && i < numberOfInstances; ++i)
+	{
+		const float margin = frustumMargin(instances[i], planes);
+		result = (drawn[i] == (margin >= 0.f ? 1u : 0u) || fabsf(margin) < 1e-3f);
+		numberOfDrawn += drawn[i];
+	}
+	result = result && (numberOfDrawn == arguments[1]);
+
+	// A frustum that contains nothing draws nothing.
+	const float emptyPlanes[6][4] = { { 0.f, 0.f, 0.f, -1.f } };
+	culler.Cull(emptyPlanes, 3);
+	gfxLayer->ReadStorageBuffer(culler.GetArguments(), sizeof(arguments), arguments);
+	result = result && (arguments[1] == 0);
+
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	gfxLayer->DestroyStorageBuffer(drawnBuffer);
+	gfxLayer->DestroyVertexBuffer(vertexBuffer);
+	gfxLayer->DestroyFrameBuffer(drawArea.frameBuffer);
+	gfxLayer->DestroyTexture(texture);
+	culler.Shutdown();
+	delete[] drawn;
+	delete[] instances;
+	if (!result)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	return true;
+}
+
+// Runs the jobs of Render::Culler on threads, the first one on the
+// calling thread rather than waiting.
+static void runCullingJobs(void*, Render::Culler::Job job, void* const* args, int numberOfJobs)
+{
+	platform::ThreadData threads[MAX_THREADS_CULLING];
+	for (int i = 1; i < numberOfJobs; ++i)
+	{
+		platform::MultiThreading::StartThread(&threads[i - 1], job, args[i]);
+	}
+	job(args[0]);
+	platform::MultiThreading::WaitAllThreads(threads, numberOfJobs - 1);
+}
+
+// CPU reference of Render::Culler, one object and one plane at a time.
+// Returns by how much the object is inside of the frustum: it is
+// visible if it isn't negative.
+static float cullerMargin(const float center[3], float radius, const float halfSize[3], const float planes[6][4])
+{
+	float margin = 1e30f;
+	for (int p = 0; p < 6; ++p)
+	{
+		const float* plane = planes[p];
+		const float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+#if ENABLE_SPHERE_CULLING
+		margin = (distance + radius < margin ? distance + radius : margin);
+#endif // ENABLE_SPHERE_CULLING
+#if ENABLE_AABB_CULLING
+		const float extent = fabsf(plane[0]) * halfSize[0] + fabsf(plane[1]) * halfSize[1] + fabsf(plane[2]) * halfSize[2];
+		margin = (distance + extent < margin ? distance + extent : margin);
+#endif // ENABLE_AABB_CULLING
+	}
+	return margin;
+}
+
+// Checks that a list of indices is increasing, and matches the
+// reference margins of the objects from first to first + count.
+static bool checkVisibleObjects(const int* visible, int numberOfVisible,
+								const float* margins, int first, int count)
+{
+	int next = 0;
+	for (int i = first; i < first + count; ++i)
+	{
+		const bool listed = (next < numberOfVisible && visible[next] == i);
+		next += (listed ? 1 : 0);
+
+		// Objects that touch a plane can go either way.
+		if (listed != (margins[i] >= 0.f) && fabsf(margins[i]) >= 1e-3f)
+		{
+			return false;
+		}
+	}
+	return next == numberOfVisible;
+}
+
+bool CullerTest(Gfx::IGraphicLayer*)
+{
+	// Boxes around and behind a camera looking down -z, with a 90
+	// degrees field of view. There are enough of them to be split
+	// between jobs, and the number isn't a multiple of the SIMD width.
+	const int numberOfObjects = 100003;
+	const float s = 0.70710678f;
+	const float planes[6][4] = {
+		{    s,  0.f,   -s,   0.f }, // Left.
+		{   -s,  0.f,   -s,   0.f }, // Right.
+		{  0.f,    s,   -s,   0.f }, // Bottom.
+		{  0.f,   -s,   -s,   0.f }, // Top.
+		{  0.f,  0.f, -1.f,  -1.f }, // Near.
+		{  0.f,  0.f,  1.f, 100.f }, // Far.
+	};
+
+	Render::Culler culler;
+	culler.Init(numberOfObjects);
+	float* margins = new float[numberOfObjects];
+	Noise::Rand rand(7);
+	for (int i = 0; i < numberOfObjects; ++i)
+	{
+		const float center[3] = { rand.fgen(-60.f, 60.f), rand.fgen(-60.f, 60.f), rand.fgen(-110.f, 10.f) };
+		const float halfSize[3] = { rand.fgen(0.5f, 3.f), rand.fgen(0.5f, 3.f), rand.fgen(0.5f, 3.f) };
+		const float radius = sqrtf(halfSize[0] * halfSize[0] + halfSize[1] * halfSize[1] + halfSize[2] * halfSize[2]);
+		const float boundsMin[3] = { center[0] - halfSize[0], center[1] - halfSize[1], center[2] - halfSize[2] };
+		const float boundsMax[3] = { center[0] + halfSize[0], center[1] + halfSize[1], center[2] + halfSize[2] };
+		culler.Add(center, radius, boundsMin, boundsMax);
+		margins[i] = cullerMargin(center, radius, halfSize, planes);
+	}
+
+	int* visible = new int[numberOfObjects];
+	const int numberOfVisible = culler.Cull(planes, visible, runCullingJobs);
+	bool result = (numberOfVisible > 0 && numberOfVisible < numberOfObjects &&
+				   checkVisibleObjects(visible, numberOfVisible, margins, 0, numberOfObjects));
+
+	// On the calling thread only, and on a range that doesn't start on
+	// a whole SIMD block.
+	result = result && (culler.Cull(planes, visible) == numberOfVisible);
+	const int rangeVisible = culler.CullRange(planes, 13, 1001, visible);
+	result = result && checkVisibleObjects(visible, rangeVisible, margins, 13, 1001);
+
+	delete[] visible;
+	delete[] margins;
+	culler.Shutdown();
+	return result;
+}
+
 bool UniformBufferTest(Gfx::IGraphicLayer* gfxLayer)
 {
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
@@ -206,12 +771,1077 @@ bool UniformBufferTest(Gfx::IGraphicLayer* gfxLayer)
 	return true;
 }
 
+bool GeometryHeapTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = {
+		-1.f, -1.f, 0.f,
+		 1.f, -1.f, 0.f,
+		 1.f,  1.f, 0.f,
+		-1.f,  1.f, 0.f,
+	};
+	const unsigned short indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	Gfx::GeometryHeap heap;
+	heap.Init(gfxLayer, Gfx::PrimitiveType::Triangles,
+			  attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+			  16, Gfx::VertexIndexType::UInt16, 24);
+
+	// Fill the heap with four quads.
+	Gfx::MeshID meshes[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		meshes[i] = heap.Allocate(4, vertices, 6, indices);
+		if (meshes[i] == Gfx::MeshID::InvalidID)
+		{
+			return false;
+		}
+	}
+	if (heap.Allocate(4, vertices, 6, indices) != Gfx::MeshID::InvalidID ||
+		heap.GetStats().vertexUtilization != 1.f)
+	{
+		return false;
+	}
+
+	// Free two quads that are not next to each other: there is room
+	// for two quads, but not for one mesh of twice the size.
+	heap.Free(meshes[0]);
+	heap.Free(meshes[2]);
+	const Gfx::GeometryHeap::Stats fragmented = heap.GetStats();
+	if (fragmented.numberOfMeshes != 2 ||
+		fragmented.usedVertices != 8 ||
+		fragmented.vertexFragmentation != 0.5f)
+	{
+		return false;
+	}
+
+	heap.Defragment();
+	const Gfx::GeometryHeap::Stats defragmented = heap.GetStats();
+	if (defragmented.numberOfMeshes != 2 ||
+		defragmented.usedVertices != 8 ||
+		defragmented.vertexFragmentation != 0.f ||
+		defragmented.indexFragmentation != 0.f)
+	{
+		return false;
+	}
+
+	// The remaining meshes are now packed at the beginning of the heap.
+	const Gfx::Geometry geometry1 = heap.GetGeometry(meshes[1]);
+	const Gfx::Geometry geometry3 = heap.GetGeometry(meshes[3]);
+	if (geometry1.baseVertex + geometry3.baseVertex != 4 ||
+		geometry1.firstIndexOffset + geometry3.firstIndexOffset != 6 * sizeof(unsigned short) ||
+		geometry1.numberOfIndices != 6)
+	{
+		return false;
+	}
+
+	heap.Shutdown();
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+	return true;
+}
+
+bool UniformRingTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_UNIFORM_BUFFER_RING && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	// Test data.
+	const size_t testDataSize = 256;
+	std::uint32_t inputData[testDataSize];
+	for (size_t i = 0; i < testDataSize; ++i)
+	{
+		inputData[i] = 42 + 2 * i;
+	}
+
+	// Create shader. offset, bias and the terms array go through the
+	// uniform ring, multiplier is bound as a plain uniform. The elements
+	// of terms are padded to 16 bytes each in the block.
+	Gfx::ShaderID computeShader = gfxLayer->CreateShader();
+	if (computeShader == Gfx::ShaderID::InvalidID)
+	{
+		return false;
+	}
+
+	const char* computeShaderSource = R"(
+        #version 450
+        layout(local_size_x = 1) in;
+        layout(std140) uniform DrawUniforms {
+            int offset;
+            float bias;
+            int terms[2];
+        };
+        uniform int multiplier;
+        layout(std430) buffer ShaderData {
+            int data[];
+        };
+        void main() {
+            data[gl_GlobalInvocationID.x] += offset;
+            data[gl_GlobalInvocationID.x] *= multiplier;
+            data[gl_GlobalInvocationID.x] += int(bias) + terms[1];
+        }
+    )";
+	const Gfx::ShaderStage shaderStage = { Gfx::ShaderType::ComputeShader, computeShaderSource, __FILE__ };
+	gfxLayer->LoadShader(computeShader, &shaderStage, 1);
+
+	Gfx::StorageBufferID storageBuffer = gfxLayer->CreateStorageBuffer();
+	Gfx::ComputeParameters computeParameters = Gfx::ComputeParameters();
+	computeParameters.uniforms.add(Gfx::Uniform::Int1("offset", 0));
+	computeParameters.uniforms.add(Gfx::Uniform::Float1("bias", 0.f));
+	computeParameters.uniforms.add(Gfx::Uniform::Int1("multiplier", 1));
+	computeParameters.uniforms.add(Gfx::Uniform::Int2("terms", 0, 0));
+	computeParameters.uniforms.add(Gfx::Uniform::StorageBufferInput1("ShaderData", storageBuffer));
+
+	// Successive dispatches: new values, one changed value, and the
+	// same values again after the ring is recycled at the end of the
+	// frame.
+	struct Step
+	{
+		int		offset;
+		float	bias;
+		int		multiplier;
+		int		term;
+		bool	endFrame;
+	};
+	const Step steps[] = {
+		{ 3, 0.f, 2, 1, false },
+		{ 5, 0.f, 2, 1, false },
+		{ 5, 7.f, 3, 4, true },
+		{ 5, 7.f, 3, 4, false },
+	};
+
+	bool success = true;
+	for (size_t step = 0; step < ARRAY_LEN(steps) && success; ++step)
+	{
+		computeParameters.uniforms[0].iValue[0] = steps[step].offset;
+		computeParameters.uniforms[1].fValue[0] = steps[step].bias;
+		computeParameters.uniforms[2].iValue[0] = steps[step].multiplier;
+		computeParameters.uniforms[3].iValue[1] = steps[step].term;
+
+		gfxLayer->LoadStorageBuffer(storageBuffer, sizeof(inputData), inputData);
+		gfxLayer->Compute(computeShader, computeParameters, testDataSize);
+
+		// Read back and validate that the data matches the expected result.
+		std::uint32_t outputData[testDataSize];
+		memset(outputData, 0, sizeof(outputData));
+		gfxLayer->ReadStorageBuffer(storageBuffer, sizeof(outputData), outputData);
+
+		for (size_t i = 0; i < testDataSize; ++i)
+		{
+			const std::uint32_t expected = (inputData[i] + steps[step].offset) * steps[step].multiplier + (int)steps[step].bias + steps[step].term;
+			if (outputData[i] != expected)
+			{
+				success = false;
+				break;
+			}
+		}
+
+		if (steps[step].endFrame)
+		{
+			gfxLayer->EndFrame();
+		}
+	}
+
+	gfxLayer->DestroyStorageBuffer(storageBuffer);
+	gfxLayer->DestroyShader(computeShader);
+	if (!success)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING && GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	return true;
+}
+
+bool TextureArrayAllocatorTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::LinearMipmapLinear,
+		Gfx::TextureFilter::Linear,
+		1.f,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+	};
+	unsigned char data[16 * 16 * 4] = {};
+
+	Gfx::TextureArrayAllocator allocator;
+	allocator.Init(gfxLayer, 4, sampling);
+
+	// Five textures of the same size: the first four share an array.
+	Gfx::TextureLayerID layers[5];
+	for (int i = 0; i < 5; ++i)
+	{
+		layers[i] = allocator.Allocate(16, 16, Gfx::TextureFormat::RGBA8, data);
+		if (layers[i] == Gfx::TextureLayerID::InvalidID)
+		{
+			return false;
+		}
+	}
+	for (int i = 1; i < 4; ++i)
+	{
+		if (layers[i].texture != layers[0].texture ||
+			layers[i].layer != i)
+		{
+			return false;
+		}
+	}
+	if (layers[4].texture == layers[0].texture ||
+		layers[4].layer != 0)
+	{
+		return false;
+	}
+
+	// Another size gets its own array.
+	const Gfx::TextureLayerID small = allocator.Allocate(8, 8, Gfx::TextureFormat::RGBA8, data);
+	if (small.texture == layers[0].texture || small.texture == layers[4].texture)
+	{
+		return false;
+	}
+
+	// A freed layer is reused before the second array.
+	allocator.Free(layers[2]);
+	const Gfx::TextureLayerID reused = allocator.Allocate(16, 16, Gfx::TextureFormat::RGBA8, data);
+	if (reused != layers[2])
+	{
+		return false;
+	}
+
+	const Gfx::TextureArrayAllocator::Stats stats = allocator.GetStats();
+	if (stats.numberOfArrays != 3 ||
+		stats.numberOfTextures != 6 ||
+		stats.layerCapacity != 12 ||
+		stats.utilization != 0.5f)
+	{
+		return false;
+	}
+
+	allocator.Shutdown();
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+	return true;
+}
+
+bool RenderTargetPoolTest(Gfx::IGraphicLayer* gfxLayer)
+{
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Linear,
+		Gfx::TextureFilter::Linear,
+		1.f,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+	};
+
+	Gfx::RenderTargetPool pool;
+	pool.Init(gfxLayer, 2, sampling);
+
+	// A chain of four passes, each reading the result of the previous
+	// one: two targets are enough, used in turn.
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		Gfx::RenderTargetID previous = pool.Acquire(64, 64, Gfx::TextureFormat::RGBA8);
+		const Gfx::FrameBufferID first = pool.GetFrameBuffer(previous);
+		gfxLayer->ClearFrameBuffer(first, 1.f, 0.f, 0.f, false);
+		for (int pass = 1; pass < 4; ++pass)
+		{
+			const Gfx::RenderTargetID target = pool.Acquire(64, 64, Gfx::TextureFormat::RGBA8);
+			if (target == Gfx::RenderTargetID::InvalidID || target == previous)
+			{
+				return false;
+			}
+			gfxLayer->ClearFrameBuffer(pool.GetFrameBuffer(target), 0.f, 1.f, 0.f, false);
+			pool.Release(previous);
+			previous = target;
+		}
+
+		// Another format or number of textures doesn't match.
+		const Gfx::RenderTargetID gBuffer = pool.Acquire(64, 64, Gfx::TextureFormat::RGBA16f, 2);
+		if (gBuffer == Gfx::RenderTargetID::InvalidID ||
+			gBuffer == previous ||
+			pool.GetTexture(gBuffer, 0) == pool.GetTexture(gBuffer, 1))
+		{
+			return false;
+		}
+		pool.Release(gBuffer);
+		pool.Release(previous);
+		pool.EndFrame();
+		gfxLayer->EndFrame();
+	}
+
+	// 5 acquisitions per frame, of which only the first 3 created a
+	// target.
+	const long long peakMemory = 2 * 64 * 64 * 4 + 2 * 64 * 64 * 8;
+	Gfx::RenderTargetPool::Stats stats = pool.GetStats();
+	if (stats.numberOfTargets != 3 ||
+		stats.numberOfTargetsInUse != 0 ||
+		stats.memory != peakMemory ||
+		stats.peakMemory != peakMemory ||
+		stats.numberOfAcquisitions != 10 ||
+		stats.numberOfReuses != 7)
+	{
+		return false;
+	}
+
+	// Targets unused for two frames are evicted.
+	const Gfx::RenderTargetID half = pool.Acquire(32, 32, Gfx::TextureFormat::RGBA8);
+	const Gfx::FrameBufferID halfFrameBuffer = pool.GetFrameBuffer(half);
+	pool.Release(half);
+	pool.EndFrame();
+	pool.EndFrame();
+	stats = pool.GetStats();
+	if (stats.numberOfTargets != 1 ||
+		stats.memory != 32 * 32 * 4 ||
+		stats.peakMemory != peakMemory + 32 * 32 * 4)
+	{
+		return false;
+	}
+	pool.EndFrame();
+	if (pool.GetStats().numberOfTargets != 0 || pool.GetStats().memory != 0)
+	{
+		return false;
+	}
+
+	// Their ids are loaded again for the next targets, the last evicted
+	// first.
+	const Gfx::RenderTargetID other = pool.Acquire(48, 48, Gfx::TextureFormat::RGBA16f, 2);
+	if (other == Gfx::RenderTargetID::InvalidID ||
+		pool.GetFrameBuffer(other) != halfFrameBuffer ||
+		pool.GetStats().memory != 2 * 48 * 48 * 8)
+	{
+		return false;
+	}
+	gfxLayer->ClearFrameBuffer(pool.GetFrameBuffer(other), 0.f, 0.f, 1.f, false);
+	pool.Release(other);
+
+	pool.Shutdown();
+	return true;
+}
+
+bool RenderPassTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_RENDER_PASSES && GFX_ENABLE_ASYNC_READBACK
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Nearest,
+		Gfx::TextureFilter::Nearest,
+		1.f,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+	};
+
+	// Two color attachments and a depth buffer, with the depth first so
+	// the draw buffers don't match the attachments.
+	const Gfx::TextureFormat::Enum formats[] = {
+		Gfx::TextureFormat::Depth,
+		Gfx::TextureFormat::RGBA8,
+		Gfx::TextureFormat::RGBA8,
+	};
+	Gfx::TextureID textures[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		textures[i] = gfxLayer->CreateTexture();
+		gfxLayer->LoadTexture(textures[i], 16, 16, Gfx::TextureType::Texture2D, formats[i],
+							  0, 0, nullptr, sampling);
+	}
+	const Gfx::FrameBufferID frameBuffer = gfxLayer->CreateFrameBuffer(textures, 3, 0, 0);
+	const Gfx::FrameBufferID firstColor = gfxLayer->CreateFrameBuffer(textures + 1, 1, 0, 0);
+	const Gfx::FrameBufferID secondColor = gfxLayer->CreateFrameBuffer(textures + 2, 1, 0, 0);
+
+	// Each color attachment is cleared to its own color.
+	const Gfx::LoadOp::Enum clearAll[] = { Gfx::LoadOp::Clear, Gfx::LoadOp::Clear, Gfx::LoadOp::Clear };
+	const Gfx::ClearValue clearValues[] = {
+		{ { 0.f, 0.f, 0.f, 0.f }, 1.f, 0 },
+		{ { 1.f, 0.f, 0.f, 1.f }, 0.f, 0 },
+		{ { 0.f, 0.f, 1.f, 1.f }, 0.f, 0 },
+	};
+	const Gfx::StoreOp::Enum storeColors[] = { Gfx::StoreOp::DontCare, Gfx::StoreOp::Store, Gfx::StoreOp::Store };
+	gfxLayer->BeginRenderPass(frameBuffer, clearAll, clearValues, 3);
+	gfxLayer->EndRenderPass(storeColors, 3);
+
+	// A second pass keeps the first color, and clears the second one
+	// again.
+	const Gfx::LoadOp::Enum loadFirst[] = { Gfx::LoadOp::DontCare, Gfx::LoadOp::Load, Gfx::LoadOp::Clear };
+	const Gfx::ClearValue green[] = {
+		{ { 0.f, 0.f, 0.f, 0.f }, 0.f, 0 },
+		{ { 0.f, 0.f, 0.f, 0.f }, 0.f, 0 },
+		{ { 0.f, 1.f, 0.f, 1.f }, 0.f, 0 },
+	};
+	gfxLayer->BeginRenderPass(frameBuffer, loadFirst, green, 3);
+	gfxLayer->EndRenderPass(storeColors, 3);
+
+	const Gfx::ReadbackID readbacks[] = {
+		gfxLayer->RequestReadback(firstColor, 0, 0, 16, 16),
+		gfxLayer->RequestReadback(secondColor, 0, 0, 16, 16),
+	};
+	const unsigned char expected[][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 255 } };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (readbacks[i] == Gfx::ReadbackID::InvalidID)
+		{
+			return false;
+		}
+		unsigned char pixels[16 * 16 * 4];
+		while (!gfxLayer->TryGetReadback(readbacks[i], pixels))
+		{
+			gfxLayer->EndFrame();
+		}
+		for (int j = 0; j < 16 * 16 * 4; ++j)
+		{
+			if (pixels[j] != expected[i][j % 4])
+			{
+				return false;
+			}
+		}
+	}
+
+	gfxLayer->DestroyFrameBuffer(secondColor);
+	gfxLayer->DestroyFrameBuffer(firstColor);
+	gfxLayer->DestroyFrameBuffer(frameBuffer);
+	for (int i = 0; i < 3; ++i)
+	{
+		gfxLayer->DestroyTexture(textures[i]);
+	}
+#endif // GFX_ENABLE_RENDER_PASSES && GFX_ENABLE_ASYNC_READBACK
+
+	return true;
+}
+
+// Runs a controller on a synthetic load: a fixed cost, plus a cost per
+// pixel at scale 1, with some noise. Returns the average frame time of
+// the last 60 frames, and the number of scale changes over the last
+// 150 frames.
+static float runSyntheticLoad(Render::ResolutionController& controller,
+							  float fixedCost, float pixelCost,
+							  Noise::Rand& rand, int* lateChanges)
+{
+	const int numberOfFrames = 300;
+	float totalTime = 0.f;
+	int changes = 0;
+	for (int frame = 0; frame < numberOfFrames; ++frame)
+	{
+		const float scale = controller.GetScale();
+		const float frameTime = fixedCost + pixelCost * scale * scale + rand.fgen(-1.f, 1.f);
+		totalTime += (frame >= numberOfFrames - 60 ? frameTime : 0.f);
+		changes = (frame == numberOfFrames - 150 ? controller.GetNumberOfChanges() : changes);
+		controller.Update(frameTime);
+	}
+	*lateChanges = controller.GetNumberOfChanges() - changes;
+	return totalTime / 60.f;
+}
+
+bool DynamicResolutionTest(Gfx::IGraphicLayer* gfxLayer)
+{
+	const float budget = 16.f;
+	Render::ResolutionController controller;
+	controller.Init(budget, 0.5f, 1.f);
+	Noise::Rand rand(11);
+
+	// A scene 50% over budget at full resolution: the frame time comes
+	// within the band around the budget, and stays there without going
+	// back and forth.
+	int lateChanges = 0;
+	float frameTime = runSyntheticLoad(controller, 4.f, 20.f, rand, &lateChanges);
+	if (frameTime > 1.05f * budget || frameTime < 0.85f * budget ||
+		controller.GetScale() >= 1.f || controller.GetScale() <= 0.5f ||
+		lateChanges > 1)
+	{
+		return false;
+	}
+
+	// A lighter scene goes back to full resolution, and one too heavy
+	// for the budget stops at the minimum.
+	runSyntheticLoad(controller, 2.f, 8.f, rand, &lateChanges);
+	if (controller.GetScale() != 1.f || lateChanges != 0)
+	{
+		return false;
+	}
+	runSyntheticLoad(controller, 30.f, 20.f, rand, &lateChanges);
+	if (controller.GetScale() != 0.5f || lateChanges != 0)
+	{
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	controller.GetRenderSize(1920, 1080, &width, &height);
+	if (width != 960 || height != 540)
+	{
+		return false;
+	}
+
+#if GFX_ENABLE_ASYNC_READBACK
+	// The scene is drawn at 24x12 in a 64x64 target cleared to blue; the
+	// upscale shouldn't show any of it.
+	const char* vertexShaderSource = R"(
+        #version 330 core
+        in vec3 position;
+        void main() {
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
+	const char* fragmentShaderSource = R"(
+        #version 330 core
+        out vec4 color;
+        void main() {
+            color = vec4(0.0, 1.0, 0.0, 1.0);
+        }
+    )";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, vertexShaderSource, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, fragmentShaderSource, __FILE__ },
+	};
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = { -1.f, -1.f, 0.f, 3.f, -1.f, 0.f, -1.f, 3.f, 0.f };
+	const unsigned short indices[] = { 0, 1, 2 };
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Nearest,
+		Gfx::TextureFilter::Nearest,
+		1.f,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+		Gfx::TextureWrap::ClampToEdge,
+	};
+
+	Gfx::ScaledRenderTarget target;
+	target.Init(gfxLayer, 64, 64, Gfx::TextureFormat::RGBA8);
+	const Gfx::TextureID texture = gfxLayer->CreateTexture();
+	gfxLayer->LoadTexture(texture, 16, 16, Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+						  0, 0, nullptr, sampling);
+	const Gfx::DrawArea destination = { gfxLayer->CreateFrameBuffer(&texture, 1, 0, 0), { 0, 0, 16, 16 } };
+	const Gfx::VertexBufferID vertexBuffer = gfxLayer->CreateVertexBuffer();
+	gfxLayer->LoadVertexBuffer(vertexBuffer, Gfx::PrimitiveType::Triangles,
+							   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+							   sizeof(vertices), vertices,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.vertexBuffer = vertexBuffer;
+	geometry.numberOfIndices = 3;
+
+	gfxLayer->ClearFrameBuffer(target.GetFrameBuffer(), 0.f, 0.f, 1.f, true);
+	gfxLayer->Draw(target.GetDrawArea(24, 12), Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+	target.Upscale(destination, 24, 12);
+
+	const Gfx::ReadbackID readback = gfxLayer->RequestReadback(destination.frameBuffer, 0, 0, 16, 16);
+	bool result = (readback != Gfx::ReadbackID::InvalidID);
+	unsigned char pixels[16 * 16 * 4];
+	while (result && !gfxLayer->TryGetReadback(readback, pixels))
+	{
+		gfxLayer->EndFrame();
+	}
+	const unsigned char green[] = { 0, 255, 0, 255 };
+	for (int i = 0; result && i < 16 * 16 * 4; ++i)
+	{
+		result = (pixels[i] == green[i % 4]);
+	}
+
+	gfxLayer->DestroyShader(shadingParameters.shader);
+	gfxLayer->DestroyVertexBuffer(vertexBuffer);
+	gfxLayer->DestroyFrameBuffer(destination.frameBuffer);
+	gfxLayer->DestroyTexture(texture);
+	target.Shutdown();
+	if (!result)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+	return true;
+}
+
+bool FrameStatsTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_FRAME_STATS
+	const Gfx::TextureSampling sampling = {
+		Gfx::TextureFilter::Linear,
+		Gfx::TextureFilter::Linear,
+		1.f,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+		Gfx::TextureWrap::Repeat,
+	};
+	unsigned char data[16 * 16 * 4] = {};
+
+	gfxLayer->EndFrame();
+	const int numberOfTextures = gfxLayer->GetFrameStats().numberOfTextures;
+
+	const Gfx::TextureID texture = gfxLayer->CreateTexture();
+	gfxLayer->LoadTexture(texture, 16, 16, Gfx::TextureType::Texture2D, Gfx::TextureFormat::RGBA8,
+						  0, 0, data, sampling);
+	gfxLayer->EndFrame();
+	const Gfx::FrameStats loaded = gfxLayer->GetFrameStats();
+	if (loaded.numberOfTextures != numberOfTextures + 1 ||
+		loaded.bytesUploaded != sizeof(data) ||
+		loaded.numberOfDraws != 0)
+	{
+		return false;
+	}
+
+	// The counters start over, the resource counts don't.
+	gfxLayer->DestroyTexture(texture);
+	gfxLayer->EndFrame();
+	const Gfx::FrameStats destroyed = gfxLayer->GetFrameStats();
+	if (destroyed.numberOfTextures != numberOfTextures ||
+		destroyed.bytesUploaded != 0 ||
+		destroyed.textureChanges != 0)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_FRAME_STATS
+	return true;
+}
+
+bool GpuProfilerTest(Gfx::IGraphicLayer* gfxLayer)
+{
+#if GFX_ENABLE_GPU_PROFILING
+	const int numberOfFrames = 2 * GFX_GPU_PROFILING_LATENCY + 8;
+	for (int i = 0; i < numberOfFrames; ++i)
+	{
+		gfxLayer->BeginGpuScope("Outer");
+		gfxLayer->BeginGpuScope("Inner");
+		gfxLayer->EndGpuScope();
+		gfxLayer->EndGpuScope();
+		gfxLayer->EndFrame();
+	}
+
+	const Gfx::GpuProfiler& profiler = gfxLayer->GetGpuProfiler();
+	if (!profiler.IsAvailable())
+	{
+		// No timer queries on this driver: the scopes are ignored.
+		return (profiler.GetNumberOfScopes() == 0 &&
+				profiler.GetNumberOfDroppedFrames() == 0);
+	}
+
+	// Every frame but the last ones is either read back or dropped,
+	// and with several frames of latency, some are read back.
+	const Gfx::GpuProfiler::ScopeStats* outer = profiler.FindScope("Outer");
+	const Gfx::GpuProfiler::ScopeStats* inner = profiler.FindScope("Inner");
+	if (outer == nullptr ||
+		outer->numberOfSamples + profiler.GetNumberOfDroppedFrames() != numberOfFrames - GFX_GPU_PROFILING_LATENCY)
+	{
+		return false;
+	}
+	if (inner == nullptr ||
+		inner->numberOfSamples != outer->numberOfSamples ||
+		outer->depth != 0 ||
+		inner->depth != 1 ||
+		inner->lastTime > outer->lastTime ||
+		outer->averageTime < 0.f)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_GPU_PROFILING
+	return true;
+}
+
+#if GFX_MULTI_API
+// Draws a few frames of a triangle whose position changes, on a null
+// layer.
+static void drawRecordedFrames(Gfx::IGraphicLayer* gfxLayer)
+{
+	const char* source = "void main() {}";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, source, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, source, __FILE__ },
+	};
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+	const unsigned short indices[] = { 0, 1, 2 };
+	const Gfx::DrawArea drawArea = { Gfx::FrameBufferID::InvalidID, { 0, 0, 64, 64 } };
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = gfxLayer->CreateShader();
+	gfxLayer->LoadShader(shadingParameters.shader, shaderStages, ARRAY_LEN(shaderStages));
+	shadingParameters.uniforms.add(Gfx::Uniform::Float2("offset", 0.f, 0.f));
+
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.vertexBuffer = gfxLayer->CreateVertexBuffer();
+	geometry.numberOfIndices = ARRAY_LEN(indices);
+	gfxLayer->LoadVertexBuffer(geometry.vertexBuffer, Gfx::PrimitiveType::Triangles,
+							   attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+							   sizeof(vertices), vertices,
+							   sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		gfxLayer->ClearFrameBuffer(Gfx::FrameBufferID::InvalidID, 0.f, 0.f, 0.f, true);
+		for (int i = 0; i < 4; ++i)
+		{
+			shadingParameters.uniforms[0].fValue[0] = 0.1f * i;
+			gfxLayer->Draw(drawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+		}
+		gfxLayer->EndFrame();
+	}
+
+	gfxLayer->DestroyVertexBuffer(geometry.vertexBuffer);
+	gfxLayer->DestroyShader(shadingParameters.shader);
+}
+#endif // GFX_MULTI_API
+
+bool RecordingLayerTest(Gfx::IGraphicLayer*)
+{
+#if GFX_MULTI_API
+	// The same calls give the same trace, whatever the timings.
+	Gfx::NullLayer nullLayers[2];
+	Gfx::RecordingLayer trace(&nullLayers[0]);
+	Gfx::RecordingLayer otherTrace(&nullLayers[1]);
+	Gfx::RecordingLayer* recordingLayers[2] = { &trace, &otherTrace };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!recordingLayers[i]->CreateRenderingContext())
+		{
+			return false;
+		}
+		drawRecordedFrames(recordingLayers[i]);
+	}
+	if (trace.GetNumberOfCalls() != otherTrace.GetNumberOfCalls() ||
+		trace.GetNumberOfDroppedCalls() != 0)
+	{
+		return false;
+	}
+	int numberOfDraws = 0;
+	for (int i = 0; i < trace.GetNumberOfCalls(); ++i)
+	{
+		const Gfx::RecordingLayer::Call& call = trace.GetCall(i);
+		const Gfx::RecordingLayer::Call& other = otherTrace.GetCall(i);
+		if (call.type != other.type ||
+			memcmp(call.arguments, other.arguments, sizeof(call.arguments)) != 0 ||
+			call.duration < 0)
+		{
+			return false;
+		}
+		if (call.type == Gfx::RecordingLayer::CallType::Draw)
+		{
+			++numberOfDraws;
+		}
+	}
+	if (numberOfDraws != 12)
+	{
+		return false;
+	}
+
+	// Draws that only differ by a uniform value have different states.
+	const Gfx::RecordingLayer::Call& firstDraw = trace.GetCall(6);
+	const Gfx::RecordingLayer::Call& secondDraw = trace.GetCall(7);
+	if (firstDraw.type != Gfx::RecordingLayer::CallType::Draw ||
+		secondDraw.type != Gfx::RecordingLayer::CallType::Draw ||
+		firstDraw.arguments[4] == secondDraw.arguments[4])
+	{
+		return false;
+	}
+
+#if GFX_ENABLE_FRAME_STATS
+	const Gfx::FrameStats& stats = nullLayers[0].GetFrameStats();
+	if (stats.numberOfDraws != 4 ||
+		stats.numberOfTriangles != 4 ||
+		stats.shaderChanges != 0 ||
+		stats.uniformBindsIssued != 4)
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_FRAME_STATS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	// Storage buffers keep their data.
+	const int input[4] = { 1, 2, 3, 4 };
+	int output[4] = {};
+	const Gfx::StorageBufferID buffer = trace.CreateStorageBuffer();
+	trace.LoadStorageBuffer(buffer, sizeof(input), input);
+	trace.ReadStorageBuffer(buffer, sizeof(output), output);
+	trace.DestroyStorageBuffer(buffer);
+	if (memcmp(input, output, sizeof(input)) != 0 ||
+		trace.GetCall(trace.GetNumberOfCalls() - 2).arguments[2] != trace.GetCall(trace.GetNumberOfCalls() - 3).arguments[2])
+	{
+		return false;
+	}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	for (int i = 0; i < 2; ++i)
+	{
+		recordingLayers[i]->DestroyRenderingContext();
+	}
+#endif // GFX_MULTI_API
+	return true;
+}
+
+bool CaptureReplayTest(Gfx::IGraphicLayer*)
+{
+#if GFX_MULTI_API
+	const char* fileName = "CaptureReplayTest.gfxc";
+
+	// Replaying a capture makes the same calls as the captured frames.
+	Gfx::NullLayer nullLayers[2];
+	Gfx::CaptureLayer capture(&nullLayers[0]);
+	Gfx::RecordingLayer trace(&capture);
+	if (!trace.CreateRenderingContext() ||
+		!capture.BeginCapture(fileName))
+	{
+		return false;
+	}
+	drawRecordedFrames(&trace);
+	if (!capture.EndCapture())
+	{
+		return false;
+	}
+
+	Gfx::CaptureReplay replay;
+	const bool loaded = replay.Load(fileName);
+	remove(fileName);
+	if (!loaded || replay.GetNumberOfFrames() != 3)
+	{
+		return false;
+	}
+
+	Gfx::RecordingLayer replayTrace(&nullLayers[1]);
+	if (!replayTrace.CreateRenderingContext())
+	{
+		return false;
+	}
+	replay.Begin(&replayTrace, 0);
+	for (int frame = 0; frame < replay.GetNumberOfFrames(); ++frame)
+	{
+		replay.PlayFrame(frame);
+	}
+
+	// The shader and vertex buffer are destroyed after the last frame,
+	// which isn't played.
+	const int numberOfCalls = replayTrace.GetNumberOfCalls();
+	if (numberOfCalls != trace.GetNumberOfCalls() - 2)
+	{
+		return false;
+	}
+	for (int i = 0; i < numberOfCalls; ++i)
+	{
+		const Gfx::RecordingLayer::Call& call = trace.GetCall(i);
+		const Gfx::RecordingLayer::Call& other = replayTrace.GetCall(i);
+		if (call.type != other.type ||
+			memcmp(call.arguments, other.arguments, sizeof(call.arguments)) != 0)
+		{
+			return false;
+		}
+	}
+
+	// The next loop loads the same resources again, instead of making
+	// new ones.
+	replay.EndLoop();
+	for (int frame = 0; frame < replay.GetNumberOfFrames(); ++frame)
+	{
+		replay.PlayFrame(frame);
+	}
+	replay.EndLoop();
+	if (replayTrace.GetNumberOfCalls() != 2 * numberOfCalls - 3)
+	{
+		return false;
+	}
+	for (int i = numberOfCalls; i < replayTrace.GetNumberOfCalls(); ++i)
+	{
+		const Gfx::CallType::Enum type = replayTrace.GetCall(i).type;
+		if (type == Gfx::CallType::CreateShader ||
+			type == Gfx::CallType::CreateVertexBuffer ||
+			type == Gfx::CallType::DestroyShader ||
+			type == Gfx::CallType::DestroyVertexBuffer)
+		{
+			return false;
+		}
+	}
+	replay.End();
+
+	// Looping the last frame only replays its calls, on resources made
+	// once.
+	Gfx::CaptureReplay::CallTimings timings;
+	timings.Clear();
+	replayTrace.ClearTrace();
+	replay.Begin(&replayTrace);
+	for (int loop = 0; loop < 2; ++loop)
+	{
+		replay.PlayFrame(replay.GetFirstFrame(), &timings);
+		replay.EndLoop();
+	}
+	replay.End();
+	if (replay.GetFirstFrame() != 2 ||
+		timings.count[Gfx::CallType::Draw] != 8 ||
+		timings.count[Gfx::CallType::EndFrame] != 2 ||
+		timings.count[Gfx::CallType::CreateShader] != 0)
+	{
+		return false;
+	}
+
+	trace.DestroyRenderingContext();
+	replayTrace.DestroyRenderingContext();
+#endif // GFX_MULTI_API
+	return true;
+}
+
+bool SubmitDrawsTest(Gfx::IGraphicLayer*)
+{
+#if GFX_MULTI_API && GFX_ENABLE_SUBMIT_DRAWS && GFX_ENABLE_FRAME_STATS
+	const char* fileName = "SubmitDrawsTest.gfxc";
+	const char* source = "void main() {}";
+	const Gfx::ShaderStage shaderStages[] = {
+		{ Gfx::ShaderType::VertexShader, source, __FILE__ },
+		{ Gfx::ShaderType::FragmentShader, source, __FILE__ },
+	};
+	const Gfx::VertexAttribute attributes[] = {
+		{ "position", 3, Gfx::VertexAttributeType::Float },
+	};
+	const float vertices[] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+	const unsigned short indices[] = { 0, 1, 2 };
+	const Gfx::DrawArea drawArea = { Gfx::FrameBufferID::InvalidID, { 0, 0, 64, 64 } };
+	const int numberOfItems = 8;
+
+	// The same draws, submitted one at a time and as an array, are
+	// counted the same, but the array doesn't bind the uniforms the
+	// items share again.
+	Gfx::NullLayer nullLayers[2];
+	Gfx::CaptureLayer capture(&nullLayers[1]);
+	if (!nullLayers[0].CreateRenderingContext() ||
+		!capture.CreateRenderingContext() ||
+		!capture.BeginCapture(fileName))
+	{
+		return false;
+	}
+	Gfx::IGraphicLayer* layers[2] = { &nullLayers[0], &capture };
+	Gfx::ShaderID shaders[2];
+	Gfx::VertexBufferID meshes[2][2];
+	for (int i = 0; i < 2; ++i)
+	{
+		shaders[i] = layers[i]->CreateShader();
+		layers[i]->LoadShader(shaders[i], shaderStages, ARRAY_LEN(shaderStages));
+		for (int j = 0; j < 2; ++j)
+		{
+			meshes[i][j] = layers[i]->CreateVertexBuffer();
+			layers[i]->LoadVertexBuffer(meshes[i][j], Gfx::PrimitiveType::Triangles,
+										attributes, ARRAY_LEN(attributes), 3 * sizeof(float),
+										sizeof(vertices), vertices,
+										sizeof(indices), indices, Gfx::VertexIndexType::UInt16);
+		}
+	}
+
+	// Items 0 and 1, then 2 and 3, share their uniforms.
+	Gfx::Uniform offsets[numberOfItems];
+	for (int i = 0; i < numberOfItems; ++i)
+	{
+		offsets[i] = Gfx::Uniform::Float2("offset", 0.1f * i, 0.f);
+	}
+	const int uniformIndices[numberOfItems] = { 0, 0, 2, 2, 4, 5, 6, 7 };
+
+	Gfx::ShadingParameters shadingParameters;
+	shadingParameters.shader = shaders[0];
+	shadingParameters.uniforms.add(offsets[0]);
+	Gfx::Geometry geometry = Gfx::Geometry();
+	geometry.numberOfIndices = ARRAY_LEN(indices);
+	for (int i = 0; i < numberOfItems; ++i)
+	{
+		geometry.vertexBuffer = meshes[0][i / 4];
+		shadingParameters.uniforms[0] = offsets[uniformIndices[i]];
+		nullLayers[0].Draw(drawArea, Gfx::RasterTests::NoDepthTest, geometry, shadingParameters);
+	}
+	nullLayers[0].EndFrame();
+
+	Gfx::DrawState state;
+	state.drawArea = drawArea;
+	state.rasterTests = Gfx::RasterTests::NoDepthTest;
+	state.blendingMode = shadingParameters.blendingMode;
+	state.polygonMode = shadingParameters.polygonMode;
+	Gfx::DrawItem items[numberOfItems];
+	for (int i = 0; i < numberOfItems; ++i)
+	{
+		items[i] = Gfx::DrawItem();
+		items[i].state = &state;
+		items[i].uniforms = &offsets[uniformIndices[i]];
+		items[i].numberOfUniforms = 1;
+		items[i].shader = shaders[1];
+		items[i].vertexBuffer = meshes[1][i / 4];
+		items[i].numberOfIndices = ARRAY_LEN(indices);
+		items[i].numberOfInstances = 1;
+	}
+	capture.SubmitDraws(items, numberOfItems);
+	capture.EndFrame();
+	if (!capture.EndCapture())
+	{
+		return false;
+	}
+
+	const Gfx::FrameStats& drawStats = nullLayers[0].GetFrameStats();
+	const Gfx::FrameStats& submitStats = nullLayers[1].GetFrameStats();
+	if (drawStats.numberOfDraws != numberOfItems ||
+		submitStats.numberOfDraws != numberOfItems ||
+		submitStats.numberOfTriangles != drawStats.numberOfTriangles ||
+		submitStats.vertexBufferChanges != drawStats.vertexBufferChanges ||
+		submitStats.rasterStateChanges != drawStats.rasterStateChanges ||
+		drawStats.uniformBindsIssued != numberOfItems ||
+		submitStats.uniformBindsIssued != numberOfItems - 2 ||
+		submitStats.uniformBindsAvoided != 2)
+	{
+		return false;
+	}
+
+	// The replay shares the states and uniforms the same way.
+	Gfx::CaptureReplay replay;
+	const bool loaded = replay.Load(fileName);
+	remove(fileName);
+	if (!loaded || replay.GetNumberOfFrames() != 1)
+	{
+		return false;
+	}
+	Gfx::NullLayer replayLayer;
+	if (!replayLayer.CreateRenderingContext())
+	{
+		return false;
+	}
+	replay.Begin(&replayLayer, 0);
+	replay.PlayFrame(0);
+	replay.End();
+	const Gfx::FrameStats& replayStats = replayLayer.GetFrameStats();
+	if (replayStats.numberOfDraws != numberOfItems ||
+		replayStats.vertexBufferChanges != submitStats.vertexBufferChanges ||
+		replayStats.uniformBindsIssued != submitStats.uniformBindsIssued)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < 2; ++i)
+	{
+		layers[i]->DestroyShader(shaders[i]);
+		layers[i]->DestroyVertexBuffer(meshes[i][0]);
+		layers[i]->DestroyVertexBuffer(meshes[i][1]);
+		layers[i]->DestroyRenderingContext();
+	}
+	replayLayer.DestroyRenderingContext();
+#endif // GFX_MULTI_API && GFX_ENABLE_SUBMIT_DRAWS && GFX_ENABLE_FRAME_STATS
+	return true;
+}
+
 FunctionalTest tests[] = {
 	//dummyTest,
 	//dummyBrokenTest,
 	StorageBufferTest,
+	AsyncReadbackTest,
 	ComputeShaderTest,
+	ChainedComputeTest,
+	GpuCullerTest,
+	CullerTest,
 	UniformBufferTest,
+	GeometryHeapTest,
+	UniformRingTest,
+	TextureArrayAllocatorTest,
+	RenderTargetPoolTest,
+	RenderPassTest,
+	DynamicResolutionTest,
+	FrameStatsTest,
+	GpuProfilerTest,
+	RecordingLayerTest,
+	CaptureReplayTest,
+	SubmitDrawsTest,
 };
 
 /// <summary>
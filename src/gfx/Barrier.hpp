@@ -0,0 +1,28 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif // _WIN32
+#include <GL/gl.h>
+#include "gfx/OpenGL/glext.h"
+
+namespace Gfx
+{
+	/// <summary>
+	/// How data written by shaders is used next, for
+	/// IGraphicLayer::InsertMemoryBarrier(). The values can be combined.
+	/// </summary>
+	struct Barrier
+	{
+		enum Enum {
+			StorageBuffer = GL_SHADER_STORAGE_BARRIER_BIT, // Read or written by a shader.
+			IndirectArguments = GL_COMMAND_BARRIER_BIT, // Of ComputeIndirect() or indirect draws.
+			VertexAttributes = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+			Indices = GL_ELEMENT_ARRAY_BARRIER_BIT,
+			UniformBuffer = GL_UNIFORM_BARRIER_BIT,
+			TextureFetch = GL_TEXTURE_FETCH_BARRIER_BIT,
+			BufferUpdate = GL_BUFFER_UPDATE_BARRIER_BIT, // Copied, or read back.
+			All = (int)GL_ALL_BARRIER_BITS,
+		};
+	};
+}
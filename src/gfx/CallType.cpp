@@ -0,0 +1,70 @@
+#include "CallType.hpp"
+
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+using namespace Gfx;
+
+static const char* callNames[] = {
+	"CreateRenderingContext",
+	"DestroyRenderingContext",
+	"CreateVertexBuffer",
+	"DestroyVertexBuffer",
+	"LoadVertexBuffer",
+	"UpdateVertexBufferRange",
+	"UpdateIndexBufferRange",
+	"CopyVertexBufferRange",
+	"CopyIndexBufferRange",
+	"CreateTexture",
+	"DestroyTexture",
+	"LoadTexture",
+	"GenerateMipMaps",
+	"LoadTextureArray",
+	"LoadTextureLayer",
+	"AllocateTexture",
+	"LoadTextureLevel",
+	"LoadCompressedTexture",
+	"MapTextureUpload",
+	"LoadTextureAsync",
+	"IsTextureReady",
+	"CreateUniformBuffer",
+	"DestroyUniformBuffer",
+	"LoadUniformBuffer",
+	"CreateStorageBuffer",
+	"DestroyStorageBuffer",
+	"LoadStorageBuffer",
+	"ReadStorageBuffer",
+	"CreateShader",
+	"DestroyShader",
+	"LoadShader",
+	"LoadShaderAsync",
+	"IsShaderReady",
+	"CreateFrameBuffer",
+	"DestroyFrameBuffer",
+	"ClearFrameBuffer",
+	"Draw",
+	"DrawBatch",
+	"Compute",
+	"BeginGpuScope",
+	"EndGpuScope",
+	"EndFrame",
+	"SubmitDraws",
+	"ComputeIndirect",
+	"InsertMemoryBarrier",
+	"RequestReadback",
+	"RequestFrameBufferReadback",
+	"TryGetReadback",
+	"DrawIndirect",
+	"LoadFrameBuffer",
+	"BeginRenderPass",
+	"EndRenderPass",
+};
+
+static_assert(sizeof(callNames) / sizeof(callNames[0]) == CallType::Count,
+			  "Each call type should have a name.");
+
+const char* Gfx::GetCallName(CallType::Enum type)
+{
+	ASSERT(type >= 0 && type < CallType::Count);
+	return callNames[type];
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+namespace Gfx
+{
+	/// <summary>
+	/// The calls of IGraphicLayer, to tell them apart in call traces and
+	/// captures.
+	///
+	/// The values are written in files: add new calls at the end, and
+	/// keep them whatever the build flags.
+	/// </summary>
+	struct CallType
+	{
+		enum Enum {
+			CreateRenderingContext,
+			DestroyRenderingContext,
+			CreateVertexBuffer,
+			DestroyVertexBuffer,
+			LoadVertexBuffer,
+			UpdateVertexBufferRange,
+			UpdateIndexBufferRange,
+			CopyVertexBufferRange,
+			CopyIndexBufferRange,
+			CreateTexture,
+			DestroyTexture,
+			LoadTexture,
+			GenerateMipMaps,
+			LoadTextureArray,
+			LoadTextureLayer,
+			AllocateTexture,
+			LoadTextureLevel,
+			LoadCompressedTexture,
+			MapTextureUpload,
+			LoadTextureAsync,
+			IsTextureReady,
+			CreateUniformBuffer,
+			DestroyUniformBuffer,
+			LoadUniformBuffer,
+			CreateStorageBuffer,
+			DestroyStorageBuffer,
+			LoadStorageBuffer,
+			ReadStorageBuffer,
+			CreateShader,
+			DestroyShader,
+			LoadShader,
+			LoadShaderAsync,
+			IsShaderReady,
+			CreateFrameBuffer,
+			DestroyFrameBuffer,
+			ClearFrameBuffer,
+			Draw,
+			DrawBatch,
+			Compute,
+			BeginGpuScope,
+			EndGpuScope,
+			EndFrame,
+			SubmitDraws,
+			ComputeIndirect,
+			InsertMemoryBarrier,
+			RequestReadback,
+			RequestFrameBufferReadback,
+			TryGetReadback,
+			DrawIndirect,
+			LoadFrameBuffer,
+			BeginRenderPass,
+			EndRenderPass,
+
+			Count
+		};
+	};
+
+	/// <returns>The name of the IGraphicLayer method, or "DrawBatch"
+	/// for the Draw() of a batch, and "RequestFrameBufferReadback" for
+	/// the RequestReadback() of a frame buffer.</returns>
+	const char*	GetCallName(CallType::Enum type);
+}
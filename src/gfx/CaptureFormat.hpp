@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CallType.hpp"
+
+namespace Gfx
+{
+	//
+	// Layout of a capture file, written by CaptureLayer and played by
+	// CaptureReplay.
+	//
+	// The file is a CaptureHeader, followed by the calls. Each call is a
+	// CaptureCall, followed by its arguments. Arguments are 32 bits
+	// words: integers, floats, and data, which is a word for the size in
+	// bytes followed by the bytes, padded to a word. Strings are data
+	// that include the terminating zero; a null string has a size of 0.
+	//
+	// Everything is 4 bytes aligned, and the data is used in place: a
+	// capture can be read or mapped in memory, and played as is.
+	//
+	// Resource ids are those of the captured layer; the replay maps
+	// them to its own.
+	//
+
+	static const int CaptureVersion = 1;
+
+	struct CaptureHeader
+	{
+		char		magic[4]; // "GFXC"
+		int			version;
+		int			numberOfCalls;
+		int			numberOfFrames; // Number of EndFrame calls.
+
+		// Render states are captured as they are in memory; their size
+		// depends on the build flags, which should be the same for the
+		// replay.
+		int			rasterTestsSize;
+		int			blendingModeSize;
+	};
+
+	struct CaptureCall
+	{
+		int			type; // CallType::Enum
+		int			size; // Of the arguments, in bytes.
+	};
+}
@@ -0,0 +1,1148 @@
+#include "CaptureLayer.hpp"
+
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include "gfx/BlendingMode.hpp"
+#include "gfx/CaptureFormat.hpp"
+#include "gfx/DrawArea.hpp"
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+#include "gfx/DrawBatch.hpp"
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/DrawItem.hpp"
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/Geometry.hpp"
+#include "gfx/OpenGL/OpenGLTypeConversion.hpp"
+#include "gfx/RasterTests.hpp"
+#include "gfx/ShadingParameters.hpp"
+#include "gfx/VertexAttribute.hpp"
+#include <cstring>
+
+#if GFX_MULTI_API
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::CaptureLayer::TextureInfo>;
+
+#endif
+
+CaptureLayer::CaptureLayer(IGraphicLayer* layer):
+	m_layer(layer),
+	m_textures(GFX_MAX_TEXTURES),
+	m_file(nullptr),
+	m_failed(false),
+	m_numberOfCalls(0),
+	m_numberOfFrames(0),
+	m_arguments(nullptr),
+	m_argumentsSize(0),
+	m_argumentsCapacity(0)
+{
+	ASSERT(layer != nullptr);
+}
+
+CaptureLayer::~CaptureLayer()
+{
+	if (m_file != nullptr)
+	{
+		EndCapture();
+	}
+	delete[] m_arguments;
+}
+
+bool CaptureLayer::BeginCapture(const char* fileName)
+{
+	ASSERT(m_file == nullptr);
+	m_file = fopen(fileName, "wb");
+	if (m_file == nullptr)
+	{
+		LOG_ERROR("Could not write capture %s.", fileName);
+		return false;
+	}
+
+	// The header is written again with the counts at the end.
+	CaptureHeader header = {};
+	m_failed = (fwrite(&header, sizeof(header), 1, m_file) != 1);
+	m_numberOfCalls = 0;
+	m_numberOfFrames = 0;
+	LOG_INFO("Capturing graphic calls to %s.", fileName);
+	return true;
+}
+
+bool CaptureLayer::EndCapture()
+{
+	ASSERT(m_file != nullptr);
+
+	CaptureHeader header;
+	memcpy(header.magic, "GFXC", sizeof(header.magic));
+	header.version = CaptureVersion;
+	header.numberOfCalls = m_numberOfCalls;
+	header.numberOfFrames = m_numberOfFrames;
+	header.rasterTestsSize = sizeof(RasterTests);
+	header.blendingModeSize = sizeof(BlendingMode);
+	if (fseek(m_file, 0, SEEK_SET) != 0 ||
+		fwrite(&header, sizeof(header), 1, m_file) != 1)
+	{
+		m_failed = true;
+	}
+	if (fclose(m_file) != 0)
+	{
+		m_failed = true;
+	}
+	m_file = nullptr;
+
+	if (m_failed)
+	{
+		LOG_ERROR("The capture could not be written entirely.");
+		return false;
+	}
+	LOG_INFO("Capture done: %d calls, %d frames.", m_numberOfCalls, m_numberOfFrames);
+	return true;
+}
+
+CaptureLayer::TextureInfo& CaptureLayer::GetTextureInfo(const TextureID id)
+{
+	ASSERT(id.index >= 0);
+	while (m_textures.size <= id.index)
+	{
+		TextureInfo& textureInfo = m_textures.getNew();
+		textureInfo.format = TextureFormat::RGBA8;
+		textureInfo.width = 0;
+		textureInfo.height = 0;
+		textureInfo.mappedUpload = nullptr;
+	}
+	return m_textures[id.index];
+}
+
+//
+// Writing the calls.
+//
+
+void CaptureLayer::BeginCall()
+{
+	m_argumentsSize = 0;
+}
+
+void CaptureLayer::EndCall(CallType::Enum type)
+{
+	const CaptureCall call = { type, m_argumentsSize };
+	if (fwrite(&call, sizeof(call), 1, m_file) != 1 ||
+		(m_argumentsSize > 0 && fwrite(m_arguments, m_argumentsSize, 1, m_file) != 1))
+	{
+		m_failed = true;
+	}
+	++m_numberOfCalls;
+	if (type == CallType::EndFrame)
+	{
+		++m_numberOfFrames;
+	}
+}
+
+// Makes room for more arguments, and returns where to write them.
+char* CaptureLayer::Reserve(int size)
+{
+	const int requiredCapacity = m_argumentsSize + size;
+	if (requiredCapacity > m_argumentsCapacity)
+	{
+		int capacity = (m_argumentsCapacity > 0 ? 2 * m_argumentsCapacity : 1024);
+		while (capacity < requiredCapacity)
+		{
+			capacity *= 2;
+		}
+		char* arguments = new char[capacity];
+		memcpy(arguments, m_arguments, m_argumentsSize);
+		delete[] m_arguments;
+		m_arguments = arguments;
+		m_argumentsCapacity = capacity;
+	}
+
+	char* result = m_arguments + m_argumentsSize;
+	m_argumentsSize = requiredCapacity;
+	return result;
+}
+
+void CaptureLayer::Write(int value)
+{
+	memcpy(Reserve(sizeof(value)), &value, sizeof(value));
+}
+
+void CaptureLayer::Write(float value)
+{
+	memcpy(Reserve(sizeof(value)), &value, sizeof(value));
+}
+
+void CaptureLayer::WriteData(const void* data, int size)
+{
+	if (data == nullptr)
+	{
+		size = 0;
+	}
+	Write(size);
+	if (size > 0)
+	{
+		const int paddedSize = (size + 3) & ~3;
+		char* dest = Reserve(paddedSize);
+		memcpy(dest, data, size);
+		memset(dest + size, 0, paddedSize - size);
+	}
+}
+
+void CaptureLayer::WriteString(const char* str)
+{
+	WriteData(str, (str != nullptr ? (int)strlen(str) + 1 : 0));
+}
+
+void CaptureLayer::WriteTextureSampling(const TextureSampling& textureSampling)
+{
+	Write(textureSampling.minifyingFilter);
+	Write(textureSampling.magnifyingFilter);
+	Write(textureSampling.maxAnisotropy);
+	Write(textureSampling.rWrap);
+	Write(textureSampling.sWrap);
+	Write(textureSampling.tWrap);
+}
+
+void CaptureLayer::WriteUniforms(const Uniform* uniforms, int numberOfUniforms)
+{
+	Write(numberOfUniforms);
+	for (int i = 0; i < numberOfUniforms; ++i)
+	{
+		const Uniform& uniform = uniforms[i];
+		WriteString(uniform.name);
+		Write(uniform.size);
+		Write(uniform.type);
+		WriteData(uniform.fValue, sizeof(uniform.fValue));
+	}
+}
+
+void CaptureLayer::WriteDrawState(const DrawArea& drawArea,
+								  const RasterTests& rasterTests)
+{
+	Write(drawArea.frameBuffer.index);
+	Write(drawArea.viewport.x);
+	Write(drawArea.viewport.y);
+	Write(drawArea.viewport.width);
+	Write(drawArea.viewport.height);
+	WriteData(&rasterTests, sizeof(rasterTests));
+}
+
+void CaptureLayer::WriteShadingParameters(const ShadingParameters& shadingParameters)
+{
+	WriteData(&shadingParameters.blendingMode, sizeof(shadingParameters.blendingMode));
+	Write(shadingParameters.numberOfInstances);
+	Write(shadingParameters.polygonMode);
+	Write(shadingParameters.shader.index);
+	WriteUniforms(shadingParameters.uniforms.elt, shadingParameters.uniforms.size);
+}
+
+//
+// Forwarded calls.
+//
+
+bool CaptureLayer::CreateRenderingContext()
+{
+	return m_layer->CreateRenderingContext();
+}
+
+void CaptureLayer::DestroyRenderingContext()
+{
+	m_layer->DestroyRenderingContext();
+}
+
+VertexBufferID CaptureLayer::CreateVertexBuffer()
+{
+	const VertexBufferID id = m_layer->CreateVertexBuffer();
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::CreateVertexBuffer);
+	}
+	return id;
+}
+
+void CaptureLayer::DestroyVertexBuffer(const VertexBufferID id)
+{
+	m_layer->DestroyVertexBuffer(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyVertexBuffer);
+	}
+}
+
+void CaptureLayer::LoadVertexBuffer(const VertexBufferID id,
+									PrimitiveType::Enum primitiveType,
+									const VertexAttribute* vertexAttributes,
+									int numberOfAttributes, int stride,
+									int vertexDataSize, const void* vertexData,
+									int indexDataSize, const void* indexData,
+									VertexIndexType::Enum indexType)
+{
+	m_layer->LoadVertexBuffer(id, primitiveType, vertexAttributes, numberOfAttributes, stride,
+							  vertexDataSize, vertexData, indexDataSize, indexData, indexType);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(primitiveType);
+		Write(numberOfAttributes);
+		for (int i = 0; i < numberOfAttributes; ++i)
+		{
+			WriteString(vertexAttributes[i].name);
+			Write(vertexAttributes[i].num);
+			Write(vertexAttributes[i].type);
+		}
+		Write(stride);
+		Write(vertexDataSize);
+		WriteData(vertexData, vertexDataSize);
+		Write(indexDataSize);
+		WriteData(indexData, indexDataSize);
+		Write(indexType);
+		EndCall(CallType::LoadVertexBuffer);
+	}
+}
+
+void CaptureLayer::UpdateVertexBufferRange(const VertexBufferID id,
+										   int offset, int size,
+										   const void* data)
+{
+	m_layer->UpdateVertexBufferRange(id, offset, size, data);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(offset);
+		WriteData(data, size);
+		EndCall(CallType::UpdateVertexBufferRange);
+	}
+}
+
+void CaptureLayer::UpdateIndexBufferRange(const VertexBufferID id,
+										  int offset, int size,
+										  const void* data)
+{
+	m_layer->UpdateIndexBufferRange(id, offset, size, data);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(offset);
+		WriteData(data, size);
+		EndCall(CallType::UpdateIndexBufferRange);
+	}
+}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+void CaptureLayer::CopyVertexBufferRange(const VertexBufferID source,
+										 int sourceOffset,
+										 const VertexBufferID destination,
+										 int destinationOffset,
+										 int size)
+{
+	m_layer->CopyVertexBufferRange(source, sourceOffset, destination, destinationOffset, size);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(source.index);
+		Write(sourceOffset);
+		Write(destination.index);
+		Write(destinationOffset);
+		Write(size);
+		EndCall(CallType::CopyVertexBufferRange);
+	}
+}
+
+void CaptureLayer::CopyIndexBufferRange(const VertexBufferID source,
+										int sourceOffset,
+										const VertexBufferID destination,
+										int destinationOffset,
+										int size)
+{
+	m_layer->CopyIndexBufferRange(source, sourceOffset, destination, destinationOffset, size);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(source.index);
+		Write(sourceOffset);
+		Write(destination.index);
+		Write(destinationOffset);
+		Write(size);
+		EndCall(CallType::CopyIndexBufferRange);
+	}
+}
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+TextureID CaptureLayer::CreateTexture()
+{
+	const TextureID id = m_layer->CreateTexture();
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::CreateTexture);
+	}
+	return id;
+}
+
+void CaptureLayer::DestroyTexture(const TextureID id)
+{
+	m_layer->DestroyTexture(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyTexture);
+	}
+}
+
+void CaptureLayer::LoadTexture(const TextureID id,
+							   int width, int height,
+							   TextureType::Enum textureType,
+							   TextureFormat::Enum textureFormat,
+							   int side, int lodLevel,
+							   const void* data,
+							   const TextureSampling& textureSampling)
+{
+	m_layer->LoadTexture(id, width, height, textureType, textureFormat, side, lodLevel, data, textureSampling);
+
+	TextureInfo& textureInfo = GetTextureInfo(id);
+	if (lodLevel <= 0)
+	{
+		textureInfo.format = textureFormat;
+		textureInfo.width = width;
+		textureInfo.height = height;
+	}
+	if (IsCapturing())
+	{
+		// The size of generic compressed data isn't known, so it is
+		// left out.
+		const bool hasKnownSize = (textureFormat != TextureFormat::Compressed);
+		BeginCall();
+		Write(id.index);
+		Write(width);
+		Write(height);
+		Write(textureType);
+		Write(textureFormat);
+		Write(side);
+		Write(lodLevel);
+		WriteData(hasKnownSize ? data : nullptr, getTextureImageSize(textureFormat, width, height));
+		WriteTextureSampling(textureSampling);
+		EndCall(CallType::LoadTexture);
+	}
+}
+
+void CaptureLayer::GenerateMipMaps(const TextureID id)
+{
+	m_layer->GenerateMipMaps(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::GenerateMipMaps);
+	}
+}
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+void CaptureLayer::LoadTextureArray(const TextureID id,
+									int width, int height,
+									int numberOfLayers,
+									TextureFormat::Enum textureFormat,
+									const TextureSampling& textureSampling)
+{
+	m_layer->LoadTextureArray(id, width, height, numberOfLayers, textureFormat, textureSampling);
+
+	TextureInfo& textureInfo = GetTextureInfo(id);
+	textureInfo.format = textureFormat;
+	textureInfo.width = width;
+	textureInfo.height = height;
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(width);
+		Write(height);
+		Write(numberOfLayers);
+		Write(textureFormat);
+		WriteTextureSampling(textureSampling);
+		EndCall(CallType::LoadTextureArray);
+	}
+}
+
+void CaptureLayer::LoadTextureLayer(const TextureID id, int layer, const void* data)
+{
+	m_layer->LoadTextureLayer(id, layer, data);
+	if (IsCapturing())
+	{
+		const TextureInfo& textureInfo = GetTextureInfo(id);
+		BeginCall();
+		Write(id.index);
+		Write(layer);
+		WriteData(data, getTextureImageSize(textureInfo.format, textureInfo.width, textureInfo.height));
+		EndCall(CallType::LoadTextureLayer);
+	}
+}
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+void CaptureLayer::AllocateTexture(const TextureID id,
+								   int width, int height,
+								   int numberOfLevels,
+								   TextureFormat::Enum textureFormat,
+								   const TextureSampling& textureSampling)
+{
+	m_layer->AllocateTexture(id, width, height, numberOfLevels, textureFormat, textureSampling);
+
+	TextureInfo& textureInfo = GetTextureInfo(id);
+	textureInfo.format = textureFormat;
+	textureInfo.width = width;
+	textureInfo.height = height;
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(width);
+		Write(height);
+		Write(numberOfLevels);
+		Write(textureFormat);
+		WriteTextureSampling(textureSampling);
+		EndCall(CallType::AllocateTexture);
+	}
+}
+
+void CaptureLayer::LoadTextureLevel(const TextureID id, int level, const void* data)
+{
+	m_layer->LoadTextureLevel(id, level, data);
+	if (IsCapturing())
+	{
+		const TextureInfo& textureInfo = GetTextureInfo(id);
+		const int width = textureInfo.width >> level;
+		const int height = textureInfo.height >> level;
+		BeginCall();
+		Write(id.index);
+		Write(level);
+		WriteData(data, getTextureImageSize(textureInfo.format, (width > 0 ? width : 1), (height > 0 ? height : 1)));
+		EndCall(CallType::LoadTextureLevel);
+	}
+}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+void CaptureLayer::LoadCompressedTexture(const TextureID id,
+										 int width, int height,
+										 TextureFormat::Enum textureFormat,
+										 int lodLevel,
+										 int dataSize, const void* data,
+										 const TextureSampling& textureSampling)
+{
+	m_layer->LoadCompressedTexture(id, width, height, textureFormat, lodLevel, dataSize, data, textureSampling);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(width);
+		Write(height);
+		Write(textureFormat);
+		Write(lodLevel);
+		WriteData(data, dataSize);
+		WriteTextureSampling(textureSampling);
+		EndCall(CallType::LoadCompressedTexture);
+	}
+}
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+void* CaptureLayer::MapTextureUpload(const TextureID id, int size)
+{
+	void* buffer = m_layer->MapTextureUpload(id, size);
+	GetTextureInfo(id).mappedUpload = buffer;
+	return buffer;
+}
+
+// The data is in the mapped buffer by now, so the upload is captured
+// as a synchronous load.
+void CaptureLayer::LoadTextureAsync(const TextureID id,
+									int width, int height,
+									TextureType::Enum textureType,
+									TextureFormat::Enum textureFormat,
+									int side, int lodLevel,
+									const TextureSampling& textureSampling)
+{
+	TextureInfo& textureInfo = GetTextureInfo(id);
+	const void* data = textureInfo.mappedUpload;
+	textureInfo.mappedUpload = nullptr;
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(width);
+		Write(height);
+		Write(textureType);
+		Write(textureFormat);
+		Write(side);
+		Write(lodLevel);
+		WriteData(data, getTextureImageSize(textureFormat, width, height));
+		WriteTextureSampling(textureSampling);
+		EndCall(CallType::LoadTexture);
+	}
+	if (lodLevel <= 0)
+	{
+		textureInfo.format = textureFormat;
+		textureInfo.width = width;
+		textureInfo.height = height;
+	}
+
+	// Forwarded last, since the mapping is released by the call.
+	m_layer->LoadTextureAsync(id, width, height, textureType, textureFormat, side, lodLevel, textureSampling);
+}
+
+bool CaptureLayer::IsTextureReady(const TextureID id)
+{
+	return m_layer->IsTextureReady(id);
+}
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+UniformBufferID CaptureLayer::CreateUniformBuffer()
+{
+	const UniformBufferID id = m_layer->CreateUniformBuffer();
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::CreateUniformBuffer);
+	}
+	return id;
+}
+
+void CaptureLayer::DestroyUniformBuffer(const UniformBufferID id)
+{
+	m_layer->DestroyUniformBuffer(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyUniformBuffer);
+	}
+}
+
+void CaptureLayer::LoadUniformBuffer(const UniformBufferID id,
+									 int size,
+									 const void* data)
+{
+	m_layer->LoadUniformBuffer(id, size, data);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(size);
+		WriteData(data, size);
+		EndCall(CallType::LoadUniformBuffer);
+	}
+}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+StorageBufferID CaptureLayer::CreateStorageBuffer()
+{
+	const StorageBufferID id = m_layer->CreateStorageBuffer();
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::CreateStorageBuffer);
+	}
+	return id;
+}
+
+void CaptureLayer::DestroyStorageBuffer(const StorageBufferID id)
+{
+	m_layer->DestroyStorageBuffer(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyStorageBuffer);
+	}
+}
+
+void CaptureLayer::LoadStorageBuffer(const StorageBufferID id, size_t size, const void* data)
+{
+	m_layer->LoadStorageBuffer(id, size, data);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write((int)size);
+		WriteData(data, (int)size);
+		EndCall(CallType::LoadStorageBuffer);
+	}
+}
+
+void CaptureLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void* dest)
+{
+	m_layer->ReadStorageBuffer(id, size, dest);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write((int)size);
+		EndCall(CallType::ReadStorageBuffer);
+	}
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+ReadbackID CaptureLayer::RequestReadback(const StorageBufferID id, int offset, int size)
+{
+	const ReadbackID result = m_layer->RequestReadback(id, offset, size);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(offset);
+		Write(size);
+		Write(result.index);
+		EndCall(CallType::RequestReadback);
+	}
+	return result;
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+ReadbackID CaptureLayer::RequestReadback(const FrameBufferID id,
+										 int x, int y,
+										 int width, int height)
+{
+	const ReadbackID result = m_layer->RequestReadback(id, x, y, width, height);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(x);
+		Write(y);
+		Write(width);
+		Write(height);
+		Write(result.index);
+		EndCall(CallType::RequestFrameBufferReadback);
+	}
+	return result;
+}
+
+// The result is captured, so the replay knows when the data was
+// retrieved.
+bool CaptureLayer::TryGetReadback(const ReadbackID id, void* dest)
+{
+	const bool result = m_layer->TryGetReadback(id, dest);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write((int)result);
+		EndCall(CallType::TryGetReadback);
+	}
+	return result;
+}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+ShaderID CaptureLayer::CreateShader()
+{
+	const ShaderID id = m_layer->CreateShader();
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::CreateShader);
+	}
+	return id;
+}
+
+void CaptureLayer::DestroyShader(const ShaderID id)
+{
+	m_layer->DestroyShader(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyShader);
+	}
+}
+
+void CaptureLayer::LoadShader(const ShaderID id,
+							  const ShaderStage* shaderStages,
+							  int numberOfStages)
+{
+	m_layer->LoadShader(id, shaderStages, numberOfStages);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(numberOfStages);
+		for (int i = 0; i < numberOfStages; ++i)
+		{
+			Write(shaderStages[i].shaderType);
+			WriteString(shaderStages[i].source);
+			WriteString(shaderStages[i].sourceInfo);
+		}
+		EndCall(CallType::LoadShader);
+	}
+}
+
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+void CaptureLayer::LoadShaderAsync(const ShaderID id,
+								   const ShaderStage* shaderStages,
+								   int numberOfStages)
+{
+	m_layer->LoadShaderAsync(id, shaderStages, numberOfStages);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(numberOfStages);
+		for (int i = 0; i < numberOfStages; ++i)
+		{
+			Write(shaderStages[i].shaderType);
+			WriteString(shaderStages[i].source);
+			WriteString(shaderStages[i].sourceInfo);
+		}
+		EndCall(CallType::LoadShaderAsync);
+	}
+}
+
+bool CaptureLayer::IsShaderReady(const ShaderID id)
+{
+	return m_layer->IsShaderReady(id);
+}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+FrameBufferID CaptureLayer::CreateFrameBuffer(const TextureID* textures,
+											  int numberOfTextures,
+											  int side, int lodLevel)
+{
+	const FrameBufferID id = m_layer->CreateFrameBuffer(textures, numberOfTextures, side, lodLevel);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(numberOfTextures);
+		for (int i = 0; i < numberOfTextures; ++i)
+		{
+			Write(textures[i].index);
+		}
+		Write(side);
+		Write(lodLevel);
+		EndCall(CallType::CreateFrameBuffer);
+	}
+	return id;
+}
+
+void CaptureLayer::LoadFrameBuffer(const FrameBufferID id,
+								   const TextureID* textures,
+								   int numberOfTextures,
+								   int side, int lodLevel)
+{
+	m_layer->LoadFrameBuffer(id, textures, numberOfTextures, side, lodLevel);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(numberOfTextures);
+		for (int i = 0; i < numberOfTextures; ++i)
+		{
+			Write(textures[i].index);
+		}
+		Write(side);
+		Write(lodLevel);
+		EndCall(CallType::LoadFrameBuffer);
+	}
+}
+
+void CaptureLayer::DestroyFrameBuffer(const FrameBufferID id)
+{
+	m_layer->DestroyFrameBuffer(id);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		EndCall(CallType::DestroyFrameBuffer);
+	}
+}
+
+void CaptureLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
+									float r, float g, float b,
+									bool clearDepth)
+{
+	m_layer->ClearFrameBuffer(frameBuffer, r, g, b, clearDepth);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(frameBuffer.index);
+		Write(r);
+		Write(g);
+		Write(b);
+		Write((int)clearDepth);
+		EndCall(CallType::ClearFrameBuffer);
+	}
+}
+
+#if GFX_ENABLE_RENDER_PASSES
+void CaptureLayer::BeginRenderPass(const FrameBufferID id,
+								   const LoadOp::Enum* loadOps,
+								   const ClearValue* clearValues,
+								   int numberOfAttachments)
+{
+	m_layer->BeginRenderPass(id, loadOps, clearValues, numberOfAttachments);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(id.index);
+		Write(numberOfAttachments);
+		for (int i = 0; i < numberOfAttachments; ++i)
+		{
+			// The clear values are only meaningful for LoadOp::Clear.
+			const ClearValue clearValue = (loadOps[i] == LoadOp::Clear ? clearValues[i] : ClearValue());
+			Write((int)loadOps[i]);
+			for (int j = 0; j < 4; ++j)
+			{
+				Write(clearValue.color[j]);
+			}
+			Write(clearValue.depth);
+			Write(clearValue.stencil);
+		}
+		EndCall(CallType::BeginRenderPass);
+	}
+}
+
+void CaptureLayer::EndRenderPass(const StoreOp::Enum* storeOps,
+								 int numberOfAttachments)
+{
+	m_layer->EndRenderPass(storeOps, numberOfAttachments);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(numberOfAttachments);
+		for (int i = 0; i < numberOfAttachments; ++i)
+		{
+			Write((int)storeOps[i]);
+		}
+		EndCall(CallType::EndRenderPass);
+	}
+}
+#endif // GFX_ENABLE_RENDER_PASSES
+
+void CaptureLayer::Draw(const DrawArea& drawArea,
+						const RasterTests& rasterTests,
+						const Geometry& geometry,
+						const ShadingParameters& shadingParameters)
+{
+	m_layer->Draw(drawArea, rasterTests, geometry, shadingParameters);
+	if (IsCapturing())
+	{
+		BeginCall();
+		WriteDrawState(drawArea, rasterTests);
+		Write(geometry.vertexBuffer.index);
+		Write(geometry.numberOfIndices);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		Write(geometry.firstIndexOffset);
+		Write(geometry.baseVertex);
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		Write(0);
+		Write(0);
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		WriteShadingParameters(shadingParameters);
+		EndCall(CallType::Draw);
+	}
+}
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+void CaptureLayer::Draw(const DrawArea& drawArea,
+						const RasterTests& rasterTests,
+						const DrawBatch& batch,
+						const ShadingParameters& shadingParameters)
+{
+	m_layer->Draw(drawArea, rasterTests, batch, shadingParameters);
+	if (IsCapturing())
+	{
+		BeginCall();
+		WriteDrawState(drawArea, rasterTests);
+		Write(batch.vertexBuffer.index);
+		WriteData(batch.items.elt, batch.items.size * sizeof(DrawBatch::Item));
+		WriteShadingParameters(shadingParameters);
+		EndCall(CallType::DrawBatch);
+	}
+}
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+// The states and uniforms an item shares with the item before it are
+// written as a flag rather than again, so the replay shares them too,
+// and the layer it plays on skips the same work.
+void CaptureLayer::SubmitDraws(const DrawItem* items, int count)
+{
+	m_layer->SubmitDraws(items, count);
+	if (IsCapturing())
+	{
+		int numberOfUniforms = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			if (i == 0 || items[i].uniforms != items[i - 1].uniforms ||
+				items[i].numberOfUniforms != items[i - 1].numberOfUniforms)
+			{
+				numberOfUniforms += items[i].numberOfUniforms;
+			}
+		}
+
+		BeginCall();
+		Write(count);
+		Write(numberOfUniforms); // To allocate them once on replay.
+		for (int i = 0; i < count; ++i)
+		{
+			const DrawItem& item = items[i];
+			const bool sameState = (i > 0 && item.state == items[i - 1].state);
+			Write((int)sameState);
+			if (!sameState)
+			{
+				const DrawState& state = *item.state;
+				WriteDrawState(state.drawArea, state.rasterTests);
+				WriteData(&state.blendingMode, sizeof(state.blendingMode));
+				Write(state.polygonMode);
+			}
+			const bool sameUniforms = (i > 0 && item.uniforms == items[i - 1].uniforms &&
+									   item.numberOfUniforms == items[i - 1].numberOfUniforms);
+			Write((int)sameUniforms);
+			if (!sameUniforms)
+			{
+				WriteUniforms(item.uniforms, item.numberOfUniforms);
+			}
+			Write(item.shader.index);
+			Write(item.vertexBuffer.index);
+			Write(item.numberOfIndices);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			Write(item.firstIndexOffset);
+			Write(item.baseVertex);
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			Write(0);
+			Write(0);
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			Write(item.numberOfInstances);
+		}
+		EndCall(CallType::SubmitDraws);
+	}
+}
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void CaptureLayer::DrawIndirect(const DrawArea& drawArea,
+								const RasterTests& rasterTests,
+								const VertexBufferID vertexBuffer,
+								const ShadingParameters& shadingParameters,
+								const StorageBufferID arguments,
+								int offset)
+{
+	m_layer->DrawIndirect(drawArea, rasterTests, vertexBuffer, shadingParameters, arguments, offset);
+	if (IsCapturing())
+	{
+		BeginCall();
+		WriteDrawState(drawArea, rasterTests);
+		Write(vertexBuffer.index);
+		Write(arguments.index);
+		Write(offset);
+		WriteShadingParameters(shadingParameters);
+		EndCall(CallType::DrawIndirect);
+	}
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_COMPUTE_SHADERS
+void CaptureLayer::Compute(const ShaderID shader,
+						   const ComputeParameters& computeParameters,
+						   int x, int y, int z)
+{
+	m_layer->Compute(shader, computeParameters, x, y, z);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(shader.index);
+		Write(x);
+		Write(y);
+		Write(z);
+		WriteUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size);
+		EndCall(CallType::Compute);
+	}
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void CaptureLayer::ComputeIndirect(const ShaderID shader,
+								   const ComputeParameters& computeParameters,
+								   const StorageBufferID arguments,
+								   int offset)
+{
+	m_layer->ComputeIndirect(shader, computeParameters, arguments, offset);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(shader.index);
+		Write(arguments.index);
+		Write(offset);
+		WriteUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size);
+		EndCall(CallType::ComputeIndirect);
+	}
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void CaptureLayer::InsertMemoryBarrier(int barriers)
+{
+	m_layer->InsertMemoryBarrier(barriers);
+	if (IsCapturing())
+	{
+		BeginCall();
+		Write(barriers);
+		EndCall(CallType::InsertMemoryBarrier);
+	}
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_GPU_PROFILING
+void CaptureLayer::BeginGpuScope(const char* name)
+{
+	m_layer->BeginGpuScope(name);
+	if (IsCapturing())
+	{
+		BeginCall();
+		WriteString(name);
+		EndCall(CallType::BeginGpuScope);
+	}
+}
+
+void CaptureLayer::EndGpuScope()
+{
+	m_layer->EndGpuScope();
+	if (IsCapturing())
+	{
+		BeginCall();
+		EndCall(CallType::EndGpuScope);
+	}
+}
+#endif // GFX_ENABLE_GPU_PROFILING
+
+void CaptureLayer::EndFrame()
+{
+	m_layer->EndFrame();
+	if (IsCapturing())
+	{
+		BeginCall();
+		EndCall(CallType::EndFrame);
+	}
+}
+
+#endif // GFX_MULTI_API
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include "gfx/CallType.hpp"
+#include "gfx/IGraphicLayer.hpp"
+#include "gfx/TextureFormat.hpp"
+#include <cstdio>
+
+#if GFX_MULTI_API
+
+namespace Gfx
+{
+	struct Uniform;
+
+	/// <summary>
+	/// IGraphicLayer that forwards every call to another layer and, while
+	/// capturing, writes it to a file with everything it was given: the
+	/// vertex, texture and buffer data, the shader sources, the uniforms
+	/// and the render states. See CaptureFormat.hpp for the layout, and
+	/// CaptureReplay to play a capture back.
+	///
+	/// A capture can only be replayed if it has all the resources its
+	/// frames use: start it before they are created and loaded.
+	/// Asynchronous texture uploads are captured as synchronous ones,
+	/// and polls for completion aren't captured.
+	/// </summary>
+	class CaptureLayer : public IGraphicLayer
+	{
+	public:
+		/// <param name="layer">Layer the calls are forwarded to. It is
+		///     not owned by the capture layer.</param>
+		CaptureLayer(IGraphicLayer* layer);
+		~CaptureLayer();
+
+		/// <summary>
+		/// Starts writing the calls to a file, which is overwritten.
+		/// </summary>
+		/// <returns>False if the file couldn't be opened.</returns>
+		bool					BeginCapture(const char* fileName);
+
+		/// <summary>
+		/// Stops the capture and closes the file.
+		/// </summary>
+		/// <returns>False if something couldn't be written.</returns>
+		bool					EndCapture();
+
+		bool					IsCapturing() const { return m_file != nullptr; }
+
+		bool					CreateRenderingContext();
+		void					DestroyRenderingContext();
+
+		VertexBufferID			CreateVertexBuffer();
+		void					DestroyVertexBuffer(const VertexBufferID id);
+		void					LoadVertexBuffer(const VertexBufferID id,
+												 PrimitiveType::Enum primitiveType,
+												 const VertexAttribute* vertexAttributes,
+												 int numberOfAttributes, int stride,
+												 int vertexDataSize, const void* vertexData,
+												 int indexDataSize, const void* indexData,
+												 VertexIndexType::Enum indexType);
+		void					UpdateVertexBufferRange(const VertexBufferID id,
+														int offset, int size,
+														const void* data);
+		void					UpdateIndexBufferRange(const VertexBufferID id,
+													   int offset, int size,
+													   const void* data);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		void					CopyVertexBufferRange(const VertexBufferID source,
+													  int sourceOffset,
+													  const VertexBufferID destination,
+													  int destinationOffset,
+													  int size);
+		void					CopyIndexBufferRange(const VertexBufferID source,
+													 int sourceOffset,
+													 const VertexBufferID destination,
+													 int destinationOffset,
+													 int size);
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+		TextureID				CreateTexture();
+		void					DestroyTexture(const TextureID id);
+		void					LoadTexture(const TextureID id,
+											int width, int height,
+											TextureType::Enum textureType,
+											TextureFormat::Enum textureFormat,
+											int side, int lodLevel,
+											const void* data,
+											const TextureSampling& textureSampling);
+		void					GenerateMipMaps(const TextureID id);
+#if GFX_ENABLE_TEXTURE_ARRAYS
+		void					LoadTextureArray(const TextureID id,
+												 int width, int height,
+												 int numberOfLayers,
+												 TextureFormat::Enum textureFormat,
+												 const TextureSampling& textureSampling);
+		void					LoadTextureLayer(const TextureID id, int layer, const void* data);
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+		void					AllocateTexture(const TextureID id,
+												int width, int height,
+												int numberOfLevels,
+												TextureFormat::Enum textureFormat,
+												const TextureSampling& textureSampling);
+		void					LoadTextureLevel(const TextureID id, int level, const void* data);
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+		void					LoadCompressedTexture(const TextureID id,
+													  int width, int height,
+													  TextureFormat::Enum textureFormat,
+													  int lodLevel,
+													  int dataSize, const void* data,
+													  const TextureSampling& textureSampling);
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		void*					MapTextureUpload(const TextureID id, int size);
+		void					LoadTextureAsync(const TextureID id,
+												 int width, int height,
+												 TextureType::Enum textureType,
+												 TextureFormat::Enum textureFormat,
+												 int side, int lodLevel,
+												 const TextureSampling& textureSampling);
+		bool					IsTextureReady(const TextureID id);
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+		UniformBufferID			CreateUniformBuffer();
+		void					DestroyUniformBuffer(const UniformBufferID id);
+		void					LoadUniformBuffer(const UniformBufferID id,
+												  int size,
+												  const void* data);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		StorageBufferID			CreateStorageBuffer();
+		void					DestroyStorageBuffer(const StorageBufferID id);
+		void					LoadStorageBuffer(const StorageBufferID id,
+												  size_t size,
+												  const void* data);
+		void					ReadStorageBuffer(const StorageBufferID id,
+												  size_t size,
+												  void* dest);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const StorageBufferID id,
+												int offset, int size);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const FrameBufferID id,
+												int x, int y,
+												int width, int height);
+		bool					TryGetReadback(const ReadbackID id, void* dest);
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+		ShaderID				CreateShader();
+		void					DestroyShader(const ShaderID id);
+		void					LoadShader(const ShaderID id,
+										   const ShaderStage* shaderStages,
+										   int numberOfStages);
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		void					LoadShaderAsync(const ShaderID id,
+												const ShaderStage* shaderStages,
+												int numberOfStages);
+		bool					IsShaderReady(const ShaderID id);
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+		FrameBufferID			CreateFrameBuffer(const TextureID* textures,
+												  int numberOfTextures,
+												  int side, int lodLevel);
+		void					LoadFrameBuffer(const FrameBufferID id,
+												const TextureID* textures,
+												int numberOfTextures,
+												int side, int lodLevel);
+		void					DestroyFrameBuffer(const FrameBufferID id);
+		void					ClearFrameBuffer(const FrameBufferID frameBuffer,
+												 float r, float g, float b,
+												 bool clearDepth);
+#if GFX_ENABLE_RENDER_PASSES
+		void					BeginRenderPass(const FrameBufferID id,
+												const LoadOp::Enum* loadOps,
+												const ClearValue* clearValues,
+												int numberOfAttachments);
+		void					EndRenderPass(const StoreOp::Enum* storeOps,
+											  int numberOfAttachments);
+#endif // GFX_ENABLE_RENDER_PASSES
+
+		void					Draw(const DrawArea& drawArea,
+									 const RasterTests& rasterTests,
+									 const Geometry& geometry,
+									 const ShadingParameters& shadingParameters);
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		void					Draw(const DrawArea& drawArea,
+									 const RasterTests& rasterTests,
+									 const DrawBatch& batch,
+									 const ShadingParameters& shadingParameters);
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+		void					SubmitDraws(const DrawItem* items, int count);
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					DrawIndirect(const DrawArea& drawArea,
+											 const RasterTests& rasterTests,
+											 const VertexBufferID vertexBuffer,
+											 const ShadingParameters& shadingParameters,
+											 const StorageBufferID arguments,
+											 int offset);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_COMPUTE_SHADERS
+		void					Compute(const ShaderID shader,
+										const ComputeParameters& computeParameters,
+										int x, int y = 1, int z = 1);
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					ComputeIndirect(const ShaderID shader,
+												const ComputeParameters& computeParameters,
+												const StorageBufferID arguments,
+												int offset);
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					InsertMemoryBarrier(int barriers);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_FRAME_STATS
+		const FrameStats&		GetFrameStats() const { return m_layer->GetFrameStats(); }
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+		void					BeginGpuScope(const char* name);
+		void					EndGpuScope();
+		GpuProfiler&			GetGpuProfiler() { return m_layer->GetGpuProfiler(); }
+#endif // GFX_ENABLE_GPU_PROFILING
+		void					EndFrame();
+
+	private:
+		struct TextureInfo
+		{
+			TextureFormat::Enum	format;
+			int				width;
+			int				height;
+			void*			mappedUpload; // Returned by MapTextureUpload.
+		};
+
+		TextureInfo&			GetTextureInfo(const TextureID id);
+
+		void					BeginCall();
+		void					EndCall(CallType::Enum type);
+		char*					Reserve(int size);
+		void					Write(int value);
+		void					Write(float value);
+		void					WriteData(const void* data, int size);
+		void					WriteString(const char* str);
+		void					WriteTextureSampling(const TextureSampling& textureSampling);
+		void					WriteUniforms(const Uniform* uniforms, int numberOfUniforms);
+		void					WriteDrawState(const DrawArea& drawArea,
+											   const RasterTests& rasterTests);
+		void					WriteShadingParameters(const ShadingParameters& shadingParameters);
+
+		IGraphicLayer*			m_layer;
+		Container::Array<TextureInfo> m_textures; // Indexed by id.
+
+		FILE*					m_file;
+		bool					m_failed; // Something couldn't be written.
+		int						m_numberOfCalls;
+		int						m_numberOfFrames;
+
+		// Arguments of the call being written.
+		char*					m_arguments;
+		int						m_argumentsSize;
+		int						m_argumentsCapacity;
+	};
+}
+
+#endif // GFX_MULTI_API
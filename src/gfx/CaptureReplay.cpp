@@ -0,0 +1,1355 @@
+#include "CaptureReplay.hpp"
+
+#include "BlendingMode.hpp"
+#include "CaptureFormat.hpp"
+#include "DrawArea.hpp"
+#include "Geometry.hpp"
+#include "IGraphicLayerImplementations.hpp"
+#include "RasterTests.hpp"
+#include "VertexAttribute.hpp"
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Limits of the calls that take arrays; larger ones are skipped.
+#define MAX_SHADER_STAGES 8
+#define MAX_FRAME_BUFFER_TEXTURES 16
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::CaptureReplay::LoopResource>;
+
+#endif
+
+static long long getNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void initTable(Container::Array<int>& table, int size)
+{
+	table.init(size);
+	for (int i = 0; i < size; ++i)
+	{
+		table.add(-1);
+	}
+}
+
+void CaptureReplay::CallTimings::Clear()
+{
+	memset(this, 0, sizeof(*this));
+}
+
+CaptureReplay::CaptureReplay():
+	m_data(nullptr),
+	m_size(0),
+	m_ownedData(nullptr),
+	m_frameStarts(nullptr),
+	m_numberOfFrames(0),
+	m_layer(nullptr),
+	m_firstFrame(0),
+	m_looping(false),
+	m_nextLoopResource(0),
+	m_vertexAttributes(new VertexAttribute[GFX_MAX_VERTEX_BUFFERS * GFX_MAX_VERTEX_ATTRIBUTES])
+#if GFX_ENABLE_SUBMIT_DRAWS
+	, m_drawItems(nullptr)
+	, m_drawStates(nullptr)
+	, m_drawUniforms(nullptr)
+	, m_drawItemsCapacity(0)
+	, m_drawUniformsCapacity(0)
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_ASYNC_READBACK
+	, m_readbackData(nullptr)
+	, m_readbackDataCapacity(0)
+#endif // GFX_ENABLE_ASYNC_READBACK
+{
+	memset(m_warnedCalls, 0, sizeof(m_warnedCalls));
+	initTable(m_vertexBuffers, GFX_MAX_VERTEX_BUFFERS);
+	initTable(m_textures, GFX_MAX_TEXTURES);
+	initTable(m_uniformBuffers, GFX_MAX_UNIFORM_BUFFERS);
+	initTable(m_storageBuffers, GFX_MAX_STORAGE_BUFFERS);
+	initTable(m_shaders, GFX_MAX_SHADERS);
+	initTable(m_frameBuffers, GFX_MAX_FRAME_BUFFERS);
+	m_loopResources.init(GFX_MAX_VERTEX_BUFFERS + GFX_MAX_TEXTURES + GFX_MAX_UNIFORM_BUFFERS +
+						 GFX_MAX_STORAGE_BUFFERS + GFX_MAX_SHADERS + GFX_MAX_FRAME_BUFFERS);
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		m_readbacks[i].capturedIndex = -1;
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+}
+
+CaptureReplay::~CaptureReplay()
+{
+	ASSERT(m_layer == nullptr);
+	Unload();
+	delete[] m_vertexAttributes;
+#if GFX_ENABLE_SUBMIT_DRAWS
+	delete[] m_drawItems;
+	delete[] m_drawStates;
+	delete[] m_drawUniforms;
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_ASYNC_READBACK
+	delete[] m_readbackData;
+#endif // GFX_ENABLE_ASYNC_READBACK
+}
+
+bool CaptureReplay::Load(const char* fileName)
+{
+	ASSERT(m_data == nullptr);
+
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+	{
+		LOG_ERROR("Could not open capture %s.", fileName);
+		return false;
+	}
+
+	long size = -1;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		size = ftell(file);
+	}
+	char* data = nullptr;
+	if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+	{
+		data = new char[size];
+		if (fread(data, size, 1, file) != 1)
+		{
+			delete[] data;
+			data = nullptr;
+		}
+	}
+	fclose(file);
+
+	if (data == nullptr)
+	{
+		LOG_ERROR("Could not read capture %s.", fileName);
+		return false;
+	}
+	if (!Init(data, (int)size))
+	{
+		delete[] data;
+		return false;
+	}
+	m_ownedData = data;
+	LOG_INFO("Loaded capture %s: %d frames.", fileName, GetNumberOfFrames());
+	return true;
+}
+
+bool CaptureReplay::Init(const void* data, int size)
+{
+	ASSERT(m_data == nullptr);
+	ASSERT(data != nullptr);
+
+	CaptureHeader header;
+	if (size < (int)sizeof(header))
+	{
+		LOG_ERROR("The capture is truncated.");
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, "GFXC", sizeof(header.magic)) != 0 ||
+		header.version != CaptureVersion)
+	{
+		LOG_ERROR("Not a capture, or a capture of another version.");
+		return false;
+	}
+	if (header.rasterTestsSize != (int)sizeof(RasterTests) ||
+		header.blendingModeSize != (int)sizeof(BlendingMode))
+	{
+		LOG_ERROR("The capture was made with other build flags.");
+		return false;
+	}
+
+	m_data = (const char*)data;
+	m_size = size;
+	if (!IndexFrames())
+	{
+		m_data = nullptr;
+		m_size = 0;
+		return false;
+	}
+	return true;
+}
+
+void CaptureReplay::Unload()
+{
+	ASSERT(m_layer == nullptr);
+	delete[] m_ownedData;
+	m_ownedData = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+	delete[] m_frameStarts;
+	m_frameStarts = nullptr;
+	m_numberOfFrames = 0;
+}
+
+// Checks the calls fit in the capture, and finds where the frames
+// start.
+bool CaptureReplay::IndexFrames()
+{
+	int numberOfFrames = 0;
+	const int firstCall = sizeof(CaptureHeader);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		if (pass == 1)
+		{
+			if (numberOfFrames == 0)
+			{
+				LOG_ERROR("The capture has no complete frame.");
+				return false;
+			}
+			m_frameStarts = new int[numberOfFrames + 1];
+			m_frameStarts[0] = firstCall;
+			m_numberOfFrames = 0;
+		}
+
+		int offset = firstCall;
+		while (offset + (int)sizeof(CaptureCall) <= m_size)
+		{
+			CaptureCall call;
+			memcpy(&call, m_data + offset, sizeof(call));
+			if (call.type < 0 || call.type >= CallType::Count ||
+				call.size < 0 || call.size > m_size - offset - (int)sizeof(call))
+			{
+				LOG_ERROR("The capture is corrupted at offset %d.", offset);
+				return false;
+			}
+			offset += sizeof(call) + call.size;
+			if (call.type == CallType::EndFrame)
+			{
+				if (pass == 0)
+				{
+					++numberOfFrames;
+				}
+				else
+				{
+					m_frameStarts[++m_numberOfFrames] = offset;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//
+// Playing.
+//
+
+void CaptureReplay::Begin(IGraphicLayer* layer, int firstFrame)
+{
+	ASSERT(m_data != nullptr);
+	ASSERT(m_layer == nullptr);
+	ASSERT(layer != nullptr);
+	ASSERT(firstFrame < GetNumberOfFrames());
+
+	m_layer = layer;
+	m_firstFrame = (firstFrame >= 0 ? firstFrame : GetNumberOfFrames() - 1);
+	m_looping = false;
+	PlayCalls(m_frameStarts[0], m_frameStarts[m_firstFrame], nullptr);
+	m_looping = true;
+	m_nextLoopResource = 0;
+}
+
+void CaptureReplay::PlayFrame(int frame, CallTimings* timings)
+{
+	ASSERT(m_layer != nullptr);
+	ASSERT(frame >= m_firstFrame && frame < GetNumberOfFrames());
+	PlayCalls(m_frameStarts[frame], m_frameStarts[frame + 1], timings);
+}
+
+void CaptureReplay::EndLoop()
+{
+	ASSERT(m_layer != nullptr);
+	ASSERT(m_looping);
+#if GFX_ENABLE_ASYNC_READBACK
+	// The tickets retrieved by the looped frames were requested before
+	// them, so the readbacks of the loop are retrieved here instead.
+	RetrieveReadbacks(true);
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+	// Destroying them only unmaps the ones kept for the next loop.
+	for (int i = m_loopResources.size - 1; i >= 0; --i)
+	{
+		Destroy(m_loopResources[i].destroyCall, m_loopResources[i].capturedIndex);
+	}
+	m_nextLoopResource = 0;
+}
+
+void CaptureReplay::End()
+{
+	ASSERT(m_layer != nullptr);
+	EndLoop();
+	m_looping = false;
+	for (int i = m_loopResources.size - 1; i >= 0; --i)
+	{
+		DestroyResource(m_loopResources[i].destroyCall, m_loopResources[i].index);
+	}
+	m_loopResources.clear();
+
+	// Frame buffers first, since they use textures.
+	for (int i = 0; i < m_frameBuffers.size; ++i)
+	{
+		Destroy(CallType::DestroyFrameBuffer, i);
+	}
+	for (int i = 0; i < m_vertexBuffers.size; ++i)
+	{
+		Destroy(CallType::DestroyVertexBuffer, i);
+	}
+	for (int i = 0; i < m_textures.size; ++i)
+	{
+		Destroy(CallType::DestroyTexture, i);
+	}
+	for (int i = 0; i < m_uniformBuffers.size; ++i)
+	{
+		Destroy(CallType::DestroyUniformBuffer, i);
+	}
+	for (int i = 0; i < m_storageBuffers.size; ++i)
+	{
+		Destroy(CallType::DestroyStorageBuffer, i);
+	}
+	for (int i = 0; i < m_shaders.size; ++i)
+	{
+		Destroy(CallType::DestroyShader, i);
+	}
+	m_layer = nullptr;
+}
+
+void CaptureReplay::PlayCalls(int start, int end, CallTimings* timings)
+{
+	int offset = start;
+	while (offset < end)
+	{
+		CaptureCall call;
+		memcpy(&call, m_data + offset, sizeof(call));
+		offset += sizeof(call);
+
+		Reader reader = { m_data + offset, m_data + offset + call.size };
+		const CallType::Enum type = (CallType::Enum)call.type;
+		if (timings != nullptr)
+		{
+			const long long callStart = getNanoseconds();
+			PlayCall(type, reader);
+			timings->duration[type] += getNanoseconds() - callStart;
+			++timings->count[type];
+		}
+		else
+		{
+			PlayCall(type, reader);
+		}
+		offset += call.size;
+	}
+}
+
+//
+// Reading the arguments. A corrupted call reads zeros rather than
+// beyond its arguments.
+//
+
+int CaptureReplay::Reader::ReadInt()
+{
+	int value = 0;
+	if (data + sizeof(value) <= end)
+	{
+		memcpy(&value, data, sizeof(value));
+		data += sizeof(value);
+	}
+	return value;
+}
+
+float CaptureReplay::Reader::ReadFloat()
+{
+	float value = 0.f;
+	if (data + sizeof(value) <= end)
+	{
+		memcpy(&value, data, sizeof(value));
+		data += sizeof(value);
+	}
+	return value;
+}
+
+const void* CaptureReplay::Reader::ReadData(int* size)
+{
+	*size = ReadInt();
+	const int paddedSize = (*size + 3) & ~3;
+	if (*size <= 0 || paddedSize > end - data)
+	{
+		*size = 0;
+		return nullptr;
+	}
+	const void* result = data;
+	data += paddedSize;
+	return result;
+}
+
+const char* CaptureReplay::Reader::ReadString()
+{
+	int size;
+	const char* str = (const char*)ReadData(&size);
+	return (str != nullptr && str[size - 1] == '\0' ? str : nullptr);
+}
+
+void CaptureReplay::ReadTextureSampling(Reader& reader, TextureSampling* textureSampling)
+{
+	textureSampling->minifyingFilter = (TextureFilter::Enum)reader.ReadInt();
+	textureSampling->magnifyingFilter = (TextureFilter::Enum)reader.ReadInt();
+	textureSampling->maxAnisotropy = reader.ReadFloat();
+	textureSampling->rWrap = (TextureWrap::Enum)reader.ReadInt();
+	textureSampling->sWrap = (TextureWrap::Enum)reader.ReadInt();
+	textureSampling->tWrap = (TextureWrap::Enum)reader.ReadInt();
+}
+
+void CaptureReplay::ReadUniform(Reader& reader, Uniform* uniform)
+{
+	uniform->name = reader.ReadString();
+	uniform->size = reader.ReadInt();
+	uniform->type = (UniformType::Enum)reader.ReadInt();
+
+	int size;
+	const void* value = reader.ReadData(&size);
+	memset(uniform->fValue, 0, sizeof(uniform->fValue));
+	memcpy(uniform->fValue, value, (size < (int)sizeof(uniform->fValue) ? size : sizeof(uniform->fValue)));
+
+	switch (uniform->type)
+	{
+	case UniformType::Sampler:
+		uniform->textureId.index = (uniform->textureId.index >= 0 && uniform->textureId.index < m_textures.size ?
+									m_textures[uniform->textureId.index] : -1);
+		break;
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	case UniformType::UniformBuffer:
+		uniform->uniformBufferId.index = (uniform->uniformBufferId.index >= 0 && uniform->uniformBufferId.index < m_uniformBuffers.size ?
+										  m_uniformBuffers[uniform->uniformBufferId.index] : -1);
+		break;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case UniformType::StorageBufferInput:
+	case UniformType::StorageBufferOutput:
+		uniform->storageBufferId.index = (uniform->storageBufferId.index >= 0 && uniform->storageBufferId.index < m_storageBuffers.size ?
+										  m_storageBuffers[uniform->storageBufferId.index] : -1);
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	default:
+		break;
+	}
+}
+
+void CaptureReplay::ReadUniforms(Reader& reader, Container::Array<Uniform>* uniforms)
+{
+	uniforms->clear();
+	const int numberOfUniforms = reader.ReadInt();
+	for (int i = 0; i < numberOfUniforms && i < GFX_MAX_UNIFORMS; ++i)
+	{
+		ReadUniform(reader, &uniforms->getNew());
+	}
+}
+
+void CaptureReplay::ReadDrawState(Reader& reader, DrawArea* drawArea, RasterTests* rasterTests)
+{
+	const int frameBuffer = reader.ReadInt();
+	drawArea->frameBuffer.index = (frameBuffer >= 0 && frameBuffer < m_frameBuffers.size ? m_frameBuffers[frameBuffer] : -1);
+	drawArea->viewport.x = reader.ReadInt();
+	drawArea->viewport.y = reader.ReadInt();
+	drawArea->viewport.width = reader.ReadInt();
+	drawArea->viewport.height = reader.ReadInt();
+
+	int size;
+	const void* data = reader.ReadData(&size);
+	if (size == (int)sizeof(*rasterTests))
+	{
+		memcpy(rasterTests, data, size);
+	}
+}
+
+void CaptureReplay::ReadShadingParameters(Reader& reader, ShadingParameters* shadingParameters)
+{
+	int size;
+	const void* data = reader.ReadData(&size);
+	if (size == (int)sizeof(shadingParameters->blendingMode))
+	{
+		memcpy(&shadingParameters->blendingMode, data, size);
+	}
+	shadingParameters->numberOfInstances = reader.ReadInt();
+	shadingParameters->polygonMode = (PolygonMode::Enum)reader.ReadInt();
+	const int shader = reader.ReadInt();
+	shadingParameters->shader.index = (shader >= 0 && shader < m_shaders.size ? m_shaders[shader] : -1);
+	ReadUniforms(reader, &shadingParameters->uniforms);
+}
+
+//
+// Mapping the ids.
+//
+
+Container::Array<int>& CaptureReplay::GetTable(CallType::Enum destroyCall)
+{
+	switch (destroyCall)
+	{
+	case CallType::DestroyTexture:			return m_textures;
+	case CallType::DestroyUniformBuffer:	return m_uniformBuffers;
+	case CallType::DestroyStorageBuffer:	return m_storageBuffers;
+	case CallType::DestroyShader:			return m_shaders;
+	case CallType::DestroyFrameBuffer:		return m_frameBuffers;
+	default:
+		ASSERT(destroyCall == CallType::DestroyVertexBuffer);
+		return m_vertexBuffers;
+	}
+}
+
+// Returns the replay id of the resource the previous loop created at
+// the same call, or -1 if one should be created. The calls are the
+// same from one loop to the next, and so are the resources.
+int CaptureReplay::ReuseLoopResource(CallType::Enum destroyCall) const
+{
+	if (!m_looping || m_nextLoopResource >= m_loopResources.size)
+	{
+		return -1;
+	}
+	const LoopResource& resource = m_loopResources[m_nextLoopResource];
+	ASSERT(resource.destroyCall == destroyCall);
+	UNUSED_EXPR(destroyCall);
+	return resource.index;
+}
+
+// Whether a resource destroyed by the looped frames should be kept for
+// the next loop instead.
+bool CaptureReplay::KeepLoopResource(CallType::Enum destroyCall, int index) const
+{
+	if (!m_looping)
+	{
+		return false;
+	}
+	for (int i = 0; i < m_loopResources.size; ++i)
+	{
+		if (m_loopResources[i].destroyCall == destroyCall &&
+			m_loopResources[i].index == index)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void CaptureReplay::Map(CallType::Enum destroyCall, int capturedIndex, int index)
+{
+	if (m_looping)
+	{
+		LoopResource& resource = (m_nextLoopResource < m_loopResources.size ?
+								  m_loopResources[m_nextLoopResource] :
+								  m_loopResources.getNew());
+		resource.destroyCall = destroyCall;
+		resource.capturedIndex = capturedIndex;
+		resource.index = index;
+		++m_nextLoopResource;
+	}
+
+	Container::Array<int>& table = GetTable(destroyCall);
+	if (capturedIndex < 0 || capturedIndex >= table.size)
+	{
+		LOG_ERROR("Captured resource %d is out of range; the replay will be wrong.", capturedIndex);
+		return;
+	}
+	table[capturedIndex] = index;
+}
+
+// Returns the replay id of a resource about to be destroyed, or -1.
+int CaptureReplay::Unmap(Container::Array<int>& table, int capturedIndex)
+{
+	if (capturedIndex < 0 || capturedIndex >= table.size)
+	{
+		return -1;
+	}
+	const int index = table[capturedIndex];
+	table[capturedIndex] = -1;
+	return index;
+}
+
+void CaptureReplay::Destroy(CallType::Enum destroyCall, int capturedIndex)
+{
+	const int index = Unmap(GetTable(destroyCall), capturedIndex);
+	if (index >= 0 && !KeepLoopResource(destroyCall, index))
+	{
+		DestroyResource(destroyCall, index);
+	}
+}
+
+void CaptureReplay::DestroyResource(CallType::Enum destroyCall, int index)
+{
+	switch (destroyCall)
+	{
+	case CallType::DestroyVertexBuffer:
+		{
+			const VertexBufferID id = { index };
+			m_layer->DestroyVertexBuffer(id);
+		}
+		break;
+	case CallType::DestroyTexture:
+		{
+			const TextureID id = { index };
+			m_layer->DestroyTexture(id);
+		}
+		break;
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	case CallType::DestroyUniformBuffer:
+		{
+			const UniformBufferID id = { index };
+			m_layer->DestroyUniformBuffer(id);
+		}
+		break;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::DestroyStorageBuffer:
+		{
+			const StorageBufferID id = { index };
+			m_layer->DestroyStorageBuffer(id);
+		}
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::DestroyShader:
+		{
+			const ShaderID id = { index };
+			m_layer->DestroyShader(id);
+		}
+		break;
+	case CallType::DestroyFrameBuffer:
+		{
+			const FrameBufferID id = { index };
+			m_layer->DestroyFrameBuffer(id);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+//
+// The calls, read as CaptureLayer writes them.
+//
+
+void CaptureReplay::PlayCall(CallType::Enum type, Reader& reader)
+{
+	switch (type)
+	{
+	// The replay layer already has its context.
+	case CallType::CreateRenderingContext:
+	case CallType::DestroyRenderingContext:
+		break;
+
+	case CallType::CreateVertexBuffer:
+		{
+			const int capturedIndex = reader.ReadInt();
+			int index = ReuseLoopResource(CallType::DestroyVertexBuffer);
+			if (index < 0)
+			{
+				index = m_layer->CreateVertexBuffer().index;
+			}
+			Map(CallType::DestroyVertexBuffer, capturedIndex, index);
+		}
+		break;
+	case CallType::LoadVertexBuffer:
+		{
+			const int vertexBuffer = reader.ReadInt();
+			const VertexBufferID id = { (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1) };
+			const PrimitiveType::Enum primitiveType = (PrimitiveType::Enum)reader.ReadInt();
+			const int numberOfAttributes = reader.ReadInt();
+			if (numberOfAttributes < 0 || numberOfAttributes > GFX_MAX_VERTEX_ATTRIBUTES)
+			{
+				LOG_ERROR("Skipped a vertex buffer with %d attributes.", numberOfAttributes);
+				break;
+			}
+			if (vertexBuffer < 0 || vertexBuffer >= GFX_MAX_VERTEX_BUFFERS)
+			{
+				LOG_ERROR("Skipped vertex buffer %d, which is out of range.", vertexBuffer);
+				break;
+			}
+			VertexAttribute* vertexAttributes = m_vertexAttributes + vertexBuffer * GFX_MAX_VERTEX_ATTRIBUTES;
+			for (int i = 0; i < numberOfAttributes; ++i)
+			{
+				vertexAttributes[i].name = reader.ReadString();
+				vertexAttributes[i].num = reader.ReadInt();
+				vertexAttributes[i].type = (VertexAttributeType::Enum)reader.ReadInt();
+			}
+			const int stride = reader.ReadInt();
+			const int vertexDataSize = reader.ReadInt();
+			int size;
+			const void* vertexData = reader.ReadData(&size);
+			const int indexDataSize = reader.ReadInt();
+			const void* indexData = reader.ReadData(&size);
+			const VertexIndexType::Enum indexType = (VertexIndexType::Enum)reader.ReadInt();
+			m_layer->LoadVertexBuffer(id, primitiveType, vertexAttributes, numberOfAttributes, stride,
+									  vertexDataSize, vertexData, indexDataSize, indexData, indexType);
+		}
+		break;
+	case CallType::UpdateVertexBufferRange:
+	case CallType::UpdateIndexBufferRange:
+		{
+			const int vertexBuffer = reader.ReadInt();
+			const VertexBufferID id = { (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1) };
+			const int offset = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			if (type == CallType::UpdateVertexBufferRange)
+			{
+				m_layer->UpdateVertexBufferRange(id, offset, size, data);
+			}
+			else
+			{
+				m_layer->UpdateIndexBufferRange(id, offset, size, data);
+			}
+		}
+		break;
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	case CallType::CopyVertexBufferRange:
+	case CallType::CopyIndexBufferRange:
+		{
+			const int source = reader.ReadInt();
+			const VertexBufferID sourceId = { (source >= 0 && source < m_vertexBuffers.size ? m_vertexBuffers[source] : -1) };
+			const int sourceOffset = reader.ReadInt();
+			const int destination = reader.ReadInt();
+			const VertexBufferID destinationId = { (destination >= 0 && destination < m_vertexBuffers.size ? m_vertexBuffers[destination] : -1) };
+			const int destinationOffset = reader.ReadInt();
+			const int size = reader.ReadInt();
+			if (type == CallType::CopyVertexBufferRange)
+			{
+				m_layer->CopyVertexBufferRange(sourceId, sourceOffset, destinationId, destinationOffset, size);
+			}
+			else
+			{
+				m_layer->CopyIndexBufferRange(sourceId, sourceOffset, destinationId, destinationOffset, size);
+			}
+		}
+		break;
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+	case CallType::CreateTexture:
+		{
+			const int capturedIndex = reader.ReadInt();
+			int index = ReuseLoopResource(CallType::DestroyTexture);
+			if (index < 0)
+			{
+				index = m_layer->CreateTexture().index;
+			}
+			Map(CallType::DestroyTexture, capturedIndex, index);
+		}
+		break;
+	case CallType::LoadTexture:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int width = reader.ReadInt();
+			const int height = reader.ReadInt();
+			const TextureType::Enum textureType = (TextureType::Enum)reader.ReadInt();
+			const TextureFormat::Enum textureFormat = (TextureFormat::Enum)reader.ReadInt();
+			const int side = reader.ReadInt();
+			const int lodLevel = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			TextureSampling textureSampling;
+			ReadTextureSampling(reader, &textureSampling);
+			m_layer->LoadTexture(id, width, height, textureType, textureFormat, side, lodLevel, data, textureSampling);
+		}
+		break;
+	case CallType::GenerateMipMaps:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			m_layer->GenerateMipMaps(id);
+		}
+		break;
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	case CallType::LoadTextureArray:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int width = reader.ReadInt();
+			const int height = reader.ReadInt();
+			const int numberOfLayers = reader.ReadInt();
+			const TextureFormat::Enum textureFormat = (TextureFormat::Enum)reader.ReadInt();
+			TextureSampling textureSampling;
+			ReadTextureSampling(reader, &textureSampling);
+			m_layer->LoadTextureArray(id, width, height, numberOfLayers, textureFormat, textureSampling);
+		}
+		break;
+	case CallType::LoadTextureLayer:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int layer = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			m_layer->LoadTextureLayer(id, layer, data);
+		}
+		break;
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+	case CallType::AllocateTexture:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int width = reader.ReadInt();
+			const int height = reader.ReadInt();
+			const int numberOfLevels = reader.ReadInt();
+			const TextureFormat::Enum textureFormat = (TextureFormat::Enum)reader.ReadInt();
+			TextureSampling textureSampling;
+			ReadTextureSampling(reader, &textureSampling);
+			m_layer->AllocateTexture(id, width, height, numberOfLevels, textureFormat, textureSampling);
+		}
+		break;
+	case CallType::LoadTextureLevel:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int level = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			m_layer->LoadTextureLevel(id, level, data);
+		}
+		break;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+	case CallType::LoadCompressedTexture:
+		{
+			const int texture = reader.ReadInt();
+			const TextureID id = { (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1) };
+			const int width = reader.ReadInt();
+			const int height = reader.ReadInt();
+			const TextureFormat::Enum textureFormat = (TextureFormat::Enum)reader.ReadInt();
+			const int lodLevel = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			TextureSampling textureSampling;
+			ReadTextureSampling(reader, &textureSampling);
+			m_layer->LoadCompressedTexture(id, width, height, textureFormat, lodLevel, size, data, textureSampling);
+		}
+		break;
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	case CallType::CreateUniformBuffer:
+		{
+			const int capturedIndex = reader.ReadInt();
+			int index = ReuseLoopResource(CallType::DestroyUniformBuffer);
+			if (index < 0)
+			{
+				index = m_layer->CreateUniformBuffer().index;
+			}
+			Map(CallType::DestroyUniformBuffer, capturedIndex, index);
+		}
+		break;
+	case CallType::LoadUniformBuffer:
+		{
+			const int uniformBuffer = reader.ReadInt();
+			const UniformBufferID id = { (uniformBuffer >= 0 && uniformBuffer < m_uniformBuffers.size ? m_uniformBuffers[uniformBuffer] : -1) };
+			const int bufferSize = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			m_layer->LoadUniformBuffer(id, bufferSize, data);
+		}
+		break;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::CreateStorageBuffer:
+		{
+			const int capturedIndex = reader.ReadInt();
+			int index = ReuseLoopResource(CallType::DestroyStorageBuffer);
+			if (index < 0)
+			{
+				index = m_layer->CreateStorageBuffer().index;
+			}
+			Map(CallType::DestroyStorageBuffer, capturedIndex, index);
+		}
+		break;
+	case CallType::LoadStorageBuffer:
+		{
+			const int storageBuffer = reader.ReadInt();
+			const StorageBufferID id = { (storageBuffer >= 0 && storageBuffer < m_storageBuffers.size ? m_storageBuffers[storageBuffer] : -1) };
+			const int bufferSize = reader.ReadInt();
+			int size;
+			const void* data = reader.ReadData(&size);
+			m_layer->LoadStorageBuffer(id, bufferSize, data);
+		}
+		break;
+	case CallType::ReadStorageBuffer:
+		{
+			const int storageBuffer = reader.ReadInt();
+			const StorageBufferID id = { (storageBuffer >= 0 && storageBuffer < m_storageBuffers.size ? m_storageBuffers[storageBuffer] : -1) };
+			const int size = reader.ReadInt();
+
+			// The read back is what stalls, whatever the data goes to.
+			char* dest = new char[size > 0 ? size : 1];
+			m_layer->ReadStorageBuffer(id, size, dest);
+			delete[] dest;
+		}
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	case CallType::CreateShader:
+		{
+			const int capturedIndex = reader.ReadInt();
+			int index = ReuseLoopResource(CallType::DestroyShader);
+			if (index < 0)
+			{
+				index = m_layer->CreateShader().index;
+			}
+			Map(CallType::DestroyShader, capturedIndex, index);
+		}
+		break;
+	case CallType::LoadShader:
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	case CallType::LoadShaderAsync:
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		{
+			const int shader = reader.ReadInt();
+			const ShaderID id = { (shader >= 0 && shader < m_shaders.size ? m_shaders[shader] : -1) };
+			const int numberOfStages = reader.ReadInt();
+			if (numberOfStages < 0 || numberOfStages > MAX_SHADER_STAGES)
+			{
+				LOG_ERROR("Skipped a shader with %d stages.", numberOfStages);
+				break;
+			}
+			ShaderStage shaderStages[MAX_SHADER_STAGES];
+			for (int i = 0; i < numberOfStages; ++i)
+			{
+				shaderStages[i].shaderType = (ShaderType::Enum)reader.ReadInt();
+				shaderStages[i].source = reader.ReadString();
+				shaderStages[i].sourceInfo = reader.ReadString();
+			}
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+			if (type == CallType::LoadShaderAsync)
+			{
+				m_layer->LoadShaderAsync(id, shaderStages, numberOfStages);
+				break;
+			}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+			m_layer->LoadShader(id, shaderStages, numberOfStages);
+		}
+		break;
+
+	case CallType::CreateFrameBuffer:
+	case CallType::LoadFrameBuffer:
+		{
+			const int frameBuffer = reader.ReadInt();
+			const int numberOfTextures = reader.ReadInt();
+			if (numberOfTextures <= 0 || numberOfTextures > MAX_FRAME_BUFFER_TEXTURES)
+			{
+				LOG_ERROR("Skipped a frame buffer with %d textures.", numberOfTextures);
+				break;
+			}
+			TextureID textures[MAX_FRAME_BUFFER_TEXTURES];
+			for (int i = 0; i < numberOfTextures; ++i)
+			{
+				const int texture = reader.ReadInt();
+				textures[i].index = (texture >= 0 && texture < m_textures.size ? m_textures[texture] : -1);
+			}
+			const int side = reader.ReadInt();
+			const int lodLevel = reader.ReadInt();
+			if (type == CallType::LoadFrameBuffer)
+			{
+				const FrameBufferID id = { (frameBuffer >= 0 && frameBuffer < m_frameBuffers.size ? m_frameBuffers[frameBuffer] : -1) };
+				m_layer->LoadFrameBuffer(id, textures, numberOfTextures, side, lodLevel);
+				break;
+			}
+
+			// The one of the previous loop is loaded again, since its
+			// textures may have been loaded again with new storage.
+			FrameBufferID id = { ReuseLoopResource(CallType::DestroyFrameBuffer) };
+			if (id.index >= 0)
+			{
+				m_layer->LoadFrameBuffer(id, textures, numberOfTextures, side, lodLevel);
+			}
+			else
+			{
+				id = m_layer->CreateFrameBuffer(textures, numberOfTextures, side, lodLevel);
+			}
+			Map(CallType::DestroyFrameBuffer, frameBuffer, id.index);
+		}
+		break;
+	case CallType::ClearFrameBuffer:
+		{
+			const int frameBuffer = reader.ReadInt();
+			const FrameBufferID id = { (frameBuffer >= 0 && frameBuffer < m_frameBuffers.size ? m_frameBuffers[frameBuffer] : -1) };
+			const float r = reader.ReadFloat();
+			const float g = reader.ReadFloat();
+			const float b = reader.ReadFloat();
+			const bool clearDepth = (reader.ReadInt() != 0);
+			m_layer->ClearFrameBuffer(id, r, g, b, clearDepth);
+		}
+		break;
+#if GFX_ENABLE_RENDER_PASSES
+	case CallType::BeginRenderPass:
+		{
+			const int frameBuffer = reader.ReadInt();
+			const FrameBufferID id = { (frameBuffer >= 0 && frameBuffer < m_frameBuffers.size ? m_frameBuffers[frameBuffer] : -1) };
+			const int numberOfAttachments = reader.ReadInt();
+			if (numberOfAttachments <= 0 || numberOfAttachments > MaxFrameBufferAttachments)
+			{
+				LOG_ERROR("Skipped a render pass with %d attachments.", numberOfAttachments);
+				break;
+			}
+			LoadOp::Enum loadOps[MaxFrameBufferAttachments];
+			ClearValue clearValues[MaxFrameBufferAttachments];
+			for (int i = 0; i < numberOfAttachments; ++i)
+			{
+				loadOps[i] = (LoadOp::Enum)reader.ReadInt();
+				for (int j = 0; j < 4; ++j)
+				{
+					clearValues[i].color[j] = reader.ReadFloat();
+				}
+				clearValues[i].depth = reader.ReadFloat();
+				clearValues[i].stencil = reader.ReadInt();
+			}
+			m_layer->BeginRenderPass(id, loadOps, clearValues, numberOfAttachments);
+		}
+		break;
+	case CallType::EndRenderPass:
+		{
+			const int numberOfAttachments = reader.ReadInt();
+			if (numberOfAttachments <= 0 || numberOfAttachments > MaxFrameBufferAttachments)
+			{
+				LOG_ERROR("Skipped the end of a render pass with %d attachments.", numberOfAttachments);
+				break;
+			}
+			StoreOp::Enum storeOps[MaxFrameBufferAttachments];
+			for (int i = 0; i < numberOfAttachments; ++i)
+			{
+				storeOps[i] = (StoreOp::Enum)reader.ReadInt();
+			}
+			m_layer->EndRenderPass(storeOps, numberOfAttachments);
+		}
+		break;
+#endif // GFX_ENABLE_RENDER_PASSES
+
+	case CallType::DestroyVertexBuffer:
+	case CallType::DestroyTexture:
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	case CallType::DestroyUniformBuffer:
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::DestroyStorageBuffer:
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::DestroyShader:
+	case CallType::DestroyFrameBuffer:
+		Destroy(type, reader.ReadInt());
+		break;
+
+	case CallType::Draw:
+		{
+			DrawArea drawArea;
+			RasterTests rasterTests;
+			ReadDrawState(reader, &drawArea, &rasterTests);
+			const int vertexBuffer = reader.ReadInt();
+			Geometry geometry;
+			geometry.vertexBuffer.index = (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1);
+			geometry.numberOfIndices = reader.ReadInt();
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			geometry.firstIndexOffset = reader.ReadInt();
+			geometry.baseVertex = reader.ReadInt();
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			reader.ReadInt();
+			reader.ReadInt();
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+			ReadShadingParameters(reader, &m_shadingParameters);
+			m_layer->Draw(drawArea, rasterTests, geometry, m_shadingParameters);
+		}
+		break;
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+	case CallType::DrawBatch:
+		{
+			DrawArea drawArea;
+			RasterTests rasterTests;
+			ReadDrawState(reader, &drawArea, &rasterTests);
+			const int vertexBuffer = reader.ReadInt();
+			m_drawBatch.Clear();
+			m_drawBatch.vertexBuffer.index = (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1);
+			int size;
+			const void* items = reader.ReadData(&size);
+			const int numberOfItems = size / (int)sizeof(DrawBatch::Item);
+			for (int i = 0; i < numberOfItems && i < GFX_MAX_DRAW_BATCH_SIZE; ++i)
+			{
+				memcpy(&m_drawBatch.items.getNew(), (const char*)items + i * sizeof(DrawBatch::Item), sizeof(DrawBatch::Item));
+			}
+			ReadShadingParameters(reader, &m_shadingParameters);
+			m_layer->Draw(drawArea, rasterTests, m_drawBatch, m_shadingParameters);
+		}
+		break;
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+	case CallType::SubmitDraws:
+		PlaySubmitDraws(reader);
+		break;
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::DrawIndirect:
+		{
+			DrawArea drawArea;
+			RasterTests rasterTests;
+			ReadDrawState(reader, &drawArea, &rasterTests);
+			const int vertexBuffer = reader.ReadInt();
+			const VertexBufferID vertexBufferId = { (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1) };
+			const int arguments = reader.ReadInt();
+			const StorageBufferID argumentsId = { (arguments >= 0 && arguments < m_storageBuffers.size ? m_storageBuffers[arguments] : -1) };
+			const int offset = reader.ReadInt();
+			ReadShadingParameters(reader, &m_shadingParameters);
+			m_layer->DrawIndirect(drawArea, rasterTests, vertexBufferId, m_shadingParameters, argumentsId, offset);
+		}
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_COMPUTE_SHADERS
+	case CallType::Compute:
+		{
+			const int shader = reader.ReadInt();
+			const ShaderID id = { (shader >= 0 && shader < m_shaders.size ? m_shaders[shader] : -1) };
+			const int x = reader.ReadInt();
+			const int y = reader.ReadInt();
+			const int z = reader.ReadInt();
+			ReadUniforms(reader, &m_computeParameters.uniforms);
+			m_layer->Compute(id, m_computeParameters, x, y, z);
+		}
+		break;
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::ComputeIndirect:
+		{
+			const int shader = reader.ReadInt();
+			const ShaderID id = { (shader >= 0 && shader < m_shaders.size ? m_shaders[shader] : -1) };
+			const int arguments = reader.ReadInt();
+			const StorageBufferID argumentsId = { (arguments >= 0 && arguments < m_storageBuffers.size ? m_storageBuffers[arguments] : -1) };
+			const int offset = reader.ReadInt();
+			ReadUniforms(reader, &m_computeParameters.uniforms);
+			m_layer->ComputeIndirect(id, m_computeParameters, argumentsId, offset);
+		}
+		break;
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::InsertMemoryBarrier:
+		m_layer->InsertMemoryBarrier(reader.ReadInt());
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::RequestReadback:
+		{
+			const int storageBuffer = reader.ReadInt();
+			const StorageBufferID id = { (storageBuffer >= 0 && storageBuffer < m_storageBuffers.size ? m_storageBuffers[storageBuffer] : -1) };
+			const int offset = reader.ReadInt();
+			const int size = reader.ReadInt();
+			const int capturedIndex = reader.ReadInt();
+			RetrieveReadbacks(false);
+			AddReadback(capturedIndex, m_layer->RequestReadback(id, offset, size), size);
+		}
+		break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	case CallType::RequestFrameBufferReadback:
+		{
+			const int frameBuffer = reader.ReadInt();
+			const FrameBufferID id = { (frameBuffer >= 0 && frameBuffer < m_frameBuffers.size ? m_frameBuffers[frameBuffer] : -1) };
+			const int x = reader.ReadInt();
+			const int y = reader.ReadInt();
+			const int width = reader.ReadInt();
+			const int height = reader.ReadInt();
+			const int capturedIndex = reader.ReadInt();
+			RetrieveReadbacks(false);
+			AddReadback(capturedIndex, m_layer->RequestReadback(id, x, y, width, height), width * height * 4);
+		}
+		break;
+	case CallType::TryGetReadback:
+		{
+			const int capturedIndex = reader.ReadInt();
+			const bool result = (reader.ReadInt() != 0);
+
+			// The ticket may have been retrieved earlier in the replay,
+			// or not have been requested, if the layer had no buffer.
+			for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+			{
+				PendingReadback& readback = m_readbacks[i];
+				if (readback.capturedIndex == capturedIndex && capturedIndex >= 0)
+				{
+					if (!RetrieveReadback(readback) && result)
+					{
+						readback.retrieved = true;
+					}
+					break;
+				}
+			}
+		}
+		break;
+#endif // GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_GPU_PROFILING
+	case CallType::BeginGpuScope:
+		// The name is kept by the profiler, and lives as long as the
+		// capture.
+		m_layer->BeginGpuScope(reader.ReadString());
+		break;
+	case CallType::EndGpuScope:
+		m_layer->EndGpuScope();
+		break;
+#endif // GFX_ENABLE_GPU_PROFILING
+	case CallType::EndFrame:
+		m_layer->EndFrame();
+		break;
+
+	default:
+		if (!m_warnedCalls[type])
+		{
+			LOG_WARNING("Skipped %s calls, which this build doesn't support.", GetCallName(type));
+			m_warnedCalls[type] = true;
+		}
+		break;
+	}
+}
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+// Rebuilds the items with the states and uniforms shared as they were
+// in the capture.
+void CaptureReplay::PlaySubmitDraws(Reader& reader)
+{
+	const int count = reader.ReadInt();
+	const int totalUniforms = reader.ReadInt();
+	if (count < 0 || totalUniforms < 0)
+	{
+		return;
+	}
+	if (count > m_drawItemsCapacity)
+	{
+		delete[] m_drawItems;
+		delete[] m_drawStates;
+		m_drawItems = new DrawItem[count];
+		m_drawStates = new DrawState[count];
+		m_drawItemsCapacity = count;
+	}
+	if (totalUniforms > m_drawUniformsCapacity)
+	{
+		delete[] m_drawUniforms;
+		m_drawUniforms = new Uniform[totalUniforms];
+		m_drawUniformsCapacity = totalUniforms;
+	}
+
+	int numberOfStates = 0;
+	int numberOfUniforms = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		DrawItem& item = m_drawItems[i];
+		const bool sameState = (reader.ReadInt() != 0 && i > 0);
+		if (sameState)
+		{
+			item.state = m_drawItems[i - 1].state;
+		}
+		else
+		{
+			DrawState& state = m_drawStates[numberOfStates++];
+			ReadDrawState(reader, &state.drawArea, &state.rasterTests);
+			int size;
+			const void* data = reader.ReadData(&size);
+			if (size == (int)sizeof(state.blendingMode))
+			{
+				memcpy(&state.blendingMode, data, size);
+			}
+			state.polygonMode = (PolygonMode::Enum)reader.ReadInt();
+			item.state = &state;
+		}
+
+		const bool sameUniforms = (reader.ReadInt() != 0 && i > 0);
+		if (sameUniforms)
+		{
+			item.uniforms = m_drawItems[i - 1].uniforms;
+			item.numberOfUniforms = m_drawItems[i - 1].numberOfUniforms;
+		}
+		else
+		{
+			const int itemUniforms = reader.ReadInt();
+			item.uniforms = m_drawUniforms + numberOfUniforms;
+			item.numberOfUniforms = 0;
+			for (int j = 0; j < itemUniforms && numberOfUniforms < totalUniforms; ++j)
+			{
+				ReadUniform(reader, &m_drawUniforms[numberOfUniforms++]);
+				++item.numberOfUniforms;
+			}
+		}
+
+		const int shader = reader.ReadInt();
+		item.shader.index = (shader >= 0 && shader < m_shaders.size ? m_shaders[shader] : -1);
+		const int vertexBuffer = reader.ReadInt();
+		item.vertexBuffer.index = (vertexBuffer >= 0 && vertexBuffer < m_vertexBuffers.size ? m_vertexBuffers[vertexBuffer] : -1);
+		item.numberOfIndices = reader.ReadInt();
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		item.firstIndexOffset = reader.ReadInt();
+		item.baseVertex = reader.ReadInt();
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		reader.ReadInt();
+		reader.ReadInt();
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		item.numberOfInstances = reader.ReadInt();
+	}
+	m_layer->SubmitDraws(m_drawItems, count);
+}
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_ASYNC_READBACK
+void CaptureReplay::AddReadback(int capturedIndex, const ReadbackID id, int size)
+{
+	if (id == ReadbackID::InvalidID || capturedIndex < 0)
+	{
+		return;
+	}
+
+	// The layer has as many buffers, so there is always a free entry.
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		PendingReadback& readback = m_readbacks[i];
+		if (readback.capturedIndex < 0)
+		{
+			readback.capturedIndex = capturedIndex;
+			readback.id = id;
+			readback.size = size;
+			readback.retrieved = false;
+			return;
+		}
+	}
+	ASSERT(false);
+}
+
+bool CaptureReplay::RetrieveReadback(PendingReadback& readback)
+{
+	if (readback.size > m_readbackDataCapacity)
+	{
+		delete[] m_readbackData;
+		m_readbackData = new char[readback.size];
+		m_readbackDataCapacity = readback.size;
+	}
+	if (!m_layer->TryGetReadback(readback.id, m_readbackData))
+	{
+		return false;
+	}
+	readback.capturedIndex = -1;
+	return true;
+}
+
+// Tries again the readbacks the capture has retrieved, or, if wait is
+// true, retrieves all of them.
+void CaptureReplay::RetrieveReadbacks(bool wait)
+{
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		PendingReadback& readback = m_readbacks[i];
+		if (readback.capturedIndex < 0 || !(wait || readback.retrieved))
+		{
+			continue;
+		}
+		while (!RetrieveReadback(readback) && wait)
+		{
+		}
+	}
+}
+#endif // GFX_ENABLE_ASYNC_READBACK
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "CallType.hpp"
+#include "DrawBatch.hpp"
+#include "DrawItem.hpp"
+#include "GraphicLayerConfig.hpp"
+#include "IGraphicLayer.hpp"
+#include "ShadingParameters.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Plays a capture written by CaptureLayer on a graphic layer, to
+	/// measure the cost of the same calls from one build or driver to
+	/// the next, without running the application that made them.
+	///
+	/// The calls before the first looped frame are played once, to
+	/// create and load the resources. The looped frames can then be
+	/// played as many times as needed. The resources they create are
+	/// only created on the first loop, and kept to the end: the next
+	/// loops load them again, into the same ids, so every loop does the
+	/// same work without growing the layer's tables.
+	///
+	/// Resource ids are those of the replay layer: the ids of the
+	/// capture, including those in the uniforms, are mapped to them.
+	/// Calls the build doesn't support are skipped, with a warning.
+	/// </summary>
+	class CaptureReplay
+	{
+	public:
+		/// <summary>
+		/// Time spent playing each type of call: reading its arguments
+		/// from the capture, and the call to the layer itself.
+		/// </summary>
+		struct CallTimings
+		{
+			long long		duration[CallType::Count]; // In nanoseconds.
+			int				count[CallType::Count];
+
+			void			Clear();
+		};
+
+		CaptureReplay();
+		~CaptureReplay();
+
+		/// <summary>
+		/// Reads a whole capture file.
+		/// </summary>
+		/// <returns>False if the file couldn't be read, or isn't a
+		/// capture this build can play.</returns>
+		bool				Load(const char* fileName);
+
+		/// <summary>
+		/// Uses a capture already in memory, for example a mapped file.
+		/// The data isn't copied, and should be kept until Unload().
+		/// </summary>
+		bool				Init(const void* data, int size);
+		void				Unload();
+
+		/// <returns>Number of complete frames in the capture. Calls
+		/// after the last EndFrame are ignored.</returns>
+		int					GetNumberOfFrames() const { return m_numberOfFrames; }
+
+		/// <summary>
+		/// Plays the calls before the first looped frame.
+		/// </summary>
+		///
+		/// <param name="firstFrame">First frame of the loop, up to the
+		///     last one; -1 to only loop the last frame.</param>
+		void				Begin(IGraphicLayer* layer, int firstFrame = -1);
+
+		/// <summary>
+		/// Plays one of the looped frames, from GetFirstFrame() to
+		/// GetNumberOfFrames() - 1, including its EndFrame.
+		/// </summary>
+		///
+		/// <param name="timings">If not null, each call is timed and
+		///     added to it.</param>
+		void				PlayFrame(int frame, CallTimings* timings = nullptr);
+
+		/// <summary>
+		/// Ends a loop, after which the looped frames can be played
+		/// again. The resources they created are kept for the next loop.
+		/// </summary>
+		void				EndLoop();
+
+		/// <summary>
+		/// Destroys all the resources created by the replay.
+		/// </summary>
+		void				End();
+
+		int					GetFirstFrame() const { return m_firstFrame; }
+
+	private:
+		struct Reader
+		{
+			const char*		data;
+			const char*		end;
+
+			int				ReadInt();
+			float			ReadFloat();
+			const void*		ReadData(int* size);
+			const char*		ReadString();
+		};
+
+		struct LoopResource
+		{
+			CallType::Enum	destroyCall;
+			int				capturedIndex;
+			int				index; // Replay id.
+		};
+
+		bool				IndexFrames();
+		void				PlayCalls(int start, int end, CallTimings* timings);
+		void				PlayCall(CallType::Enum type, Reader& reader);
+		void				ReadTextureSampling(Reader& reader, TextureSampling* textureSampling);
+		void				ReadUniform(Reader& reader, Uniform* uniform);
+		void				ReadUniforms(Reader& reader, Container::Array<Uniform>* uniforms);
+		void				ReadDrawState(Reader& reader, DrawArea* drawArea, RasterTests* rasterTests);
+		void				ReadShadingParameters(Reader& reader, ShadingParameters* shadingParameters);
+
+		Container::Array<int>& GetTable(CallType::Enum destroyCall);
+		int					ReuseLoopResource(CallType::Enum destroyCall) const;
+		bool				KeepLoopResource(CallType::Enum destroyCall, int index) const;
+		void				Map(CallType::Enum destroyCall, int capturedIndex, int index);
+		int					Unmap(Container::Array<int>& table, int capturedIndex);
+		void				Destroy(CallType::Enum destroyCall, int capturedIndex);
+		void				DestroyResource(CallType::Enum destroyCall, int index);
+
+		const char*			m_data;
+		int					m_size;
+		char*				m_ownedData; // If read by Load().
+
+		// Offset of the first call of each frame, and of the end of the
+		// last frame.
+		int*				m_frameStarts;
+		int					m_numberOfFrames;
+
+		IGraphicLayer*		m_layer;
+		int					m_firstFrame;
+		bool				m_looping;
+		bool				m_warnedCalls[CallType::Count];
+
+		// Replay ids, indexed by the captured ids; -1 if not created.
+		Container::Array<int> m_vertexBuffers;
+		Container::Array<int> m_textures;
+		Container::Array<int> m_uniformBuffers;
+		Container::Array<int> m_storageBuffers;
+		Container::Array<int> m_shaders;
+		Container::Array<int> m_frameBuffers;
+
+		// Resources created by the looped frames, in the order of the
+		// calls, and the next one to reuse.
+		Container::Array<LoopResource> m_loopResources;
+		int					m_nextLoopResource;
+
+		// Attributes of each captured vertex buffer, kept since the
+		// layer may only keep a pointer to them.
+		VertexAttribute*	m_vertexAttributes;
+
+		// Reused for the calls that take them.
+		ShadingParameters	m_shadingParameters;
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		DrawBatch			m_drawBatch;
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_COMPUTE_SHADERS
+		ComputeParameters	m_computeParameters;
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+#if GFX_ENABLE_SUBMIT_DRAWS
+		void				PlaySubmitDraws(Reader& reader);
+
+		// Grown to the largest SubmitDraws played.
+		DrawItem*			m_drawItems;
+		DrawState*			m_drawStates;
+		Uniform*			m_drawUniforms;
+		int					m_drawItemsCapacity; // Also of m_drawStates.
+		int					m_drawUniformsCapacity;
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_ASYNC_READBACK
+		// Readback of the replay layer, and the captured ticket it
+		// stands for. The data is dropped once retrieved.
+		struct PendingReadback
+		{
+			int				capturedIndex; // -1 if free.
+			ReadbackID		id;
+			int				size;
+			bool			retrieved; // By the capture; it is then tried again at each request.
+		};
+		void				AddReadback(int capturedIndex, const ReadbackID id, int size);
+		bool				RetrieveReadback(PendingReadback& readback);
+		void				RetrieveReadbacks(bool wait);
+
+		PendingReadback		m_readbacks[GFX_READBACK_BUFFERS];
+		char*				m_readbackData;
+		int					m_readbackDataCapacity;
+#endif // GFX_ENABLE_ASYNC_READBACK
+	};
+}
@@ -0,0 +1,59 @@
+#include "DrawBatch.hpp"
+
+#include "Geometry.hpp"
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::DrawBatch::Item>;
+
+#endif
+
+DrawBatch::DrawBatch():
+	vertexBuffer(VertexBufferID::InvalidID),
+	items(GFX_MAX_DRAW_BATCH_SIZE)
+{
+}
+
+bool DrawBatch::Add(const Geometry& geometry, int numberOfInstances)
+{
+	ASSERT(geometry.vertexBuffer != VertexBufferID::InvalidID);
+	if (items.size == 0)
+	{
+		vertexBuffer = geometry.vertexBuffer;
+	}
+	else if (geometry.vertexBuffer != vertexBuffer || items.size >= GFX_MAX_DRAW_BATCH_SIZE)
+	{
+		return false;
+	}
+
+	Item& item = items.getNew();
+	item.numberOfIndices = geometry.numberOfIndices;
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	item.firstIndexOffset = geometry.firstIndexOffset;
+	item.baseVertex = geometry.baseVertex;
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	item.firstIndexOffset = 0;
+	item.baseVertex = 0;
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	item.numberOfInstances = numberOfInstances;
+	return true;
+}
+
+void DrawBatch::Clear()
+{
+	vertexBuffer = VertexBufferID::InvalidID;
+	items.clear();
+}
+
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
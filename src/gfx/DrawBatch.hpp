@@ -0,0 +1,51 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+#include "ResourceID.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+namespace Gfx
+{
+	struct Geometry;
+
+	/// <summary>
+	/// A list of meshes stored in the same vertex buffer, to be drawn in
+	/// a single call with the same shader and render state.
+	/// The shader can tell the draws apart with gl_DrawID, which is the
+	/// index of the draw in the batch.
+	/// </summary>
+	struct DrawBatch
+	{
+		struct Item
+		{
+			int						numberOfIndices;
+			int						firstIndexOffset; // In bytes, like Geometry::firstIndexOffset.
+			int						baseVertex;
+			int						numberOfInstances;
+		};
+
+		VertexBufferID				vertexBuffer;
+		Container::Array<Item>		items;
+
+		DrawBatch();
+
+		/// <summary>
+		/// Adds a mesh to the batch.
+		/// </summary>
+		/// <returns>False if the mesh uses another vertex buffer than
+		/// the rest of the batch, or if the batch is full. The batch
+		/// should then be drawn and cleared before adding more.</returns>
+		bool						Add(const Geometry& geometry, int numberOfInstances = 1);
+		void						Clear();
+
+	private:
+		// No batch copy.
+		DrawBatch(const DrawBatch& src);
+		DrawBatch& operator = (const DrawBatch& src);
+	};
+}
+
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "BlendingMode.hpp"
+#include "DrawArea.hpp"
+#include "GraphicLayerConfig.hpp"
+#include "PolygonMode.hpp"
+#include "RasterTests.hpp"
+#include "ResourceID.hpp"
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+
+namespace Gfx
+{
+	struct Uniform;
+
+	/// <summary>
+	/// Where and how a list of draws renders: the destination and the
+	/// render states. Draws that share it should point to the same
+	/// DrawState, so the layer doesn't compare it again.
+	/// </summary>
+	struct DrawState
+	{
+		DrawArea					drawArea;
+		RasterTests					rasterTests;
+		BlendingMode				blendingMode;
+		PolygonMode::Enum			polygonMode;
+	};
+
+	/// <summary>
+	/// One draw of IGraphicLayer::SubmitDraws(). It is the equivalent of
+	/// the arguments of IGraphicLayer::Draw(), with the render states
+	/// and uniforms referenced rather than copied, so an item fits in
+	/// 64 bytes.
+	///
+	/// Consecutive items are compared by pointer: items that point to
+	/// the same state, or to the same uniforms with the same shader, as
+	/// the item before them are drawn without setting them again. The
+	/// states and uniforms should not change until SubmitDraws()
+	/// returns.
+	/// </summary>
+	struct DrawItem
+	{
+		const DrawState*			state;
+		const Uniform*				uniforms;
+		int							numberOfUniforms;
+		ShaderID					shader;
+		VertexBufferID				vertexBuffer;
+		int							numberOfIndices;
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		int							firstIndexOffset; // In bytes, like Geometry::firstIndexOffset.
+		int							baseVertex;
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		int							numberOfInstances;
+	};
+}
+
+#endif // GFX_ENABLE_SUBMIT_DRAWS
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+
+#if GFX_ENABLE_FRAME_STATS
+
+namespace Gfx
+{
+	/// <summary>
+	/// What a graphic layer did during a frame, to tell where the CPU
+	/// side of the rendering goes. See IGraphicLayer::GetFrameStats().
+	/// </summary>
+	struct FrameStats
+	{
+		// Draw calls; a batch drawn with a single indirect call counts
+		// as one draw, and as all of its instances and triangles.
+		int			numberOfDraws;
+		int			numberOfInstances;
+		int			numberOfTriangles; // Of all the instances.
+		int			numberOfDispatches; // Compute shaders.
+
+		// State changes that reached the driver. The redundant ones the
+		// layer filters out aren't counted.
+		int			shaderChanges;
+		int			vertexBufferChanges;
+		int			frameBufferChanges;
+		int			textureChanges;
+		int			rasterStateChanges; // Viewport, polygon mode and raster tests.
+		int			blendStateChanges;
+
+		// Uniforms set on the shader, and those skipped because it
+		// already had the same value (see
+		// GFX_SKIP_REDUNDANT_UNIFORM_BINDING), or because the item of
+		// SubmitDraws() before shared them. The uniforms of the uniform
+		// buffer ring are only counted in bytesUploaded.
+		int			uniformBindsIssued;
+		int			uniformBindsAvoided;
+
+		// Vertex, index, uniform, storage buffer and texture data given
+		// to the driver.
+		long long	bytesUploaded;
+
+		// Resources alive at the end of the frame.
+		int			numberOfVertexBuffers;
+		int			numberOfTextures;
+		int			numberOfShaders;
+		int			numberOfFrameBuffers;
+		int			numberOfUniformBuffers;
+		int			numberOfStorageBuffers;
+	};
+}
+
+#endif // GFX_ENABLE_FRAME_STATS
@@ -17,6 +17,7 @@ namespace Gfx
 		int				numberOfIndices;
 #if GFX_ENABLE_VERTEX_BUFFER_OFFSET
 		int				firstIndexOffset; // FIXME: find a good name.
+		int				baseVertex; // Added to each index before fetching the vertex.
 #endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
 	};
 }
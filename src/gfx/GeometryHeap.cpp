@@ -0,0 +1,359 @@
+#include "GeometryHeap.hpp"
+
+#include "IGraphicLayerImplementations.hpp"
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include <cstring>
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::GeometryHeap::MeshInfo>;
+template class Container::Array<Gfx::GeometryHeap::RangeAllocator::Range>;
+
+#endif
+
+const MeshID MeshID::InvalidID = { -1 };
+
+//
+// Range allocator
+//
+
+void GeometryHeap::RangeAllocator::Init(int capacity)
+{
+	ASSERT(capacity > 0);
+
+	// Free ranges are never adjacent, so there is at most one more
+	// free range than allocated ranges.
+	m_freeRanges.init(GFX_MAX_GEOMETRY_HEAP_MESHES + 1);
+	m_capacity = capacity;
+	Reset(0);
+}
+
+int GeometryHeap::RangeAllocator::Allocate(int size)
+{
+	ASSERT(size > 0);
+
+	int bestFit = -1;
+	for (int i = 0; i < m_freeRanges.size; ++i)
+	{
+		const int rangeSize = m_freeRanges[i].size;
+		if (rangeSize >= size && (bestFit < 0 || rangeSize < m_freeRanges[bestFit].size))
+		{
+			bestFit = i;
+			if (rangeSize == size)
+			{
+				break;
+			}
+		}
+	}
+	if (bestFit < 0)
+	{
+		return -1;
+	}
+
+	Range& range = m_freeRanges[bestFit];
+	const int offset = range.offset;
+	range.offset += size;
+	range.size -= size;
+	if (range.size == 0)
+	{
+		// Keep the ranges sorted.
+		memmove(&m_freeRanges[bestFit], &m_freeRanges[bestFit] + 1, (m_freeRanges.size - bestFit - 1) * sizeof(Range));
+		--m_freeRanges.size;
+	}
+
+	m_used += size;
+	return offset;
+}
+
+void GeometryHeap::RangeAllocator::Free(int offset, int size)
+{
+	ASSERT(offset >= 0 && size > 0 && offset + size <= m_capacity);
+
+	int next = 0;
+	while (next < m_freeRanges.size && m_freeRanges[next].offset < offset)
+	{
+		++next;
+	}
+	ASSERT(next == m_freeRanges.size || offset + size <= m_freeRanges[next].offset);
+	ASSERT(next == 0 || m_freeRanges[next - 1].offset + m_freeRanges[next - 1].size <= offset);
+
+	const bool mergeWithPrevious = (next > 0 && m_freeRanges[next - 1].offset + m_freeRanges[next - 1].size == offset);
+	const bool mergeWithNext = (next < m_freeRanges.size && offset + size == m_freeRanges[next].offset);
+
+	if (mergeWithPrevious && mergeWithNext)
+	{
+		m_freeRanges[next - 1].size += size + m_freeRanges[next].size;
+		memmove(&m_freeRanges[next], &m_freeRanges[next] + 1, (m_freeRanges.size - next - 1) * sizeof(Range));
+		--m_freeRanges.size;
+	}
+	else if (mergeWithPrevious)
+	{
+		m_freeRanges[next - 1].size += size;
+	}
+	else if (mergeWithNext)
+	{
+		m_freeRanges[next].offset = offset;
+		m_freeRanges[next].size += size;
+	}
+	else
+	{
+		m_freeRanges.getNew();
+		memmove(&m_freeRanges[next] + 1, &m_freeRanges[next], (m_freeRanges.size - next - 1) * sizeof(Range));
+		m_freeRanges[next].offset = offset;
+		m_freeRanges[next].size = size;
+	}
+
+	m_used -= size;
+}
+
+void GeometryHeap::RangeAllocator::Reset(int usedSize)
+{
+	ASSERT(usedSize >= 0 && usedSize <= m_capacity);
+
+	m_freeRanges.clear();
+	if (usedSize < m_capacity)
+	{
+		Range& range = m_freeRanges.getNew();
+		range.offset = usedSize;
+		range.size = m_capacity - usedSize;
+	}
+	m_used = usedSize;
+}
+
+float GeometryHeap::RangeAllocator::Fragmentation() const
+{
+	const int freeSize = m_capacity - m_used;
+	if (freeSize == 0)
+	{
+		return 0.f;
+	}
+
+	int largestRange = 0;
+	for (int i = 0; i < m_freeRanges.size; ++i)
+	{
+		if (m_freeRanges[i].size > largestRange)
+		{
+			largestRange = m_freeRanges[i].size;
+		}
+	}
+	return 1.f - (float)largestRange / (float)freeSize;
+}
+
+//
+// Geometry heap
+//
+
+GeometryHeap::GeometryHeap():
+	m_gfxLayer(nullptr),
+	m_vertexBuffer(VertexBufferID::InvalidID),
+	m_scratchBuffer(VertexBufferID::InvalidID)
+{
+}
+
+void GeometryHeap::Init(IGraphicLayer* gfxLayer,
+						PrimitiveType::Enum primitiveType,
+						const VertexAttribute* vertexAttributes,
+						int numberOfAttributes, int stride,
+						int vertexCapacity,
+						VertexIndexType::Enum indexType,
+						int indexCapacity)
+{
+	ASSERT(gfxLayer != nullptr);
+	ASSERT(m_gfxLayer == nullptr);
+
+	m_gfxLayer = gfxLayer;
+	m_primitiveType = primitiveType;
+	m_vertexAttributes = vertexAttributes;
+	m_numberOfAttributes = numberOfAttributes;
+	m_stride = stride;
+	m_indexType = indexType;
+	m_indexSize = (indexType == VertexIndexType::UInt8 ? 1 :
+				   indexType == VertexIndexType::UInt16 ? 2 : 4);
+
+	m_vertices.Init(vertexCapacity);
+	m_indices.Init(indexCapacity);
+	m_meshes.init(GFX_MAX_GEOMETRY_HEAP_MESHES);
+	m_freeMeshes.init(GFX_MAX_GEOMETRY_HEAP_MESHES);
+
+	m_vertexBuffer = m_gfxLayer->CreateVertexBuffer();
+	m_gfxLayer->LoadVertexBuffer(m_vertexBuffer, m_primitiveType,
+								 m_vertexAttributes, m_numberOfAttributes, m_stride,
+								 vertexCapacity * m_stride, nullptr,
+								 indexCapacity * m_indexSize, nullptr,
+								 m_indexType);
+}
+
+void GeometryHeap::Shutdown()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	m_gfxLayer->DestroyVertexBuffer(m_vertexBuffer);
+	m_vertexBuffer = VertexBufferID::InvalidID;
+	if (m_scratchBuffer != VertexBufferID::InvalidID)
+	{
+		m_gfxLayer->DestroyVertexBuffer(m_scratchBuffer);
+		m_scratchBuffer = VertexBufferID::InvalidID;
+	}
+	m_meshes.clear();
+	m_freeMeshes.clear();
+}
+
+MeshID GeometryHeap::Allocate(int numberOfVertices, const void* vertexData,
+							  int numberOfIndices, const void* indexData)
+{
+	ASSERT(numberOfVertices > 0);
+	ASSERT(vertexData != nullptr);
+	ASSERT(numberOfIndices > 0);
+	ASSERT(indexData != nullptr);
+
+	if (m_freeMeshes.size == 0 && m_meshes.size >= GFX_MAX_GEOMETRY_HEAP_MESHES)
+	{
+		return MeshID::InvalidID;
+	}
+
+	const int firstVertex = m_vertices.Allocate(numberOfVertices);
+	if (firstVertex < 0)
+	{
+		return MeshID::InvalidID;
+	}
+	const int firstIndex = m_indices.Allocate(numberOfIndices);
+	if (firstIndex < 0)
+	{
+		m_vertices.Free(firstVertex, numberOfVertices);
+		return MeshID::InvalidID;
+	}
+
+	MeshID id;
+	if (m_freeMeshes.size > 0)
+	{
+		id.index = m_freeMeshes.last();
+		m_freeMeshes.pop();
+	}
+	else
+	{
+		m_meshes.getNew();
+		id.index = m_meshes.size - 1;
+	}
+
+	MeshInfo& mesh = m_meshes[id.index];
+	mesh.firstVertex = firstVertex;
+	mesh.numberOfVertices = numberOfVertices;
+	mesh.firstIndex = firstIndex;
+	mesh.numberOfIndices = numberOfIndices;
+	mesh.allocated = true;
+
+	m_gfxLayer->UpdateVertexBufferRange(m_vertexBuffer, firstVertex * m_stride, numberOfVertices * m_stride, vertexData);
+	m_gfxLayer->UpdateIndexBufferRange(m_vertexBuffer, firstIndex * m_indexSize, numberOfIndices * m_indexSize, indexData);
+
+	return id;
+}
+
+void GeometryHeap::Free(const MeshID id)
+{
+	ASSERT(id.index >= 0 && id.index < m_meshes.size);
+
+	MeshInfo& mesh = m_meshes[id.index];
+	ASSERT(mesh.allocated);
+
+	m_vertices.Free(mesh.firstVertex, mesh.numberOfVertices);
+	m_indices.Free(mesh.firstIndex, mesh.numberOfIndices);
+	mesh.allocated = false;
+	m_freeMeshes.add(id.index);
+}
+
+Geometry GeometryHeap::GetGeometry(const MeshID id) const
+{
+	ASSERT(id.index >= 0 && id.index < m_meshes.size);
+
+	const MeshInfo& mesh = m_meshes[id.index];
+	ASSERT(mesh.allocated);
+
+	Geometry geometry;
+	geometry.vertexBuffer = m_vertexBuffer;
+	geometry.numberOfIndices = mesh.numberOfIndices;
+	geometry.firstIndexOffset = mesh.firstIndex * m_indexSize;
+	geometry.baseVertex = mesh.firstVertex;
+	return geometry;
+}
+
+void GeometryHeap::Defragment()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	// The meshes are packed into the scratch buffer, and the packed
+	// result is copied back, so the heap keeps the same vertex buffer.
+	// The scratch buffer is kept for the next time, since vertex buffer
+	// slots are not recycled by the graphic layer.
+	if (m_scratchBuffer == VertexBufferID::InvalidID)
+	{
+		m_scratchBuffer = m_gfxLayer->CreateVertexBuffer();
+		m_gfxLayer->LoadVertexBuffer(m_scratchBuffer, m_primitiveType,
+									 m_vertexAttributes, m_numberOfAttributes, m_stride,
+									 m_vertices.Capacity() * m_stride, nullptr,
+									 m_indices.Capacity() * m_indexSize, nullptr,
+									 m_indexType);
+	}
+
+	int numberOfVertices = 0;
+	int numberOfIndices = 0;
+	for (int i = 0; i < m_meshes.size; ++i)
+	{
+		MeshInfo& mesh = m_meshes[i];
+		if (!mesh.allocated)
+		{
+			continue;
+		}
+
+		// Indices are relative to the first vertex of the mesh, so
+		// they don't need to be updated.
+		m_gfxLayer->CopyVertexBufferRange(m_vertexBuffer, mesh.firstVertex * m_stride,
+										  m_scratchBuffer, numberOfVertices * m_stride,
+										  mesh.numberOfVertices * m_stride);
+		m_gfxLayer->CopyIndexBufferRange(m_vertexBuffer, mesh.firstIndex * m_indexSize,
+										 m_scratchBuffer, numberOfIndices * m_indexSize,
+										 mesh.numberOfIndices * m_indexSize);
+		mesh.firstVertex = numberOfVertices;
+		mesh.firstIndex = numberOfIndices;
+		numberOfVertices += mesh.numberOfVertices;
+		numberOfIndices += mesh.numberOfIndices;
+	}
+
+	if (numberOfVertices > 0)
+	{
+		m_gfxLayer->CopyVertexBufferRange(m_scratchBuffer, 0, m_vertexBuffer, 0, numberOfVertices * m_stride);
+	}
+	if (numberOfIndices > 0)
+	{
+		m_gfxLayer->CopyIndexBufferRange(m_scratchBuffer, 0, m_vertexBuffer, 0, numberOfIndices * m_indexSize);
+	}
+
+	m_vertices.Reset(numberOfVertices);
+	m_indices.Reset(numberOfIndices);
+}
+
+GeometryHeap::Stats GeometryHeap::GetStats() const
+{
+	Stats stats;
+	stats.numberOfMeshes = m_meshes.size - m_freeMeshes.size;
+	stats.vertexCapacity = m_vertices.Capacity();
+	stats.usedVertices = m_vertices.Used();
+	stats.indexCapacity = m_indices.Capacity();
+	stats.usedIndices = m_indices.Used();
+	stats.vertexUtilization = (float)stats.usedVertices / (float)stats.vertexCapacity;
+	stats.indexUtilization = (float)stats.usedIndices / (float)stats.indexCapacity;
+	stats.vertexFragmentation = m_vertices.Fragmentation();
+	stats.indexFragmentation = m_indices.Fragmentation();
+	return stats;
+}
+
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Geometry.hpp"
+#include "GraphicLayerConfig.hpp"
+#include "IGraphicLayer.hpp"
+#include "ResourceID.hpp"
+#include "VertexAttribute.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Identifier of a mesh allocated in a GeometryHeap.
+	/// </summary>
+	struct MeshID
+	{
+		int index;
+
+		static const MeshID InvalidID;
+	};
+
+	inline
+	bool operator == (const MeshID lhs, const MeshID rhs)
+	{
+		return lhs.index == rhs.index;
+	}
+
+	inline
+	bool operator != (const MeshID lhs, const MeshID rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	/// <summary>
+	/// Stores many meshes of the same vertex layout in a single vertex
+	/// buffer, sub-allocating vertex and index ranges from it.
+	///
+	/// Drawing meshes of the same heap doesn't change the bound vertex
+	/// buffer, and they can be put in the same DrawBatch.
+	/// </summary>
+	class GeometryHeap
+	{
+	public:
+		struct Stats
+		{
+			int		numberOfMeshes;
+			int		vertexCapacity;
+			int		usedVertices;
+			int		indexCapacity;
+			int		usedIndices;
+
+			// Ratio of the space in use, from 0 to 1.
+			float	vertexUtilization;
+			float	indexUtilization;
+
+			// 0 when all the free space is in one range, and tends
+			// to 1 as it is split into many small ranges.
+			float	vertexFragmentation;
+			float	indexFragmentation;
+		};
+
+		GeometryHeap();
+
+		/// <summary>
+		/// Allocates the vertex buffer of the heap.
+		/// </summary>
+		///
+		/// <param name="vertexCapacity">Maximum number of vertices.</param>
+		/// <param name="indexCapacity">Maximum number of indices.</param>
+		void				Init(IGraphicLayer* gfxLayer,
+								 PrimitiveType::Enum primitiveType,
+								 const VertexAttribute* vertexAttributes,
+								 int numberOfAttributes, int stride,
+								 int vertexCapacity,
+								 VertexIndexType::Enum indexType,
+								 int indexCapacity);
+		void				Shutdown();
+
+		/// <summary>
+		/// Allocates an indexed mesh in the heap and uploads its data.
+		/// The indices are relative to the first vertex of the mesh.
+		/// </summary>
+		/// <returns>The mesh, or MeshID::InvalidID if there is not
+		/// enough contiguous free space left.</returns>
+		MeshID				Allocate(int numberOfVertices, const void* vertexData,
+									 int numberOfIndices, const void* indexData);
+		void				Free(const MeshID id);
+
+		/// <summary>
+		/// Geometry to draw a mesh of the heap. It has to be queried
+		/// again after Defragment, since meshes may have moved.
+		/// </summary>
+		Geometry			GetGeometry(const MeshID id) const;
+
+		/// <summary>
+		/// Moves all the meshes next to each other, so the free space
+		/// is in a single range. The data is copied on the GPU, through
+		/// a scratch vertex buffer of the same size as the heap, which
+		/// is allocated on first use.
+		/// </summary>
+		void				Defragment();
+
+		Stats				GetStats() const;
+		VertexBufferID		GetVertexBuffer() const { return m_vertexBuffer; }
+
+	private:
+		/// <summary>
+		/// Best fit allocator of ranges within [0, capacity). Free
+		/// ranges are kept sorted and merged with their neighbours.
+		/// </summary>
+		class RangeAllocator
+		{
+		public:
+			void			Init(int capacity);
+
+			// Returns the offset of the allocated range, or -1.
+			int				Allocate(int size);
+			void			Free(int offset, int size);
+
+			// Marks [0, usedSize) as allocated and the rest as free.
+			void			Reset(int usedSize);
+
+			int				Capacity() const { return m_capacity; }
+			int				Used() const { return m_used; }
+			float			Fragmentation() const;
+
+		private:
+			struct Range
+			{
+				int			offset;
+				int			size;
+			};
+
+			Container::Array<Range> m_freeRanges;
+			int				m_capacity;
+			int				m_used;
+		};
+
+		struct MeshInfo
+		{
+			int				firstVertex;
+			int				numberOfVertices;
+			int				firstIndex;
+			int				numberOfIndices;
+			bool			allocated;
+		};
+
+		IGraphicLayer*		m_gfxLayer;
+		VertexBufferID		m_vertexBuffer;
+		PrimitiveType::Enum	m_primitiveType;
+		const VertexAttribute* m_vertexAttributes;
+		int					m_numberOfAttributes;
+		int					m_stride;
+		VertexIndexType::Enum m_indexType;
+		int					m_indexSize;
+
+		VertexBufferID		m_scratchBuffer; // Used by Defragment.
+
+		RangeAllocator		m_vertices;
+		RangeAllocator		m_indices;
+		Container::Array<MeshInfo> m_meshes;
+		Container::Array<int> m_freeMeshes;
+	};
+}
+
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
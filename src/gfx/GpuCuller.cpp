@@ -0,0 +1,201 @@
+#include "GpuCuller.hpp"
+
+#include "Barrier.hpp"
+#include "IGraphicLayerImplementations.hpp"
+#include "ShadingParameters.hpp"
+#include "Uniform.hxx"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include <cstdint>
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+using namespace Gfx;
+
+#define CULLING_GROUP_SIZE 64
+
+// The box of an instance in world space is the box around its
+// transformed box: its half size on an axis is the sum of the half
+// sizes weighted by the absolute values of the row of the matrix. The
+// box is outside of a plane if its corner the furthest along the normal
+// is.
+static const char* cullingShaderSource = R"(
+    #version 450
+    layout(local_size_x = 64) in;
+    struct Instance {
+        vec4 transform[3];
+        vec4 boundsMin;
+        vec4 boundsMax;
+    };
+    layout(std430) buffer Instances {
+        Instance instances[];
+    };
+    layout(std430) buffer Frustum {
+        vec4 planes[6];
+    };
+    layout(std430) buffer VisibleInstances {
+        uint visibleInstances[];
+    };
+    layout(std430) buffer Arguments {
+        uint count;
+        uint instanceCount;
+        uint firstIndex;
+        int baseVertex;
+        uint baseInstance;
+    };
+    uniform int numberOfInstances;
+    void main() {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= uint(numberOfInstances)) {
+            return;
+        }
+        Instance instance = instances[i];
+        vec3 center = 0.5 * (instance.boundsMax.xyz + instance.boundsMin.xyz);
+        vec3 halfSize = 0.5 * (instance.boundsMax.xyz - instance.boundsMin.xyz);
+        vec3 worldCenter = vec3(
+            dot(instance.transform[0].xyz, center) + instance.transform[0].w,
+            dot(instance.transform[1].xyz, center) + instance.transform[1].w,
+            dot(instance.transform[2].xyz, center) + instance.transform[2].w);
+        vec3 worldHalfSize = vec3(
+            dot(abs(instance.transform[0].xyz), halfSize),
+            dot(abs(instance.transform[1].xyz), halfSize),
+            dot(abs(instance.transform[2].xyz), halfSize));
+        for (int p = 0; p < 6; ++p) {
+            vec4 plane = planes[p];
+            if (dot(plane.xyz, worldCenter) + plane.w + dot(abs(plane.xyz), worldHalfSize) < 0.0) {
+                return;
+            }
+        }
+        visibleInstances[atomicAdd(instanceCount, 1)] = i;
+    }
+)";
+
+// Same layout as the Arguments block, and as DrawIndirect expects.
+struct DrawArguments
+{
+	std::uint32_t		count;
+	std::uint32_t		instanceCount;
+	std::uint32_t		firstIndex;
+	std::int32_t		baseVertex;
+	std::uint32_t		baseInstance;
+};
+
+GpuCuller::GpuCuller():
+	m_gfxLayer(nullptr),
+	m_shader(ShaderID::InvalidID),
+	m_instances(StorageBufferID::InvalidID),
+	m_visibleInstances(StorageBufferID::InvalidID),
+	m_frustum(StorageBufferID::InvalidID),
+	m_arguments(StorageBufferID::InvalidID),
+	m_capacity(0),
+	m_numberOfInstances(0)
+{
+}
+
+void GpuCuller::Init(IGraphicLayer* gfxLayer, int capacity)
+{
+	ASSERT(gfxLayer != nullptr);
+	ASSERT(m_gfxLayer == nullptr);
+	ASSERT(capacity > 0);
+
+	m_gfxLayer = gfxLayer;
+	m_capacity = capacity;
+	m_numberOfInstances = 0;
+
+	m_shader = m_gfxLayer->CreateShader();
+	const ShaderStage shaderStage = { ShaderType::ComputeShader, cullingShaderSource, __FILE__ };
+	m_gfxLayer->LoadShader(m_shader, &shaderStage, 1);
+
+	const DrawArguments noDraw = {};
+	m_instances = m_gfxLayer->CreateStorageBuffer();
+	m_visibleInstances = m_gfxLayer->CreateStorageBuffer();
+	m_frustum = m_gfxLayer->CreateStorageBuffer();
+	m_arguments = m_gfxLayer->CreateStorageBuffer();
+	m_gfxLayer->LoadStorageBuffer(m_instances, capacity * sizeof(Instance), nullptr);
+	m_gfxLayer->LoadStorageBuffer(m_visibleInstances, capacity * sizeof(std::uint32_t), nullptr);
+	m_gfxLayer->LoadStorageBuffer(m_frustum, 6 * 4 * sizeof(float), nullptr);
+	m_gfxLayer->LoadStorageBuffer(m_arguments, sizeof(noDraw), &noDraw);
+}
+
+void GpuCuller::Shutdown()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	m_gfxLayer->DestroyStorageBuffer(m_arguments);
+	m_gfxLayer->DestroyStorageBuffer(m_frustum);
+	m_gfxLayer->DestroyStorageBuffer(m_visibleInstances);
+	m_gfxLayer->DestroyStorageBuffer(m_instances);
+	m_gfxLayer->DestroyShader(m_shader);
+	m_arguments = StorageBufferID::InvalidID;
+	m_frustum = StorageBufferID::InvalidID;
+	m_visibleInstances = StorageBufferID::InvalidID;
+	m_instances = StorageBufferID::InvalidID;
+	m_shader = ShaderID::InvalidID;
+	m_gfxLayer = nullptr;
+}
+
+void GpuCuller::SetInstances(const Instance* instances, int count)
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(count >= 0 && count <= m_capacity);
+	ASSERT(count == 0 || instances != nullptr);
+
+	m_numberOfInstances = count;
+	if (count > 0)
+	{
+		m_gfxLayer->LoadStorageBuffer(m_instances, count * sizeof(Instance), instances);
+	}
+}
+
+void GpuCuller::Cull(const float planes[6][4],
+					 int numberOfIndices,
+					 int firstIndex, int baseVertex)
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(numberOfIndices > 0);
+	ASSERT(firstIndex >= 0);
+
+	// The instance count is reset by the CPU, and only incremented by
+	// the shader.
+	const DrawArguments arguments = { (std::uint32_t)numberOfIndices, 0, (std::uint32_t)firstIndex, baseVertex, 0 };
+	m_gfxLayer->LoadStorageBuffer(m_arguments, sizeof(arguments), &arguments);
+	if (m_numberOfInstances == 0)
+	{
+		return;
+	}
+	m_gfxLayer->LoadStorageBuffer(m_frustum, 6 * 4 * sizeof(float), planes);
+
+	ComputeParameters computeParameters;
+	computeParameters.uniforms.add(Uniform::StorageBufferInput1("Instances", m_instances));
+	computeParameters.uniforms.add(Uniform::StorageBufferInput1("Frustum", m_frustum));
+	computeParameters.uniforms.add(Uniform::StorageBufferOutput1("VisibleInstances", m_visibleInstances));
+	computeParameters.uniforms.add(Uniform::StorageBufferOutput1("Arguments", m_arguments));
+	computeParameters.uniforms.add(Uniform::Int1("numberOfInstances", m_numberOfInstances));
+	m_gfxLayer->Compute(m_shader, computeParameters,
+						(m_numberOfInstances + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE);
+
+	// The draw reads the arguments as a command, and the visible
+	// instances from its vertex shader.
+	m_gfxLayer->InsertMemoryBarrier(Barrier::IndirectArguments | Barrier::StorageBuffer);
+}
+
+void GpuCuller::ExtractPlanes(const float viewProjection[16], float planes[6][4])
+{
+	// Rows of the matrix, which is column major.
+	const float* m = viewProjection;
+	for (int i = 0; i < 4; ++i)
+	{
+		const float row0 = m[4 * i + 0];
+		const float row1 = m[4 * i + 1];
+		const float row2 = m[4 * i + 2];
+		const float row3 = m[4 * i + 3];
+		planes[0][i] = row3 + row0; // Left.
+		planes[1][i] = row3 - row0; // Right.
+		planes[2][i] = row3 + row1; // Bottom.
+		planes[3][i] = row3 - row1; // Top.
+		planes[4][i] = row3 + row2; // Near.
+		planes[5][i] = row3 - row2; // Far.
+	}
+}
+
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+#include "ResourceID.hpp"
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Frustum culling of the instances of a mesh on the GPU.
+	///
+	/// The instances are stored in a storage buffer. Cull() tests them
+	/// against the frustum with a compute shader, writes the indices of
+	/// those that are visible to a second storage buffer, and their
+	/// number to the arguments of IGraphicLayer::DrawIndirect(), so the
+	/// CPU never waits for the result.
+	///
+	/// The vertex shader of the draw finds its instance with
+	/// visibleInstances[gl_InstanceID], with the two buffers bound as
+	/// storage buffer inputs. The visible instances are in no particular
+	/// order.
+	/// </summary>
+	class GpuCuller
+	{
+	public:
+		/// <summary>
+		/// An instance, with the same layout in the storage buffer:
+		///     struct Instance {
+		///         vec4 transform[3];
+		///         vec4 boundsMin;
+		///         vec4 boundsMax;
+		///     };
+		/// </summary>
+		struct Instance
+		{
+			float			transform[12]; // Rows of the object to world 3x4 matrix.
+			float			boundsMin[4]; // Bounding box in object space; w is unused.
+			float			boundsMax[4];
+		};
+
+		GpuCuller();
+
+		/// <summary>
+		/// Creates the buffers and the compute shader.
+		/// </summary>
+		///
+		/// <param name="capacity">Maximum number of instances.</param>
+		void				Init(IGraphicLayer* gfxLayer, int capacity);
+		void				Shutdown();
+
+		/// <summary>
+		/// Uploads the instances to cull. They are kept until the next
+		/// call, so static instances are only uploaded once.
+		/// </summary>
+		void				SetInstances(const Instance* instances, int count);
+
+		/// <summary>
+		/// Culls the instances, and sets the arguments of the draw of
+		/// the mesh. The memory barriers needed by the draw are
+		/// inserted.
+		/// </summary>
+		///
+		/// <param name="planes">The six planes of the frustum, as
+		///     (a, b, c, d) such that a point is inside when
+		///     a x + b y + c z + d >= 0 for all planes. See
+		///     ExtractPlanes.</param>
+		/// <param name="numberOfIndices">Number of indices of the mesh.</param>
+		/// <param name="firstIndex">Index of the first index of the
+		///     mesh in the vertex buffer, in indices rather than in
+		///     bytes.</param>
+		void				Cull(const float planes[6][4],
+								 int numberOfIndices,
+								 int firstIndex = 0, int baseVertex = 0);
+
+		/// <summary>
+		/// Computes the frustum planes of a column major view projection
+		/// matrix, as OpenGL expects it (Gribb and Hartmann). The planes
+		/// are not normalized.
+		/// </summary>
+		static void			ExtractPlanes(const float viewProjection[16], float planes[6][4]);
+
+		StorageBufferID		GetInstances() const { return m_instances; }
+		StorageBufferID		GetVisibleInstances() const { return m_visibleInstances; }
+		StorageBufferID		GetArguments() const { return m_arguments; } // For DrawIndirect, at offset 0.
+		int					GetNumberOfInstances() const { return m_numberOfInstances; }
+
+	private:
+		// No culler copy.
+		GpuCuller(const GpuCuller& src);
+		GpuCuller& operator = (const GpuCuller& src);
+
+		IGraphicLayer*		m_gfxLayer;
+		ShaderID			m_shader;
+		StorageBufferID		m_instances;
+		StorageBufferID		m_visibleInstances;
+		StorageBufferID		m_frustum;
+		StorageBufferID		m_arguments;
+		int					m_capacity;
+		int					m_numberOfInstances;
+	};
+}
+
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
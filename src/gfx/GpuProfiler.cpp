@@ -0,0 +1,143 @@
+#include "GpuProfiler.hpp"
+
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include <cstdio>
+#include <cstring>
+
+#if GFX_ENABLE_GPU_PROFILING
+
+// Weight of a new sample in the rolling average.
+#define AVERAGE_WEIGHT (1.f / 16.f)
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::GpuProfiler::ScopeStats>;
+template class Container::Array<Gfx::GpuProfiler::TraceEvent>;
+
+#endif
+
+GpuProfiler::GpuProfiler():
+	m_droppedFrames(0),
+	m_available(false)
+{
+}
+
+void GpuProfiler::Init(bool available)
+{
+	m_scopes.init(GFX_MAX_GPU_SCOPES);
+	m_events.init(GFX_MAX_GPU_TRACE_EVENTS);
+	m_droppedFrames = 0;
+	m_available = available;
+}
+
+void GpuProfiler::Shutdown()
+{
+	m_scopes.clear();
+	m_events.clear();
+}
+
+void GpuProfiler::AddScope(const char* name, int depth, int frame,
+						   long long start, long long end)
+{
+	ASSERT(name != nullptr);
+
+	// The GPU may report the end of an empty scope slightly before its
+	// start.
+	const float time = (end > start ? (float)(end - start) : 0.f) * 0.001f;
+
+	int index = FindScopeIndex(name);
+	if (index < 0)
+	{
+		if (m_scopes.size >= GFX_MAX_GPU_SCOPES)
+		{
+			return;
+		}
+		ScopeStats& newScope = m_scopes.getNew();
+		newScope.name = name;
+		newScope.averageTime = time;
+		newScope.numberOfSamples = 0;
+		index = m_scopes.size - 1;
+	}
+
+	ScopeStats& scope = m_scopes[index];
+	scope.depth = depth;
+	scope.lastTime = time;
+	scope.averageTime += (time - scope.averageTime) * AVERAGE_WEIGHT;
+	++scope.numberOfSamples;
+
+	if (m_events.size < GFX_MAX_GPU_TRACE_EVENTS)
+	{
+		TraceEvent& event = m_events.getNew();
+		event.name = name;
+		event.frame = frame;
+		event.start = start;
+		event.end = (end > start ? end : start);
+	}
+}
+
+void GpuProfiler::DropFrame()
+{
+	++m_droppedFrames;
+}
+
+bool GpuProfiler::WriteTrace(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == nullptr)
+	{
+		LOG_ERROR("Could not write GPU trace %s.", fileName);
+		return false;
+	}
+
+	// Process 0 and thread 0 are left to the CPU scopes.
+	const int pid = 0;
+	const int tid = 1;
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", pid, tid);
+	for (int i = 0; i < m_events.size; ++i)
+	{
+		const TraceEvent& event = m_events[i];
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,\"args\":{\"frame\":%d}}",
+				event.name, event.start, event.end - event.start, pid, tid, event.frame);
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+
+	LOG_INFO("GPU trace written to %s: %d scopes.", fileName, m_events.size);
+	return true;
+}
+
+void GpuProfiler::ClearTrace()
+{
+	m_events.clear();
+}
+
+const GpuProfiler::ScopeStats* GpuProfiler::FindScope(const char* name) const
+{
+	const int index = FindScopeIndex(name);
+	return (index >= 0 ? &m_scopes[index] : nullptr);
+}
+
+int GpuProfiler::FindScopeIndex(const char* name) const
+{
+	for (int i = 0; i < m_scopes.size; ++i)
+	{
+		// Names are usually literals, so the pointers match.
+		if (m_scopes[i].name == name || strcmp(m_scopes[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+#endif // GFX_ENABLE_GPU_PROFILING
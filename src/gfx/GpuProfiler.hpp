@@ -0,0 +1,104 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_GPU_PROFILING
+
+namespace Gfx
+{
+	/// <summary>
+	/// Keeps the timings of the GPU scopes measured by a graphic layer,
+	/// once it has read its timer queries back: a rolling average per
+	/// scope, and the timings themselves for a trace.
+	///
+	/// The profiler doesn't talk to the driver; see
+	/// IGraphicLayer::BeginGpuScope() and EndGpuScope().
+	/// </summary>
+	class GpuProfiler
+	{
+	public:
+		struct ScopeStats
+		{
+			const char*	name;
+			int			depth; // Number of scopes it was nested in.
+
+			// Times are in milliseconds. The average is exponentially
+			// weighted, so it follows changes within a few dozen
+			// frames.
+			float		lastTime;
+			float		averageTime;
+			int			numberOfSamples;
+		};
+
+		GpuProfiler();
+
+		/// <param name="available">Whether the graphic layer can
+		///     measure GPU time. Without it, no scope is ever added.</param>
+		void				Init(bool available);
+		void				Shutdown();
+
+		bool				IsAvailable() const { return m_available; }
+
+		/// <summary>
+		/// Adds the timing of a scope, read back from the GPU.
+		/// </summary>
+		///
+		/// <param name="name">Name of the scope. The pointer is kept, so
+		///     it should be a string literal.</param>
+		/// <param name="frame">Frame the scope was measured in.</param>
+		/// <param name="start">Start of the scope in microseconds, on
+		///     the same clock as the CPU scopes.</param>
+		/// <param name="end">End of the scope, on the same clock.</param>
+		void				AddScope(const char* name, int depth, int frame,
+									 long long start, long long end);
+
+		/// <summary>
+		/// Counts a frame whose timings weren't available in time, and
+		/// were dropped rather than waited for.
+		/// </summary>
+		void				DropFrame();
+
+		/// <summary>
+		/// Writes the timings kept so far in the Chrome trace event
+		/// format (JSON), which chrome://tracing and Perfetto can open.
+		/// The GPU scopes are on a thread of their own, named "GPU".
+		/// </summary>
+		/// <returns>False if the file couldn't be written.</returns>
+		bool				WriteTrace(const char* fileName) const;
+
+		/// <summary>
+		/// Forgets the timings kept for the trace; the averages are
+		/// kept.
+		/// </summary>
+		void				ClearTrace();
+
+		int					GetNumberOfScopes() const { return m_scopes.size; }
+		const ScopeStats&	GetScope(int index) const { return m_scopes[index]; }
+
+		/// <returns>The stats of the scope of that name, or nullptr if
+		/// it has never been read back.</returns>
+		const ScopeStats*	FindScope(const char* name) const;
+
+		int					GetNumberOfDroppedFrames() const { return m_droppedFrames; }
+
+	private:
+		struct TraceEvent
+		{
+			const char*		name;
+			int				frame;
+			long long		start;
+			long long		end;
+		};
+
+		int					FindScopeIndex(const char* name) const;
+
+		Container::Array<ScopeStats> m_scopes;
+		Container::Array<TraceEvent> m_events;
+		int					m_droppedFrames;
+		bool				m_available;
+	};
+}
+
+#endif // GFX_ENABLE_GPU_PROFILING
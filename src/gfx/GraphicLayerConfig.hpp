@@ -4,11 +4,48 @@
 // Be careful to have consistent definitions for the engine, graphic
 // layer, and executable.
 
+// Count the calls made to the underlying graphics API, for profiling.
+// See OpenGLLayer::GetNumberOfDriverCalls().
+#ifndef GFX_COUNT_DRIVER_CALLS
+#	define GFX_COUNT_DRIVER_CALLS 0
+#endif
+
+// Enable reading storage buffers and frame buffers back without
+// stalling: the data is copied to a ring of staging buffers, and
+// retrieved a frame or two later, once the GPU is done with it.
+// See IGraphicLayer::RequestReadback() and GFX_READBACK_BUFFERS.
+#ifndef GFX_ENABLE_ASYNC_READBACK
+#	define GFX_ENABLE_ASYNC_READBACK 0
+#endif
+
+// Enable compiling shaders asynchronously: all the shaders can be
+// submitted before waiting for any of them, so the driver can compile
+// them in parallel (with GL_KHR_parallel_shader_compile when
+// available). See IGraphicLayer::LoadShaderAsync().
+#ifndef GFX_ENABLE_ASYNC_SHADER_COMPILATION
+#	define GFX_ENABLE_ASYNC_SHADER_COMPILATION 0
+#endif
+
+// Enable loading textures asynchronously, through a ring of pixel
+// buffer objects (PBO) that can be filled from any thread.
+// See IGraphicLayer::LoadTextureAsync().
+#ifndef GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#	define GFX_ENABLE_ASYNC_TEXTURE_UPLOAD 0
+#endif
+
 // Enable vertex clipping.
 #ifndef GFX_ENABLE_CLIPPING
 #	define GFX_ENABLE_CLIPPING 1
 #endif
 
+// Enable loading block compressed textures (BC1, BC4, BC5, BC7).
+// See IGraphicLayer::LoadCompressedTexture(), and Texture::Compress()
+// in the engine to compress images.
+// BC7 requires OpenGL 4.2, and BC1 EXT_texture_compression_s3tc.
+#ifndef GFX_ENABLE_COMPRESSED_TEXTURES
+#	define GFX_ENABLE_COMPRESSED_TEXTURES 0
+#endif
+
 // Enable compute shaders.
 // See GFX_ENABLE_STORAGE_BUFFER_OBJECT for SSBO.
 #ifndef GFX_ENABLE_COMPUTE_SHADERS
@@ -20,11 +57,60 @@
 #	define GFX_ENABLE_DEPTH_TESTING 1
 #endif
 
+// Enable direct state access (glNamedBufferData, glTextureStorage2D...),
+// used at run time when the driver supports GL_ARB_direct_state_access,
+// so resources are edited without being bound.
+#ifndef GFX_ENABLE_DIRECT_STATE_ACCESS
+#	define GFX_ENABLE_DIRECT_STATE_ACCESS 0
+#endif
+
 // Enable polygon culling based on face orientation.
 #ifndef GFX_ENABLE_FACE_CULLING
 #	define GFX_ENABLE_FACE_CULLING 1
 #endif
 
+// Enable counting what the graphic layer does during a frame: draws,
+// state changes, uniforms, uploads, and the resources alive.
+// See IGraphicLayer::GetFrameStats() and Gfx::FrameStats.
+#ifndef GFX_ENABLE_FRAME_STATS
+#	define GFX_ENABLE_FRAME_STATS 0
+#endif
+
+// Enable measuring the GPU time of scopes of commands, with
+// IGraphicLayer::BeginGpuScope() and EndGpuScope(). The timer queries
+// are read a few frames later, without waiting for the GPU; see
+// GFX_GPU_PROFILING_LATENCY and Gfx::GpuProfiler.
+// Requires GL_ARB_timer_query; scopes are ignored without it.
+#ifndef GFX_ENABLE_GPU_PROFILING
+#	define GFX_ENABLE_GPU_PROFILING 0
+#endif
+
+// Enable drawing a batch of meshes sharing a vertex buffer, a shader
+// and render state with a single indirect draw call.
+// The shader can tell the draws apart with gl_DrawID, for example to
+// fetch per draw data from a storage buffer.
+// Requires OpenGL 4.3.
+#ifndef GFX_ENABLE_MULTI_DRAW_INDIRECT
+#	define GFX_ENABLE_MULTI_DRAW_INDIRECT 0
+#endif
+
+// Enable keeping linked program binaries on disk, so shaders don't need
+// to be compiled again on the next launch, when the driver supports
+// GL_ARB_get_program_binary.
+// See Gfx::ProgramBinaryCache and OpenGLLayer::SetProgramBinaryCache().
+#ifndef GFX_ENABLE_PROGRAM_BINARY_CACHE
+#	define GFX_ENABLE_PROGRAM_BINARY_CACHE 0
+#endif
+
+// Enable render passes, which say per attachment of a frame buffer
+// whether its content is loaded, cleared, or doesn't matter, and
+// whether it is kept after the pass or discarded
+// (glInvalidateFramebuffer, when GL_ARB_invalidate_subdata is
+// available). See IGraphicLayer::BeginRenderPass().
+#ifndef GFX_ENABLE_RENDER_PASSES
+#	define GFX_ENABLE_RENDER_PASSES 0
+#endif
+
 // Enable filtering with scissor testing.
 #ifndef GFX_ENABLE_SCISSOR_TESTING
 #	define GFX_ENABLE_SCISSOR_TESTING 0
@@ -42,19 +128,74 @@
 #	define GFX_ENABLE_STORAGE_BUFFER_OBJECT 0
 #endif
 
+// Enable submitting an array of draws in one call, so the layer
+// compares consecutive draws rather than the bound state, and does the
+// work shared by all the draws once. See IGraphicLayer::SubmitDraws()
+// and Gfx::DrawItem.
+#ifndef GFX_ENABLE_SUBMIT_DRAWS
+#	define GFX_ENABLE_SUBMIT_DRAWS 0
+#endif
+
+// Enable 2D texture arrays, and Gfx::TextureArrayAllocator to share
+// arrays between textures of the same size and format, so materials
+// that only differ by their textures can be drawn without rebinding.
+#ifndef GFX_ENABLE_TEXTURE_ARRAYS
+#	define GFX_ENABLE_TEXTURE_ARRAYS 0
+#endif
+
+// Enable allocating all the levels of a texture at once, then loading
+// them one by one; see IGraphicLayer::AllocateTexture(). The storage is
+// immutable (glTexStorage2D/3D) when the driver has
+// ARB_texture_storage, which spares it validating the texture again at
+// each upload. Texture arrays use it as well.
+#ifndef GFX_ENABLE_TEXTURE_STORAGE
+#	define GFX_ENABLE_TEXTURE_STORAGE 0
+#endif
+
 // Enable uniform buffer objects (UBO).
 #ifndef GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 #	define GFX_ENABLE_UNIFORM_BUFFER_OBJECT 0
 #endif
 
+// Enable passing the float and int uniforms of a draw through a ring
+// uniform buffer, instead of one API call per uniform.
+// Only applies to the uniforms a shader declares in a std140 uniform
+// block named DrawUniforms, without instance name; the layout of the
+// block is queried when the shader is loaded. Other uniforms are bound
+// as usual.
+// Requires GFX_ENABLE_UNIFORM_BUFFER_OBJECT.
+#ifndef GFX_ENABLE_UNIFORM_BUFFER_RING
+#	define GFX_ENABLE_UNIFORM_BUFFER_RING 0
+#endif
+
+// Enable one vertex array object (VAO) per vertex buffer.
+// When enabled, the vertex attribute layout is recorded once when the
+// vertex buffer is loaded, and binding a vertex buffer is a single
+// call. When disabled, the attributes are specified again every time
+// a different vertex buffer is bound, which needs less code.
+#ifndef GFX_ENABLE_VERTEX_ARRAY_OBJECT
+#	define GFX_ENABLE_VERTEX_ARRAY_OBJECT 0
+#endif
+
 // Enable support for rendering from an offset within a vertex buffer.
 // When enabled, Gfx::Geometry::firstIndexOffset specifies the offset
-// in the vertex buffer where rendering starts.
-// This is useful for storing multiple meshes in a single buffer.
+// in the vertex buffer where rendering starts, and
+// Gfx::Geometry::baseVertex the offset added to the indices.
+// This is useful for storing multiple meshes in a single buffer, see
+// Gfx::GeometryHeap.
 #ifndef GFX_ENABLE_VERTEX_BUFFER_OFFSET
 #	define GFX_ENABLE_VERTEX_BUFFER_OFFSET 0
 #endif
 
+// Number of frames the GPU is given to finish a frame before the
+// timer queries of its scopes are read. When they still aren't
+// available by then, the timings of that frame are dropped rather than
+// waited for.
+// See GFX_ENABLE_GPU_PROFILING.
+#ifndef GFX_GPU_PROFILING_LATENCY
+#	define GFX_GPU_PROFILING_LATENCY 3
+#endif
+
 // When GFX_SKIP_REDUNDANT_UNIFORM_BINDING is enabled, this controls
 // how uniform value changes are detected when skipping redundant
 // bindings.
@@ -65,11 +206,50 @@
 #	define GFX_HASH_UNIFORM_VALUE 0
 #endif
 
+// Maximum number of draws in a batch.
+// See GFX_ENABLE_MULTI_DRAW_INDIRECT to enable batches.
+#ifndef GFX_MAX_DRAW_BATCH_SIZE
+#	define GFX_MAX_DRAW_BATCH_SIZE 1024
+#endif
+
 // Maximum number of frame buffers (FBO).
 #ifndef GFX_MAX_FRAME_BUFFERS
 #	define GFX_MAX_FRAME_BUFFERS 1024
 #endif
 
+// Maximum number of GPU scopes in a frame, and of distinct scopes; the
+// following ones are ignored.
+// See GFX_ENABLE_GPU_PROFILING.
+#ifndef GFX_MAX_GPU_SCOPES
+#	define GFX_MAX_GPU_SCOPES 64
+#endif
+
+// Maximum number of GPU scope timings kept for the trace; the following
+// ones are only counted in the averages.
+// See GFX_ENABLE_GPU_PROFILING.
+#ifndef GFX_MAX_GPU_TRACE_EVENTS
+#	define GFX_MAX_GPU_TRACE_EVENTS 65536
+#endif
+
+// Maximum number of meshes in a geometry heap.
+// See GFX_ENABLE_VERTEX_BUFFER_OFFSET to enable geometry heaps.
+#ifndef GFX_MAX_GEOMETRY_HEAP_MESHES
+#	define GFX_MAX_GEOMETRY_HEAP_MESHES 4096
+#endif
+
+// Maximum number of render targets alive in a render target pool.
+// See Gfx::RenderTargetPool.
+#ifndef GFX_MAX_POOLED_RENDER_TARGETS
+#	define GFX_MAX_POOLED_RENDER_TARGETS 64
+#endif
+
+// Maximum number of calls a recording layer keeps in its trace; the
+// following ones are forwarded, but only counted.
+// See Gfx::RecordingLayer.
+#ifndef GFX_MAX_RECORDED_CALLS
+#	define GFX_MAX_RECORDED_CALLS 262144
+#endif
+
 // Maximum number of shaders.
 #ifndef GFX_MAX_SHADERS
 #	define GFX_MAX_SHADERS 512
@@ -92,6 +272,12 @@
 #	define GFX_MAX_TEXTURES 512
 #endif
 
+// Maximum number of texture arrays in a texture array allocator.
+// See GFX_ENABLE_TEXTURE_ARRAYS to enable texture arrays.
+#ifndef GFX_MAX_TEXTURE_ARRAYS
+#	define GFX_MAX_TEXTURE_ARRAYS 32
+#endif
+
 // Maximum number of textures that can be bound to a shader.
 #ifndef GFX_MAX_TEXTURE_SLOTS
 #	define GFX_MAX_TEXTURE_SLOTS 16
@@ -124,8 +310,36 @@
 #	define GFX_MAX_VERTEX_BUFFERS 256
 #endif
 
+// Maximum size in bytes of the program binaries on disk. Beyond that,
+// the least recently used ones are removed.
+// See GFX_ENABLE_PROGRAM_BINARY_CACHE to enable the cache.
+#ifndef GFX_PROGRAM_BINARY_CACHE_SIZE
+#	define GFX_PROGRAM_BINARY_CACHE_SIZE (64 * 1024 * 1024)
+#endif
+
+// Number of staging buffers in the readback ring, which is the maximum
+// number of asynchronous readbacks in flight.
+// See GFX_ENABLE_ASYNC_READBACK to enable asynchronous readbacks.
+#ifndef GFX_READBACK_BUFFERS
+#	define GFX_READBACK_BUFFERS 8
+#endif
+
 // Avoid binding uniforms that already have the correct value.
 // See GFX_HASH_UNIFORM_VALUE to control how value changes are detected.
 #ifndef GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 #	define GFX_SKIP_REDUNDANT_UNIFORM_BINDING 1
 #endif
+
+// Number of pixel buffer objects in the texture upload ring, which is
+// the maximum number of asynchronous texture uploads in flight.
+// See GFX_ENABLE_ASYNC_TEXTURE_UPLOAD to enable asynchronous uploads.
+#ifndef GFX_TEXTURE_UPLOAD_BUFFERS
+#	define GFX_TEXTURE_UPLOAD_BUFFERS 8
+#endif
+
+// Size in bytes of the ring uniform buffer. It is recycled at the end
+// of every frame, or when full.
+// See GFX_ENABLE_UNIFORM_BUFFER_RING to enable the ring.
+#ifndef GFX_UNIFORM_BUFFER_RING_SIZE
+#	define GFX_UNIFORM_BUFFER_RING_SIZE (1024 * 1024)
+#endif
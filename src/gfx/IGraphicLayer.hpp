@@ -1,5 +1,6 @@
 #pragma once
 
+#include "RenderPass.hpp"
 #include "ResourceID.hpp"
 #include "TextureFormat.hpp"
 #include "VertexAttribute.hpp"
@@ -10,8 +11,20 @@ namespace Gfx
 	struct ComputeParameters;
 #endif // GFX_ENABLE_COMPUTE_SHADERS
 	struct DrawArea;
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+	struct DrawBatch;
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+	struct DrawItem;
+#endif // GFX_ENABLE_SUBMIT_DRAWS
 	struct FrameBufferID;
+#if GFX_ENABLE_FRAME_STATS
+	struct FrameStats;
+#endif // GFX_ENABLE_FRAME_STATS
 	struct Geometry;
+#if GFX_ENABLE_GPU_PROFILING
+	class GpuProfiler;
+#endif // GFX_ENABLE_GPU_PROFILING
 	struct RasterTests;
 	struct ShaderID;
 #if GFX_ENABLE_STORAGE_BUFFER_OBJECT
@@ -59,11 +72,13 @@ namespace Gfx
 		///     and the next.</param>
 		/// <param name="vertexDataSize">Size of the vertex data in
 		///     bytes.</param>
-		/// <param name="vertexData">Raw vertex data.</param>
+		/// <param name="vertexData">Raw vertex data, or nullptr to
+		///     only allocate the buffer.</param>
 		/// <param name="indexDataSize">Size of the index data in
 		///     bytes. The vertex buffer is assumed to be non indexed
 		///     if the value is 0.</param>
-		/// <param name="indexData">Raw index data.</param>
+		/// <param name="indexData">Raw index data, or nullptr to only
+		///     allocate the buffer.</param>
 		/// <param name="indexType">Type of the indices.</param>
 		virtual void				LoadVertexBuffer(const VertexBufferID id,
 													 PrimitiveType::Enum primitiveType,
@@ -73,6 +88,58 @@ namespace Gfx
 													 int indexDataSize, const void* indexData,
 													 VertexIndexType::Enum indexType) = 0;
 
+		/// <summary>
+		/// Overwrites a range of the vertex data of an existing vertex
+		/// buffer, keeping its layout. The range has to fit within the
+		/// data previously given to LoadVertexBuffer.
+		/// </summary>
+		///
+		/// <param name="offset">Offset in bytes from the beginning of
+		///     the vertex data.</param>
+		/// <param name="size">Size of the range in bytes.</param>
+		/// <param name="data">Raw vertex data.</param>
+		virtual void				UpdateVertexBufferRange(const VertexBufferID id,
+															int offset, int size,
+															const void* data) = 0;
+
+		/// <summary>
+		/// Overwrites a range of the index data of an existing indexed
+		/// vertex buffer. The range has to fit within the data
+		/// previously given to LoadVertexBuffer.
+		/// </summary>
+		///
+		/// <param name="offset">Offset in bytes from the beginning of
+		///     the index data.</param>
+		/// <param name="size">Size of the range in bytes.</param>
+		/// <param name="data">Raw index data.</param>
+		virtual void				UpdateIndexBufferRange(const VertexBufferID id,
+														   int offset, int size,
+														   const void* data) = 0;
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		/// <summary>
+		/// Copies a range of vertex data from a vertex buffer to
+		/// another, without going through the CPU. If the source and
+		/// destination are the same buffer, the ranges must not
+		/// overlap.
+		/// </summary>
+		virtual void				CopyVertexBufferRange(const VertexBufferID source,
+														  int sourceOffset,
+														  const VertexBufferID destination,
+														  int destinationOffset,
+														  int size) = 0;
+
+		/// <summary>
+		/// Copies a range of index data from a vertex buffer to
+		/// another. Same as CopyVertexBufferRange, for the indices.
+		/// </summary>
+		virtual void				CopyIndexBufferRange(const VertexBufferID source,
+														 int sourceOffset,
+														 const VertexBufferID destination,
+														 int destinationOffset,
+														 int size) = 0;
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
 		/// <summary>
 		/// Creates an uninitialized texture.
 		/// </summary>
@@ -101,6 +168,101 @@ namespace Gfx
 		/// </summary>
 		virtual void				GenerateMipMaps(const TextureID id) = 0;
 
+#if GFX_ENABLE_TEXTURE_ARRAYS
+		/// <summary>
+		/// Allocates a 2D texture array, with all the mipmap levels if
+		/// the filter uses them. The layers are undefined until loaded
+		/// with LoadTextureLayer.
+		/// Shaders sample it with a sampler2DArray and the layer index
+		/// as third coordinate.
+		/// </summary>
+		virtual void				LoadTextureArray(const TextureID id,
+													 int width, int height,
+													 int numberOfLayers,
+													 TextureFormat::Enum textureFormat,
+													 const TextureSampling& textureSampling) = 0;
+
+		/// <summary>
+		/// Sets the level 0 of one layer of a texture array, in the
+		/// format it was allocated with. GenerateMipMaps updates the
+		/// other levels.
+		/// </summary>
+		virtual void				LoadTextureLayer(const TextureID id, int layer, const void* data) = 0;
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+		/// <summary>
+		/// Allocates the levels of a 2D texture, to be loaded with
+		/// LoadTextureLevel, typically from a mip chain computed on the
+		/// CPU. The texture only samples the levels that are allocated.
+		/// </summary>
+		///
+		/// <param name="numberOfLevels">Number of mipmap levels, from 1
+		///     to the full chain down to 1x1.</param>
+		virtual void				AllocateTexture(const TextureID id,
+													int width, int height,
+													int numberOfLevels,
+													TextureFormat::Enum textureFormat,
+													const TextureSampling& textureSampling) = 0;
+
+		/// <summary>
+		/// Sets one level of a texture allocated by AllocateTexture, in
+		/// the format it was allocated with. Level n is half the size
+		/// of level n - 1, rounded down.
+		/// </summary>
+		virtual void				LoadTextureLevel(const TextureID id, int level, const void* data) = 0;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+		/// <summary>
+		/// Sets one mipmap level of a 2D texture from block compressed
+		/// data. Levels can be loaded one after the other from level 0;
+		/// the texture only samples the levels loaded so far.
+		/// </summary>
+		///
+		/// <param name="textureFormat">One of the BCn formats.</param>
+		/// <param name="lodLevel">Mipmap level, 0 being the largest.</param>
+		/// <param name="dataSize">Size of the compressed data in bytes.</param>
+		virtual void				LoadCompressedTexture(const TextureID id,
+														  int width, int height,
+														  TextureFormat::Enum textureFormat,
+														  int lodLevel,
+														  int dataSize, const void* data,
+														  const TextureSampling& textureSampling) = 0;
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		/// <summary>
+		/// Reserves an upload buffer for the data of a texture, to be
+		/// loaded with LoadTextureAsync. The data can be written to the
+		/// returned pointer from any thread, until LoadTextureAsync.
+		/// </summary>
+		///
+		/// <param name="size">Size of the data in bytes.</param>
+		/// <returns>The address to write the data to, or nullptr if all
+		/// the upload buffers are in use, in which case it can be tried
+		/// again later.</returns>
+		virtual void*				MapTextureUpload(const TextureID id, int size) = 0;
+
+		/// <summary>
+		/// Same as LoadTexture, with the data written to the address
+		/// returned by MapTextureUpload. The copy to the texture happens
+		/// asynchronously, see IsTextureReady.
+		/// </summary>
+		virtual void				LoadTextureAsync(const TextureID id,
+													 int width, int height,
+													 TextureType::Enum textureType,
+													 TextureFormat::Enum textureFormat,
+													 int side, int lodLevel,
+													 const TextureSampling& textureSampling) = 0;
+
+		/// <summary>
+		/// Tells whether the last asynchronous load of a texture is
+		/// complete. Textures loaded with LoadTexture are always ready.
+		/// </summary>
+		virtual bool				IsTextureReady(const TextureID id) = 0;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		/// <summary>
 		/// Creates an uninitialized uniform buffer.
@@ -131,13 +293,54 @@ namespace Gfx
 													  const void* data) = 0;
 
 		/// <summary>
-		/// Reads the data from an existing storage buffer.
+		/// Reads the data from an existing storage buffer. This waits
+		/// for the GPU to be done with the buffer; see RequestReadback
+		/// to read it without stalling.
 		/// </summary>
 		virtual void				ReadStorageBuffer(const StorageBufferID id,
 													  size_t size,
 													  void* dest) = 0;
 #endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		/// <summary>
+		/// Starts copying a range of a storage buffer to a staging
+		/// buffer, to be retrieved with TryGetReadback once the GPU is
+		/// done, typically a frame or two later.
+		/// </summary>
+		///
+		/// <returns>The ticket to retrieve the data with, or InvalidID
+		/// if all the staging buffers hold readbacks not retrieved yet,
+		/// in which case it can be tried again later.</returns>
+		virtual ReadbackID			RequestReadback(const StorageBufferID id,
+													int offset, int size) = 0;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+		/// <summary>
+		/// Same as above, for a rectangle of the first color attachment
+		/// of a frame buffer, or of the default frame buffer with
+		/// InvalidID. The pixels are read as RGBA8, row by row from the
+		/// bottom, so the data is width * height * 4 bytes.
+		/// </summary>
+		virtual ReadbackID			RequestReadback(const FrameBufferID id,
+													int x, int y,
+													int width, int height) = 0;
+
+		/// <summary>
+		/// Copies the data of a readback to dest if the GPU is done with
+		/// it, without waiting otherwise. Once retrieved, the ticket is
+		/// not valid anymore and its staging buffer is reused.
+		/// </summary>
+		///
+		/// <param name="dest">Where to copy the data, the size of the
+		/// request.</param>
+		/// <returns>true if the data was copied; false if the GPU isn't
+		///     done yet, or if the ticket is invalid or was already
+		///     retrieved.</returns>
+		virtual bool				TryGetReadback(const ReadbackID id, void* dest) = 0;
+#endif // GFX_ENABLE_ASYNC_READBACK
+
 		/// <summary>
 		/// Creates an uninitialized shader program.
 		/// </summary>
@@ -151,12 +354,44 @@ namespace Gfx
 											   const ShaderStage* shaderStages,
 											   int numberOfStages) = 0;
 
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		/// <summary>
+		/// Same as LoadShader, without waiting for the compilation, so
+		/// many shaders can be compiled in parallel. Errors are only
+		/// reported once the shader is ready.
+		/// The shader can be used right away, in which case drawing
+		/// waits for the compilation. The sourceInfo strings of the
+		/// stages must remain valid until then.
+		/// </summary>
+		virtual void				LoadShaderAsync(const ShaderID id,
+													const ShaderStage* shaderStages,
+													int numberOfStages) = 0;
+
+		/// <summary>
+		/// Tells whether the shader can be used without waiting for its
+		/// compilation. If the driver can't tell, this waits for it and
+		/// returns true.
+		/// </summary>
+		virtual bool				IsShaderReady(const ShaderID id) = 0;
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
 		/// <summary>
 		/// Creates a frame buffer.
 		/// </summary>
 		virtual FrameBufferID		CreateFrameBuffer(const TextureID* textures,
 													  int numberOfTextures,
 													  int side, int lodLevel) = 0;
+
+		/// <summary>
+		/// Attaches other textures to an existing frame buffer, as if it
+		/// was destroyed and created again, but keeping its id. A frame
+		/// buffer should also be loaded again once its textures have
+		/// been loaded again.
+		/// </summary>
+		virtual void				LoadFrameBuffer(const FrameBufferID id,
+													const TextureID* textures,
+													int numberOfTextures,
+													int side, int lodLevel) = 0;
 		virtual void				DestroyFrameBuffer(const FrameBufferID id) = 0;
 
 		/// <summary>
@@ -168,6 +403,40 @@ namespace Gfx
 													 float b,
 													 bool clearDepth) = 0;
 
+#if GFX_ENABLE_RENDER_PASSES
+		/// <summary>
+		/// Starts drawing to a frame buffer, saying what to do with the
+		/// previous content of each attachment. Unlike ClearFrameBuffer,
+		/// each attachment has its own clear value, and the ones the
+		/// pass overwrites are neither cleared nor loaded, which saves
+		/// bandwidth on tiled and software rasterizers.
+		/// The draws of the pass should target the same frame buffer.
+		/// </summary>
+		///
+		/// <param name="loadOps">Operation of each attachment, in the
+		///     order of the textures given to CreateFrameBuffer(). The
+		///     default frame buffer has two attachments: color, then
+		///     depth and stencil.</param>
+		/// <param name="clearValues">Clear value of each attachment,
+		///     only read for LoadOp::Clear; can be nullptr if there is
+		///     none.</param>
+		virtual void				BeginRenderPass(const FrameBufferID id,
+													const LoadOp::Enum* loadOps,
+													const ClearValue* clearValues,
+													int numberOfAttachments) = 0;
+
+		/// <summary>
+		/// Ends the render pass, saying which attachments the following
+		/// passes need. The others are invalidated, so the driver
+		/// doesn't have to write them back to memory.
+		/// </summary>
+		///
+		/// <param name="storeOps">Operation of each attachment, in the
+		///     same order as for BeginRenderPass().</param>
+		virtual void				EndRenderPass(const StoreOp::Enum* storeOps,
+												  int numberOfAttachments) = 0;
+#endif // GFX_ENABLE_RENDER_PASSES
+
 		/// <summary>
 		/// Draws one mesh or more, using the given parameters.
 		/// </summary>
@@ -176,6 +445,54 @@ namespace Gfx
 										 const Geometry& geometry,
 										 const ShadingParameters& shadingParameters) = 0;
 
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		/// <summary>
+		/// Draws a batch of meshes sharing the same vertex buffer, with
+		/// a single draw call. The number of instances is given by each
+		/// item of the batch, instead of the shading parameters.
+		/// </summary>
+		virtual void				Draw(const DrawArea& drawArea,
+										 const RasterTests& rasterTests,
+										 const DrawBatch& batch,
+										 const ShadingParameters& shadingParameters) = 0;
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+		/// <summary>
+		/// Draws a list of items in order, as many calls to Draw() would.
+		/// The state is only set where an item differs from the one
+		/// before it, and the work that doesn't depend on the items is
+		/// done once for the whole list. See Gfx::DrawItem.
+		/// </summary>
+		virtual void				SubmitDraws(const DrawItem* items, int count) = 0;
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		/// <summary>
+		/// Draws an indexed mesh with its number of indices and of
+		/// instances read by the GPU from a storage buffer, so a compute
+		/// pass can decide them without the CPU waiting for its result.
+		/// The number of instances of the shading parameters is ignored.
+		/// </summary>
+		///
+		/// <param name="arguments">Storage buffer holding the count,
+		///     instance count, first index, base vertex and base instance
+		///     of the draw, as five consecutive uint. The first index is
+		///     in indices, not in bytes.</param>
+		/// <param name="offset">Offset in bytes of the count in the
+		///     buffer, a multiple of 4.</param>
+		///
+		/// <remarks>If a shader wrote the arguments, a
+		/// Barrier::IndirectArguments should be inserted between the two
+		/// with InsertMemoryBarrier(). See GpuCuller.</remarks>
+		virtual void				DrawIndirect(const DrawArea& drawArea,
+												 const RasterTests& rasterTests,
+												 const VertexBufferID vertexBuffer,
+												 const ShadingParameters& shadingParameters,
+												 const StorageBufferID arguments,
+												 int offset) = 0;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
 #if GFX_ENABLE_COMPUTE_SHADERS
 		/// <summary>
 		/// Dispatches a compute shader for execution on the GPU.
@@ -188,6 +505,66 @@ namespace Gfx
 											int x, int y = 1, int z = 1) = 0;
 #endif // GFX_ENABLE_COMPUTE_SHADERS
 
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		/// <summary>
+		/// Dispatches a compute shader with a number of work groups read
+		/// by the GPU from a storage buffer, so a previous pass can
+		/// decide it without the CPU waiting for its result.
+		/// </summary>
+		///
+		/// <param name="arguments">Storage buffer holding the x, y and z
+		///     number of work groups, as three consecutive uint.</param>
+		/// <param name="offset">Offset in bytes of x in the buffer, a
+		///     multiple of 4.</param>
+		///
+		/// <remarks>If a shader wrote the arguments, a
+		/// Barrier::IndirectArguments should be inserted between the two
+		/// with InsertMemoryBarrier().</remarks>
+		virtual void				ComputeIndirect(const ShaderID shader,
+													const ComputeParameters& computeParameters,
+													const StorageBufferID arguments,
+													int offset) = 0;
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		/// <summary>
+		/// Makes what shaders wrote so far visible to the following
+		/// uses given as a combination of Barrier::Enum, for passes
+		/// chained on the GPU.
+		///
+		/// A storage buffer written by a shader is otherwise only
+		/// synchronized when it is next bound for reading, or read back.
+		/// </summary>
+		virtual void				InsertMemoryBarrier(int barriers) = 0;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_FRAME_STATS
+		/// <summary>
+		/// What the layer did during the last frame, up to the last call
+		/// to EndFrame(), and the resources alive at that point.
+		/// </summary>
+		virtual const FrameStats&	GetFrameStats() const = 0;
+#endif // GFX_ENABLE_FRAME_STATS
+
+#if GFX_ENABLE_GPU_PROFILING
+		/// <summary>
+		/// Starts measuring the GPU time of the commands that follow,
+		/// until the matching EndGpuScope(). Scopes can be nested.
+		/// The timings reach the profiler GFX_GPU_PROFILING_LATENCY
+		/// frames later, without waiting for the GPU.
+		/// </summary>
+		///
+		/// <param name="name">Name of the scope. The pointer is kept, so
+		///     it should be a string literal.</param>
+		virtual void				BeginGpuScope(const char* name) = 0;
+		virtual void				EndGpuScope() = 0;
+
+		/// <summary>
+		/// Timings of the GPU scopes read back so far.
+		/// </summary>
+		virtual GpuProfiler&		GetGpuProfiler() = 0;
+#endif // GFX_ENABLE_GPU_PROFILING
+
 		virtual void				EndFrame() = 0;
 	};
 #endif // GFX_MULTI_API
@@ -2,4 +2,5 @@
 
 #include "IGraphicLayer.hpp"
 #include "gfx/DirectX/DirectXLayer.hpp"
+#include "gfx/Null/NullLayer.hpp"
 #include "gfx/OpenGL/OpenGLLayer.hpp"
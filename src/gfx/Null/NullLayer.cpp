@@ -0,0 +1,1059 @@
+#include "NullLayer.hpp"
+
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+#include "gfx/DrawBatch.hpp"
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/DrawItem.hpp"
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/Geometry.hpp"
+#include "gfx/ShadingParameters.hpp"
+#include <cstring>
+
+#if GFX_MULTI_API
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::NullLayer::VBOInfo>;
+template class Container::Array<Gfx::NullLayer::TextureInfo>;
+template class Container::Array<Gfx::NullLayer::ShaderInfo>;
+template class Container::Array<Gfx::NullLayer::FBOInfo>;
+template class Container::Array<Gfx::NullLayer::BufferInfo>;
+
+#endif
+
+#if GFX_ENABLE_FRAME_STATS
+#define COUNT_FRAME_STAT(stat, n) (m_frameStats.stat += (n))
+#else // !GFX_ENABLE_FRAME_STATS
+#define COUNT_FRAME_STAT(stat, n) UNUSED_EXPR(n)
+#endif // !GFX_ENABLE_FRAME_STATS
+
+static int getNumberOfTriangles(PrimitiveType::Enum primitiveType, int numberOfIndices)
+{
+	switch (primitiveType)
+	{
+	case PrimitiveType::Triangles: return numberOfIndices / 3;
+	case PrimitiveType::TriangleStrip: return (numberOfIndices > 2 ? numberOfIndices - 2 : 0);
+	case PrimitiveType::Quads: return 2 * (numberOfIndices / 4);
+	case PrimitiveType::QuadStrip: return (numberOfIndices > 2 ? 2 * ((numberOfIndices - 2) / 2) : 0);
+	default: return 0;
+	}
+}
+
+NullLayer::NullLayer()
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	: m_uploadBuffer(nullptr)
+	, m_uploadBufferCapacity(0)
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+{
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		m_readbacks[i].data = nullptr;
+		m_readbacks[i].capacity = 0;
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+}
+
+NullLayer::~NullLayer()
+{
+	DestroyRenderingContext();
+}
+
+bool NullLayer::CreateRenderingContext()
+{
+	m_VBOs.init(GFX_MAX_VERTEX_BUFFERS);
+	m_textures.init(GFX_MAX_TEXTURES);
+	m_shaders.init(GFX_MAX_SHADERS);
+	m_FBOs.init(GFX_MAX_FRAME_BUFFERS);
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	m_UBOs.init(GFX_MAX_UNIFORM_BUFFERS);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	m_SSBOs.init(GFX_MAX_STORAGE_BUFFERS);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	m_currentShader = ShaderID::InvalidID;
+	m_currentVBO = VertexBufferID::InvalidID;
+	m_currentFrameBuffer = FrameBufferID::InvalidID;
+	m_currentViewport.x = -1; // Initializing to an invalid value
+	m_currentViewport.y = -1;
+	m_currentViewport.width = -1;
+	m_currentViewport.height = -1;
+	m_currentPolygonMode = PolygonMode::Filled;
+#if GFX_ENABLE_RENDER_PASSES
+	m_renderPassFrameBuffer = FrameBufferID::InvalidID;
+	m_inRenderPass = false;
+#endif // GFX_ENABLE_RENDER_PASSES
+
+#if GFX_ENABLE_FRAME_STATS
+	m_frameStats = FrameStats();
+	m_lastFrameStats = FrameStats();
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+	m_gpuProfiler.Init(false);
+	m_numberOfOpenGpuScopes = 0;
+#endif // GFX_ENABLE_GPU_PROFILING
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		m_readbacks[i].request = -1;
+		m_readbacks[i].ready = false;
+	}
+	m_nextReadback = 0;
+	m_numberOfReadbackRequests = 0;
+#endif // GFX_ENABLE_ASYNC_READBACK
+	return true;
+}
+
+void NullLayer::DestroyRenderingContext()
+{
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	for (int i = 0; i < m_SSBOs.size; ++i)
+	{
+		delete[] m_SSBOs[i].data;
+	}
+	m_SSBOs.clear();
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+	m_UBOs.clear();
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	delete[] m_uploadBuffer;
+	m_uploadBuffer = nullptr;
+	m_uploadBufferCapacity = 0;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		delete[] m_readbacks[i].data;
+		m_readbacks[i].data = nullptr;
+		m_readbacks[i].capacity = 0;
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+	m_VBOs.clear();
+	m_textures.clear();
+	m_shaders.clear();
+	m_FBOs.clear();
+}
+
+void NullLayer::CountUpload(int size)
+{
+	COUNT_FRAME_STAT(bytesUploaded, size);
+}
+
+//
+// Vertex buffers
+//
+
+VertexBufferID NullLayer::CreateVertexBuffer()
+{
+	VBOInfo& newVBO = m_VBOs.getNew();
+	newVBO.alive = true;
+	newVBO.indexed = false;
+	newVBO.primitiveType = PrimitiveType::Triangles;
+	newVBO.vertexBufferCapacity = 0;
+	newVBO.indexBufferCapacity = 0;
+	COUNT_FRAME_STAT(numberOfVertexBuffers, 1);
+
+	VertexBufferID id = { m_VBOs.size - 1 };
+	return id;
+}
+
+void NullLayer::DestroyVertexBuffer(const VertexBufferID id)
+{
+	ASSERT(m_VBOs.size > id.index && m_VBOs[id.index].alive);
+	m_VBOs[id.index].alive = false;
+	if (m_currentVBO == id)
+	{
+		m_currentVBO = VertexBufferID::InvalidID;
+	}
+	COUNT_FRAME_STAT(numberOfVertexBuffers, -1);
+}
+
+void NullLayer::LoadVertexBuffer(const VertexBufferID id,
+								 PrimitiveType::Enum primitiveType,
+								 const VertexAttribute* vertexAttributes,
+								 int numberOfAttributes, int /* stride */,
+								 int vertexDataSize, const void* vertexData,
+								 int indexDataSize, const void* indexData,
+								 VertexIndexType::Enum /* indexType */)
+{
+	ASSERT(vertexAttributes != nullptr);
+	ASSERT(numberOfAttributes > 0);
+	ASSERT(vertexDataSize > 0);
+	ASSERT(m_VBOs.size > id.index && m_VBOs[id.index].alive);
+	UNUSED_EXPR(vertexAttributes);
+	UNUSED_EXPR(numberOfAttributes);
+
+	VBOInfo& vboInfo = m_VBOs[id.index];
+	vboInfo.primitiveType = primitiveType;
+	vboInfo.indexed = (indexDataSize > 0);
+	vboInfo.vertexBufferCapacity = vertexDataSize;
+	vboInfo.indexBufferCapacity = indexDataSize;
+	CountUpload((vertexData != nullptr ? vertexDataSize : 0) +
+				(indexData != nullptr ? indexDataSize : 0));
+}
+
+void NullLayer::UpdateVertexBufferRange(const VertexBufferID id,
+										int offset, int size,
+										const void* data)
+{
+	ASSERT(m_VBOs.size > id.index && m_VBOs[id.index].alive);
+	ASSERT(offset >= 0 && size >= 0 && offset + size <= m_VBOs[id.index].vertexBufferCapacity);
+	ASSERT(data != nullptr);
+	UNUSED_EXPR(id);
+	UNUSED_EXPR(offset);
+	UNUSED_EXPR(data);
+	CountUpload(size);
+}
+
+void NullLayer::UpdateIndexBufferRange(const VertexBufferID id,
+									   int offset, int size,
+									   const void* data)
+{
+	ASSERT(m_VBOs.size > id.index && m_VBOs[id.index].alive);
+	ASSERT(m_VBOs[id.index].indexed);
+	ASSERT(offset >= 0 && size >= 0 && offset + size <= m_VBOs[id.index].indexBufferCapacity);
+	ASSERT(data != nullptr);
+	UNUSED_EXPR(id);
+	UNUSED_EXPR(offset);
+	UNUSED_EXPR(data);
+	CountUpload(size);
+}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+void NullLayer::CopyVertexBufferRange(const VertexBufferID source,
+									  int sourceOffset,
+									  const VertexBufferID destination,
+									  int destinationOffset,
+									  int size)
+{
+	ASSERT(m_VBOs.size > source.index && m_VBOs[source.index].alive);
+	ASSERT(m_VBOs.size > destination.index && m_VBOs[destination.index].alive);
+	ASSERT(sourceOffset >= 0 && size >= 0 && sourceOffset + size <= m_VBOs[source.index].vertexBufferCapacity);
+	ASSERT(destinationOffset >= 0 && destinationOffset + size <= m_VBOs[destination.index].vertexBufferCapacity);
+	UNUSED_EXPR(source);
+	UNUSED_EXPR(sourceOffset);
+	UNUSED_EXPR(destination);
+	UNUSED_EXPR(destinationOffset);
+	UNUSED_EXPR(size);
+}
+
+void NullLayer::CopyIndexBufferRange(const VertexBufferID source,
+									 int sourceOffset,
+									 const VertexBufferID destination,
+									 int destinationOffset,
+									 int size)
+{
+	ASSERT(m_VBOs.size > source.index && m_VBOs[source.index].alive);
+	ASSERT(m_VBOs.size > destination.index && m_VBOs[destination.index].alive);
+	ASSERT(sourceOffset >= 0 && size >= 0 && sourceOffset + size <= m_VBOs[source.index].indexBufferCapacity);
+	ASSERT(destinationOffset >= 0 && destinationOffset + size <= m_VBOs[destination.index].indexBufferCapacity);
+	UNUSED_EXPR(source);
+	UNUSED_EXPR(sourceOffset);
+	UNUSED_EXPR(destination);
+	UNUSED_EXPR(destinationOffset);
+	UNUSED_EXPR(size);
+}
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+//
+// Textures
+//
+
+TextureID NullLayer::CreateTexture()
+{
+	TextureInfo& newTexture = m_textures.getNew();
+	newTexture.alive = true;
+	newTexture.width = 0;
+	newTexture.height = 0;
+	newTexture.numberOfLayers = 0;
+	newTexture.numberOfLevels = 0;
+	newTexture.mapped = false;
+	COUNT_FRAME_STAT(numberOfTextures, 1);
+
+	TextureID id = { m_textures.size - 1 };
+	return id;
+}
+
+void NullLayer::DestroyTexture(const TextureID id)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	m_textures[id.index].alive = false;
+	COUNT_FRAME_STAT(numberOfTextures, -1);
+}
+
+void NullLayer::LoadTexture(const TextureID id,
+							int width, int height,
+							TextureType::Enum /* textureType */,
+							TextureFormat::Enum /* textureFormat */,
+							int /* side */, int lodLevel,
+							const void* data,
+							const TextureSampling& /* textureSampling */)
+{
+	ASSERT(width * height > 0);
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+	if (lodLevel <= 0)
+	{
+		textureInfo.width = width;
+		textureInfo.height = height;
+		textureInfo.numberOfLayers = 0;
+		textureInfo.numberOfLevels = 0;
+	}
+	COUNT_FRAME_STAT(bytesUploaded, (data != nullptr ? 4 * width * height : 0));
+}
+
+void NullLayer::GenerateMipMaps(const TextureID id)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	ASSERT(m_textures[id.index].width > 0);
+	UNUSED_EXPR(id);
+}
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+void NullLayer::LoadTextureArray(const TextureID id,
+								 int width, int height,
+								 int numberOfLayers,
+								 TextureFormat::Enum /* textureFormat */,
+								 const TextureSampling& /* textureSampling */)
+{
+	ASSERT(width * height > 0);
+	ASSERT(numberOfLayers > 0);
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+	textureInfo.width = width;
+	textureInfo.height = height;
+	textureInfo.numberOfLayers = numberOfLayers;
+	textureInfo.numberOfLevels = 0;
+}
+
+void NullLayer::LoadTextureLayer(const TextureID id, int layer, const void* data)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	ASSERT(data != nullptr);
+
+	const TextureInfo& textureInfo = m_textures[id.index];
+	ASSERT(layer >= 0 && layer < textureInfo.numberOfLayers);
+	UNUSED_EXPR(layer);
+	UNUSED_EXPR(data);
+	COUNT_FRAME_STAT(bytesUploaded, 4 * textureInfo.width * textureInfo.height);
+}
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+void NullLayer::AllocateTexture(const TextureID id,
+								int width, int height,
+								int numberOfLevels,
+								TextureFormat::Enum /* textureFormat */,
+								const TextureSampling& /* textureSampling */)
+{
+	ASSERT(width * height > 0);
+	ASSERT(numberOfLevels > 0);
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+	textureInfo.width = width;
+	textureInfo.height = height;
+	textureInfo.numberOfLayers = 0;
+	textureInfo.numberOfLevels = numberOfLevels;
+}
+
+void NullLayer::LoadTextureLevel(const TextureID id, int level, const void* data)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	ASSERT(data != nullptr);
+
+	const TextureInfo& textureInfo = m_textures[id.index];
+	ASSERT(level >= 0 && level < textureInfo.numberOfLevels);
+	UNUSED_EXPR(data);
+	const int width = textureInfo.width >> level;
+	const int height = textureInfo.height >> level;
+	COUNT_FRAME_STAT(bytesUploaded, 4 * (width > 0 ? width : 1) * (height > 0 ? height : 1));
+}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+void NullLayer::LoadCompressedTexture(const TextureID id,
+									  int width, int height,
+									  TextureFormat::Enum textureFormat,
+									  int lodLevel,
+									  int dataSize, const void* data,
+									  const TextureSampling& /* textureSampling */)
+{
+	ASSERT(width * height > 0);
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	ASSERT(textureFormat >= TextureFormat::BC1 && textureFormat <= TextureFormat::BC7);
+	ASSERT(lodLevel >= 0);
+	ASSERT(dataSize > 0 && data != nullptr);
+	UNUSED_EXPR(textureFormat);
+	UNUSED_EXPR(data);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+	if (lodLevel == 0)
+	{
+		textureInfo.width = width;
+		textureInfo.height = height;
+		textureInfo.numberOfLayers = 0;
+		textureInfo.numberOfLevels = 0;
+	}
+	CountUpload(dataSize);
+}
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+void* NullLayer::MapTextureUpload(const TextureID id, int size)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	ASSERT(!m_textures[id.index].mapped);
+	ASSERT(size > 0);
+
+	if (size > m_uploadBufferCapacity)
+	{
+		delete[] m_uploadBuffer;
+		m_uploadBuffer = new char[size];
+		m_uploadBufferCapacity = size;
+	}
+	m_textures[id.index].mapped = true;
+	return m_uploadBuffer;
+}
+
+void NullLayer::LoadTextureAsync(const TextureID id,
+								 int width, int height,
+								 TextureType::Enum textureType,
+								 TextureFormat::Enum textureFormat,
+								 int side, int lodLevel,
+								 const TextureSampling& textureSampling)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].mapped);
+	m_textures[id.index].mapped = false;
+	LoadTexture(id, width, height, textureType, textureFormat, side, lodLevel,
+				m_uploadBuffer, textureSampling);
+}
+
+bool NullLayer::IsTextureReady(const TextureID id)
+{
+	ASSERT(m_textures.size > id.index && m_textures[id.index].alive);
+	return !m_textures[id.index].mapped;
+}
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+//
+// Uniform and storage buffers
+//
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+UniformBufferID NullLayer::CreateUniformBuffer()
+{
+	BufferInfo& newUBO = m_UBOs.getNew();
+	newUBO.alive = true;
+	newUBO.size = 0;
+	newUBO.data = nullptr;
+	COUNT_FRAME_STAT(numberOfUniformBuffers, 1);
+
+	UniformBufferID id = { m_UBOs.size - 1 };
+	return id;
+}
+
+void NullLayer::DestroyUniformBuffer(const UniformBufferID id)
+{
+	ASSERT(m_UBOs.size > id.index && m_UBOs[id.index].alive);
+	m_UBOs[id.index].alive = false;
+	COUNT_FRAME_STAT(numberOfUniformBuffers, -1);
+}
+
+void NullLayer::LoadUniformBuffer(const UniformBufferID id,
+								  int size,
+								  const void* data)
+{
+	ASSERT(size >= 0);
+	ASSERT(m_UBOs.size > id.index && m_UBOs[id.index].alive);
+
+	BufferInfo& uboInfo = m_UBOs[id.index];
+	ASSERT(uboInfo.size == 0 || uboInfo.size == size);
+	uboInfo.size = size;
+	CountUpload(data != nullptr ? size : 0);
+}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+StorageBufferID NullLayer::CreateStorageBuffer()
+{
+	BufferInfo& newSSBO = m_SSBOs.getNew();
+	newSSBO.alive = true;
+	newSSBO.size = 0;
+	newSSBO.data = nullptr;
+	COUNT_FRAME_STAT(numberOfStorageBuffers, 1);
+
+	StorageBufferID id = { m_SSBOs.size - 1 };
+	return id;
+}
+
+void NullLayer::DestroyStorageBuffer(const StorageBufferID id)
+{
+	ASSERT(m_SSBOs.size > id.index && m_SSBOs[id.index].alive);
+	BufferInfo& ssboInfo = m_SSBOs[id.index];
+	delete[] ssboInfo.data;
+	ssboInfo.data = nullptr;
+	ssboInfo.size = 0;
+	ssboInfo.alive = false;
+	COUNT_FRAME_STAT(numberOfStorageBuffers, -1);
+}
+
+void NullLayer::LoadStorageBuffer(const StorageBufferID id, size_t size, const void* data)
+{
+	ASSERT(m_SSBOs.size > id.index && m_SSBOs[id.index].alive);
+
+	BufferInfo& ssboInfo = m_SSBOs[id.index];
+	if ((int)size != ssboInfo.size)
+	{
+		delete[] ssboInfo.data;
+		ssboInfo.data = new char[size];
+		ssboInfo.size = (int)size;
+	}
+	if (data != nullptr)
+	{
+		memcpy(ssboInfo.data, data, size);
+		CountUpload((int)size);
+	}
+	else
+	{
+		memset(ssboInfo.data, 0, size);
+	}
+}
+
+void NullLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void* dest)
+{
+	ASSERT(m_SSBOs.size > id.index && m_SSBOs[id.index].alive);
+
+	const BufferInfo& ssboInfo = m_SSBOs[id.index];
+	ASSERT((int)size <= ssboInfo.size);
+	memcpy(dest, ssboInfo.data, size);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+//
+// Readbacks
+//
+
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+ReadbackID NullLayer::RequestReadback(const StorageBufferID id, int offset, int size)
+{
+	ASSERT(m_SSBOs.size > id.index && m_SSBOs[id.index].alive);
+	const BufferInfo& ssboInfo = m_SSBOs[id.index];
+	ASSERT(offset >= 0 && size > 0 && offset + size <= ssboInfo.size);
+
+	const int index = ReserveReadback(size);
+	if (index < 0)
+	{
+		return ReadbackID::InvalidID;
+	}
+	memcpy(m_readbacks[index].data, ssboInfo.data + offset, size);
+	ReadbackID result = { m_readbacks[index].request };
+	return result;
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+// Nothing is rendered, so the pixels are black.
+ReadbackID NullLayer::RequestReadback(const FrameBufferID id,
+									  int x, int y,
+									  int width, int height)
+{
+	ASSERT(m_FBOs.size > id.index);
+	ASSERT(id.index < 0 || (m_FBOs[id.index].alive &&
+							x >= 0 && y >= 0 &&
+							x + width <= m_FBOs[id.index].width &&
+							y + height <= m_FBOs[id.index].height));
+	ASSERT(width > 0 && height > 0);
+	UNUSED_EXPR(id);
+	UNUSED_EXPR(x);
+	UNUSED_EXPR(y);
+
+	const int index = ReserveReadback(width * height * 4);
+	if (index < 0)
+	{
+		return ReadbackID::InvalidID;
+	}
+	memset(m_readbacks[index].data, 0, width * height * 4);
+	ReadbackID result = { m_readbacks[index].request };
+	return result;
+}
+
+bool NullLayer::TryGetReadback(const ReadbackID id, void* dest)
+{
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		Readback& readback = m_readbacks[i];
+		if (readback.request == id.index && id.index >= 0)
+		{
+			if (!readback.ready)
+			{
+				return false;
+			}
+			memcpy(dest, readback.data, readback.size);
+			readback.request = -1;
+			return true;
+		}
+	}
+
+	// Invalid, or already retrieved.
+	return false;
+}
+
+int NullLayer::ReserveReadback(int size)
+{
+	int index = -1;
+	for (int i = 0; i < GFX_READBACK_BUFFERS && index < 0; ++i)
+	{
+		const int candidate = (m_nextReadback + i) % GFX_READBACK_BUFFERS;
+		if (m_readbacks[candidate].request < 0)
+		{
+			index = candidate;
+		}
+	}
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	Readback& readback = m_readbacks[index];
+	if (size > readback.capacity)
+	{
+		delete[] readback.data;
+		readback.data = new char[size];
+		readback.capacity = size;
+	}
+	readback.size = size;
+	readback.request = m_numberOfReadbackRequests;
+	readback.ready = false;
+	m_numberOfReadbackRequests = (m_numberOfReadbackRequests + 1) & 0x7fffffff;
+	m_nextReadback = (index + 1) % GFX_READBACK_BUFFERS;
+	return index;
+}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+//
+// Shaders
+//
+
+ShaderID NullLayer::CreateShader()
+{
+	ShaderInfo& newShader = m_shaders.getNew();
+	newShader.alive = true;
+	newShader.loaded = false;
+	COUNT_FRAME_STAT(numberOfShaders, 1);
+
+	ShaderID id = { m_shaders.size - 1 };
+	return id;
+}
+
+void NullLayer::DestroyShader(const ShaderID id)
+{
+	ASSERT(m_shaders.size > id.index && m_shaders[id.index].alive);
+	m_shaders[id.index].alive = false;
+	m_shaders[id.index].loaded = false;
+	if (m_currentShader == id)
+	{
+		m_currentShader = ShaderID::InvalidID;
+	}
+	COUNT_FRAME_STAT(numberOfShaders, -1);
+}
+
+void NullLayer::LoadShader(const ShaderID id,
+						   const ShaderStage* shaderStages,
+						   int numberOfStages)
+{
+	ASSERT(m_shaders.size > id.index && m_shaders[id.index].alive);
+	ASSERT(shaderStages != nullptr && numberOfStages > 0);
+	UNUSED_EXPR(shaderStages);
+	UNUSED_EXPR(numberOfStages);
+	m_shaders[id.index].loaded = true;
+}
+
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+void NullLayer::LoadShaderAsync(const ShaderID id,
+								const ShaderStage* shaderStages,
+								int numberOfStages)
+{
+	LoadShader(id, shaderStages, numberOfStages);
+}
+
+bool NullLayer::IsShaderReady(const ShaderID id)
+{
+	ASSERT(m_shaders.size > id.index && m_shaders[id.index].alive);
+	UNUSED_EXPR(id);
+	return true;
+}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+//
+// Frame buffers and drawing
+//
+
+FrameBufferID NullLayer::CreateFrameBuffer(const TextureID* textures,
+										   int numberOfTextures,
+										   int /* side */, int /* lodLevel */)
+{
+	ASSERT(textures != nullptr && numberOfTextures > 0);
+	for (int i = 0; i < numberOfTextures; ++i)
+	{
+		ASSERT(m_textures.size > textures[i].index && m_textures[textures[i].index].alive);
+	}
+
+	FBOInfo& newFBO = m_FBOs.getNew();
+	newFBO.alive = true;
+	newFBO.width = m_textures[textures[0].index].width;
+	newFBO.height = m_textures[textures[0].index].height;
+#if GFX_ENABLE_RENDER_PASSES
+	newFBO.numberOfAttachments = numberOfTextures;
+#endif // GFX_ENABLE_RENDER_PASSES
+	COUNT_FRAME_STAT(numberOfFrameBuffers, 1);
+
+	FrameBufferID id = { m_FBOs.size - 1 };
+	return id;
+}
+
+void NullLayer::LoadFrameBuffer(const FrameBufferID id,
+								const TextureID* textures,
+								int numberOfTextures,
+								int /* side */, int /* lodLevel */)
+{
+	ASSERT(m_FBOs.size > id.index && m_FBOs[id.index].alive);
+	ASSERT(textures != nullptr && numberOfTextures > 0);
+	for (int i = 0; i < numberOfTextures; ++i)
+	{
+		ASSERT(m_textures.size > textures[i].index && m_textures[textures[i].index].alive);
+	}
+
+	FBOInfo& fbo = m_FBOs[id.index];
+	fbo.width = m_textures[textures[0].index].width;
+	fbo.height = m_textures[textures[0].index].height;
+#if GFX_ENABLE_RENDER_PASSES
+	fbo.numberOfAttachments = numberOfTextures;
+#endif // GFX_ENABLE_RENDER_PASSES
+}
+
+void NullLayer::DestroyFrameBuffer(const FrameBufferID id)
+{
+	ASSERT(m_FBOs.size > id.index && m_FBOs[id.index].alive);
+	m_FBOs[id.index].alive = false;
+	if (m_currentFrameBuffer == id)
+	{
+		m_currentFrameBuffer = FrameBufferID::InvalidID;
+	}
+	COUNT_FRAME_STAT(numberOfFrameBuffers, -1);
+}
+
+void NullLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
+								 float /* r */, float /* g */, float /* b */,
+								 bool /* clearDepth */)
+{
+	ASSERT(frameBuffer.index < 0 || (m_FBOs.size > frameBuffer.index && m_FBOs[frameBuffer.index].alive));
+	if (m_currentFrameBuffer != frameBuffer)
+	{
+		m_currentFrameBuffer = frameBuffer;
+		COUNT_FRAME_STAT(frameBufferChanges, 1);
+	}
+}
+
+#if GFX_ENABLE_RENDER_PASSES
+void NullLayer::BeginRenderPass(const FrameBufferID id,
+								const LoadOp::Enum* loadOps,
+								const ClearValue* /* clearValues */,
+								int numberOfAttachments)
+{
+	ASSERT(!m_inRenderPass);
+	ASSERT(id.index < 0 || (m_FBOs.size > id.index && m_FBOs[id.index].alive));
+	ASSERT(numberOfAttachments == (id.index >= 0 ? m_FBOs[id.index].numberOfAttachments : 2));
+	ASSERT(loadOps != nullptr);
+	UNUSED_EXPR(loadOps);
+	UNUSED_EXPR(numberOfAttachments);
+	m_inRenderPass = true;
+	m_renderPassFrameBuffer = id;
+	if (m_currentFrameBuffer != id)
+	{
+		m_currentFrameBuffer = id;
+		COUNT_FRAME_STAT(frameBufferChanges, 1);
+	}
+}
+
+void NullLayer::EndRenderPass(const StoreOp::Enum* storeOps,
+							  int numberOfAttachments)
+{
+	ASSERT(m_inRenderPass);
+	ASSERT(numberOfAttachments == (m_renderPassFrameBuffer.index >= 0 ? m_FBOs[m_renderPassFrameBuffer.index].numberOfAttachments : 2));
+	ASSERT(storeOps != nullptr);
+	UNUSED_EXPR(storeOps);
+	UNUSED_EXPR(numberOfAttachments);
+	m_inRenderPass = false;
+}
+#endif // GFX_ENABLE_RENDER_PASSES
+
+void NullLayer::BindShader(const ShaderID id)
+{
+	ASSERT(id.index < 0 || (m_shaders.size > id.index && m_shaders[id.index].loaded));
+	if (m_currentShader != id)
+	{
+		m_currentShader = id;
+		COUNT_FRAME_STAT(shaderChanges, 1);
+	}
+}
+
+void NullLayer::BindVertexBuffer(const VertexBufferID id)
+{
+	ASSERT(id.index < 0 || (m_VBOs.size > id.index && m_VBOs[id.index].alive));
+	if (m_currentVBO != id)
+	{
+		m_currentVBO = id;
+		COUNT_FRAME_STAT(vertexBufferChanges, 1);
+	}
+}
+
+// Counts the state changes a draw would make, the way OpenGLLayer
+// filters the redundant ones.
+void NullLayer::SetState(const DrawArea& drawArea,
+						 const RasterTests& rasterTests,
+						 const ShadingParameters& shadingParameters)
+{
+	BindShader(shadingParameters.shader);
+	COUNT_FRAME_STAT(uniformBindsIssued, shadingParameters.uniforms.size);
+	SetRenderState(drawArea, rasterTests, shadingParameters.blendingMode, shadingParameters.polygonMode);
+}
+
+void NullLayer::SetRenderState(const DrawArea& drawArea,
+							   const RasterTests& rasterTests,
+							   const BlendingMode& blendingMode,
+							   PolygonMode::Enum polygonMode)
+{
+	ASSERT(drawArea.frameBuffer.index < 0 ||
+		   (m_FBOs.size > drawArea.frameBuffer.index && m_FBOs[drawArea.frameBuffer.index].alive));
+	if (m_currentFrameBuffer != drawArea.frameBuffer)
+	{
+		m_currentFrameBuffer = drawArea.frameBuffer;
+		COUNT_FRAME_STAT(frameBufferChanges, 1);
+	}
+	if (m_currentViewport != drawArea.viewport)
+	{
+		m_currentViewport = drawArea.viewport;
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
+	}
+	if (m_currentPolygonMode != polygonMode)
+	{
+		m_currentPolygonMode = polygonMode;
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
+	}
+	if (m_currentRasterTests != rasterTests)
+	{
+		// Copied as bytes, since the comparison includes the padding,
+		// which an assignment may leave out.
+		memcpy(&m_currentRasterTests, &rasterTests, sizeof(rasterTests));
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
+	}
+	if (m_currentBlendingMode != blendingMode)
+	{
+		m_currentBlendingMode = blendingMode;
+		COUNT_FRAME_STAT(blendStateChanges, 1);
+	}
+}
+
+void NullLayer::Draw(const DrawArea& drawArea,
+					 const RasterTests& rasterTests,
+					 const Geometry& geometry,
+					 const ShadingParameters& shadingParameters)
+{
+	BindVertexBuffer(geometry.vertexBuffer);
+	SetState(drawArea, rasterTests, shadingParameters);
+	CountDraw(geometry.vertexBuffer, geometry.numberOfIndices, shadingParameters.numberOfInstances);
+}
+
+void NullLayer::CountDraw(const VertexBufferID id, int numberOfIndices,
+						  int numberOfInstances)
+{
+	if (id.index >= 0)
+	{
+		const VBOInfo& vboInfo = m_VBOs[id.index];
+		COUNT_FRAME_STAT(numberOfDraws, 1);
+		COUNT_FRAME_STAT(numberOfInstances, numberOfInstances);
+		COUNT_FRAME_STAT(numberOfTriangles, numberOfInstances * getNumberOfTriangles(vboInfo.primitiveType, numberOfIndices));
+	}
+}
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+void NullLayer::Draw(const DrawArea& drawArea,
+					 const RasterTests& rasterTests,
+					 const DrawBatch& batch,
+					 const ShadingParameters& shadingParameters)
+{
+	if (batch.items.size == 0)
+	{
+		return;
+	}
+
+	ASSERT(batch.vertexBuffer.index >= 0);
+	BindVertexBuffer(batch.vertexBuffer);
+	SetState(drawArea, rasterTests, shadingParameters);
+
+	const VBOInfo& vboInfo = m_VBOs[batch.vertexBuffer.index];
+	ASSERT(vboInfo.indexed);
+	for (int i = 0; i < batch.items.size; ++i)
+	{
+		const DrawBatch::Item& item = batch.items[i];
+		ASSERT(item.firstIndexOffset >= 0 && item.firstIndexOffset < vboInfo.indexBufferCapacity);
+		COUNT_FRAME_STAT(numberOfInstances, item.numberOfInstances);
+		COUNT_FRAME_STAT(numberOfTriangles, item.numberOfInstances * getNumberOfTriangles(vboInfo.primitiveType, item.numberOfIndices));
+	}
+	COUNT_FRAME_STAT(numberOfDraws, 1);
+	CountUpload(batch.items.size * 5 * sizeof(int)); // The indirect commands.
+}
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+// Sets what differs from the previous item, as OpenGLLayer does.
+void NullLayer::SubmitDraws(const DrawItem* items, int count)
+{
+	ASSERT(count == 0 || (items != nullptr && count > 0));
+	const DrawItem* previous = nullptr;
+	for (int i = 0; i < count; ++i)
+	{
+		const DrawItem& item = items[i];
+		ASSERT(item.state != nullptr);
+		BindVertexBuffer(item.vertexBuffer);
+		BindShader(item.shader);
+		if (previous == nullptr ||
+			item.shader != previous->shader ||
+			item.uniforms != previous->uniforms ||
+			item.numberOfUniforms != previous->numberOfUniforms)
+		{
+			COUNT_FRAME_STAT(uniformBindsIssued, item.numberOfUniforms);
+		}
+		else
+		{
+			COUNT_FRAME_STAT(uniformBindsAvoided, item.numberOfUniforms);
+		}
+		if (previous == nullptr || item.state != previous->state)
+		{
+			const DrawState& state = *item.state;
+			SetRenderState(state.drawArea, state.rasterTests, state.blendingMode, state.polygonMode);
+		}
+		CountDraw(item.vertexBuffer, item.numberOfIndices, item.numberOfInstances);
+		previous = &item;
+	}
+}
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void NullLayer::DrawIndirect(const DrawArea& drawArea,
+							 const RasterTests& rasterTests,
+							 const VertexBufferID vertexBuffer,
+							 const ShadingParameters& shadingParameters,
+							 const StorageBufferID arguments,
+							 int offset)
+{
+	ASSERT(vertexBuffer.index >= 0 && m_VBOs[vertexBuffer.index].indexed);
+	ASSERT(arguments.index >= 0 && m_SSBOs.size > arguments.index && m_SSBOs[arguments.index].alive);
+	ASSERT(offset >= 0 && offset % 4 == 0 && offset + 5 * (int)sizeof(int) <= m_SSBOs[arguments.index].size);
+	BindVertexBuffer(vertexBuffer);
+	SetState(drawArea, rasterTests, shadingParameters);
+
+	// Counted with the arguments as they were loaded, since no shader
+	// runs to write them.
+	const int* command = (const int*)(m_SSBOs[arguments.index].data + offset);
+	CountDraw(vertexBuffer, command[0], command[1]);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_COMPUTE_SHADERS
+void NullLayer::Compute(const ShaderID shader,
+						const ComputeParameters& computeParameters,
+						int x, int y, int z)
+{
+	ASSERT(x > 0 && y > 0 && z > 0);
+	UNUSED_EXPR(x);
+	UNUSED_EXPR(y);
+	UNUSED_EXPR(z);
+	BindShader(shader);
+	COUNT_FRAME_STAT(uniformBindsIssued, computeParameters.uniforms.size);
+	COUNT_FRAME_STAT(numberOfDispatches, 1);
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void NullLayer::ComputeIndirect(const ShaderID shader,
+								const ComputeParameters& computeParameters,
+								const StorageBufferID arguments,
+								int offset)
+{
+	ASSERT(arguments.index >= 0 && m_SSBOs.size > arguments.index && m_SSBOs[arguments.index].alive);
+	ASSERT(offset >= 0 && offset % 4 == 0 && offset + 3 * (int)sizeof(int) <= m_SSBOs[arguments.index].size);
+	UNUSED_EXPR(arguments);
+	UNUSED_EXPR(offset);
+	BindShader(shader);
+	COUNT_FRAME_STAT(uniformBindsIssued, computeParameters.uniforms.size);
+	COUNT_FRAME_STAT(numberOfDispatches, 1);
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void NullLayer::InsertMemoryBarrier(int barriers)
+{
+	ASSERT(barriers != 0);
+	UNUSED_EXPR(barriers);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_GPU_PROFILING
+void NullLayer::BeginGpuScope(const char* name)
+{
+	ASSERT(name != nullptr);
+	UNUSED_EXPR(name);
+	++m_numberOfOpenGpuScopes;
+}
+
+void NullLayer::EndGpuScope()
+{
+	ASSERT(m_numberOfOpenGpuScopes > 0);
+	--m_numberOfOpenGpuScopes;
+}
+#endif // GFX_ENABLE_GPU_PROFILING
+
+void NullLayer::EndFrame()
+{
+#if GFX_ENABLE_GPU_PROFILING
+	ASSERT(m_numberOfOpenGpuScopes == 0);
+#endif // GFX_ENABLE_GPU_PROFILING
+
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		m_readbacks[i].ready = (m_readbacks[i].request >= 0);
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+#if GFX_ENABLE_FRAME_STATS
+	// The counters start over, the resource counts carry on.
+	m_lastFrameStats = m_frameStats;
+	m_frameStats = FrameStats();
+	m_frameStats.numberOfVertexBuffers = m_lastFrameStats.numberOfVertexBuffers;
+	m_frameStats.numberOfTextures = m_lastFrameStats.numberOfTextures;
+	m_frameStats.numberOfShaders = m_lastFrameStats.numberOfShaders;
+	m_frameStats.numberOfFrameBuffers = m_lastFrameStats.numberOfFrameBuffers;
+	m_frameStats.numberOfUniformBuffers = m_lastFrameStats.numberOfUniformBuffers;
+	m_frameStats.numberOfStorageBuffers = m_lastFrameStats.numberOfStorageBuffers;
+#endif // GFX_ENABLE_FRAME_STATS
+}
+
+#endif // GFX_MULTI_API
@@ -0,0 +1,340 @@
+#pragma once
+
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include "gfx/BlendingMode.hpp"
+#include "gfx/DrawArea.hpp"
+#include "gfx/IGraphicLayer.hpp"
+#include "gfx/PolygonMode.hpp"
+#include "gfx/RasterTests.hpp"
+#if GFX_ENABLE_FRAME_STATS
+#include "gfx/FrameStats.hpp"
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+#include "gfx/GpuProfiler.hpp"
+#endif // GFX_ENABLE_GPU_PROFILING
+
+#if GFX_MULTI_API
+
+namespace Gfx
+{
+	/// <summary>
+	/// IGraphicLayer that keeps track of the resources and of what is
+	/// drawn, without calling any graphics API. It needs no context, so
+	/// the submission cost of the engine can be measured on any
+	/// machine, and gives the same results from one run to the next.
+	///
+	/// Resources are validated as OpenGLLayer does in debug builds:
+	/// using a destroyed resource, or updating beyond what was loaded,
+	/// asserts. Storage buffers keep their data, so reading one back
+	/// returns what was loaded. Nothing is ever rendered, and the GPU
+	/// scopes are ignored.
+	/// </summary>
+	class NullLayer : public IGraphicLayer
+	{
+	public:
+		NullLayer();
+		~NullLayer();
+
+		bool					CreateRenderingContext();
+		void					DestroyRenderingContext();
+
+		VertexBufferID			CreateVertexBuffer();
+		void					DestroyVertexBuffer(const VertexBufferID id);
+		void					LoadVertexBuffer(const VertexBufferID id,
+												 PrimitiveType::Enum primitiveType,
+												 const VertexAttribute* vertexAttributes,
+												 int numberOfAttributes, int stride,
+												 int vertexDataSize, const void* vertexData,
+												 int indexDataSize, const void* indexData,
+												 VertexIndexType::Enum indexType);
+		void					UpdateVertexBufferRange(const VertexBufferID id,
+														int offset, int size,
+														const void* data);
+		void					UpdateIndexBufferRange(const VertexBufferID id,
+													   int offset, int size,
+													   const void* data);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		void					CopyVertexBufferRange(const VertexBufferID source,
+													  int sourceOffset,
+													  const VertexBufferID destination,
+													  int destinationOffset,
+													  int size);
+		void					CopyIndexBufferRange(const VertexBufferID source,
+													 int sourceOffset,
+													 const VertexBufferID destination,
+													 int destinationOffset,
+													 int size);
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+		TextureID				CreateTexture();
+		void					DestroyTexture(const TextureID id);
+		void					LoadTexture(const TextureID id,
+											int width, int height,
+											TextureType::Enum textureType,
+											TextureFormat::Enum textureFormat,
+											int side, int lodLevel,
+											const void* data,
+											const TextureSampling& textureSampling);
+		void					GenerateMipMaps(const TextureID id);
+#if GFX_ENABLE_TEXTURE_ARRAYS
+		void					LoadTextureArray(const TextureID id,
+												 int width, int height,
+												 int numberOfLayers,
+												 TextureFormat::Enum textureFormat,
+												 const TextureSampling& textureSampling);
+		void					LoadTextureLayer(const TextureID id, int layer, const void* data);
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+		void					AllocateTexture(const TextureID id,
+												int width, int height,
+												int numberOfLevels,
+												TextureFormat::Enum textureFormat,
+												const TextureSampling& textureSampling);
+		void					LoadTextureLevel(const TextureID id, int level, const void* data);
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+		void					LoadCompressedTexture(const TextureID id,
+													  int width, int height,
+													  TextureFormat::Enum textureFormat,
+													  int lodLevel,
+													  int dataSize, const void* data,
+													  const TextureSampling& textureSampling);
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		void*					MapTextureUpload(const TextureID id, int size);
+		void					LoadTextureAsync(const TextureID id,
+												 int width, int height,
+												 TextureType::Enum textureType,
+												 TextureFormat::Enum textureFormat,
+												 int side, int lodLevel,
+												 const TextureSampling& textureSampling);
+		bool					IsTextureReady(const TextureID id);
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+		UniformBufferID			CreateUniformBuffer();
+		void					DestroyUniformBuffer(const UniformBufferID id);
+		void					LoadUniformBuffer(const UniformBufferID id,
+												  int size,
+												  const void* data);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		StorageBufferID			CreateStorageBuffer();
+		void					DestroyStorageBuffer(const StorageBufferID id);
+		void					LoadStorageBuffer(const StorageBufferID id,
+												  size_t size,
+												  const void* data);
+		void					ReadStorageBuffer(const StorageBufferID id,
+												  size_t size,
+												  void* dest);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const StorageBufferID id,
+												int offset, int size);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const FrameBufferID id,
+												int x, int y,
+												int width, int height);
+		bool					TryGetReadback(const ReadbackID id, void* dest);
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+		ShaderID				CreateShader();
+		void					DestroyShader(const ShaderID id);
+		void					LoadShader(const ShaderID id,
+										   const ShaderStage* shaderStages,
+										   int numberOfStages);
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		void					LoadShaderAsync(const ShaderID id,
+												const ShaderStage* shaderStages,
+												int numberOfStages);
+		bool					IsShaderReady(const ShaderID id);
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+		FrameBufferID			CreateFrameBuffer(const TextureID* textures,
+												  int numberOfTextures,
+												  int side, int lodLevel);
+		void					LoadFrameBuffer(const FrameBufferID id,
+												const TextureID* textures,
+												int numberOfTextures,
+												int side, int lodLevel);
+		void					DestroyFrameBuffer(const FrameBufferID id);
+		void					ClearFrameBuffer(const FrameBufferID frameBuffer,
+												 float r, float g, float b,
+												 bool clearDepth);
+#if GFX_ENABLE_RENDER_PASSES
+		void					BeginRenderPass(const FrameBufferID id,
+												const LoadOp::Enum* loadOps,
+												const ClearValue* clearValues,
+												int numberOfAttachments);
+		void					EndRenderPass(const StoreOp::Enum* storeOps,
+											  int numberOfAttachments);
+#endif // GFX_ENABLE_RENDER_PASSES
+
+		void					Draw(const DrawArea& drawArea,
+									 const RasterTests& rasterTests,
+									 const Geometry& geometry,
+									 const ShadingParameters& shadingParameters);
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		void					Draw(const DrawArea& drawArea,
+									 const RasterTests& rasterTests,
+									 const DrawBatch& batch,
+									 const ShadingParameters& shadingParameters);
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+		void					SubmitDraws(const DrawItem* items, int count);
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					DrawIndirect(const DrawArea& drawArea,
+											 const RasterTests& rasterTests,
+											 const VertexBufferID vertexBuffer,
+											 const ShadingParameters& shadingParameters,
+											 const StorageBufferID arguments,
+											 int offset);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_COMPUTE_SHADERS
+		void					Compute(const ShaderID shader,
+										const ComputeParameters& computeParameters,
+										int x, int y = 1, int z = 1);
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					ComputeIndirect(const ShaderID shader,
+												const ComputeParameters& computeParameters,
+												const StorageBufferID arguments,
+												int offset);
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					InsertMemoryBarrier(int barriers);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_FRAME_STATS
+		const FrameStats&		GetFrameStats() const { return m_lastFrameStats; }
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+		void					BeginGpuScope(const char* name);
+		void					EndGpuScope();
+		GpuProfiler&			GetGpuProfiler() { return m_gpuProfiler; }
+#endif // GFX_ENABLE_GPU_PROFILING
+		void					EndFrame();
+
+	private:
+		struct VBOInfo
+		{
+			bool			alive;
+			bool			indexed;
+			PrimitiveType::Enum primitiveType;
+			int				vertexBufferCapacity; // Loaded size in bytes.
+			int				indexBufferCapacity;
+		};
+
+		struct TextureInfo
+		{
+			bool			alive;
+			int				width;
+			int				height;
+			int				numberOfLayers; // 0 if not an array.
+			int				numberOfLevels; // Allocated by AllocateTexture, or 0.
+			bool			mapped; // By MapTextureUpload.
+		};
+
+		struct ShaderInfo
+		{
+			bool			alive;
+			bool			loaded;
+		};
+
+		struct FBOInfo
+		{
+			bool			alive;
+			int				width;
+			int				height;
+#if GFX_ENABLE_RENDER_PASSES
+			int				numberOfAttachments;
+#endif // GFX_ENABLE_RENDER_PASSES
+		};
+
+		struct BufferInfo
+		{
+			bool			alive;
+			int				size;
+			char*			data; // Only kept for storage buffers.
+		};
+
+		void					SetState(const DrawArea& drawArea,
+										 const RasterTests& rasterTests,
+										 const ShadingParameters& shadingParameters);
+		void					SetRenderState(const DrawArea& drawArea,
+											   const RasterTests& rasterTests,
+											   const BlendingMode& blendingMode,
+											   PolygonMode::Enum polygonMode);
+		void					BindShader(const ShaderID id);
+		void					BindVertexBuffer(const VertexBufferID id);
+		void					CountDraw(const VertexBufferID id, int numberOfIndices,
+										  int numberOfInstances);
+		void					CountUpload(int size);
+#if GFX_ENABLE_ASYNC_READBACK
+		int						ReserveReadback(int size);
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+		Container::Array<VBOInfo>		m_VBOs;
+		Container::Array<TextureInfo>	m_textures;
+		Container::Array<ShaderInfo>	m_shaders;
+		Container::Array<FBOInfo>		m_FBOs;
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+		Container::Array<BufferInfo>	m_UBOs;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		Container::Array<BufferInfo>	m_SSBOs;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		// Returned by MapTextureUpload; a single buffer is enough, since
+		// the data is dropped right away.
+		char*					m_uploadBuffer;
+		int						m_uploadBufferCapacity;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_ASYNC_READBACK
+		// Same ring as OpenGLLayer's. The data is copied when requested,
+		// and can be retrieved after the next EndFrame, which is about
+		// the earliest a GPU would be done with it.
+		struct Readback
+		{
+			char*			data;
+			int				capacity;
+			int				size;
+			int				request; // -1 if free.
+			bool			ready;
+		};
+		Readback				m_readbacks[GFX_READBACK_BUFFERS];
+		int						m_nextReadback;
+		int						m_numberOfReadbackRequests;
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+		// What a driver would be bound to, to count the state changes.
+		ShaderID				m_currentShader;
+		VertexBufferID			m_currentVBO;
+		FrameBufferID			m_currentFrameBuffer;
+		Viewport				m_currentViewport;
+		PolygonMode::Enum		m_currentPolygonMode;
+		RasterTests				m_currentRasterTests;
+		BlendingMode			m_currentBlendingMode;
+#if GFX_ENABLE_RENDER_PASSES
+		FrameBufferID			m_renderPassFrameBuffer;
+		bool					m_inRenderPass;
+#endif // GFX_ENABLE_RENDER_PASSES
+
+#if GFX_ENABLE_FRAME_STATS
+		FrameStats				m_frameStats; // Of the frame in progress.
+		FrameStats				m_lastFrameStats;
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+		GpuProfiler				m_gpuProfiler;
+		int						m_numberOfOpenGpuScopes;
+#endif // GFX_ENABLE_GPU_PROFILING
+	};
+}
+
+#endif // GFX_MULTI_API
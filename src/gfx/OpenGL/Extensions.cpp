@@ -35,7 +35,7 @@ static const char* functionNames = {
 	"glBindBuffer\x0"					// GL_ARB_vertex_buffer_object
 	"glBindBufferBase\x0"
 	"glBufferData\x0"					// GL_ARB_vertex_buffer_object
-	UNUSED_GL_EXTENSION // "glBufferSubData\x0"	// GL_ARB_vertex_buffer_object
+	"glBufferSubData\x0"				// GL_ARB_vertex_buffer_object
 	"glDeleteBuffers\x0"				// GL_ARB_vertex_buffer_object
 	"glGenBuffers\x0"					// GL_ARB_vertex_buffer_object
 	"glDrawArraysInstanced\x0"			// GL_ARB_instanced_arrays
@@ -55,7 +55,11 @@ static const char* functionNames = {
 	UNUSED_GL_EXTENSION // "glClientActiveTexture\x0"	// GL_ARB_multitexture
 	"glGenerateMipmap\x0"
 	UNUSED_GL_EXTENSION // "glMultiTexCoord4fv\x0"		// GL_ARB_multitexture
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	"glTexImage3D\x0"					// GL_EXT_texture3D
+#else // !GFX_ENABLE_TEXTURE_ARRAYS
 	UNUSED_GL_EXTENSION // "glTexImage3D\x0"
+#endif // !GFX_ENABLE_TEXTURE_ARRAYS
 
 	// Shaders
 	"glAttachShader\x0"
@@ -116,15 +120,18 @@ static const char* functionNames = {
 	"glGetProgramResourceIndex\x0"
 	"glShaderStorageBlockBinding\x0"
 	"glMemoryBarrier\x0"
-	"glMapBufferRange\x0"
-	"glUnmapBuffer\x0"
 #else // !GFX_ENABLE_STORAGE_BUFFER_OBJECT
 	UNUSED_GL_EXTENSION
 	UNUSED_GL_EXTENSION
 	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT || GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK
+	"glMapBufferRange\x0"
+	"glUnmapBuffer\x0"
+#else // !(GFX_ENABLE_STORAGE_BUFFER_OBJECT || GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK)
 	UNUSED_GL_EXTENSION
 	UNUSED_GL_EXTENSION
-#endif // !GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#endif // !(GFX_ENABLE_STORAGE_BUFFER_OBJECT || GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK)
 
 	// Other
 	UNUSED_GL_EXTENSION // "glLoadTransposeMatrixf\x0"
@@ -138,15 +145,261 @@ static const char* functionNames = {
 	UNUSED_GL_EXTENSION
 #endif // !GFX_ENABLE_STENCIL_TESTING
 
+	// Vertex array objects
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	"glBindVertexArray\x0"				// GL_ARB_vertex_array_object
+	"glDeleteVertexArrays\x0"			// GL_ARB_vertex_array_object
+	"glGenVertexArrays\x0"				// GL_ARB_vertex_array_object
+#else // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
+
+	// Indirect drawing
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+	"glMultiDrawElementsIndirect\x0"	// GL_ARB_multi_draw_indirect
+#else // !GFX_ENABLE_MULTI_DRAW_INDIRECT
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+	// Shared buffers
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK
+	"glCopyBufferSubData\x0"			// GL_ARB_copy_buffer
+#else // !(GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK)
+	UNUSED_GL_EXTENSION
+#endif // !(GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK)
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	"glDrawElementsInstancedBaseVertex\x0"	// GL_ARB_draw_elements_base_vertex
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+	// Uniform buffer ring
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	"glBindBufferRange\x0"				// GL_ARB_uniform_buffer_object
+	"glGetActiveUniformBlockiv\x0"		// GL_ARB_uniform_buffer_object
+	"glGetActiveUniformName\x0"			// GL_ARB_uniform_buffer_object
+	"glGetActiveUniformsiv\x0"			// GL_ARB_uniform_buffer_object
+#else // !GFX_ENABLE_UNIFORM_BUFFER_RING
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_UNIFORM_BUFFER_RING
+
+	// Direct state access, optional: see InitializeOpenGLExtensions.
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	"glCheckNamedFramebufferStatus\x0"	// GL_ARB_direct_state_access
+	"glCopyNamedBufferSubData\x0"		// GL_ARB_direct_state_access
+	"glCreateBuffers\x0"				// GL_ARB_direct_state_access
+	"glCreateFramebuffers\x0"			// GL_ARB_direct_state_access
+	"glCreateTextures\x0"				// GL_ARB_direct_state_access
+	"glGenerateTextureMipmap\x0"		// GL_ARB_direct_state_access
+	"glMapNamedBufferRange\x0"			// GL_ARB_direct_state_access
+	"glNamedBufferData\x0"				// GL_ARB_direct_state_access
+	"glNamedBufferSubData\x0"			// GL_ARB_direct_state_access
+	"glNamedFramebufferDrawBuffers\x0"	// GL_ARB_direct_state_access
+	"glNamedFramebufferTexture\x0"		// GL_ARB_direct_state_access
+	"glNamedFramebufferTextureLayer\x0"	// GL_ARB_direct_state_access
+	"glTextureParameterf\x0"			// GL_ARB_direct_state_access
+	"glTextureParameteri\x0"			// GL_ARB_direct_state_access
+	"glTextureStorage2D\x0"				// GL_ARB_direct_state_access
+	"glTextureSubImage2D\x0"			// GL_ARB_direct_state_access
+	"glUnmapNamedBuffer\x0"				// GL_ARB_direct_state_access
+#else // !GFX_ENABLE_DIRECT_STATE_ACCESS
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_DIRECT_STATE_ACCESS
+
+	// Synchronization
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK
+	"glClientWaitSync\x0"				// GL_ARB_sync
+	"glDeleteSync\x0"					// GL_ARB_sync
+	"glFenceSync\x0"					// GL_ARB_sync
+#else // !(GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK)
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !(GFX_ENABLE_ASYNC_TEXTURE_UPLOAD || GFX_ENABLE_ASYNC_READBACK)
+
+	// Parallel shader compilation, optional: see InitializeOpenGLExtensions.
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	"glMaxShaderCompilerThreadsKHR\x0"	// GL_KHR_parallel_shader_compile
+#else // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+	// Program binaries, optional: see InitializeOpenGLExtensions.
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	"glGetProgramBinary\x0"				// GL_ARB_get_program_binary
+	"glProgramBinary\x0"				// GL_ARB_get_program_binary
+	"glProgramParameteri\x0"			// GL_ARB_get_program_binary
+#else // !GFX_ENABLE_PROGRAM_BINARY_CACHE
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+	// Compressed textures
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+	"glCompressedTexImage2D\x0"			// GL_ARB_texture_compression
+#else // !GFX_ENABLE_COMPRESSED_TEXTURES
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_COMPRESSED_TEXTURES
+
+	// Texture arrays
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	"glTexSubImage3D\x0"					// GL_EXT_texture3D
+#else // !GFX_ENABLE_TEXTURE_ARRAYS
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_TEXTURE_ARRAYS
+
+	// Texture storage
+#if GFX_ENABLE_TEXTURE_STORAGE
+	"glTexStorage2D\x0"					// GL_ARB_texture_storage
+	"glTexStorage3D\x0"					// GL_ARB_texture_storage
+#else // !GFX_ENABLE_TEXTURE_STORAGE
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_TEXTURE_STORAGE
+
+	// Timer queries, optional: see InitializeOpenGLExtensions.
+#if GFX_ENABLE_GPU_PROFILING
+	"glDeleteQueries\x0"				// GL_ARB_occlusion_query
+	"glGenQueries\x0"					// GL_ARB_occlusion_query
+	"glGetInteger64v\x0"				// GL_ARB_sync
+	"glGetQueryObjectiv\x0"				// GL_ARB_occlusion_query
+	"glGetQueryObjectui64v\x0"			// GL_ARB_timer_query
+	"glQueryCounter\x0"					// GL_ARB_timer_query
+#else // !GFX_ENABLE_GPU_PROFILING
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_GPU_PROFILING
+
+	// Indirect compute
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	"glDispatchComputeIndirect\x0"		// GL_ARB_compute_shader
+#else // !(GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+	UNUSED_GL_EXTENSION
+#endif // !(GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT)
+
+	// Indirect drawing from a storage buffer
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	"glDrawElementsIndirect\x0"		// GL_ARB_draw_indirect
+#else // !GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+	// Render passes; invalidation is optional: see InitializeOpenGLExtensions.
+#if GFX_ENABLE_RENDER_PASSES
+	"glClearBufferfi\x0"				// OpenGL 3.0
+	"glClearBufferfv\x0"				// OpenGL 3.0
+	"glClearBufferiv\x0"				// OpenGL 3.0
+	"glInvalidateFramebuffer\x0"		// GL_ARB_invalidate_subdata
+#else // !GFX_ENABLE_RENDER_PASSES
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+	UNUSED_GL_EXTENSION
+#endif // !GFX_ENABLE_RENDER_PASSES
+
 #if DEBUG
 	"glDebugMessageCallback\x0"
 #endif // DEBUG
 };
 
+// Ranges of the functions of optional extensions. When they are
+// missing, the layer falls back to something else: binding objects to
+// edit them, compiling shaders one after the other, or at every
+// launch, allocating mutable textures, not measuring GPU scopes, or
+// keeping attachments a render pass discards...
+#define FIRST_DIRECT_STATE_ACCESS_FUNCTION 80
+#define NUM_DIRECT_STATE_ACCESS_FUNCTIONS 17
+#define FIRST_INVALIDATE_SUBDATA_FUNCTION 119
+#define NUM_INVALIDATE_SUBDATA_FUNCTIONS 1
+#define FIRST_PARALLEL_SHADER_COMPILE_FUNCTION 100
+#define NUM_PARALLEL_SHADER_COMPILE_FUNCTIONS 1
+#define FIRST_PROGRAM_BINARY_FUNCTION 101
+#define NUM_PROGRAM_BINARY_FUNCTIONS 3
+#define FIRST_TEXTURE_STORAGE_FUNCTION 106
+#define NUM_TEXTURE_STORAGE_FUNCTIONS 2
+#define FIRST_TIMER_QUERY_FUNCTION 108
+#define NUM_TIMER_QUERY_FUNCTIONS 6
+
 void* Gfx::opengl_functions[NUM_FUNCTIONS];
+Gfx::OpenGLCapabilities Gfx::opengl_capabilities;
 
 //--- c o d e ---------------------------------------------------------------
 
+static bool isExtensionSupported(PFNGLGETSTRINGIPROC glGetStringi,
+								 int numberOfExtensions,
+								 const char* extensionName)
+{
+	for (int i = 0; i < numberOfExtensions; ++i)
+	{
+		if (strcmp(extensionName, (const char*)glGetStringi(GL_EXTENSIONS, i)) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool isOptionalFunction(int index)
+{
+	return ((index >= FIRST_DIRECT_STATE_ACCESS_FUNCTION &&
+			 index < FIRST_DIRECT_STATE_ACCESS_FUNCTION + NUM_DIRECT_STATE_ACCESS_FUNCTIONS) ||
+			(index >= FIRST_INVALIDATE_SUBDATA_FUNCTION &&
+			 index < FIRST_INVALIDATE_SUBDATA_FUNCTION + NUM_INVALIDATE_SUBDATA_FUNCTIONS) ||
+			(index >= FIRST_PARALLEL_SHADER_COMPILE_FUNCTION &&
+			 index < FIRST_PARALLEL_SHADER_COMPILE_FUNCTION + NUM_PARALLEL_SHADER_COMPILE_FUNCTIONS) ||
+			(index >= FIRST_PROGRAM_BINARY_FUNCTION &&
+			 index < FIRST_PROGRAM_BINARY_FUNCTION + NUM_PROGRAM_BINARY_FUNCTIONS) ||
+			(index >= FIRST_TEXTURE_STORAGE_FUNCTION &&
+			 index < FIRST_TEXTURE_STORAGE_FUNCTION + NUM_TEXTURE_STORAGE_FUNCTIONS) ||
+			(index >= FIRST_TIMER_QUERY_FUNCTION &&
+			 index < FIRST_TIMER_QUERY_FUNCTION + NUM_TIMER_QUERY_FUNCTIONS));
+}
+
+#if GFX_ENABLE_DIRECT_STATE_ACCESS || \
+	GFX_ENABLE_RENDER_PASSES || \
+	GFX_ENABLE_ASYNC_SHADER_COMPILATION || \
+	GFX_ENABLE_PROGRAM_BINARY_CACHE || \
+	GFX_ENABLE_TEXTURE_STORAGE || \
+	GFX_ENABLE_GPU_PROFILING
+static bool areFunctionsBound(int first, int count)
+{
+	for (int i = first; i < first + count; ++i)
+	{
+		if (Gfx::opengl_functions[i] == nullptr)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS || ...
+
 bool Gfx::InitializeOpenGLExtensions()
 {
 	bool success = true;
@@ -168,17 +421,11 @@ bool Gfx::InitializeOpenGLExtensions()
 
 	for (const char* extensionName = extensionNames; *extensionName != '\0'; extensionName += 1 + strlen(extensionName))
 	{
-		bool found = false;
-		for (int i = 0; i < numberOfExtensions; ++i)
+		if (isExtensionSupported(glGetStringi, numberOfExtensions, extensionName))
 		{
-			if (strcmp(extensionName, (const char*)glGetStringi(GL_EXTENSIONS, i)) == 0)
-			{
-				LOG_INFO("Found extension %s.", extensionName);
-				found = true;
-				break;
-			}
+			LOG_INFO("Found extension %s.", extensionName);
 		}
-		if (!found)
+		else
 		{
 			LOG_ERROR("Extension %s is not available.", extensionName);
 			success = false;
@@ -204,12 +451,72 @@ bool Gfx::InitializeOpenGLExtensions()
 
 		if (!opengl_functions[i])
 		{
-			LOG_ERROR("Binding of OpenGL function %s failed.", functionName);
-			success = false;
+			if (isOptionalFunction(i))
+			{
+				LOG_INFO("OpenGL function %s is not available.", functionName);
+			}
+			else
+			{
+				LOG_ERROR("Binding of OpenGL function %s failed.", functionName);
+				success = false;
+			}
 		}
 
 		functionName += 1 + strlen(functionName);
 	}
 
+	opengl_capabilities.directStateAccess = false;
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	opengl_capabilities.directStateAccess =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_ARB_direct_state_access") &&
+		areFunctionsBound(FIRST_DIRECT_STATE_ACCESS_FUNCTION, NUM_DIRECT_STATE_ACCESS_FUNCTIONS);
+	LOG_INFO("Direct state access: %s.", (opengl_capabilities.directStateAccess ? "yes" : "no"));
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+
+	opengl_capabilities.invalidateSubdata = false;
+#if GFX_ENABLE_RENDER_PASSES
+	opengl_capabilities.invalidateSubdata =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_ARB_invalidate_subdata") &&
+		areFunctionsBound(FIRST_INVALIDATE_SUBDATA_FUNCTION, NUM_INVALIDATE_SUBDATA_FUNCTIONS);
+	LOG_INFO("Frame buffer invalidation: %s.", (opengl_capabilities.invalidateSubdata ? "yes" : "no"));
+#endif // GFX_ENABLE_RENDER_PASSES
+
+	opengl_capabilities.parallelShaderCompile = false;
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	opengl_capabilities.parallelShaderCompile =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_KHR_parallel_shader_compile") &&
+		areFunctionsBound(FIRST_PARALLEL_SHADER_COMPILE_FUNCTION, NUM_PARALLEL_SHADER_COMPILE_FUNCTIONS);
+	LOG_INFO("Parallel shader compilation: %s.", (opengl_capabilities.parallelShaderCompile ? "yes" : "no"));
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+	opengl_capabilities.programBinary = false;
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	// The extension can be there with no binary format at all, in which
+	// case glGetProgramBinary has nothing to give.
+	int numberOfBinaryFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfBinaryFormats);
+	opengl_capabilities.programBinary =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_ARB_get_program_binary") &&
+		areFunctionsBound(FIRST_PROGRAM_BINARY_FUNCTION, NUM_PROGRAM_BINARY_FUNCTIONS) &&
+		numberOfBinaryFormats > 0;
+	LOG_INFO("Program binaries: %s.", (opengl_capabilities.programBinary ? "yes" : "no"));
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+	opengl_capabilities.textureStorage = false;
+#if GFX_ENABLE_TEXTURE_STORAGE
+	opengl_capabilities.textureStorage =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_ARB_texture_storage") &&
+		areFunctionsBound(FIRST_TEXTURE_STORAGE_FUNCTION, NUM_TEXTURE_STORAGE_FUNCTIONS);
+	LOG_INFO("Immutable texture storage: %s.", (opengl_capabilities.textureStorage ? "yes" : "no"));
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+	opengl_capabilities.timerQuery = false;
+#if GFX_ENABLE_GPU_PROFILING
+	opengl_capabilities.timerQuery =
+		isExtensionSupported(glGetStringi, numberOfExtensions, "GL_ARB_timer_query") &&
+		areFunctionsBound(FIRST_TIMER_QUERY_FUNCTION, NUM_TIMER_QUERY_FUNCTIONS);
+	LOG_INFO("Timer queries: %s.", (opengl_capabilities.timerQuery ? "yes" : "no"));
+#endif // GFX_ENABLE_GPU_PROFILING
+
 	return success;
 }
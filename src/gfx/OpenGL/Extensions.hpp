@@ -15,6 +15,36 @@
 #undef None
 #undef Always
 #endif // _WIN32
+#include <GL/gl.h>
+#include "gfx/OpenGL/glext.h"
+
+#ifndef GL_VERSION_4_5
+// The bundled glext.h predates OpenGL 4.5, which brought direct state
+// access into core.
+typedef GLenum (APIENTRYP PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC) (GLuint framebuffer, GLenum target);
+typedef void (APIENTRYP PFNGLCOPYNAMEDBUFFERSUBDATAPROC) (GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+typedef void (APIENTRYP PFNGLCREATEBUFFERSPROC) (GLsizei n, GLuint *buffers);
+typedef void (APIENTRYP PFNGLCREATEFRAMEBUFFERSPROC) (GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLCREATETEXTURESPROC) (GLenum target, GLsizei n, GLuint *textures);
+typedef void (APIENTRYP PFNGLGENERATETEXTUREMIPMAPPROC) (GLuint texture);
+typedef void *(APIENTRYP PFNGLMAPNAMEDBUFFERRANGEPROC) (GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERDATAPROC) (GLuint buffer, GLsizeiptr size, const void *data, GLenum usage);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC) (GLuint buffer, GLintptr offset, GLsizeiptr size, const void *data);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC) (GLuint framebuffer, GLsizei n, const GLenum *bufs);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERTEXTUREPROC) (GLuint framebuffer, GLenum attachment, GLuint texture, GLint level);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERTEXTURELAYERPROC) (GLuint framebuffer, GLenum attachment, GLuint texture, GLint level, GLint layer);
+typedef void (APIENTRYP PFNGLTEXTUREPARAMETERFPROC) (GLuint texture, GLenum pname, GLfloat param);
+typedef void (APIENTRYP PFNGLTEXTUREPARAMETERIPROC) (GLuint texture, GLenum pname, GLint param);
+typedef void (APIENTRYP PFNGLTEXTURESTORAGE2DPROC) (GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXTURESUBIMAGE2DPROC) (GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels);
+typedef GLboolean (APIENTRYP PFNGLUNMAPNAMEDBUFFERPROC) (GLuint buffer);
+#endif // !GL_VERSION_4_5
+
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count);
+#endif // !GL_KHR_parallel_shader_compile
 
 #if DEBUG
 #define NUM_DEBUG_FUNCTIONS 1
@@ -22,12 +52,27 @@
 #define NUM_DEBUG_FUNCTIONS 0
 #endif // !DEBUG
 
-#define NUM_FUNCTIONS (8+7+5+16+12+12+5+5+NUM_DEBUG_FUNCTIONS)
+#define NUM_FUNCTIONS (8+7+5+16+12+12+5+5+3+1+2+4+17+3+1+3+1+1+2+6+1+1+4+NUM_DEBUG_FUNCTIONS)
 
 namespace Gfx
 {
 	extern void*	opengl_functions[NUM_FUNCTIONS];
 
+	/// <summary>
+	/// Optional features, which the layer uses when the driver
+	/// supports them. They are found by InitializeOpenGLExtensions.
+	/// </summary>
+	struct OpenGLCapabilities
+	{
+		bool		directStateAccess;
+		bool		invalidateSubdata;
+		bool		parallelShaderCompile;
+		bool		programBinary;
+		bool		textureStorage;
+		bool		timerQuery;
+	};
+	extern OpenGLCapabilities opengl_capabilities;
+
 	/// <summary>
 	/// Loads the OpenGL extension functions.
 	/// </summary>
@@ -123,6 +168,86 @@ namespace Gfx
 #define glStencilFuncSeparate         ((PFNGLSTENCILFUNCSEPARATEPROC)     ::Gfx::opengl_functions[68])
 #define glStencilOpSeparate           ((PFNGLSTENCILOPSEPARATEPROC)       ::Gfx::opengl_functions[69])
 
+// Vertex array objects (3)
+#define glBindVertexArray             ((PFNGLBINDVERTEXARRAYPROC)         ::Gfx::opengl_functions[70])
+#define glDeleteVertexArrays          ((PFNGLDELETEVERTEXARRAYSPROC)      ::Gfx::opengl_functions[71])
+#define glGenVertexArrays             ((PFNGLGENVERTEXARRAYSPROC)         ::Gfx::opengl_functions[72])
+
+// Indirect drawing (1)
+#define glMultiDrawElementsIndirect   ((PFNGLMULTIDRAWELEMENTSINDIRECTPROC) ::Gfx::opengl_functions[73])
+
+// Shared buffers (2)
+#define glCopyBufferSubData           ((PFNGLCOPYBUFFERSUBDATAPROC)       ::Gfx::opengl_functions[74])
+#define glDrawElementsInstancedBaseVertex ((PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC) ::Gfx::opengl_functions[75])
+
+// Uniform buffer ring (4)
+#define glBindBufferRange             ((PFNGLBINDBUFFERRANGEPROC)         ::Gfx::opengl_functions[76])
+#define glGetActiveUniformBlockiv     ((PFNGLGETACTIVEUNIFORMBLOCKIVPROC) ::Gfx::opengl_functions[77])
+#define glGetActiveUniformName        ((PFNGLGETACTIVEUNIFORMNAMEPROC)    ::Gfx::opengl_functions[78])
+#define glGetActiveUniformsiv         ((PFNGLGETACTIVEUNIFORMSIVPROC)     ::Gfx::opengl_functions[79])
+
+// Direct state access (17), optional
+#define glCheckNamedFramebufferStatus ((PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC) ::Gfx::opengl_functions[80])
+#define glCopyNamedBufferSubData      ((PFNGLCOPYNAMEDBUFFERSUBDATAPROC)  ::Gfx::opengl_functions[81])
+#define glCreateBuffers               ((PFNGLCREATEBUFFERSPROC)           ::Gfx::opengl_functions[82])
+#define glCreateFramebuffers          ((PFNGLCREATEFRAMEBUFFERSPROC)      ::Gfx::opengl_functions[83])
+#define glCreateTextures              ((PFNGLCREATETEXTURESPROC)          ::Gfx::opengl_functions[84])
+#define glGenerateTextureMipmap       ((PFNGLGENERATETEXTUREMIPMAPPROC)   ::Gfx::opengl_functions[85])
+#define glMapNamedBufferRange         ((PFNGLMAPNAMEDBUFFERRANGEPROC)     ::Gfx::opengl_functions[86])
+#define glNamedBufferData             ((PFNGLNAMEDBUFFERDATAPROC)         ::Gfx::opengl_functions[87])
+#define glNamedBufferSubData          ((PFNGLNAMEDBUFFERSUBDATAPROC)      ::Gfx::opengl_functions[88])
+#define glNamedFramebufferDrawBuffers ((PFNGLNAMEDFRAMEBUFFERDRAWBUFFERSPROC) ::Gfx::opengl_functions[89])
+#define glNamedFramebufferTexture     ((PFNGLNAMEDFRAMEBUFFERTEXTUREPROC) ::Gfx::opengl_functions[90])
+#define glNamedFramebufferTextureLayer ((PFNGLNAMEDFRAMEBUFFERTEXTURELAYERPROC) ::Gfx::opengl_functions[91])
+#define glTextureParameterf           ((PFNGLTEXTUREPARAMETERFPROC)       ::Gfx::opengl_functions[92])
+#define glTextureParameteri           ((PFNGLTEXTUREPARAMETERIPROC)       ::Gfx::opengl_functions[93])
+#define glTextureStorage2D            ((PFNGLTEXTURESTORAGE2DPROC)        ::Gfx::opengl_functions[94])
+#define glTextureSubImage2D           ((PFNGLTEXTURESUBIMAGE2DPROC)       ::Gfx::opengl_functions[95])
+#define glUnmapNamedBuffer            ((PFNGLUNMAPNAMEDBUFFERPROC)        ::Gfx::opengl_functions[96])
+
+// Synchronization (3)
+#define glClientWaitSync              ((PFNGLCLIENTWAITSYNCPROC)          ::Gfx::opengl_functions[97])
+#define glDeleteSync                  ((PFNGLDELETESYNCPROC)              ::Gfx::opengl_functions[98])
+#define glFenceSync                   ((PFNGLFENCESYNCPROC)               ::Gfx::opengl_functions[99])
+
+// Parallel shader compilation (1), optional
+#define glMaxShaderCompilerThreadsKHR ((PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) ::Gfx::opengl_functions[100])
+
+// Program binaries (3), optional
+#define glGetProgramBinary            ((PFNGLGETPROGRAMBINARYPROC)        ::Gfx::opengl_functions[101])
+#define glProgramBinary               ((PFNGLPROGRAMBINARYPROC)           ::Gfx::opengl_functions[102])
+#define glProgramParameteri           ((PFNGLPROGRAMPARAMETERIPROC)       ::Gfx::opengl_functions[103])
+
+// Compressed textures (1)
+#define glCompressedTexImage2D        ((PFNGLCOMPRESSEDTEXIMAGE2DPROC)    ::Gfx::opengl_functions[104])
+
+// Texture arrays (1)
+#define glTexSubImage3D               ((PFNGLTEXSUBIMAGE3DPROC)           ::Gfx::opengl_functions[105])
+
+// Texture storage (2), optional
+#define glTexStorage2D                ((PFNGLTEXSTORAGE2DPROC)            ::Gfx::opengl_functions[106])
+#define glTexStorage3D                ((PFNGLTEXSTORAGE3DPROC)            ::Gfx::opengl_functions[107])
+
+// Timer queries (6), optional
+#define glDeleteQueries               ((PFNGLDELETEQUERIESPROC)           ::Gfx::opengl_functions[108])
+#define glGenQueries                  ((PFNGLGENQUERIESPROC)              ::Gfx::opengl_functions[109])
+#define glGetInteger64v               ((PFNGLGETINTEGER64VPROC)           ::Gfx::opengl_functions[110])
+#define glGetQueryObjectiv            ((PFNGLGETQUERYOBJECTIVPROC)        ::Gfx::opengl_functions[111])
+#define glGetQueryObjectui64v         ((PFNGLGETQUERYOBJECTUI64VPROC)     ::Gfx::opengl_functions[112])
+#define glQueryCounter                ((PFNGLQUERYCOUNTERPROC)            ::Gfx::opengl_functions[113])
+
+// Indirect compute (1)
+#define glDispatchComputeIndirect     ((PFNGLDISPATCHCOMPUTEINDIRECTPROC) ::Gfx::opengl_functions[114])
+
+// Indirect drawing from a storage buffer (1)
+#define glDrawElementsIndirect        ((PFNGLDRAWELEMENTSINDIRECTPROC)    ::Gfx::opengl_functions[115])
+
+// Render passes (4)
+#define glClearBufferfi               ((PFNGLCLEARBUFFERFIPROC)           ::Gfx::opengl_functions[116])
+#define glClearBufferfv               ((PFNGLCLEARBUFFERFVPROC)           ::Gfx::opengl_functions[117])
+#define glClearBufferiv               ((PFNGLCLEARBUFFERIVPROC)           ::Gfx::opengl_functions[118])
+#define glInvalidateFramebuffer       ((PFNGLINVALIDATEFRAMEBUFFERPROC)   ::Gfx::opengl_functions[119])
+
 #if DEBUG
-#define glDebugMessageCallback        ((PFNGLDEBUGMESSAGECALLBACKPROC)    ::Gfx::opengl_functions[70])
+#define glDebugMessageCallback        ((PFNGLDEBUGMESSAGECALLBACKPROC)    ::Gfx::opengl_functions[120])
 #endif // DEBUG
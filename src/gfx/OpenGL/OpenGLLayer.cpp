@@ -2,6 +2,9 @@
 
 #include "Extensions.hpp"
 #include "OpenGLTypeConversion.hpp"
+#include "gfx/Barrier.hpp"
+#include "gfx/DrawBatch.hpp"
+#include "gfx/DrawItem.hpp"
 #include "engine/debug/Assert.hpp"
 #include "engine/debug/Debug.hpp" // FIXME: ideally Gfx should not have dependency over Engine.
 #include "gfx/Geometry.hpp"
@@ -14,11 +17,27 @@
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 #include "engine/container/HashTable.hxx"
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+#include "ProgramBinaryCache.hpp"
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE || GFX_ENABLE_GPU_PROFILING
+#include <chrono>
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE || GFX_ENABLE_GPU_PROFILING
 
 #if GFX_MULTI_API || GFX_OPENGL_ONLY
 
 #define MAX_MRT 4
 
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+#define UNIFORM_RING_BLOCK_NAME "DrawUniforms"
+
+// The ring uses the binding point after the ones of the uniform buffers.
+#define UNIFORM_RING_BINDING GFX_MAX_UNIFORM_BUFFER_SLOTS
+
+// Each uniform is at most a 4x4 matrix.
+#define MAX_UNIFORM_BLOCK_SIZE (GFX_MAX_UNIFORMS * 16 * sizeof(float))
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
 // Defines whether after a shader compilation, we should try to get the
 // log from the shader compiler.
 #ifndef ENABLE_SHADER_COMPILATION_ERROR_CHECK
@@ -35,11 +54,25 @@
 #define ENABLE_OPENGL_ERROR_CHECK	1
 #endif // DEBUG
 
+#if GFX_COUNT_DRIVER_CALLS
+static int numberOfDriverCalls = 0;
+#define COUNT_DRIVER_CALL() ++numberOfDriverCalls
+#else // !GFX_COUNT_DRIVER_CALLS
+#define COUNT_DRIVER_CALL()
+#endif // !GFX_COUNT_DRIVER_CALLS
+
+#if GFX_ENABLE_FRAME_STATS
+#define COUNT_FRAME_STAT(stat, n) (m_frameStats.stat += (n))
+#else // !GFX_ENABLE_FRAME_STATS
+#define COUNT_FRAME_STAT(stat, n)
+#endif // !GFX_ENABLE_FRAME_STATS
+
 #if ENABLE_OPENGL_ERROR_CHECK
 
 #define GL_CHECK(exp) 													\
 	do																	\
 	{																	\
+		COUNT_DRIVER_CALL();											\
 		exp;															\
 		GLenum error = glGetError();									\
 		if (error != GL_NO_ERROR)										\
@@ -53,12 +86,64 @@
 
 #else // !ENABLE_OPENGL_ERROR_CHECK
 
+#if GFX_COUNT_DRIVER_CALLS
+#define GL_CHECK(exp) do { COUNT_DRIVER_CALL(); exp; } while (0)
+#else // !GFX_COUNT_DRIVER_CALLS
 #define GL_CHECK(exp) exp
+#endif // !GFX_COUNT_DRIVER_CALLS
 
 #endif // !ENABLE_OPENGL_ERROR_CHECK
 
+// Value of the shadow state when the actual state is not known, so the
+// next binding always goes through.
+#define UNKNOWN_BINDING ((GLuint)-1)
+
 using namespace Gfx;
 
+// Indexed by OpenGLLayer::BufferTarget::Enum.
+static const GLenum bufferTargets[] = {
+	GL_ARRAY_BUFFER,
+	GL_COPY_READ_BUFFER,
+	GL_COPY_WRITE_BUFFER,
+	GL_DISPATCH_INDIRECT_BUFFER,
+	GL_DRAW_INDIRECT_BUFFER,
+	GL_ELEMENT_ARRAY_BUFFER,
+	GL_PIXEL_PACK_BUFFER,
+	GL_PIXEL_UNPACK_BUFFER,
+	GL_SHADER_STORAGE_BUFFER,
+	GL_UNIFORM_BUFFER,
+};
+
+// Indexed by OpenGLLayer::TextureTarget::Enum.
+static const GLenum textureTargets[] = {
+	GL_TEXTURE_2D,
+	GL_TEXTURE_CUBE_MAP,
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	GL_TEXTURE_2D_ARRAY,
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+};
+
+// Indexed by OpenGLLayer::Capability::Enum.
+static const GLenum capabilities[] = {
+	GL_BLEND,
+	GL_CLIP_DISTANCE0,
+	GL_CULL_FACE,
+	GL_DEPTH_TEST,
+	GL_SCISSOR_TEST,
+	GL_STENCIL_TEST,
+	GL_TEXTURE_CUBE_MAP_SEAMLESS,
+};
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE || GFX_ENABLE_GPU_PROFILING
+// To measure what the program binary cache saves, and to put the GPU
+// scopes on the same clock as the CPU ones.
+static long long getMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE || GFX_ENABLE_GPU_PROFILING
+
 #if DEBUG
 void MessageCallback(GLenum /* source */,
 					 GLenum type,
@@ -90,31 +175,125 @@ bool OpenGLLayer::CreateRenderingContext()
 #endif // !DISABLE_TERMINATE_ON_EXTENSION_CHECK_FAILURE
 	}
 
+	// The optional features are known before creating any object, since
+	// the way buffers are created depends on them.
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	m_useDirectStateAccess = opengl_capabilities.directStateAccess;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	// Let the driver pick the number of compiler threads.
+	m_parallelShaderCompile = opengl_capabilities.parallelShaderCompile;
+	if (m_parallelShaderCompile)
+	{
+		GL_CHECK(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+	}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+#if GFX_ENABLE_TEXTURE_STORAGE
+	m_useTextureStorage = opengl_capabilities.textureStorage;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_GPU_PROFILING
+	m_useTimerQueries = opengl_capabilities.timerQuery;
+#endif // GFX_ENABLE_GPU_PROFILING
+#if GFX_ENABLE_RENDER_PASSES
+	m_useInvalidateFramebuffer = opengl_capabilities.invalidateSubdata;
+#endif // GFX_ENABLE_RENDER_PASSES
+
+	// Nothing is known of the bindings made before, so the first ones
+	// always go through.
+	for (int i = 0; i < BufferTarget::Count; ++i)
+	{
+		m_boundBuffers[i] = UNKNOWN_BINDING;
+	}
+	for (int i = 0; i < GFX_MAX_TEXTURE_SLOTS; ++i)
+	{
+		for (int j = 0; j < TextureTarget::Count; ++j)
+		{
+			m_boundTextures[i][j] = UNKNOWN_BINDING;
+		}
+	}
+	m_activeTextureSlot = -1;
+	m_boundProgram = UNKNOWN_BINDING;
+	m_boundFrameBuffer = UNKNOWN_BINDING;
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	m_boundVertexArray = UNKNOWN_BINDING;
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	for (int i = 0; i < Capability::Count; ++i)
+	{
+		GLboolean enabled;
+		GL_CHECK(enabled = glIsEnabled(capabilities[i]));
+		m_enabledCapabilities[i] = (enabled == GL_TRUE);
+	}
+
 	m_FBOs.init(GFX_MAX_FRAME_BUFFERS);
 	m_shaders.init(GFX_MAX_SHADERS);
 #if GFX_ENABLE_STORAGE_BUFFER_OBJECT
 	m_SSBOs.init(GFX_MAX_STORAGE_BUFFERS);
 #endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 	m_textures.init(GFX_MAX_TEXTURES);
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	for (int i = 0; i < GFX_TEXTURE_UPLOAD_BUFFERS; ++i)
+	{
+		TextureUpload& upload = m_textureUploads[i];
+		GenerateBufferObject(&upload.buffer);
+		upload.capacity = 0;
+		upload.texture = TextureID::InvalidID;
+		upload.fence = nullptr;
+		upload.mapped = false;
+	}
+	m_nextTextureUpload = 0;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#if GFX_ENABLE_ASYNC_READBACK
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		Readback& readback = m_readbacks[i];
+		GenerateBufferObject(&readback.buffer);
+		readback.capacity = 0;
+		readback.size = 0;
+		readback.request = -1;
+		readback.fence = nullptr;
+	}
+	m_nextReadback = 0;
+	m_numberOfReadbackRequests = 0;
+#endif // GFX_ENABLE_ASYNC_READBACK
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 	m_UBOs.init(GFX_MAX_UNIFORM_BUFFERS);
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	GenerateBufferObject(&m_uniformRing);
+	GL_CHECK(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformRingAlignment));
+	m_uniformRingGeneration = 0;
+	RecycleUniformRing();
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 	m_VBOs.init(GFX_MAX_VERTEX_BUFFERS);
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+	m_indirectCommands.init(GFX_MAX_DRAW_BATCH_SIZE);
+	GenerateBufferObject(&m_indirectBuffer);
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
 
-	for (int i = 0; i < GFX_MAX_TEXTURE_SLOTS; ++i)
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+	for (int i = 0; i < GFX_MAX_STORAGE_BUFFER_BINDINGS; ++i)
 	{
-		m_currentTextures[i] = TextureID::InvalidID;
+		m_currentSSBOs[i] = StorageBufferID::InvalidID;
 	}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 	for (int i = 0; i < GFX_MAX_UNIFORM_BUFFER_SLOTS; ++i)
 	{
 		m_currentUBOs[i] = UniformBufferID::InvalidID;
 	}
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	// Vertex array object the platform layer may have bound, to use
+	// when no vertex buffer is bound.
+	int defaultVertexArray = 0;
+	GL_CHECK(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &defaultVertexArray));
+	m_defaultVertexArray = defaultVertexArray;
+#else // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
 	for (int i = 0; i < GFX_MAX_VERTEX_ATTRIBUTES; ++i)
 	{
 		m_enabledVertexAttributes[i] = false;
 	}
+#endif // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
 
 	m_currentViewport.x = -1; // Initializing to an invalid value
 	m_currentViewport.y = -1;
@@ -122,10 +301,48 @@ bool OpenGLLayer::CreateRenderingContext()
 	m_currentViewport.height = -1;
 	m_currentPolygonMode = PolygonMode::Filled;
 
-	m_currentFrameBuffer = FrameBufferID::InvalidID;
 	m_currentShader = ShaderID::InvalidID;
 	m_currentVBO = VertexBufferID::InvalidID;
 
+#if GFX_ENABLE_RENDER_PASSES
+	m_inRenderPass = false;
+	m_renderPassFrameBuffer = FrameBufferID::InvalidID;
+#endif // GFX_ENABLE_RENDER_PASSES
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	m_programBinaryCache = nullptr;
+	m_driverHash = 0;
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+#if GFX_ENABLE_FRAME_STATS
+	m_frameStats = FrameStats();
+	m_lastFrameStats = FrameStats();
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+	m_gpuProfiler.Init(m_useTimerQueries);
+	for (int i = 0; i < GFX_GPU_PROFILING_LATENCY + 1; ++i)
+	{
+		GpuFrame& gpuFrame = m_gpuFrames[i];
+		gpuFrame.numberOfScopes = 0;
+		gpuFrame.frame = 0;
+		for (int j = 0; m_useTimerQueries && j < GFX_MAX_GPU_SCOPES; ++j)
+		{
+			GL_CHECK(glGenQueries(2, gpuFrame.scopes[j].queries));
+		}
+	}
+	m_currentGpuFrame = 0;
+	m_frame = 0;
+	m_numberOfOpenGpuScopes = 0;
+
+	// The GL time is the time the GPU has reached, without waiting for
+	// it. Both clocks are steady, so the offset is only measured once.
+	m_gpuClockOffset = 0;
+	if (m_useTimerQueries)
+	{
+		GLint64 gpuTime = 0;
+		GL_CHECK(glGetInteger64v(GL_TIMESTAMP, &gpuTime));
+		m_gpuClockOffset = getMicroseconds() - gpuTime / 1000;
+	}
+#endif // GFX_ENABLE_GPU_PROFILING
+
 #if DEBUG && ENABLE_GLDEBUGMESSAGECALLBACK
 	// This doens't work everywhere, hence the specific gate.
 	GL_CHECK(glEnable(GL_DEBUG_OUTPUT));
@@ -136,6 +353,272 @@ bool OpenGLLayer::CreateRenderingContext()
 	return true;
 }
 
+void OpenGLLayer::BindBufferObject(BufferTarget::Enum target, GLuint buffer)
+{
+	if (m_boundBuffers[target] != buffer)
+	{
+		GL_CHECK(glBindBuffer(bufferTargets[target], buffer));
+		m_boundBuffers[target] = buffer;
+	}
+}
+
+void OpenGLLayer::BindTextureObject(int slot, GLenum type, GLuint texture)
+{
+	ASSERT(slot >= 0 && slot < GFX_MAX_TEXTURE_SLOTS);
+	int target = (type == GL_TEXTURE_CUBE_MAP ? TextureTarget::CubeMap : TextureTarget::Texture2D);
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	if (type == GL_TEXTURE_2D_ARRAY)
+	{
+		target = TextureTarget::Texture2DArray;
+	}
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+	ASSERT(textureTargets[target] == type);
+	if (m_boundTextures[slot][target] == texture)
+	{
+		return;
+	}
+
+	if (m_activeTextureSlot != slot)
+	{
+		GL_CHECK(glActiveTexture(GL_TEXTURE0 + slot));
+		m_activeTextureSlot = slot;
+	}
+	GL_CHECK(glBindTexture(type, texture));
+	m_boundTextures[slot][target] = texture;
+	COUNT_FRAME_STAT(textureChanges, 1);
+}
+
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+// indexBuffer is the element array buffer recorded in the vertex array,
+// or UNKNOWN_BINDING.
+void OpenGLLayer::BindVertexArrayObject(GLuint vertexArray, GLuint indexBuffer)
+{
+	if (m_boundVertexArray != vertexArray)
+	{
+		GL_CHECK(glBindVertexArray(vertexArray));
+		m_boundVertexArray = vertexArray;
+		m_boundBuffers[BufferTarget::ElementArray] = indexBuffer;
+	}
+}
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+
+void OpenGLLayer::SetCapability(Capability::Enum capability, bool enabled)
+{
+	if (m_enabledCapabilities[capability] == enabled)
+	{
+		return;
+	}
+
+	if (enabled)
+	{
+		GL_CHECK(glEnable(capabilities[capability]));
+	}
+	else
+	{
+		GL_CHECK(glDisable(capabilities[capability]));
+	}
+	m_enabledCapabilities[capability] = enabled;
+}
+
+void OpenGLLayer::GenerateBufferObject(GLuint* buffer)
+{
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	// A name from glGenBuffers only becomes a buffer object once bound,
+	// which direct state access never does.
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(glCreateBuffers(1, buffer));
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	GL_CHECK(glGenBuffers(1, buffer));
+}
+
+void OpenGLLayer::LoadBufferObject(BufferTarget::Enum target, GLuint buffer,
+								   GLsizeiptr size, const void* data, GLenum usage)
+{
+	COUNT_FRAME_STAT(bytesUploaded, (data != nullptr ? size : 0));
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(glNamedBufferData(buffer, size, data, usage));
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	BindBufferObject(target, buffer);
+	GL_CHECK(glBufferData(bufferTargets[target], size, data, usage));
+}
+
+void OpenGLLayer::UpdateBufferObject(BufferTarget::Enum target, GLuint buffer,
+									 GLintptr offset, GLsizeiptr size, const void* data)
+{
+	COUNT_FRAME_STAT(bytesUploaded, size);
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(glNamedBufferSubData(buffer, offset, size, data));
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	BindBufferObject(target, buffer);
+	GL_CHECK(glBufferSubData(bufferTargets[target], offset, size, data));
+}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK
+void OpenGLLayer::CopyBufferObject(GLuint source, GLintptr sourceOffset,
+								   GLuint destination, GLintptr destinationOffset,
+								   GLsizeiptr size)
+{
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(glCopyNamedBufferSubData(source, destination, sourceOffset, destinationOffset, size));
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	BindBufferObject(BufferTarget::CopyRead, source);
+	BindBufferObject(BufferTarget::CopyWrite, destination);
+	GL_CHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size));
+}
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK
+
+void OpenGLLayer::OnBufferObjectDeleted(GLuint buffer)
+{
+	for (int i = 0; i < BufferTarget::Count; ++i)
+	{
+		if (m_boundBuffers[i] == buffer)
+		{
+			m_boundBuffers[i] = 0;
+		}
+	}
+}
+
+void OpenGLLayer::OnTextureObjectDeleted(GLuint texture)
+{
+	for (int i = 0; i < GFX_MAX_TEXTURE_SLOTS; ++i)
+	{
+		for (int j = 0; j < TextureTarget::Count; ++j)
+		{
+			if (m_boundTextures[i][j] == texture)
+			{
+				m_boundTextures[i][j] = 0;
+			}
+		}
+	}
+}
+
+#if DEBUG
+// Checks the shadow state against the actual OpenGL state, to catch
+// state changed behind the back of the layer, or not recorded.
+void OpenGLLayer::ValidateStateShadow()
+{
+	static const GLenum bufferBindings[] = {
+		GL_ARRAY_BUFFER_BINDING,
+		GL_COPY_READ_BUFFER_BINDING,
+		GL_COPY_WRITE_BUFFER_BINDING,
+		GL_DISPATCH_INDIRECT_BUFFER_BINDING,
+		GL_DRAW_INDIRECT_BUFFER_BINDING,
+		GL_ELEMENT_ARRAY_BUFFER_BINDING,
+		GL_PIXEL_PACK_BUFFER_BINDING,
+		GL_PIXEL_UNPACK_BUFFER_BINDING,
+		GL_SHADER_STORAGE_BUFFER_BINDING,
+		GL_UNIFORM_BUFFER_BINDING,
+	};
+	static const GLenum textureBindings[] = {
+		GL_TEXTURE_BINDING_2D,
+		GL_TEXTURE_BINDING_CUBE_MAP,
+#if GFX_ENABLE_TEXTURE_ARRAYS
+		GL_TEXTURE_BINDING_2D_ARRAY,
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+	};
+
+	bool valid = true;
+	GLint value = 0;
+	for (int i = 0; i < BufferTarget::Count; ++i)
+	{
+		if (m_boundBuffers[i] != UNKNOWN_BINDING)
+		{
+			GL_CHECK(glGetIntegerv(bufferBindings[i], &value));
+			if ((GLuint)value != m_boundBuffers[i])
+			{
+				LOG_ERROR("Buffer %d is bound to 0x%x, but the shadow state says %u.", value, bufferTargets[i], m_boundBuffers[i]);
+				valid = false;
+			}
+		}
+	}
+
+	for (int i = 0; i < GFX_MAX_TEXTURE_SLOTS; ++i)
+	{
+		GL_CHECK(glActiveTexture(GL_TEXTURE0 + i));
+		for (int j = 0; j < TextureTarget::Count; ++j)
+		{
+			if (m_boundTextures[i][j] != UNKNOWN_BINDING)
+			{
+				GL_CHECK(glGetIntegerv(textureBindings[j], &value));
+				if ((GLuint)value != m_boundTextures[i][j])
+				{
+					LOG_ERROR("Texture %d is bound to 0x%x on slot %d, but the shadow state says %u.", value, textureTargets[j], i, m_boundTextures[i][j]);
+					valid = false;
+				}
+			}
+		}
+	}
+	if (m_activeTextureSlot >= 0)
+	{
+		GL_CHECK(glActiveTexture(GL_TEXTURE0 + m_activeTextureSlot));
+	}
+	else
+	{
+		m_activeTextureSlot = GFX_MAX_TEXTURE_SLOTS - 1;
+	}
+
+	if (m_boundProgram != UNKNOWN_BINDING)
+	{
+		GL_CHECK(glGetIntegerv(GL_CURRENT_PROGRAM, &value));
+		if ((GLuint)value != m_boundProgram)
+		{
+			LOG_ERROR("Program %d is in use, but the shadow state says %u.", value, m_boundProgram);
+			valid = false;
+		}
+	}
+
+	if (m_boundFrameBuffer != UNKNOWN_BINDING)
+	{
+		GL_CHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &value));
+		if ((GLuint)value != m_boundFrameBuffer)
+		{
+			LOG_ERROR("Frame buffer %d is bound, but the shadow state says %u.", value, m_boundFrameBuffer);
+			valid = false;
+		}
+	}
+
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	if (m_boundVertexArray != UNKNOWN_BINDING)
+	{
+		GL_CHECK(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value));
+		if ((GLuint)value != m_boundVertexArray)
+		{
+			LOG_ERROR("Vertex array %d is bound, but the shadow state says %u.", value, m_boundVertexArray);
+			valid = false;
+		}
+	}
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+
+	for (int i = 0; i < Capability::Count; ++i)
+	{
+		GLboolean enabled;
+		GL_CHECK(enabled = glIsEnabled(capabilities[i]));
+		if ((enabled == GL_TRUE) != m_enabledCapabilities[i])
+		{
+			LOG_ERROR("Capability 0x%x is %s, but the shadow state says otherwise.", capabilities[i], (enabled == GL_TRUE ? "enabled" : "disabled"));
+			valid = false;
+		}
+	}
+
+	ASSERT(valid);
+}
+#endif // DEBUG
+
 void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 									 const PolygonMode::Enum polygonMode,
 									 const RasterTests& rasterTests,
@@ -145,12 +628,14 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 	{
 		GL_CHECK(glViewport(viewport.x, viewport.y, viewport.width, viewport.height));
 		m_currentViewport = viewport;
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
 	}
 
 	if (m_currentPolygonMode != polygonMode)
 	{
 		GL_CHECK(glPolygonMode(GL_FRONT_AND_BACK, polygonMode));
 		m_currentPolygonMode = polygonMode;
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
 	}
 
 	if (m_currentRasterTests != rasterTests)
@@ -158,28 +643,20 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 #if GFX_ENABLE_FACE_CULLING
 		const bool enableFaceCulling =
 			rasterTests.faceCulling != FaceCulling::None;
+		SetCapability(Capability::CullFace, enableFaceCulling);
 		if (enableFaceCulling)
 		{
-			GL_CHECK(glEnable(GL_CULL_FACE));
 			GL_CHECK(glCullFace(rasterTests.faceCulling));
 		}
-		else
-		{
-			GL_CHECK(glDisable(GL_CULL_FACE));
-		}
 #endif // GFX_ENABLE_FACE_CULLING
 
 #if GFX_ENABLE_SCISSOR_TESTING
+		SetCapability(Capability::ScissorTest, rasterTests.scissorTestEnabled);
 		if (rasterTests.scissorTestEnabled)
 		{
-			GL_CHECK(glEnable(GL_SCISSOR_TEST));
 			GL_CHECK(glScissor(rasterTests.scissorX, rasterTests.scissorY,
 				rasterTests.scissorWidth, rasterTests.scissorHeight));
 		}
-		else
-		{
-			GL_CHECK(glDisable(GL_SCISSOR_TEST));
-		}
 #endif // GFX_ENABLE_SCISSOR_TESTING
 
 #if GFX_ENABLE_STENCIL_TESTING
@@ -188,10 +665,9 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 			rasterTests.stencilBackTest != StencilFunction::Always ||
 			rasterTests.stencilFrontOpPass != StencilOperation::Keep ||
 			rasterTests.stencilBackOpPass != StencilOperation::Keep;
+		SetCapability(Capability::StencilTest, enableStencilTest);
 		if (enableStencilTest)
 		{
-			GL_CHECK(glEnable(GL_STENCIL_TEST));
-
 			GL_CHECK(glStencilFuncSeparate(GL_FRONT,
 				rasterTests.stencilFrontTest,
 				rasterTests.stencilFrontValue,
@@ -210,40 +686,28 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 				rasterTests.stencilBackOpDepthFail,
 				rasterTests.stencilBackOpPass));
 		}
-		else
-		{
-			GL_CHECK(glDisable(GL_STENCIL_TEST));
-		}
 #endif // GFX_ENABLE_STENCIL_TESTING
 
 #if GFX_ENABLE_DEPTH_TESTING
 		const bool enableDepthTest =
 			rasterTests.depthTest != DepthFunction::Always ||
 			rasterTests.depthWrite == true;
+		SetCapability(Capability::DepthTest, enableDepthTest);
 		if (enableDepthTest)
 		{
-			GL_CHECK(glEnable(GL_DEPTH_TEST));
 			GL_CHECK(glDepthFunc(rasterTests.depthTest));
 			GL_CHECK(glDepthMask(rasterTests.depthWrite ? GL_TRUE : GL_FALSE));
 		}
-		else
-		{
-			GL_CHECK(glDisable(GL_DEPTH_TEST));
-		}
 #endif // GFX_ENABLE_DEPTH_TESTING
 
 #if GFX_ENABLE_CLIPPING
-		if (rasterTests.enableClipDistance)
-		{
-			GL_CHECK(glEnable(GL_CLIP_DISTANCE0));
-		}
-		else
-		{
-			GL_CHECK(glDisable(GL_CLIP_DISTANCE0));
-		}
+		SetCapability(Capability::ClipDistance0, rasterTests.enableClipDistance);
 #endif // GFX_ENABLE_CLIPPING
 
-		m_currentRasterTests = rasterTests;
+		// Copied as bytes, since the comparison includes the padding,
+		// which an assignment may leave out.
+		memcpy(&m_currentRasterTests, &rasterTests, sizeof(rasterTests));
+		COUNT_FRAME_STAT(rasterStateChanges, 1);
 	}
 
 	if (m_currentBlendingMode != blendingMode)
@@ -256,9 +720,9 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 			blendingMode.dstRGBFunction != BlendFunction::Zero ||
 			blendingMode.dstAlphaFunction != BlendFunction::Zero;
 
+		SetCapability(Capability::Blend, enableBlending);
 		if (enableBlending)
 		{
-			GL_CHECK(glEnable(GL_BLEND));
 			GL_CHECK(glBlendFuncSeparate(blendingMode.srcRGBFunction,
 										 blendingMode.dstRGBFunction,
 										 blendingMode.srcAlphaFunction,
@@ -266,12 +730,42 @@ void OpenGLLayer::SetRasterizerState(const Viewport& viewport,
 			GL_CHECK(glBlendEquationSeparate(blendingMode.rgbEquation,
 											 blendingMode.alphaEquation));
 		}
-		else
-		{
-			GL_CHECK(glDisable(GL_BLEND));
-		}
 
 		m_currentBlendingMode = blendingMode;
+		COUNT_FRAME_STAT(blendStateChanges, 1);
+	}
+}
+
+#if GFX_ENABLE_FRAME_STATS
+static int getNumberOfTriangles(GLenum primitiveType, int numberOfIndices)
+{
+	switch (primitiveType)
+	{
+	case GL_TRIANGLES: return numberOfIndices / 3;
+	case GL_TRIANGLE_STRIP: return (numberOfIndices > 2 ? numberOfIndices - 2 : 0);
+	case GL_QUADS: return 2 * (numberOfIndices / 4);
+	case GL_QUAD_STRIP: return (numberOfIndices > 2 ? 2 * ((numberOfIndices - 2) / 2) : 0);
+	default: return 0;
+	}
+}
+#endif // GFX_ENABLE_FRAME_STATS
+
+// Enables and describes the attributes of the vertex buffer currently
+// bound to GL_ARRAY_BUFFER.
+static void setVertexAttributePointers(const VertexAttribute* vertexAttributes,
+									   int numberOfAttributes, int stride)
+{
+	unsigned long offset = 0;
+	for (int i = 0; i < numberOfAttributes; ++i)
+	{
+		const VertexAttribute& attrib = vertexAttributes[i];
+
+		const GLenum glenum = getVertexAttributeGLenum(attrib.type);
+		const unsigned long size = attrib.num * getVertexAttributeSize(attrib.type);
+
+		GL_CHECK(glEnableVertexAttribArray(i));
+		GL_CHECK(glVertexAttribPointer(i, attrib.num, glenum, GL_FALSE, stride, (void*)((unsigned long)nullptr + offset)));
+		offset += size;
 	}
 }
 
@@ -281,11 +775,18 @@ VertexBufferID OpenGLLayer::CreateVertexBuffer()
 	newVBO.primitiveType = GL_TRIANGLES;
 	newVBO.vertexAttributes = nullptr;
 	newVBO.numberOfAttributes = 0;
-	GL_CHECK(glGenBuffers(1, &newVBO.vertexBuffer));
-	GL_CHECK(glGenBuffers(1, &newVBO.indexBuffer));
+	newVBO.vertexBufferCapacity = 0;
+	newVBO.indexBufferCapacity = 0;
+	newVBO.indexed = false;
+	GenerateBufferObject(&newVBO.vertexBuffer);
+	GenerateBufferObject(&newVBO.indexBuffer);
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	GL_CHECK(glGenVertexArrays(1, &newVBO.vertexArray));
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
 
 	// Internal resource indexing
 	m_VBOs.add(newVBO);
+	COUNT_FRAME_STAT(numberOfVertexBuffers, 1);
 	VertexBufferID id = { m_VBOs.size - 1 };
 	return id;
 }
@@ -295,8 +796,26 @@ void OpenGLLayer::DestroyVertexBuffer(const VertexBufferID id)
 	ASSERT(m_VBOs.size > id.index);
 	GL_CHECK(glDeleteBuffers(1, &m_VBOs[id.index].vertexBuffer));
 	GL_CHECK(glDeleteBuffers(1, &m_VBOs[id.index].indexBuffer));
+	OnBufferObjectDeleted(m_VBOs[id.index].vertexBuffer);
+	OnBufferObjectDeleted(m_VBOs[id.index].indexBuffer);
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	GL_CHECK(glDeleteVertexArrays(1, &m_VBOs[id.index].vertexArray));
+	if (m_boundVertexArray == m_VBOs[id.index].vertexArray)
+	{
+		m_boundVertexArray = 0;
+		m_boundBuffers[BufferTarget::ElementArray] = UNKNOWN_BINDING;
+	}
+	m_VBOs[id.index].vertexArray = 0;
+	if (m_currentVBO.index == id.index)
+	{
+		m_currentVBO = VertexBufferID::InvalidID;
+	}
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
 	m_VBOs[id.index].vertexBuffer = 0;
 	m_VBOs[id.index].indexBuffer = 0;
+	m_VBOs[id.index].vertexBufferCapacity = 0;
+	m_VBOs[id.index].indexBufferCapacity = 0;
+	COUNT_FRAME_STAT(numberOfVertexBuffers, -1);
 }
 
 void OpenGLLayer::LoadVertexBuffer(const VertexBufferID id,
@@ -310,7 +829,6 @@ void OpenGLLayer::LoadVertexBuffer(const VertexBufferID id,
 	ASSERT(vertexAttributes != nullptr);
 	ASSERT(numberOfAttributes > 0);
 	ASSERT(vertexDataSize > 0);
-	ASSERT(vertexData != nullptr);
 	ASSERT(m_VBOs.size > id.index);
 
 	VBOInfo& vboInfo = m_VBOs[id.index];
@@ -319,25 +837,132 @@ void OpenGLLayer::LoadVertexBuffer(const VertexBufferID id,
 	vboInfo.numberOfAttributes = numberOfAttributes;
 	vboInfo.stride = stride;
 
-	int vertexBufferToRestore = 0;
-	GL_CHECK(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vertexBufferToRestore));
-	GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vboInfo.vertexBuffer));
-	GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexDataSize, vertexData, GL_STATIC_DRAW));
-	GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vertexBufferToRestore));
+	// When the data fits in what is already allocated, only upload it
+	// instead of having the driver reallocate the buffer. Without data,
+	// the buffer is only allocated.
+	if (vertexDataSize <= vboInfo.vertexBufferCapacity)
+	{
+		if (vertexData != nullptr)
+		{
+			UpdateBufferObject(BufferTarget::Array, vboInfo.vertexBuffer, 0, vertexDataSize, vertexData);
+		}
+	}
+	else
+	{
+		LoadBufferObject(BufferTarget::Array, vboInfo.vertexBuffer, vertexDataSize, vertexData, GL_STATIC_DRAW);
+		vboInfo.vertexBufferCapacity = vertexDataSize;
+	}
 
+	// Index data goes through the copy write binding point, since the
+	// element array one is part of the vertex array object state.
 	vboInfo.indexType = indexType;
 	vboInfo.indexed = false;
-	if (indexDataSize != 0 && indexData != nullptr)
+	if (indexDataSize != 0)
 	{
-		int indexBufferToRestore = 0;
-		GL_CHECK(glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &indexBufferToRestore));
-		GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboInfo.indexBuffer));
-		GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize, indexData, GL_STATIC_DRAW));
-		GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferToRestore));
+		if (indexDataSize <= vboInfo.indexBufferCapacity)
+		{
+			if (indexData != nullptr)
+			{
+				UpdateBufferObject(BufferTarget::CopyWrite, vboInfo.indexBuffer, 0, indexDataSize, indexData);
+			}
+		}
+		else
+		{
+			LoadBufferObject(BufferTarget::CopyWrite, vboInfo.indexBuffer, indexDataSize, indexData, GL_STATIC_DRAW);
+			vboInfo.indexBufferCapacity = indexDataSize;
+		}
 		vboInfo.indexed = true;
 	}
+
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	// Record the layout once in the vertex array object, so binding
+	// the vertex buffer is then a single call. The vertex array is
+	// left bound.
+	BindVertexArrayObject(vboInfo.vertexArray, UNKNOWN_BINDING);
+	BindBufferObject(BufferTarget::ElementArray, (vboInfo.indexed ? vboInfo.indexBuffer : 0));
+	BindBufferObject(BufferTarget::Array, vboInfo.vertexBuffer);
+	setVertexAttributePointers(vertexAttributes, numberOfAttributes, stride);
+
+	// The buffer may be reloaded with a different layout.
+	for (int i = numberOfAttributes; i < GFX_MAX_VERTEX_ATTRIBUTES; ++i)
+	{
+		GL_CHECK(glDisableVertexAttribArray(i));
+	}
+	m_currentVBO = id;
+#else // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	// The layout may have changed, so it is specified again on the next
+	// bind.
+	if (m_currentVBO.index == id.index)
+	{
+		m_currentVBO = VertexBufferID::InvalidID;
+	}
+#endif // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
+}
+
+void OpenGLLayer::UpdateVertexBufferRange(const VertexBufferID id,
+										  int offset, int size,
+										  const void* data)
+{
+	ASSERT(m_VBOs.size > id.index);
+	ASSERT(data != nullptr);
+
+	const VBOInfo& vboInfo = m_VBOs[id.index];
+	ASSERT(offset >= 0 && size >= 0 && offset + size <= vboInfo.vertexBufferCapacity);
+
+	UpdateBufferObject(BufferTarget::Array, vboInfo.vertexBuffer, offset, size, data);
+}
+
+void OpenGLLayer::UpdateIndexBufferRange(const VertexBufferID id,
+										 int offset, int size,
+										 const void* data)
+{
+	ASSERT(m_VBOs.size > id.index);
+	ASSERT(data != nullptr);
+
+	const VBOInfo& vboInfo = m_VBOs[id.index];
+	ASSERT(vboInfo.indexed);
+	ASSERT(offset >= 0 && size >= 0 && offset + size <= vboInfo.indexBufferCapacity);
+
+	// See LoadVertexBuffer for the binding point.
+	UpdateBufferObject(BufferTarget::CopyWrite, vboInfo.indexBuffer, offset, size, data);
+}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+void OpenGLLayer::CopyVertexBufferRange(const VertexBufferID source,
+										int sourceOffset,
+										const VertexBufferID destination,
+										int destinationOffset,
+										int size)
+{
+	ASSERT(m_VBOs.size > source.index);
+	ASSERT(m_VBOs.size > destination.index);
+
+	const VBOInfo& sourceInfo = m_VBOs[source.index];
+	const VBOInfo& destinationInfo = m_VBOs[destination.index];
+	ASSERT(sourceOffset >= 0 && size >= 0 && sourceOffset + size <= sourceInfo.vertexBufferCapacity);
+	ASSERT(destinationOffset >= 0 && destinationOffset + size <= destinationInfo.vertexBufferCapacity);
+
+	CopyBufferObject(sourceInfo.vertexBuffer, sourceOffset, destinationInfo.vertexBuffer, destinationOffset, size);
 }
 
+void OpenGLLayer::CopyIndexBufferRange(const VertexBufferID source,
+									   int sourceOffset,
+									   const VertexBufferID destination,
+									   int destinationOffset,
+									   int size)
+{
+	ASSERT(m_VBOs.size > source.index);
+	ASSERT(m_VBOs.size > destination.index);
+
+	const VBOInfo& sourceInfo = m_VBOs[source.index];
+	const VBOInfo& destinationInfo = m_VBOs[destination.index];
+	ASSERT(sourceOffset >= 0 && size >= 0 && sourceOffset + size <= sourceInfo.indexBufferCapacity);
+	ASSERT(destinationOffset >= 0 && destinationOffset + size <= destinationInfo.indexBufferCapacity);
+
+	CopyBufferObject(sourceInfo.indexBuffer, sourceOffset, destinationInfo.indexBuffer, destinationOffset, size);
+}
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
 void OpenGLLayer::BindVertexBuffer(const VertexBufferID id)
 {
 	ASSERT(m_VBOs.size > id.index);
@@ -347,34 +972,36 @@ void OpenGLLayer::BindVertexBuffer(const VertexBufferID id)
 		return;
 	}
 
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+	if (vboIndex >= 0)
+	{
+		const VBOInfo& vboInfo = m_VBOs[vboIndex];
+		BindVertexArrayObject(vboInfo.vertexArray, (vboInfo.indexed ? vboInfo.indexBuffer : 0));
+	}
+	else
+	{
+		BindVertexArrayObject(m_defaultVertexArray, UNKNOWN_BINDING);
+	}
+#else // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
 	int firstAttributeToDisable = 0;
 	if (vboIndex >= 0)
 	{
 		const VBOInfo& vboInfo = m_VBOs[vboIndex];
 
-		GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vboInfo.vertexBuffer));
-		GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (vboInfo.indexed ? vboInfo.indexBuffer : 0)));
+		BindBufferObject(BufferTarget::Array, vboInfo.vertexBuffer);
+		BindBufferObject(BufferTarget::ElementArray, (vboInfo.indexed ? vboInfo.indexBuffer : 0));
+		setVertexAttributePointers(vboInfo.vertexAttributes, vboInfo.numberOfAttributes, vboInfo.stride);
 
-		unsigned long offset = 0;
 		for (int i = 0; i < vboInfo.numberOfAttributes; ++i)
 		{
-			const VertexAttribute& attrib = vboInfo.vertexAttributes[i];
-
-			const GLenum glenum = getVertexAttributeGLenum(attrib.type);
-			const unsigned long size = attrib.num * getVertexAttributeSize(attrib.type);
-
-			GL_CHECK(glEnableVertexAttribArray(i));
-			GL_CHECK(glVertexAttribPointer(i, attrib.num, glenum, GL_FALSE, vboInfo.stride, (void*)((unsigned long)nullptr + offset)));
-			offset += size;
-
 			m_enabledVertexAttributes[i] = true;
 		}
 		firstAttributeToDisable = vboInfo.numberOfAttributes;
 	}
 	else
 	{
-		GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
-		GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+		BindBufferObject(BufferTarget::Array, 0);
+		BindBufferObject(BufferTarget::ElementArray, 0);
 	}
 
 	for (int i = firstAttributeToDisable; i < GFX_MAX_VERTEX_ATTRIBUTES; ++i)
@@ -385,8 +1012,10 @@ void OpenGLLayer::BindVertexBuffer(const VertexBufferID id)
 			m_enabledVertexAttributes[i] = false;
 		}
 	}
+#endif // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
 
 	m_currentVBO.index = vboIndex;
+	COUNT_FRAME_STAT(vertexBufferChanges, 1);
 }
 
 TextureID OpenGLLayer::CreateTexture()
@@ -394,10 +1023,23 @@ TextureID OpenGLLayer::CreateTexture()
 	TextureInfo newTexture;
 	newTexture.width = 0;
 	newTexture.height = 0;
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	newTexture.storageLevels = 0;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	newTexture.pendingUpload = -1;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#if GFX_ENABLE_TEXTURE_ARRAYS
+	newTexture.numberOfLayers = 0;
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+	newTexture.numberOfLevels = 0;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
 	GL_CHECK(glGenTextures(1, &newTexture.texture));
 
 	// Internal resource indexing
 	m_textures.add(newTexture);
+	COUNT_FRAME_STAT(numberOfTextures, 1);
 	TextureID id = { m_textures.size - 1 };
 	return id;
 }
@@ -405,17 +1047,88 @@ TextureID OpenGLLayer::CreateTexture()
 void OpenGLLayer::DestroyTexture(const TextureID id)
 {
 	ASSERT(m_textures.size > id.index);
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+	// An upload that is still mapped is abandoned, one in flight only
+	// needs to be waited for before its buffer is reused.
+	const int pendingUpload = m_textures[id.index].pendingUpload;
+	if (pendingUpload >= 0)
+	{
+		TextureUpload& upload = m_textureUploads[pendingUpload];
+		if (upload.mapped)
+		{
+			BindBufferObject(BufferTarget::PixelUnpack, upload.buffer);
+			GL_CHECK(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+			BindBufferObject(BufferTarget::PixelUnpack, 0);
+			upload.mapped = false;
+		}
+		upload.texture = TextureID::InvalidID;
+		m_textures[id.index].pendingUpload = -1;
+	}
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
 	GL_CHECK(glDeleteTextures(1, &m_textures[id.index].texture));
+	OnTextureObjectDeleted(m_textures[id.index].texture);
 	m_textures[id.index].texture = 0;
+	COUNT_FRAME_STAT(numberOfTextures, -1);
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	m_textures[id.index].storageLevels = 0;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_TEXTURE_STORAGE
+	m_textures[id.index].numberOfLevels = 0;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
 }
 
-void OpenGLLayer::LoadTexture(const TextureID id,
-							  int width, int height,
-							  TextureType::Enum textureType,
-							  TextureFormat::Enum textureFormat,
-							  int side, int lodLevel,
-							  const void* data,
+bool OpenGLLayer::HasImmutableStorage(const TextureID id) const
+{
+	const TextureInfo& textureInfo = m_textures[id.index];
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (textureInfo.storageLevels > 0)
+	{
+		return true;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_TEXTURE_STORAGE
+	if (textureInfo.numberOfLevels > 0 && m_useTextureStorage)
+	{
+		return true;
+	}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+	(void)textureInfo;
+	return false;
+}
+
+void OpenGLLayer::ReplaceTextureObject(const TextureID id)
+{
+	TextureInfo& textureInfo = m_textures[id.index];
+	GL_CHECK(glDeleteTextures(1, &textureInfo.texture));
+	OnTextureObjectDeleted(textureInfo.texture);
+	GL_CHECK(glGenTextures(1, &textureInfo.texture));
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	textureInfo.storageLevels = 0;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_TEXTURE_STORAGE
+	textureInfo.numberOfLevels = 0;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+}
+
+void OpenGLLayer::LoadTexture(const TextureID id,
+							  int width, int height,
+							  TextureType::Enum textureType,
+							  TextureFormat::Enum textureFormat,
+							  int side, int lodLevel,
+							  const void* data,
 							  const TextureSampling& textureSampling)
+{
+	LoadTextureImage(id, width, height, textureType, textureFormat, side, lodLevel,
+					 data, (data != nullptr), textureSampling);
+}
+
+void OpenGLLayer::LoadTextureImage(const TextureID id,
+								   int width, int height,
+								   TextureType::Enum textureType,
+								   TextureFormat::Enum textureFormat,
+								   int side, int lodLevel,
+								   const void* data, bool hasData,
+								   const TextureSampling& textureSampling)
 {
 	ASSERT(width * height > 0);
 	ASSERT(m_textures.size > id.index);
@@ -433,13 +1146,29 @@ void OpenGLLayer::LoadTexture(const TextureID id,
 	const GLenum minFilter = textureSampling.minifyingFilter;
 	const GLenum magFilter = textureSampling.magnifyingFilter;
 	textureInfo.format = format;
+	COUNT_FRAME_STAT(bytesUploaded, (hasData ? getImageSize(format, type, width, height) : 0));
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+	if (textureInfo.numberOfLevels > 0)
+	{
+		ReplaceTextureObject(id);
+	}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess &&
+		LoadTextureDirect(id, width, height, internalFormat, format, type, lodLevel, data, hasData, textureSampling))
+	{
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
 
-	int textureToRestore = 0;
-	GL_CHECK(glGetIntegerv((textureInfo.type == GL_TEXTURE_2D ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_CUBE_MAP), &textureToRestore));
-	GL_CHECK(glBindTexture(textureInfo.type, textureInfo.texture));
+	// The texture is left bound to the active slot, which the shadow
+	// state accounts for.
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), textureInfo.type, textureInfo.texture);
 
 	GL_CHECK(glTexImage2D(target, (lodLevel < 0 ? 0 : lodLevel), internalFormat, width, height, 0, format, type, data));
-	if (data != nullptr && textureInfo.type == GL_TEXTURE_2D)
+	if (hasData && textureInfo.type == GL_TEXTURE_2D)
 	{
 		if (lodLevel < 0 && textureSampling.minifyingFilter >= TextureFilter::NearestMipmapLinear)
 		{
@@ -467,66 +1196,463 @@ void OpenGLLayer::LoadTexture(const TextureID id,
 	}
 	GL_CHECK(glTexParameteri(textureInfo.type, GL_TEXTURE_WRAP_S, sWrap));
 	GL_CHECK(glTexParameteri(textureInfo.type, GL_TEXTURE_WRAP_T, tWrap));
+}
+
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+// Loads a 2D texture into immutable storage, without binding it.
+// Returns false if the texture has to go through glTexImage2D instead:
+// cube maps, unsized formats, and mip levels loaded before level 0.
+bool OpenGLLayer::LoadTextureDirect(const TextureID id,
+									int width, int height,
+									GLenum internalFormat, GLenum format, GLenum type,
+									int lodLevel,
+									const void* data, bool hasData,
+									const TextureSampling& textureSampling)
+{
+	TextureInfo& textureInfo = m_textures[id.index];
+	if (textureInfo.type != GL_TEXTURE_2D || internalFormat == format)
+	{
+		return false;
+	}
+
+	const GLenum minFilter = textureSampling.minifyingFilter;
+	const GLenum magFilter = textureSampling.magnifyingFilter;
+	const int level = (lodLevel < 0 ? 0 : lodLevel);
+	if (level > 0)
+	{
+		// Explicit mip levels go in the storage allocated with level 0,
+		// which has all the levels if the filter uses mipmaps.
+		if (textureInfo.storageLevels == 0)
+		{
+			return false;
+		}
+		ASSERT(level < textureInfo.storageLevels);
+	}
+	else
+	{
+		int levels = 1;
+		if (minFilter != GL_NEAREST && minFilter != GL_LINEAR)
+		{
+			for (int size = (width > height ? width : height); size > 1; size /= 2)
+			{
+				++levels;
+			}
+		}
 
-	GL_CHECK(glBindTexture(textureInfo.type, textureToRestore));
+		if (textureInfo.storageLevels != levels ||
+			textureInfo.storageWidth != width ||
+			textureInfo.storageHeight != height ||
+			textureInfo.storageFormat != internalFormat)
+		{
+			// Immutable storage cannot be respecified, so the texture
+			// object is replaced. The name from CreateTexture is replaced
+			// as well, since it is not a texture object until bound.
+			GL_CHECK(glDeleteTextures(1, &textureInfo.texture));
+			OnTextureObjectDeleted(textureInfo.texture);
+			GL_CHECK(glCreateTextures(GL_TEXTURE_2D, 1, &textureInfo.texture));
+			GL_CHECK(glTextureStorage2D(textureInfo.texture, levels, internalFormat, width, height));
+			textureInfo.storageLevels = levels;
+			textureInfo.storageWidth = width;
+			textureInfo.storageHeight = height;
+			textureInfo.storageFormat = internalFormat;
+		}
+	}
+
+	const GLuint texture = textureInfo.texture;
+	if (hasData)
+	{
+		GL_CHECK(glTextureSubImage2D(texture, level, 0, 0, width, height, format, type, data));
+		if (lodLevel < 0 && textureSampling.minifyingFilter >= TextureFilter::NearestMipmapLinear)
+		{
+			GL_CHECK(glGenerateTextureMipmap(texture));
+		}
+
+		ASSERT(textureSampling.maxAnisotropy >= 1.f);
+		GL_CHECK(glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY_EXT, textureSampling.maxAnisotropy));
+	}
+	else
+	{
+		GL_CHECK(glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY_EXT, 2));
+	}
+	GL_CHECK(glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, minFilter));
+	GL_CHECK(glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, magFilter));
+	GL_CHECK(glTextureParameteri(texture, GL_TEXTURE_WRAP_S, textureSampling.sWrap));
+	GL_CHECK(glTextureParameteri(texture, GL_TEXTURE_WRAP_T, textureSampling.tWrap));
+	return true;
 }
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
 
 void OpenGLLayer::BindTexture(const TextureID id, int slot)
 {
 	ASSERT(m_textures.size > id.index);
 	ASSERT(slot >= 0 && slot < GFX_MAX_TEXTURE_SLOTS);
 	const int textureIndex = id.index;
-	if (m_currentTextures[slot].index == textureIndex)
+	if (textureIndex >= 0)
 	{
+		BindTextureObject(slot, m_textures[textureIndex].type, m_textures[textureIndex].texture);
+	}
+	else
+	{
+		BindTextureObject(slot, GL_TEXTURE_2D, 0);
+	}
+}
+
+void OpenGLLayer::GenerateMipMaps(const TextureID id)
+{
+	ASSERT(m_textures.size > id.index);
+	TextureInfo& textureInfo = m_textures[id.index];
+
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess && textureInfo.storageLevels > 0)
+	{
+		GL_CHECK(glGenerateTextureMipmap(textureInfo.texture));
 		return;
 	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
 
-	GL_CHECK(glActiveTexture(GL_TEXTURE0 + slot));
-	if (textureIndex >= 0)
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), textureInfo.type, textureInfo.texture);
+	GL_CHECK(glGenerateMipmap(textureInfo.type));
+}
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+void OpenGLLayer::LoadTextureArray(const TextureID id,
+								   int width, int height,
+								   int numberOfLayers,
+								   TextureFormat::Enum textureFormat,
+								   const TextureSampling& textureSampling)
+{
+	ASSERT(width * height > 0);
+	ASSERT(numberOfLayers > 0);
+	ASSERT(m_textures.size > id.index);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+
+	if (textureInfo.width > 0 &&
+		(textureInfo.type != GL_TEXTURE_2D_ARRAY || HasImmutableStorage(id)))
+	{
+		ReplaceTextureObject(id);
+	}
+
+	const GLenum internalFormat = getTextureFormat_InternalFormatGLenum(textureFormat);
+	const GLenum format = getTextureFormat_FormatGLenum(textureFormat);
+	const GLenum type = getTextureFormat_TypeGLenum(textureFormat);
+	const GLenum minFilter = textureSampling.minifyingFilter;
+	textureInfo.width = width;
+	textureInfo.height = height;
+	textureInfo.type = TextureType::Texture2DArray;
+	textureInfo.format = format;
+	textureInfo.numberOfLayers = numberOfLayers;
+	textureInfo.dataType = type;
+
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), GL_TEXTURE_2D_ARRAY, textureInfo.texture);
+
+	int levels = 1;
+	if (minFilter != GL_NEAREST && minFilter != GL_LINEAR)
+	{
+		for (int size = (width > height ? width : height); size > 1; size /= 2)
+		{
+			++levels;
+		}
+	}
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+	textureInfo.numberOfLevels = levels;
+	if (m_useTextureStorage)
 	{
-		GL_CHECK(glBindTexture(m_textures[textureIndex].type, m_textures[textureIndex].texture));
+		GL_CHECK(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, numberOfLayers));
 	}
 	else
+#endif // GFX_ENABLE_TEXTURE_STORAGE
 	{
-		GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+		// Layers are not scaled down, only their size.
+		int levelWidth = width;
+		int levelHeight = height;
+		for (int level = 0; level < levels; ++level)
+		{
+			GL_CHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, levelWidth, levelHeight, numberOfLayers, 0, format, type, nullptr));
+			levelWidth = (levelWidth > 1 ? levelWidth / 2 : 1);
+			levelHeight = (levelHeight > 1 ? levelHeight / 2 : 1);
+		}
 	}
-	m_currentTextures[slot].index = textureIndex;
+
+	ASSERT(textureSampling.maxAnisotropy >= 1.f);
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, textureSampling.magnifyingFilter));
+	GL_CHECK(glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, textureSampling.maxAnisotropy));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, textureSampling.sWrap));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, textureSampling.tWrap));
 }
 
-void OpenGLLayer::GenerateMipMaps(const TextureID id)
+void OpenGLLayer::LoadTextureLayer(const TextureID id, int layer, const void* data)
+{
+	ASSERT(m_textures.size > id.index);
+	ASSERT(data != nullptr);
+
+	const TextureInfo& textureInfo = m_textures[id.index];
+	ASSERT(textureInfo.type == GL_TEXTURE_2D_ARRAY);
+	ASSERT(layer >= 0 && layer < textureInfo.numberOfLayers);
+
+	COUNT_FRAME_STAT(bytesUploaded, getImageSize(textureInfo.format, textureInfo.dataType, textureInfo.width, textureInfo.height));
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), GL_TEXTURE_2D_ARRAY, textureInfo.texture);
+	GL_CHECK(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+							 textureInfo.width, textureInfo.height, 1,
+							 textureInfo.format, textureInfo.dataType, data));
+}
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+void OpenGLLayer::AllocateTexture(const TextureID id,
+								  int width, int height,
+								  int numberOfLevels,
+								  TextureFormat::Enum textureFormat,
+								  const TextureSampling& textureSampling)
 {
+	ASSERT(width * height > 0);
+	ASSERT(numberOfLevels > 0);
 	ASSERT(m_textures.size > id.index);
+
 	TextureInfo& textureInfo = m_textures[id.index];
+	if (textureInfo.width > 0 &&
+		(textureInfo.type != GL_TEXTURE_2D || HasImmutableStorage(id)))
+	{
+		ReplaceTextureObject(id);
+	}
 
-	int slot = 0;
-	for (int i = 0; i < GFX_MAX_TEXTURE_SLOTS; ++i)
+	const GLenum internalFormat = getTextureFormat_InternalFormatGLenum(textureFormat);
+	const GLenum format = getTextureFormat_FormatGLenum(textureFormat);
+	const GLenum type = getTextureFormat_TypeGLenum(textureFormat);
+	textureInfo.width = width;
+	textureInfo.height = height;
+	textureInfo.type = TextureType::Texture2D;
+	textureInfo.format = format;
+	textureInfo.dataType = type;
+	textureInfo.numberOfLevels = numberOfLevels;
+
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), GL_TEXTURE_2D, textureInfo.texture);
+	if (m_useTextureStorage)
+	{
+		GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, numberOfLevels, internalFormat, width, height));
+	}
+	else
+	{
+		int levelWidth = width;
+		int levelHeight = height;
+		for (int level = 0; level < numberOfLevels; ++level)
+		{
+			GL_CHECK(glTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0, format, type, nullptr));
+			levelWidth = (levelWidth > 1 ? levelWidth / 2 : 1);
+			levelHeight = (levelHeight > 1 ? levelHeight / 2 : 1);
+		}
+
+		// Immutable storage does this implicitly.
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numberOfLevels - 1));
+	}
+
+	ASSERT(textureSampling.maxAnisotropy >= 1.f);
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textureSampling.minifyingFilter));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textureSampling.magnifyingFilter));
+	GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, textureSampling.maxAnisotropy));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureSampling.sWrap));
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureSampling.tWrap));
+}
+
+void OpenGLLayer::LoadTextureLevel(const TextureID id, int level, const void* data)
+{
+	ASSERT(m_textures.size > id.index);
+	ASSERT(data != nullptr);
+
+	const TextureInfo& textureInfo = m_textures[id.index];
+	ASSERT(textureInfo.type == GL_TEXTURE_2D);
+	ASSERT(level >= 0 && level < textureInfo.numberOfLevels);
+
+	int width = textureInfo.width >> level;
+	int height = textureInfo.height >> level;
+	width = (width > 0 ? width : 1);
+	height = (height > 0 ? height : 1);
+	COUNT_FRAME_STAT(bytesUploaded, getImageSize(textureInfo.format, textureInfo.dataType, width, height));
+
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), GL_TEXTURE_2D, textureInfo.texture);
+	GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height,
+							 textureInfo.format, textureInfo.dataType, data));
+}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+void OpenGLLayer::LoadCompressedTexture(const TextureID id,
+										int width, int height,
+										TextureFormat::Enum textureFormat,
+										int lodLevel,
+										int dataSize, const void* data,
+										const TextureSampling& textureSampling)
+{
+	ASSERT(width * height > 0);
+	ASSERT(m_textures.size > id.index);
+	ASSERT(textureFormat >= TextureFormat::BC1 && textureFormat <= TextureFormat::BC7);
+	ASSERT(lodLevel >= 0);
+	ASSERT(dataSize > 0 && data != nullptr);
+
+	TextureInfo& textureInfo = m_textures[id.index];
+
+	// The levels are specified one by one with glCompressedTexImage2D,
+	// which immutable storage doesn't allow.
+	if (HasImmutableStorage(id))
+	{
+		ReplaceTextureObject(id);
+	}
+
+	const GLenum internalFormat = getTextureFormat_InternalFormatGLenum(textureFormat);
+	if (lodLevel == 0)
+	{
+		textureInfo.width = width;
+		textureInfo.height = height;
+		textureInfo.type = TextureType::Texture2D;
+		textureInfo.format = getTextureFormat_FormatGLenum(textureFormat);
+	}
+	ASSERT(textureInfo.type == GL_TEXTURE_2D);
+
+	BindTextureObject((m_activeTextureSlot >= 0 ? m_activeTextureSlot : 0), GL_TEXTURE_2D, textureInfo.texture);
+	GL_CHECK(glCompressedTexImage2D(GL_TEXTURE_2D, lodLevel, internalFormat, width, height, 0, dataSize, data));
+	COUNT_FRAME_STAT(bytesUploaded, dataSize);
+
+	// Sampling stops at the last level loaded, so the texture is
+	// complete while the rest of the chain is still on its way.
+	GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, lodLevel));
+	if (lodLevel == 0)
+	{
+		ASSERT(textureSampling.maxAnisotropy >= 1.f);
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, textureSampling.minifyingFilter));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, textureSampling.magnifyingFilter));
+		GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, textureSampling.maxAnisotropy));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, textureSampling.sWrap));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, textureSampling.tWrap));
+	}
+}
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+void* OpenGLLayer::MapTextureUpload(const TextureID id, int size)
+{
+	ASSERT(m_textures.size > id.index);
+	ASSERT(size > 0);
+	ASSERT(m_textures[id.index].pendingUpload < 0 || !m_textureUploads[m_textures[id.index].pendingUpload].mapped);
+
+	// Uploads are issued in about the order they are mapped, so the
+	// next buffer of the ring is the one most likely to be free.
+	const int index = m_nextTextureUpload;
+	TextureUpload& upload = m_textureUploads[index];
+	if (upload.mapped)
+	{
+		return nullptr;
+	}
+	if (upload.fence != nullptr)
 	{
-		if (m_currentTextures[slot].index == id.index)
+		GLenum status;
+		GL_CHECK(status = glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+		if (status == GL_TIMEOUT_EXPIRED)
 		{
-			slot = i;
-			break;
+			return nullptr;
 		}
+		RetireTextureUpload(index);
 	}
-	BindTexture(id, slot);
-	if (textureInfo.type == GL_TEXTURE_2D)
+
+	// The previous content is not needed anymore, which the driver is
+	// told so it doesn't have to synchronize the mapping.
+	BindBufferObject(BufferTarget::PixelUnpack, upload.buffer);
+	if (size > upload.capacity)
 	{
-		GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
+		GL_CHECK(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+		upload.capacity = size;
 	}
-	else
+	void* data;
+	GL_CHECK(data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	BindBufferObject(BufferTarget::PixelUnpack, 0);
+
+	upload.texture = id;
+	upload.mapped = true;
+	m_textures[id.index].pendingUpload = index;
+	m_nextTextureUpload = (index + 1) % GFX_TEXTURE_UPLOAD_BUFFERS;
+	return data;
+}
+
+void OpenGLLayer::LoadTextureAsync(const TextureID id,
+								   int width, int height,
+								   TextureType::Enum textureType,
+								   TextureFormat::Enum textureFormat,
+								   int side, int lodLevel,
+								   const TextureSampling& textureSampling)
+{
+	ASSERT(m_textures.size > id.index);
+	const int index = m_textures[id.index].pendingUpload;
+	ASSERT(index >= 0);
+	TextureUpload& upload = m_textureUploads[index];
+	ASSERT(upload.mapped && upload.texture == id);
+
+	// With the pixel unpack buffer bound, the texture data is read from
+	// it by the GPU, and the call returns without copying anything.
+	// It is unbound afterwards so LoadTexture reads client memory.
+	BindBufferObject(BufferTarget::PixelUnpack, upload.buffer);
+	GL_CHECK(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+	upload.mapped = false;
+	LoadTextureImage(id, width, height, textureType, textureFormat, side, lodLevel,
+					 nullptr, true, textureSampling);
+	BindBufferObject(BufferTarget::PixelUnpack, 0);
+
+	GL_CHECK(upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+bool OpenGLLayer::IsTextureReady(const TextureID id)
+{
+	ASSERT(m_textures.size > id.index);
+	const int index = m_textures[id.index].pendingUpload;
+	if (index < 0)
+	{
+		return true;
+	}
+
+	const TextureUpload& upload = m_textureUploads[index];
+	if (upload.mapped)
+	{
+		return false;
+	}
+
+	GLenum status;
+	GL_CHECK(status = glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+	RetireTextureUpload(index);
+	return true;
+}
+
+// Called once the fence of an upload has signalled.
+void OpenGLLayer::RetireTextureUpload(int index)
+{
+	TextureUpload& upload = m_textureUploads[index];
+	GL_CHECK(glDeleteSync(upload.fence));
+	upload.fence = nullptr;
+
+	// The texture may have been destroyed, or be waiting for another
+	// upload since.
+	if (upload.texture != TextureID::InvalidID &&
+		m_textures[upload.texture.index].pendingUpload == index)
 	{
-		GL_CHECK(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
+		m_textures[upload.texture.index].pendingUpload = -1;
 	}
+	upload.texture = TextureID::InvalidID;
 }
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
 
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 UniformBufferID OpenGLLayer::CreateUniformBuffer()
 {
 	UBOInfo newUBO;
 	newUBO.size = 0;
-	GL_CHECK(glGenBuffers(1, &newUBO.uniformBuffer));
+	GenerateBufferObject(&newUBO.uniformBuffer);
 
 	// Internal resource indexing
 	m_UBOs.add(newUBO);
+	COUNT_FRAME_STAT(numberOfUniformBuffers, 1);
 	UniformBufferID id = { m_UBOs.size - 1 };
 	return id;
 }
@@ -535,7 +1661,9 @@ void OpenGLLayer::DestroyUniformBuffer(const UniformBufferID id)
 {
 	ASSERT(m_UBOs.size > id.index);
 	GL_CHECK(glDeleteBuffers(1, &m_UBOs[id.index].uniformBuffer));
+	OnBufferObjectDeleted(m_UBOs[id.index].uniformBuffer);
 	m_UBOs[id.index].uniformBuffer = 0;
+	COUNT_FRAME_STAT(numberOfUniformBuffers, -1);
 }
 
 void OpenGLLayer::LoadUniformBuffer(const UniformBufferID id,
@@ -547,25 +1675,20 @@ void OpenGLLayer::LoadUniformBuffer(const UniformBufferID id,
 
 	UBOInfo& uboInfo = m_UBOs[id.index];
 
-	int uniformBufferToRestore = 0;
-	GL_CHECK(glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &uniformBufferToRestore));
-
-	GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, uboInfo.uniformBuffer)); // Yes, questionable naming. :(
 	if (uboInfo.size == 0)
 	{
-		GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_COPY));
+		LoadBufferObject(BufferTarget::Uniform, uboInfo.uniformBuffer, size, data, GL_DYNAMIC_COPY);
 		uboInfo.size = size;
 	}
 	else
 	{
 		ASSERT(uboInfo.size == size);
-		GL_CHECK(glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data));
+		UpdateBufferObject(BufferTarget::Uniform, uboInfo.uniformBuffer, 0, size, data);
 		//GLvoid* dst;
 		//GL_CHECK(dst = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY));
 		//memcpy(dst, data, size);
 		//GL_CHECK(glUnmapBuffer(GL_UNIFORM_BUFFER));
 	}
-	GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, uniformBufferToRestore));
 }
 
 void OpenGLLayer::BindUniformBuffer(const UniformBufferID id,
@@ -586,14 +1709,10 @@ void OpenGLLayer::BindUniformBuffer(const UniformBufferID id,
 		return;
 	}
 
-	if (UBOIndex >= 0)
-	{
-		GL_CHECK(glBindBufferBase(GL_UNIFORM_BUFFER, slot, m_UBOs[UBOIndex].uniformBuffer));
-	}
-	else
-	{
-		GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
-	}
+	// glBindBufferBase also binds the generic binding point.
+	const GLuint uniformBuffer = (UBOIndex >= 0 ? m_UBOs[UBOIndex].uniformBuffer : 0);
+	GL_CHECK(glBindBufferBase(GL_UNIFORM_BUFFER, slot, uniformBuffer));
+	m_boundBuffers[BufferTarget::Uniform] = uniformBuffer;
 	m_currentUBOs[slot].index = UBOIndex;
 }
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
@@ -602,11 +1721,13 @@ void OpenGLLayer::BindUniformBuffer(const UniformBufferID id,
 StorageBufferID OpenGLLayer::CreateStorageBuffer()
 {
 	SSBOInfo newSSBO;
-	//newSSBO.size = 0;
-	GL_CHECK(glGenBuffers(1, &newSSBO.storageBuffer));
+	newSSBO.size = 0;
+	newSSBO.writing = false;
+	GenerateBufferObject(&newSSBO.storageBuffer);
 
 	// Internal resource indexing
 	m_SSBOs.add(newSSBO);
+	COUNT_FRAME_STAT(numberOfStorageBuffers, 1);
 	StorageBufferID id = { m_SSBOs.size - 1 };
 	return id;
 }
@@ -615,7 +1736,9 @@ void OpenGLLayer::DestroyStorageBuffer(const StorageBufferID id)
 {
 	ASSERT(m_SSBOs.size > id.index);
 	GL_CHECK(glDeleteBuffers(1, &m_SSBOs[id.index].storageBuffer));
+	OnBufferObjectDeleted(m_SSBOs[id.index].storageBuffer);
 	m_SSBOs[id.index].storageBuffer = 0;
+	COUNT_FRAME_STAT(numberOfStorageBuffers, -1);
 }
 
 void OpenGLLayer::LoadStorageBuffer(const StorageBufferID id, size_t size, const void* data)
@@ -623,12 +1746,8 @@ void OpenGLLayer::LoadStorageBuffer(const StorageBufferID id, size_t size, const
 	ASSERT(m_SSBOs.size > id.index);
 	SSBOInfo& ssboInfo = m_SSBOs[id.index];
 
-	int storageBufferToRestore = 0;
-	GL_CHECK(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &storageBufferToRestore));
-
-	GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboInfo.storageBuffer));
-	GL_CHECK(glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW));
-	GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, storageBufferToRestore));
+	LoadBufferObject(BufferTarget::ShaderStorage, ssboInfo.storageBuffer, size, data, GL_DYNAMIC_DRAW);
+	ssboInfo.size = (int)size;
 }
 
 void OpenGLLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void* dest)
@@ -636,9 +1755,6 @@ void OpenGLLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void*
 	ASSERT(m_SSBOs.size > id.index);
 	SSBOInfo& ssboInfo = m_SSBOs[id.index];
 
-	int storageBufferToRestore = 0;
-	GL_CHECK(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &storageBufferToRestore));
-
 	// If the buffer was previously in a writing state, make sure to
 	// synchronize before reading.
 	if (ssboInfo.writing)
@@ -646,14 +1762,22 @@ void OpenGLLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void*
 		GL_CHECK(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
 		ssboInfo.writing = false;
 	}
-	GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboInfo.storageBuffer));
 
 	// Map the buffer to client's memory space for reading.
 	void* data;
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(data = glMapNamedBufferRange(ssboInfo.storageBuffer, 0, size, GL_MAP_READ_BIT));
+		memcpy(dest, data, size);
+		GL_CHECK(glUnmapNamedBuffer(ssboInfo.storageBuffer));
+		return;
+	}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	BindBufferObject(BufferTarget::ShaderStorage, ssboInfo.storageBuffer);
 	GL_CHECK(data = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT));
 	memcpy(dest, data, size);
 	GL_CHECK(glUnmapBuffer(GL_SHADER_STORAGE_BUFFER));
-	GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, storageBufferToRestore));
 }
 
 void OpenGLLayer::BindStorageBuffer(const StorageBufferID id,
@@ -665,11 +1789,10 @@ void OpenGLLayer::BindStorageBuffer(const StorageBufferID id,
 	ASSERT(m_SSBOs.size > id.index);
 	ASSERT(slot >= 0 && slot < GFX_MAX_STORAGE_BUFFER_BINDINGS);
 	const int SSBOIndex = id.index;
-	if (m_currentSSBOs[slot].index == SSBOIndex)
-	{
-		return;
-	}
 
+	// The block binding belongs to the program, so it is set even when
+	// the buffer is already bound to the slot: passes chained with
+	// different shaders share the same buffers.
 	unsigned int blockIndex;
 	GL_CHECK(blockIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, name));
 	ASSERT(blockIndex != GL_INVALID_INDEX);
@@ -681,53 +1804,213 @@ void OpenGLLayer::BindStorageBuffer(const StorageBufferID id,
 		{
 			GL_CHECK(glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT));
 		}
-		GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, m_SSBOs[SSBOIndex].storageBuffer));
 		m_SSBOs[SSBOIndex].writing = writing;
 	}
+	if (m_currentSSBOs[slot].index == SSBOIndex)
+	{
+		return;
+	}
+
+	if (SSBOIndex >= 0)
+	{
+		// glBindBufferBase also binds the generic binding point.
+		GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, m_SSBOs[SSBOIndex].storageBuffer));
+		m_boundBuffers[BufferTarget::ShaderStorage] = m_SSBOs[SSBOIndex].storageBuffer;
+	}
 	else
 	{
-		GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+		BindBufferObject(BufferTarget::ShaderStorage, 0);
 	}
 	m_currentSSBOs[slot].index = SSBOIndex;
 }
 
 #endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 
-#if ENABLE_SHADER_COMPILATION_ERROR_CHECK
-
-// This function is a complete hack, and tries to recognize and
-// partially reformat errors from the shader compiler, so Visual Studio
-// is able to parse the first line. When it works Visual Studio can
-// then show us directly where the error is.
-//
-// The formatting used by Visual Studio looks like:
-// d:\ctrl-alt-test\h2o\src\gfx\opengl\opengllayer.cpp(411): error C2220: warning treated as error - no 'object' file generated
-static void ReformatShaderCompilerMessage(char originalLog[], const char* srcInfo, size_t maxLen)
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+ReadbackID OpenGLLayer::RequestReadback(const StorageBufferID id, int offset, int size)
 {
-#if ENABLE_SHADER_COMPILER_MESSAGE_PARSING
-	char buffer[2048];
+	ASSERT(m_SSBOs.size > id.index);
+	SSBOInfo& ssboInfo = m_SSBOs[id.index];
+	ASSERT(offset >= 0 && size > 0 && offset + size <= ssboInfo.size);
 
-	if (strncmp(originalLog, "0(", 2) == 0)
+	const int index = ReserveReadback(size);
+	if (index < 0)
 	{
-		// It seems to be the NVidia message format used here:
-		// 0(97) : error C0000: syntax error, unexpected '=', expecting "::" at token "="
-		// The log starts lines with a '0', where the name of the
-		// source file should be.
-		strncpy(buffer, originalLog + 1, sizeof(buffer) - 1);
-		strcpy(originalLog, srcInfo);
-		size_t len = strlen(buffer) + strlen(srcInfo);
-		strncpy(originalLog + strlen(srcInfo), buffer, (len >= maxLen ? maxLen - 1 : len));
+		return ReadbackID::InvalidID;
 	}
-	else if (strncmp(originalLog, "(", 1) == 0)
+	Readback& readback = m_readbacks[index];
+
+	// The copy reads the buffer like a buffer update does. The writing
+	// state is kept, since shaders reading the buffer still need their
+	// own barrier.
+	if (ssboInfo.writing)
 	{
-		// It seems to be the NVidia message format used here:
-		// (1045) : error C0000: syntax error, unexpected string literal at token "<string-const>"
-		strncpy(buffer, originalLog, sizeof(buffer) - 1);
-		strcpy(originalLog, srcInfo);
-		size_t len = strlen(buffer) + strlen(srcInfo);
-		strncpy(originalLog + strlen(srcInfo), buffer, (len >= maxLen ? maxLen - 1 : len));
+		GL_CHECK(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
 	}
-	else if (strncmp(originalLog, "ERROR: 0:", 9) == 0)
+	CopyBufferObject(ssboInfo.storageBuffer, offset, readback.buffer, 0, size);
+
+	GL_CHECK(readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	ReadbackID result = { readback.request };
+	return result;
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+ReadbackID OpenGLLayer::RequestReadback(const FrameBufferID id,
+										int x, int y,
+										int width, int height)
+{
+	ASSERT(m_FBOs.size > id.index);
+	ASSERT(id.index < 0 || (x >= 0 && y >= 0 &&
+							x + width <= m_FBOs[id.index].width &&
+							y + height <= m_FBOs[id.index].height));
+	ASSERT(width > 0 && height > 0);
+
+	const int index = ReserveReadback(width * height * 4);
+	if (index < 0)
+	{
+		return ReadbackID::InvalidID;
+	}
+	Readback& readback = m_readbacks[index];
+
+	// With the pixel pack buffer bound, the pixels are written to it by
+	// the GPU, and the call returns without waiting for the rendering.
+	BindFrameBuffer(id);
+	BindBufferObject(BufferTarget::PixelPack, readback.buffer);
+	GL_CHECK(glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	BindBufferObject(BufferTarget::PixelPack, 0);
+
+	GL_CHECK(readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	ReadbackID result = { readback.request };
+	return result;
+}
+
+bool OpenGLLayer::TryGetReadback(const ReadbackID id, void* dest)
+{
+	// Invalid, or already retrieved.
+	const int index = FindReadback(id);
+	if (index < 0)
+	{
+		return false;
+	}
+	Readback& readback = m_readbacks[index];
+
+	GLenum status;
+	GL_CHECK(status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		return false;
+	}
+	GL_CHECK(glDeleteSync(readback.fence));
+	readback.fence = nullptr;
+
+	// The copy is complete, so mapping doesn't wait for anything.
+	const void* data;
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (m_useDirectStateAccess)
+	{
+		GL_CHECK(data = glMapNamedBufferRange(readback.buffer, 0, readback.size, GL_MAP_READ_BIT));
+		memcpy(dest, data, readback.size);
+		GL_CHECK(glUnmapNamedBuffer(readback.buffer));
+	}
+	else
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	{
+		BindBufferObject(BufferTarget::PixelPack, readback.buffer);
+		GL_CHECK(data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.size, GL_MAP_READ_BIT));
+		memcpy(dest, data, readback.size);
+		GL_CHECK(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+		BindBufferObject(BufferTarget::PixelPack, 0);
+	}
+
+	readback.request = -1;
+	return true;
+}
+
+// Returns the index of a free staging buffer of at least size bytes,
+// reserved for a new request, or -1 if they are all in use.
+int OpenGLLayer::ReserveReadback(int size)
+{
+	// Readbacks are usually retrieved in the order they are requested,
+	// so the next buffer of the ring is the one most likely to be free.
+	int index = -1;
+	for (int i = 0; i < GFX_READBACK_BUFFERS && index < 0; ++i)
+	{
+		const int candidate = (m_nextReadback + i) % GFX_READBACK_BUFFERS;
+		if (m_readbacks[candidate].request < 0)
+		{
+			index = candidate;
+		}
+	}
+	if (index < 0)
+	{
+		return -1;
+	}
+
+	Readback& readback = m_readbacks[index];
+	if (size > readback.capacity)
+	{
+		LoadBufferObject(BufferTarget::PixelPack, readback.buffer, size, nullptr, GL_STREAM_READ);
+		BindBufferObject(BufferTarget::PixelPack, 0);
+		readback.capacity = size;
+	}
+	readback.size = size;
+	readback.request = m_numberOfReadbackRequests;
+	m_numberOfReadbackRequests = (m_numberOfReadbackRequests + 1) & 0x7fffffff;
+	m_nextReadback = (index + 1) % GFX_READBACK_BUFFERS;
+	return index;
+}
+
+// Returns the index of the staging buffer of a readback, or -1 if it
+// was already retrieved.
+int OpenGLLayer::FindReadback(const ReadbackID id) const
+{
+	for (int i = 0; i < GFX_READBACK_BUFFERS; ++i)
+	{
+		if (m_readbacks[i].request == id.index && id.index >= 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+#if ENABLE_SHADER_COMPILATION_ERROR_CHECK
+
+// This function is a complete hack, and tries to recognize and
+// partially reformat errors from the shader compiler, so Visual Studio
+// is able to parse the first line. When it works Visual Studio can
+// then show us directly where the error is.
+//
+// The formatting used by Visual Studio looks like:
+// d:\ctrl-alt-test\h2o\src\gfx\opengl\opengllayer.cpp(411): error C2220: warning treated as error - no 'object' file generated
+static void ReformatShaderCompilerMessage(char originalLog[], const char* srcInfo, size_t maxLen)
+{
+#if ENABLE_SHADER_COMPILER_MESSAGE_PARSING
+	char buffer[2048];
+
+	if (strncmp(originalLog, "0(", 2) == 0)
+	{
+		// It seems to be the NVidia message format used here:
+		// 0(97) : error C0000: syntax error, unexpected '=', expecting "::" at token "="
+		// The log starts lines with a '0', where the name of the
+		// source file should be.
+		strncpy(buffer, originalLog + 1, sizeof(buffer) - 1);
+		strcpy(originalLog, srcInfo);
+		size_t len = strlen(buffer) + strlen(srcInfo);
+		strncpy(originalLog + strlen(srcInfo), buffer, (len >= maxLen ? maxLen - 1 : len));
+	}
+	else if (strncmp(originalLog, "(", 1) == 0)
+	{
+		// It seems to be the NVidia message format used here:
+		// (1045) : error C0000: syntax error, unexpected string literal at token "<string-const>"
+		strncpy(buffer, originalLog, sizeof(buffer) - 1);
+		strcpy(originalLog, srcInfo);
+		size_t len = strlen(buffer) + strlen(srcInfo);
+		strncpy(originalLog + strlen(srcInfo), buffer, (len >= maxLen ? maxLen - 1 : len));
+	}
+	else if (strncmp(originalLog, "ERROR: 0:", 9) == 0)
 	{
 		// It seems to be the NVidia message format used here:
 		// ERROR: 0:97: 'fragme' : undeclared identifier
@@ -752,17 +2035,19 @@ static void ReformatShaderCompilerMessage(char originalLog[], const char* srcInf
 }
 #endif // ENABLE_SHADER_COMPILATION_ERROR_CHECK
 
-GLuint CompileShader(ShaderType::Enum shaderType, const char* src, const char* srcInfo)
+// Only submits the compilation, which the driver may do in the
+// background until the status is queried.
+static GLuint SubmitShader(ShaderType::Enum shaderType, const char* src)
 {
-	if (src == nullptr)
-	{
-		return 0;
-	}
-
 	const GLuint shader = glCreateShader(shaderType);
 	GL_CHECK(glShaderSource(shader, 1, (const GLchar**)&src, nullptr));
 	GL_CHECK(glCompileShader(shader));
+	return shader;
+}
 
+static void CheckShaderCompilation(GLuint shader, const char* srcInfo)
+{
+	UNUSED_EXPR(srcInfo); // Only for the log.
 #if ENABLE_SHADER_COMPILATION_ERROR_CHECK
 	GLint wentFine = GL_TRUE;
 	GLsizei logLength = 0;
@@ -806,20 +2091,45 @@ GLuint CompileShader(ShaderType::Enum shaderType, const char* src, const char* s
 		throw new std::exception("Shader compilation failed.");
 	}
 #endif // _HAS_EXCEPTIONS
-#endif // ENABLE_SHADER_COMPILATION_ERROR_CHECK
+#else // !ENABLE_SHADER_COMPILATION_ERROR_CHECK
+	(void)shader;
+	(void)srcInfo;
+#endif // !ENABLE_SHADER_COMPILATION_ERROR_CHECK
+}
+
+GLuint CompileShader(ShaderType::Enum shaderType, const char* src, const char* srcInfo)
+{
+	if (src == nullptr)
+	{
+		return 0;
+	}
 
+	const GLuint shader = SubmitShader(shaderType, src);
+	CheckShaderCompilation(shader, srcInfo);
 	return shader;
 }
 
-GLuint CreateAndLinkProgram(const GLuint* shaders, int numShaders)
+// Same as SubmitShader, for the link.
+static GLuint SubmitProgram(const GLuint* shaders, int numShaders)
 {
 	const GLuint program = glCreateProgram();
 	for (int i = 0; i < numShaders; ++i)
 	{
 		GL_CHECK(glAttachShader(program, shaders[i]));
 	}
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	// Without the hint, the driver may not keep the binary around.
+	if (opengl_capabilities.programBinary)
+	{
+		GL_CHECK(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
 	GL_CHECK(glLinkProgram(program));
+	return program;
+}
 
+static void CheckProgramLink(GLuint program, const GLuint* shaders, int numShaders)
+{
 #if ENABLE_SHADER_COMPILATION_ERROR_CHECK
 	GLint wentFine = GL_TRUE;
 	GLsizei logsize = 0;
@@ -860,8 +2170,17 @@ GLuint CreateAndLinkProgram(const GLuint* shaders, int numShaders)
 		throw new std::exception("Shader linking failed.");
 	}
 #endif // _HAS_EXCEPTIONS
-#endif // ENABLE_SHADER_COMPILATION_ERROR_CHECK
+#else // !ENABLE_SHADER_COMPILATION_ERROR_CHECK
+	(void)program;
+	(void)shaders;
+	(void)numShaders;
+#endif // !ENABLE_SHADER_COMPILATION_ERROR_CHECK
+}
 
+GLuint CreateAndLinkProgram(const GLuint* shaders, int numShaders)
+{
+	const GLuint program = SubmitProgram(shaders, numShaders);
+	CheckProgramLink(program, shaders, numShaders);
 	return program;
 }
 
@@ -871,9 +2190,19 @@ ShaderID OpenGLLayer::CreateShader()
 	newShader.shaders[0] = 0;
 	newShader.shaders[1] = 0;
 	newShader.program = 0;
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	newShader.pending = false;
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	newShader.blockSize = 0;
+	newShader.blockRingOffset = -1;
+	newShader.blockRingGeneration = -1;
+	newShader.blockChanged = false;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 
 	// Internal resource indexing
 	m_shaders.add(newShader);
+	COUNT_FRAME_STAT(numberOfShaders, 1);
 
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 	// Initialize the array here instead of on newShader, to avoid
@@ -881,6 +2210,11 @@ ShaderID OpenGLLayer::CreateShader()
 	// The purpose of the 3x is to reduce the chances of collisions.
 	m_shaders.last().currentUniforms.init(3 * GFX_MAX_UNIFORMS);
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	// Same as above. The block data is only allocated for shaders
+	// that have a block.
+	m_shaders.last().blockUniforms.init(GFX_MAX_UNIFORMS);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 
 	ShaderID id = { m_shaders.size - 1 };
 	return id;
@@ -897,15 +2231,21 @@ void OpenGLLayer::DestroyShader(const ShaderID id)
 	shaderInfo.program = 0;
 	shaderInfo.shaders[0] = 0;
 	shaderInfo.shaders[1] = 0;
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	shaderInfo.blockUniforms.clear();
+	shaderInfo.blockSize = 0;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	shaderInfo.pending = false;
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	COUNT_FRAME_STAT(numberOfShaders, -1);
 
 	BindShader(ShaderID::InvalidID);
 }
 
-void OpenGLLayer::LoadShader(const ShaderID id,
-							 const ShaderStage* shaderStages,
-							 int numberOfStages)
+// Deletes the program and shaders of a shader about to be loaded again.
+void OpenGLLayer::ReleaseShader(const ShaderID id)
 {
-	ASSERT(m_shaders.size > id.index);
 	ShaderInfo& shaderInfo = m_shaders[id.index];
 
 	GL_CHECK(glDeleteProgram(shaderInfo.program)); // From the manual: "A value of 0 for program will be silently ignored."
@@ -919,6 +2259,38 @@ void OpenGLLayer::LoadShader(const ShaderID id,
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 	shaderInfo.currentUniforms.clear();
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	shaderInfo.blockUniforms.clear();
+	shaderInfo.blockSize = 0;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	shaderInfo.pending = false;
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+}
+
+void OpenGLLayer::LoadShader(const ShaderID id,
+							 const ShaderStage* shaderStages,
+							 int numberOfStages)
+{
+	ASSERT(m_shaders.size > id.index);
+	ReleaseShader(id);
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	unsigned long long binaryKey = 0;
+	if (m_programBinaryCache != nullptr)
+	{
+		binaryKey = ComputeProgramKey(shaderStages, numberOfStages);
+		if (LoadProgramBinary(id, binaryKey))
+		{
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+			QueryUniformBlock(id);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+			return;
+		}
+	}
+	const long long compileStart = getMicroseconds();
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
 
 	// Warning: the following functions can throw exceptions, which
 	// means shader.program and shader.shaders[x] might not be set in
@@ -929,33 +2301,329 @@ void OpenGLLayer::LoadShader(const ShaderID id,
 		shaderInfo.shaders[i] = CompileShader(stage.shaderType, stage.source, stage.sourceInfo);
 	}
 	shaderInfo.program = CreateAndLinkProgram(shaderInfo.shaders, numberOfStages);
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	if (m_programBinaryCache != nullptr)
+	{
+		StoreProgramBinary(id, binaryKey, (int)(getMicroseconds() - compileStart));
+	}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	QueryUniformBlock(id);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 }
 
-void OpenGLLayer::BindShader(const ShaderID id)
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+void OpenGLLayer::LoadShaderAsync(const ShaderID id,
+								  const ShaderStage* shaderStages,
+								  int numberOfStages)
 {
 	ASSERT(m_shaders.size > id.index);
-	const int shaderIndex = id.index;
-	if (m_currentShader.index == shaderIndex)
+	ASSERT(numberOfStages <= (int)(sizeof(m_shaders[id.index].shaders) / sizeof(m_shaders[id.index].shaders[0])));
+	ReleaseShader(id);
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	shaderInfo.binaryKey = 0;
+	if (m_programBinaryCache != nullptr)
+	{
+		const unsigned long long binaryKey = ComputeProgramKey(shaderStages, numberOfStages);
+		if (LoadProgramBinary(id, binaryKey))
+		{
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+			QueryUniformBlock(id);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+			return;
+		}
+		shaderInfo.binaryKey = binaryKey;
+		shaderInfo.submitTime = getMicroseconds();
+	}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+	// Nothing is checked until FinishLoadingShader, so the driver
+	// doesn't have to wait for the compilation.
+	for (int i = 0; i < numberOfStages; ++i)
+	{
+		const ShaderStage& stage = shaderStages[i];
+		shaderInfo.shaders[i] = (stage.source != nullptr ? SubmitShader(stage.shaderType, stage.source) : 0);
+		shaderInfo.sourceInfo[i] = stage.sourceInfo;
+	}
+	shaderInfo.program = SubmitProgram(shaderInfo.shaders, numberOfStages);
+	shaderInfo.numberOfStages = numberOfStages;
+	shaderInfo.pending = true;
+}
+
+bool OpenGLLayer::IsShaderReady(const ShaderID id)
+{
+	ASSERT(m_shaders.size > id.index);
+	const ShaderInfo& shaderInfo = m_shaders[id.index];
+	if (!shaderInfo.pending)
+	{
+		return true;
+	}
+
+	// Without GL_KHR_parallel_shader_compile, there is no way to know
+	// without waiting.
+	if (m_parallelShaderCompile)
+	{
+		GLint completed = GL_FALSE;
+		GL_CHECK(glGetProgramiv(shaderInfo.program, GL_COMPLETION_STATUS_KHR, &completed));
+		if (completed != GL_TRUE)
+		{
+			return false;
+		}
+	}
+	FinishLoadingShader(id);
+	return true;
+}
+
+// Checks the result of LoadShaderAsync, waiting for the driver if it is
+// not done yet.
+void OpenGLLayer::FinishLoadingShader(const ShaderID id)
+{
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+	shaderInfo.pending = false;
+	for (int i = 0; i < shaderInfo.numberOfStages; ++i)
+	{
+		if (shaderInfo.shaders[i] != 0)
+		{
+			CheckShaderCompilation(shaderInfo.shaders[i], shaderInfo.sourceInfo[i]);
+		}
+	}
+	CheckProgramLink(shaderInfo.program, shaderInfo.shaders, shaderInfo.numberOfStages);
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	// The compilation time includes the time the shader waited to be
+	// checked, so it's only an upper bound.
+	if (m_programBinaryCache != nullptr && shaderInfo.binaryKey != 0)
+	{
+		StoreProgramBinary(id, shaderInfo.binaryKey, (int)(getMicroseconds() - shaderInfo.submitTime));
+	}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	QueryUniformBlock(id);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+void OpenGLLayer::SetProgramBinaryCache(ProgramBinaryCache* cache)
+{
+	m_programBinaryCache = nullptr;
+	if (cache == nullptr)
 	{
 		return;
 	}
+	if (!opengl_capabilities.programBinary)
+	{
+		LOG_INFO("Program binaries are not supported, shaders will always be compiled.");
+		return;
+	}
+	m_programBinaryCache = cache;
 
-	if (shaderIndex >= 0)
+	// A binary is only valid for the driver that produced it.
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	m_driverHash = 0;
+	for (int i = 0; i < (int)(sizeof(driverStrings) / sizeof(driverStrings[0])); ++i)
 	{
-		GL_CHECK(glUseProgram(m_shaders[shaderIndex].program));
+		const char* driverString;
+		GL_CHECK(driverString = (const char*)glGetString(driverStrings[i]));
+		if (driverString != nullptr)
+		{
+			m_driverHash = ProgramBinaryCache::Hash(driverString, (int)strlen(driverString) + 1, m_driverHash);
+		}
 	}
-	else
+}
+
+unsigned long long OpenGLLayer::ComputeProgramKey(const ShaderStage* shaderStages,
+												  int numberOfStages) const
+{
+	unsigned long long key = m_driverHash;
+	for (int i = 0; i < numberOfStages; ++i)
+	{
+		const ShaderStage& stage = shaderStages[i];
+		const int shaderType = stage.shaderType;
+		key = ProgramBinaryCache::Hash(&shaderType, sizeof(shaderType), key);
+		if (stage.source != nullptr)
+		{
+			key = ProgramBinaryCache::Hash(stage.source, (int)strlen(stage.source) + 1, key);
+		}
+	}
+	return key;
+}
+
+// Creates the program from the cached binary, if there is one and the
+// driver accepts it.
+bool OpenGLLayer::LoadProgramBinary(const ShaderID id, unsigned long long key)
+{
+	int size = 0;
+	unsigned int format = 0;
+	const void* binary = m_programBinaryCache->Find(key, &size, &format);
+	if (binary == nullptr)
+	{
+		return false;
+	}
+
+	const long long loadStart = getMicroseconds();
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+	GL_CHECK(shaderInfo.program = glCreateProgram());
+	GL_CHECK(glProgramBinary(shaderInfo.program, format, binary, size));
+
+	GLint linked = GL_FALSE;
+	GL_CHECK(glGetProgramiv(shaderInfo.program, GL_LINK_STATUS, &linked));
+	if (linked != GL_TRUE)
 	{
-		GL_CHECK(glUseProgram(0));
+		LOG_INFO("Program binary refused by the driver, compiling the shader instead.");
+		GL_CHECK(glDeleteProgram(shaderInfo.program));
+		shaderInfo.program = 0;
+		m_programBinaryCache->ReportRejected(key);
+		return false;
+	}
+
+	m_programBinaryCache->ReportLoaded(key, (int)(getMicroseconds() - loadStart));
+	return true;
+}
+
+void OpenGLLayer::StoreProgramBinary(const ShaderID id, unsigned long long key,
+									 int compileTime)
+{
+	const GLuint program = m_shaders[id.index].program;
+	GLint linked = GL_FALSE;
+	GLint size = 0;
+	GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	GL_CHECK(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size));
+	if (linked != GL_TRUE || size <= 0)
+	{
+		return;
+	}
+
+	char* binary = new char[size];
+	GLsizei length = 0;
+	GLenum format = 0;
+	GL_CHECK(glGetProgramBinary(program, size, &length, &format, binary));
+	if (length > 0)
+	{
+		m_programBinaryCache->Store(key, format, binary, length, compileTime);
+	}
+	delete[] binary;
+}
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+// The types of block members the ring can write: the same as the plain
+// uniforms.
+static bool GetBlockUniformType(GLenum glType, UniformType::Enum* type, int* components)
+{
+	switch (glType)
+	{
+	case GL_FLOAT:		*type = UniformType::Float; *components = 1; return true;
+	case GL_FLOAT_VEC2:	*type = UniformType::Float; *components = 2; return true;
+	case GL_FLOAT_VEC3:	*type = UniformType::Float; *components = 3; return true;
+	case GL_FLOAT_VEC4:	*type = UniformType::Float; *components = 4; return true;
+	case GL_FLOAT_MAT4:	*type = UniformType::Float; *components = 16; return true;
+	case GL_INT:		*type = UniformType::Int; *components = 1; return true;
+	case GL_INT_VEC2:	*type = UniformType::Int; *components = 2; return true;
+	case GL_INT_VEC3:	*type = UniformType::Int; *components = 3; return true;
+	case GL_INT_VEC4:	*type = UniformType::Int; *components = 4; return true;
+	default:			return false;
+	}
+}
+
+// Queries the layout of the block that goes through the ring.
+void OpenGLLayer::QueryUniformBlock(const ShaderID id)
+{
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+	const GLuint program = shaderInfo.program;
+	GLuint blockIndex;
+	GL_CHECK(blockIndex = glGetUniformBlockIndex(program, UNIFORM_RING_BLOCK_NAME));
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		GLint blockSize = 0;
+		GLint numberOfUniforms = 0;
+		GL_CHECK(glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize));
+		GL_CHECK(glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &numberOfUniforms));
+		ASSERT(blockSize <= (GLint)MAX_UNIFORM_BLOCK_SIZE);
+		ASSERT(blockSize <= GFX_UNIFORM_BUFFER_RING_SIZE);
+		ASSERT(numberOfUniforms <= GFX_MAX_UNIFORMS);
+
+		GLint uniformIndices[GFX_MAX_UNIFORMS];
+		GLint uniformOffsets[GFX_MAX_UNIFORMS];
+		GLint uniformTypes[GFX_MAX_UNIFORMS];
+		GLint uniformSizes[GFX_MAX_UNIFORMS];
+		GLint uniformArrayStrides[GFX_MAX_UNIFORMS];
+		GL_CHECK(glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, uniformIndices));
+		GL_CHECK(glGetActiveUniformsiv(program, numberOfUniforms, (const GLuint*)uniformIndices, GL_UNIFORM_OFFSET, uniformOffsets));
+		GL_CHECK(glGetActiveUniformsiv(program, numberOfUniforms, (const GLuint*)uniformIndices, GL_UNIFORM_TYPE, uniformTypes));
+		GL_CHECK(glGetActiveUniformsiv(program, numberOfUniforms, (const GLuint*)uniformIndices, GL_UNIFORM_SIZE, uniformSizes));
+		GL_CHECK(glGetActiveUniformsiv(program, numberOfUniforms, (const GLuint*)uniformIndices, GL_UNIFORM_ARRAY_STRIDE, uniformArrayStrides));
+		for (int i = 0; i < numberOfUniforms; ++i)
+		{
+			ShaderInfo::BlockUniform blockUniform;
+			GLsizei length = 0;
+			GL_CHECK(glGetActiveUniformName(program, uniformIndices[i], sizeof(blockUniform.name), &length, blockUniform.name));
+			if (length + 1 >= (GLsizei)sizeof(blockUniform.name))
+			{
+				LOG_ERROR("Uniform name too long, it may be truncated: %s.", blockUniform.name);
+			}
+			if (!GetBlockUniformType(uniformTypes[i], &blockUniform.type, &blockUniform.components))
+			{
+				// The member keeps its zero value.
+				LOG_ERROR("Uniform type not supported in " UNIFORM_RING_BLOCK_NAME ": %s.", blockUniform.name);
+				continue;
+			}
+
+			// Arrays are reported with the name of their first element.
+			if (length > 3 && strcmp(blockUniform.name + length - 3, "[0]") == 0)
+			{
+				blockUniform.name[length - 3] = '\0';
+			}
+			blockUniform.lastName = nullptr;
+			blockUniform.offset = uniformOffsets[i];
+			blockUniform.arrayStride = uniformArrayStrides[i];
+			blockUniform.arraySize = uniformSizes[i];
+			shaderInfo.blockUniforms.add(blockUniform);
+		}
+
+		if (shaderInfo.blockData.elt == nullptr)
+		{
+			shaderInfo.blockData.init(MAX_UNIFORM_BLOCK_SIZE);
+		}
+		memset(shaderInfo.blockData.elt, 0, blockSize);
+		shaderInfo.blockSize = blockSize;
+		shaderInfo.blockChanged = true;
+
+		GL_CHECK(glUniformBlockBinding(program, blockIndex, UNIFORM_RING_BINDING));
 	}
+}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
+void OpenGLLayer::BindShader(const ShaderID id)
+{
+	ASSERT(m_shaders.size > id.index);
+	const int shaderIndex = id.index;
 	m_currentShader.index = shaderIndex;
+
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+	if (shaderIndex >= 0 && m_shaders[shaderIndex].pending)
+	{
+		FinishLoadingShader(id);
+	}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+	// Comparing programs rather than shader ids also catches a shader
+	// reloaded while in use.
+	const GLuint program = (shaderIndex >= 0 ? m_shaders[shaderIndex].program : 0);
+	if (m_boundProgram != program)
+	{
+		GL_CHECK(glUseProgram(program));
+		m_boundProgram = program;
+		COUNT_FRAME_STAT(shaderChanges, 1);
+	}
 }
 
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
-//int uniformBindingsAvoided = 0;
-//int uniformBindingsUpdated = 0;
-//int uniformBindingsSet = 0;
-
 #if GFX_HASH_UNIFORM_VALUE
 bool SkipBindUniform(Container::HashTable<const char*, unsigned int>& currentlyBoundUniforms,
 					 const Uniform& uniform)
@@ -1044,6 +2712,10 @@ void OpenGLLayer::BindUniforms(const Uniform* uniforms, int numberOfUniforms)
 #endif // !GFX_HASH_UNIFORM_VALUE
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+		const bool hasUniformBlock = (m_shaders[m_currentShader.index].blockSize > 0);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
 		int textureSlot = 0;
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		int uniformBufferSlot = 0;
@@ -1059,13 +2731,38 @@ void OpenGLLayer::BindUniforms(const Uniform* uniforms, int numberOfUniforms)
 				continue;
 			}
 
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+			if (hasUniformBlock && SetBlockUniform(m_currentShader, uniform))
+			{
+				continue;
+			}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 			if (SkipBindUniform(currentlyBoundUniforms, uniform))
 			{
+				// The value belongs to the program, but the slots are
+				// shared with the other programs, so what is bound to
+				// them may have changed since.
+				COUNT_FRAME_STAT(uniformBindsAvoided, 1);
 				if (uniform.type == UniformType::Sampler)
 				{
 					BindTexture(uniform.textureId, textureSlot++);
 				}
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+				else if (uniform.type == UniformType::UniformBuffer)
+				{
+					BindUniformBuffer(uniform.uniformBufferId, program, uniformBufferSlot++, uniform.name);
+				}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+				else if (uniform.type == UniformType::StorageBufferInput ||
+						 uniform.type == UniformType::StorageBufferOutput)
+				{
+					const bool writing = (uniform.type == UniformType::StorageBufferOutput);
+					BindStorageBuffer(uniform.storageBufferId, program, storageBufferSlot++, uniform.name, writing);
+				}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 				continue;
 			}
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
@@ -1073,6 +2770,7 @@ void OpenGLLayer::BindUniforms(const Uniform* uniforms, int numberOfUniforms)
 			GLint location;
 			GL_CHECK(location = glGetUniformLocation(program, uniform.name));
 			ASSERT(uniform.size > 0 && uniform.size <= 16);
+			COUNT_FRAME_STAT(uniformBindsIssued, 1);
 
 			switch (uniform.type)
 			{
@@ -1131,25 +2829,171 @@ void OpenGLLayer::BindUniforms(const Uniform* uniforms, int numberOfUniforms)
 				break;
 			}
 		}
-	}
-}
+
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+		if (hasUniformBlock)
+		{
+			BindUniformBlock(m_currentShader);
+		}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+	}
+}
+
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+bool OpenGLLayer::SetBlockUniform(const ShaderID id, const Uniform& uniform)
+{
+	if (uniform.type != UniformType::Float && uniform.type != UniformType::Int)
+	{
+		return false;
+	}
+
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+	for (int i = 0; i < shaderInfo.blockUniforms.size; ++i)
+	{
+		ShaderInfo::BlockUniform& blockUniform = shaderInfo.blockUniforms[i];
+		if (blockUniform.lastName != uniform.name)
+		{
+			if (strcmp(blockUniform.name, uniform.name) != 0)
+			{
+				continue;
+			}
+			blockUniform.lastName = uniform.name;
+		}
+
+		// Floats and ints have the same size, and std140 lays out
+		// vectors and 4x4 matrices without padding. The elements of
+		// an array are padded though, so a value spanning several
+		// elements is copied one element at a time.
+		ASSERT(uniform.type == blockUniform.type);
+		ASSERT(uniform.size % blockUniform.components == 0);
+		const int numberOfElements = uniform.size / blockUniform.components;
+		ASSERT(numberOfElements <= blockUniform.arraySize);
+		const int elementSize = blockUniform.components * sizeof(float);
+		for (int element = 0; element < numberOfElements; ++element)
+		{
+			const int offset = blockUniform.offset + element * blockUniform.arrayStride;
+			ASSERT(offset + elementSize <= shaderInfo.blockSize);
+			unsigned char* dest = shaderInfo.blockData.elt + offset;
+			const float* src = uniform.fValue + element * blockUniform.components;
+			if (memcmp(dest, src, elementSize) != 0)
+			{
+				memcpy(dest, src, elementSize);
+				shaderInfo.blockChanged = true;
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+void OpenGLLayer::BindUniformBlock(const ShaderID id)
+{
+	ShaderInfo& shaderInfo = m_shaders[id.index];
+	if (!shaderInfo.blockChanged &&
+		shaderInfo.blockRingGeneration == m_uniformRingGeneration)
+	{
+		// The block is still in the ring, it only needs binding.
+		if (m_uniformRingBoundOffset != shaderInfo.blockRingOffset)
+		{
+			GL_CHECK(glBindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_RING_BINDING, m_uniformRing,
+									   shaderInfo.blockRingOffset, shaderInfo.blockSize));
+			m_boundBuffers[BufferTarget::Uniform] = m_uniformRing;
+			m_uniformRingBoundOffset = shaderInfo.blockRingOffset;
+		}
+		return;
+	}
+
+	int offset = m_uniformRingAlignment * ((m_uniformRingOffset + m_uniformRingAlignment - 1) / m_uniformRingAlignment);
+	if (offset + shaderInfo.blockSize > GFX_UNIFORM_BUFFER_RING_SIZE)
+	{
+		RecycleUniformRing();
+		offset = 0;
+	}
+
+	// glBindBufferRange also binds the ring to GL_UNIFORM_BUFFER,
+	// which is where glBufferSubData writes.
+	GL_CHECK(glBindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_RING_BINDING, m_uniformRing,
+							   offset, shaderInfo.blockSize));
+	m_boundBuffers[BufferTarget::Uniform] = m_uniformRing;
+	GL_CHECK(glBufferSubData(GL_UNIFORM_BUFFER, offset, shaderInfo.blockSize, shaderInfo.blockData.elt));
+	COUNT_FRAME_STAT(bytesUploaded, shaderInfo.blockSize);
+
+	m_uniformRingOffset = offset + shaderInfo.blockSize;
+	m_uniformRingBoundOffset = offset;
+	shaderInfo.blockRingOffset = offset;
+	shaderInfo.blockRingGeneration = m_uniformRingGeneration;
+	shaderInfo.blockChanged = false;
+}
+
+// Replaces the storage of the ring with a new one, so it can be written
+// from the start without waiting for the draws still reading it.
+void OpenGLLayer::RecycleUniformRing()
+{
+	LoadBufferObject(BufferTarget::Uniform, m_uniformRing, GFX_UNIFORM_BUFFER_RING_SIZE, nullptr, GL_STREAM_DRAW);
+	m_uniformRingOffset = 0;
+	m_uniformRingBoundOffset = -1;
+	++m_uniformRingGeneration;
+}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 
 FrameBufferID OpenGLLayer::CreateFrameBuffer(const TextureID* textures,
 											 int numberOfTextures,
 											 int side, int lodLevel)
 {
-	ASSERT(textures != nullptr && numberOfTextures > 0);
-
 	FBOInfo newFBO;
-	newFBO.width = m_textures[textures[0].index].width;
-	newFBO.height = m_textures[textures[0].index].height;
+	newFBO.frameBuffer = 0;
+	newFBO.width = 0;
+	newFBO.height = 0;
+	m_FBOs.add(newFBO);
+	COUNT_FRAME_STAT(numberOfFrameBuffers, 1);
 
-	int frameBufferToRestore = 0;
-	GL_CHECK(glGetIntegerv(GL_FRAMEBUFFER_BINDING, &frameBufferToRestore));
+	FrameBufferID id = { m_FBOs.size - 1 };
+	LoadFrameBuffer(id, textures, numberOfTextures, side, lodLevel);
+	return id;
+}
 
-	GL_CHECK(glGenFramebuffers(1, &newFBO.frameBuffer));
-	GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, newFBO.frameBuffer));
-	m_currentFrameBuffer.index = m_FBOs.size - 1;
+void OpenGLLayer::LoadFrameBuffer(const FrameBufferID id,
+								  const TextureID* textures,
+								  int numberOfTextures,
+								  int side, int lodLevel)
+{
+	ASSERT(textures != nullptr && numberOfTextures > 0);
+	ASSERT(m_FBOs.size > id.index);
+
+	// The previous attachments may not all be replaced, so a new frame
+	// buffer object is made rather than detaching them one by one.
+	FBOInfo& fboInfo = m_FBOs[id.index];
+	if (fboInfo.frameBuffer != 0)
+	{
+		GL_CHECK(glDeleteFramebuffers(1, &fboInfo.frameBuffer));
+		if (m_boundFrameBuffer == fboInfo.frameBuffer)
+		{
+			m_boundFrameBuffer = 0;
+		}
+	}
+	fboInfo.width = m_textures[textures[0].index].width;
+	fboInfo.height = m_textures[textures[0].index].height;
+#if GFX_ENABLE_RENDER_PASSES
+	ASSERT(numberOfTextures <= MaxFrameBufferAttachments);
+	fboInfo.numberOfAttachments = numberOfTextures;
+#endif // GFX_ENABLE_RENDER_PASSES
+
+	// Without direct state access, the frame buffer is left bound.
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	const bool direct = m_useDirectStateAccess;
+#else // !GFX_ENABLE_DIRECT_STATE_ACCESS
+	const bool direct = false;
+#endif // !GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (direct)
+	{
+		GL_CHECK(glCreateFramebuffers(1, &fboInfo.frameBuffer));
+	}
+	else
+	{
+		GL_CHECK(glGenFramebuffers(1, &fboInfo.frameBuffer));
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, fboInfo.frameBuffer));
+		m_boundFrameBuffer = fboInfo.frameBuffer;
+	}
 
 	GLenum buffers[MAX_MRT];
 	int numberOfBuffers = 0;
@@ -1157,7 +3001,7 @@ FrameBufferID OpenGLLayer::CreateFrameBuffer(const TextureID* textures,
 	for (int i = 0; i < numberOfTextures; ++i)
 	{
 		const TextureInfo& textureInfo = m_textures[textures[i].index];
-		ASSERT(textureInfo.width == newFBO.width && textureInfo.height == newFBO.height);
+		ASSERT(textureInfo.width == fboInfo.width && textureInfo.height == fboInfo.height);
 
 		GLenum attachment = GL_COLOR_ATTACHMENT0 + i;
 		switch (textureInfo.format)
@@ -1169,7 +3013,26 @@ FrameBufferID OpenGLLayer::CreateFrameBuffer(const TextureID* textures,
 			ASSERT(numberOfBuffers < MAX_MRT);
 			buffers[numberOfBuffers++] = attachment;
 		}
+#if GFX_ENABLE_RENDER_PASSES
+		fboInfo.attachments[i] = attachment;
+#endif // GFX_ENABLE_RENDER_PASSES
 
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+		if (direct)
+		{
+			if (textureInfo.type == GL_TEXTURE_CUBE_MAP)
+			{
+				GL_CHECK(glNamedFramebufferTextureLayer(fboInfo.frameBuffer, attachment,
+														textureInfo.texture, lodLevel, side));
+			}
+			else
+			{
+				GL_CHECK(glNamedFramebufferTexture(fboInfo.frameBuffer, attachment,
+												   textureInfo.texture, lodLevel));
+			}
+			continue;
+		}
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
 		if (textureInfo.type == GL_TEXTURE_CUBE_MAP)
 		{
 			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, attachment,
@@ -1185,10 +3048,25 @@ FrameBufferID OpenGLLayer::CreateFrameBuffer(const TextureID* textures,
 	}
 	// According to the OpenGL 3.3 spec, the buffer selection state is per
 	// frame buffer.
-	GL_CHECK(glDrawBuffers(numberOfBuffers, buffers));
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	if (direct)
+	{
+		GL_CHECK(glNamedFramebufferDrawBuffers(fboInfo.frameBuffer, numberOfBuffers, buffers));
+	}
+	else
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+	{
+		GL_CHECK(glDrawBuffers(numberOfBuffers, buffers));
+	}
 
 #if DEBUG
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+	const GLenum status = (direct ?
+						   glCheckNamedFramebufferStatus(fboInfo.frameBuffer, GL_FRAMEBUFFER) :
+						   glCheckFramebufferStatus(GL_FRAMEBUFFER));
+#else // !GFX_ENABLE_DIRECT_STATE_ACCESS
 	const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+#endif // !GFX_ENABLE_DIRECT_STATE_ACCESS
 	ASSERT(status != GL_FRAMEBUFFER_UNDEFINED);
 	ASSERT(status != GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT);
 	ASSERT(status != GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT);
@@ -1201,17 +3079,17 @@ FrameBufferID OpenGLLayer::CreateFrameBuffer(const TextureID* textures,
 
 	ASSERT(status == GL_FRAMEBUFFER_COMPLETE);
 #endif
-
-	m_FBOs.add(newFBO);
-
-	FrameBufferID id = { m_FBOs.size - 1 };
-	return id;
 }
 
 void OpenGLLayer::DestroyFrameBuffer(const FrameBufferID id)
 {
 	GL_CHECK(glDeleteFramebuffers(1, &m_FBOs[id.index].frameBuffer));
+	if (m_boundFrameBuffer == m_FBOs[id.index].frameBuffer)
+	{
+		m_boundFrameBuffer = 0;
+	}
 	m_FBOs[id.index].frameBuffer = 0;
+	COUNT_FRAME_STAT(numberOfFrameBuffers, -1);
 }
 
 void OpenGLLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
@@ -1222,7 +3100,8 @@ void OpenGLLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
 
 	GL_CHECK(glClearColor(r, g, b, 0.0f));
 #if GFX_ENABLE_SCISSOR_TESTING
-	GL_CHECK(glDisable(GL_SCISSOR_TEST));
+	SetCapability(Capability::ScissorTest, false);
+	m_currentRasterTests.scissorTestEnabled = false;
 #endif // GFX_ENABLE_SCISSOR_TESTING
 
 #if GFX_ENABLE_DEPTH_TESTING
@@ -1239,24 +3118,151 @@ void OpenGLLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
 	}
 }
 
-void OpenGLLayer::BindFrameBuffer(const FrameBufferID id)
+#if GFX_ENABLE_RENDER_PASSES
+// The default frame buffer has no textures: its attachments are the
+// color buffer, then depth and stencil.
+static const GLenum defaultFrameBufferAttachments[] = { GL_COLOR_ATTACHMENT0, GL_DEPTH_STENCIL_ATTACHMENT };
+
+// glInvalidateFramebuffer names the buffers of the default frame
+// buffer differently, and depth and stencil separately.
+static int getInvalidatedBuffers(const FrameBufferID id, GLenum attachment, GLenum* buffers)
 {
-	ASSERT(m_FBOs.size > id.index);
-	const int frameBufferIndex = id.index;
-	if (m_currentFrameBuffer.index == frameBufferIndex)
+	if (id.index >= 0)
+	{
+		buffers[0] = attachment;
+		return 1;
+	}
+	if (attachment == GL_COLOR_ATTACHMENT0)
+	{
+		buffers[0] = GL_COLOR;
+		return 1;
+	}
+	buffers[0] = GL_DEPTH;
+	buffers[1] = GL_STENCIL;
+	return 2;
+}
+
+void OpenGLLayer::BeginRenderPass(const FrameBufferID id,
+								  const LoadOp::Enum* loadOps,
+								  const ClearValue* clearValues,
+								  int numberOfAttachments)
+{
+	ASSERT(!m_inRenderPass);
+	ASSERT(loadOps != nullptr);
+	ASSERT(numberOfAttachments == (id.index >= 0 ? m_FBOs[id.index].numberOfAttachments : 2));
+	const GLenum* attachments = (id.index >= 0 ? m_FBOs[id.index].attachments : defaultFrameBufferAttachments);
+
+	m_inRenderPass = true;
+	m_renderPassFrameBuffer = id;
+	BindFrameBuffer(id);
+
+	// The attachments the pass overwrites don't need to be loaded,
+	// which is what invalidating them tells the driver.
+	GLenum invalidatedBuffers[MaxFrameBufferAttachments + 1];
+	int numberOfInvalidatedBuffers = 0;
+	bool clear = false;
+	for (int i = 0; i < numberOfAttachments; ++i)
+	{
+		if (loadOps[i] == LoadOp::DontCare)
+		{
+			numberOfInvalidatedBuffers += getInvalidatedBuffers(id, attachments[i], invalidatedBuffers + numberOfInvalidatedBuffers);
+		}
+		clear = clear || (loadOps[i] == LoadOp::Clear);
+	}
+	if (numberOfInvalidatedBuffers > 0 && m_useInvalidateFramebuffer)
+	{
+		GL_CHECK(glInvalidateFramebuffer(GL_FRAMEBUFFER, numberOfInvalidatedBuffers, invalidatedBuffers));
+	}
+	if (!clear)
 	{
 		return;
 	}
+	ASSERT(clearValues != nullptr);
 
-	if (frameBufferIndex >= 0)
+	// Clears are limited by the scissor box, and the depth write mask.
+#if GFX_ENABLE_SCISSOR_TESTING
+	SetCapability(Capability::ScissorTest, false);
+	m_currentRasterTests.scissorTestEnabled = false;
+#endif // GFX_ENABLE_SCISSOR_TESTING
+
+	// Color attachments are cleared by their index in the draw buffers,
+	// which skips depth and stencil.
+	int drawBuffer = 0;
+	for (int i = 0; i < numberOfAttachments; ++i)
 	{
-		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_FBOs[frameBufferIndex].frameBuffer));
+		const GLenum attachment = attachments[i];
+		const bool depth = (attachment == GL_DEPTH_ATTACHMENT || attachment == GL_DEPTH_STENCIL_ATTACHMENT);
+		const bool stencil = (attachment == GL_STENCIL_ATTACHMENT || attachment == GL_DEPTH_STENCIL_ATTACHMENT);
+		if (loadOps[i] == LoadOp::Clear)
+		{
+#if GFX_ENABLE_DEPTH_TESTING
+			if (depth)
+			{
+				m_currentRasterTests.depthWrite = true;
+				GL_CHECK(glDepthMask(GL_TRUE));
+			}
+#endif // GFX_ENABLE_DEPTH_TESTING
+			const ClearValue& clearValue = clearValues[i];
+			if (depth && stencil)
+			{
+				GL_CHECK(glClearBufferfi(GL_DEPTH_STENCIL, 0, clearValue.depth, clearValue.stencil));
+			}
+			else if (depth)
+			{
+				GL_CHECK(glClearBufferfv(GL_DEPTH, 0, &clearValue.depth));
+			}
+			else if (stencil)
+			{
+				GL_CHECK(glClearBufferiv(GL_STENCIL, 0, &clearValue.stencil));
+			}
+			else
+			{
+				GL_CHECK(glClearBufferfv(GL_COLOR, drawBuffer, clearValue.color));
+			}
+		}
+		drawBuffer += (depth || stencil ? 0 : 1);
 	}
-	else
+}
+
+void OpenGLLayer::EndRenderPass(const StoreOp::Enum* storeOps,
+								int numberOfAttachments)
+{
+	ASSERT(m_inRenderPass);
+	ASSERT(storeOps != nullptr);
+	const FrameBufferID id = m_renderPassFrameBuffer;
+	ASSERT(numberOfAttachments == (id.index >= 0 ? m_FBOs[id.index].numberOfAttachments : 2));
+	const GLenum* attachments = (id.index >= 0 ? m_FBOs[id.index].attachments : defaultFrameBufferAttachments);
+
+	m_inRenderPass = false;
+
+	GLenum invalidatedBuffers[MaxFrameBufferAttachments + 1];
+	int numberOfInvalidatedBuffers = 0;
+	for (int i = 0; i < numberOfAttachments; ++i)
+	{
+		if (storeOps[i] == StoreOp::DontCare)
+		{
+			numberOfInvalidatedBuffers += getInvalidatedBuffers(id, attachments[i], invalidatedBuffers + numberOfInvalidatedBuffers);
+		}
+	}
+	if (numberOfInvalidatedBuffers > 0 && m_useInvalidateFramebuffer)
+	{
+		BindFrameBuffer(id);
+		GL_CHECK(glInvalidateFramebuffer(GL_FRAMEBUFFER, numberOfInvalidatedBuffers, invalidatedBuffers));
+	}
+}
+#endif // GFX_ENABLE_RENDER_PASSES
+
+void OpenGLLayer::BindFrameBuffer(const FrameBufferID id)
+{
+	ASSERT(m_FBOs.size > id.index);
+	const int frameBufferIndex = id.index;
+	const GLuint frameBuffer = (frameBufferIndex >= 0 ? m_FBOs[frameBufferIndex].frameBuffer : 0);
+	if (m_boundFrameBuffer != frameBuffer)
 	{
-		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer));
+		m_boundFrameBuffer = frameBuffer;
+		COUNT_FRAME_STAT(frameBufferChanges, 1);
 	}
-	m_currentFrameBuffer.index = frameBufferIndex;
 }
 
 void OpenGLLayer::Draw(const DrawArea& drawArea,
@@ -1274,27 +3280,213 @@ void OpenGLLayer::Draw(const DrawArea& drawArea,
 		rasterTests,
 		shadingParameters.blendingMode);
 
-	GL_CHECK(glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS));
+	SetCapability(Capability::TextureCubeMapSeamless, true);
 
-	if (geometry.vertexBuffer.index >= 0)
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	DrawVertexBuffer(geometry.vertexBuffer, geometry.numberOfIndices,
+					 geometry.firstIndexOffset, geometry.baseVertex,
+					 shadingParameters.numberOfInstances);
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	DrawVertexBuffer(geometry.vertexBuffer, geometry.numberOfIndices,
+					 0, 0, shadingParameters.numberOfInstances);
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+}
+
+// Issues the draw call, once the vertex buffer and the state are bound.
+void OpenGLLayer::DrawVertexBuffer(const VertexBufferID id,
+								   int numberOfIndices,
+								   int firstIndexOffset, int baseVertex,
+								   int numberOfInstances)
+{
+	if (id.index < 0)
 	{
+		return;
+	}
+
+	const VBOInfo& vboInfo = m_VBOs[id.index];
 #if GFX_ENABLE_VERTEX_BUFFER_OFFSET
-		const int firstIndexOffset = geometry.firstIndexOffset;
+	if (vboInfo.indexed)
+	{
+		GL_CHECK(glDrawElementsInstancedBaseVertex(vboInfo.primitiveType, numberOfIndices, vboInfo.indexType, (void*)(size_t)firstIndexOffset, numberOfInstances, baseVertex));
+	}
+	else
+	{
+		GL_CHECK(glDrawArraysInstanced(vboInfo.primitiveType, baseVertex, numberOfIndices, numberOfInstances));
+	}
 #else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
-		const int firstIndexOffset = 0;
+	ASSERT(firstIndexOffset == 0 && baseVertex == 0);
+	UNUSED_EXPR(firstIndexOffset);
+	UNUSED_EXPR(baseVertex);
+	if (vboInfo.indexed)
+	{
+		GL_CHECK(glDrawElementsInstanced(vboInfo.primitiveType, numberOfIndices, vboInfo.indexType, nullptr, numberOfInstances));
+	}
+	else
+	{
+		GL_CHECK(glDrawArraysInstanced(vboInfo.primitiveType, 0, numberOfIndices, numberOfInstances));
+	}
 #endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	COUNT_FRAME_STAT(numberOfDraws, 1);
+	COUNT_FRAME_STAT(numberOfInstances, numberOfInstances);
+	COUNT_FRAME_STAT(numberOfTriangles, numberOfInstances * getNumberOfTriangles(vboInfo.primitiveType, numberOfIndices));
+}
 
-		const VBOInfo& vboInfo = m_VBOs[geometry.vertexBuffer.index];
-		if (vboInfo.indexed)
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+void OpenGLLayer::Draw(const DrawArea& drawArea,
+					   const RasterTests& rasterTests,
+					   const DrawBatch& batch,
+					   const ShadingParameters& shadingParameters)
+{
+	if (batch.items.size == 0)
+	{
+		return;
+	}
+
+	BindVertexBuffer(batch.vertexBuffer);
+	BindShader(shadingParameters.shader);
+	BindUniforms(shadingParameters.uniforms.elt, shadingParameters.uniforms.size);
+	BindFrameBuffer(drawArea.frameBuffer);
+
+	SetRasterizerState(drawArea.viewport,
+		shadingParameters.polygonMode,
+		rasterTests,
+		shadingParameters.blendingMode);
+
+	SetCapability(Capability::TextureCubeMapSeamless, true);
+
+	const VBOInfo& vboInfo = m_VBOs[batch.vertexBuffer.index];
+	ASSERT(vboInfo.indexed);
+	const int indexSize = (vboInfo.indexType == GL_UNSIGNED_BYTE ? 1 :
+						   vboInfo.indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+
+	m_indirectCommands.clear();
+	for (int i = 0; i < batch.items.size; ++i)
+	{
+		const DrawBatch::Item& item = batch.items[i];
+		ASSERT(item.firstIndexOffset % indexSize == 0);
+
+		DrawElementsIndirectCommand& command = m_indirectCommands.getNew();
+		command.count = item.numberOfIndices;
+		command.instanceCount = item.numberOfInstances;
+		command.firstIndex = item.firstIndexOffset / indexSize;
+		command.baseVertex = item.baseVertex;
+		command.baseInstance = 0;
+		COUNT_FRAME_STAT(numberOfInstances, item.numberOfInstances);
+		COUNT_FRAME_STAT(numberOfTriangles, item.numberOfInstances * getNumberOfTriangles(vboInfo.primitiveType, item.numberOfIndices));
+	}
+
+	// Specifying the storage again orphans the previous one, which the
+	// previous batch may still be reading from, instead of waiting for
+	// that draw to be done.
+	const int commandsSize = m_indirectCommands.size * sizeof(DrawElementsIndirectCommand);
+	COUNT_FRAME_STAT(bytesUploaded, commandsSize);
+	BindBufferObject(BufferTarget::DrawIndirect, m_indirectBuffer);
+	GL_CHECK(glBufferData(GL_DRAW_INDIRECT_BUFFER, commandsSize, m_indirectCommands.elt, GL_STREAM_DRAW));
+
+	GL_CHECK(glMultiDrawElementsIndirect(vboInfo.primitiveType, vboInfo.indexType, nullptr, m_indirectCommands.size, 0));
+	COUNT_FRAME_STAT(numberOfDraws, 1);
+}
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+void OpenGLLayer::SubmitDraws(const DrawItem* items, int count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	ASSERT(items != nullptr && count > 0);
+
+	// Doesn't depend on the items.
+	SetCapability(Capability::TextureCubeMapSeamless, true);
+
+	// The first item sets everything; the following ones only what
+	// differs from the item before them. The bound state is still
+	// compared when it is set, so nothing is set twice across calls.
+	const DrawItem* previous = nullptr;
+	for (int i = 0; i < count; ++i)
+	{
+		const DrawItem& item = items[i];
+		ASSERT(item.state != nullptr);
+
+		if (previous == nullptr || item.vertexBuffer != previous->vertexBuffer)
+		{
+			BindVertexBuffer(item.vertexBuffer);
+		}
+
+		const bool shaderChanged = (previous == nullptr || item.shader != previous->shader);
+		if (shaderChanged)
+		{
+			BindShader(item.shader);
+		}
+		if (shaderChanged ||
+			item.uniforms != previous->uniforms ||
+			item.numberOfUniforms != previous->numberOfUniforms)
 		{
-			GL_CHECK(glDrawElementsInstanced(vboInfo.primitiveType, geometry.numberOfIndices, vboInfo.indexType, (void*)firstIndexOffset, shadingParameters.numberOfInstances));
+			BindUniforms(item.uniforms, item.numberOfUniforms);
 		}
 		else
 		{
-			GL_CHECK(glDrawArraysInstanced(vboInfo.primitiveType, 0, geometry.numberOfIndices, shadingParameters.numberOfInstances));
+			COUNT_FRAME_STAT(uniformBindsAvoided, item.numberOfUniforms);
+		}
+
+		if (previous == nullptr || item.state != previous->state)
+		{
+			const DrawState& state = *item.state;
+			BindFrameBuffer(state.drawArea.frameBuffer);
+			SetRasterizerState(state.drawArea.viewport,
+				state.polygonMode,
+				state.rasterTests,
+				state.blendingMode);
 		}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		DrawVertexBuffer(item.vertexBuffer, item.numberOfIndices,
+						 item.firstIndexOffset, item.baseVertex,
+						 item.numberOfInstances);
+#else // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		DrawVertexBuffer(item.vertexBuffer, item.numberOfIndices,
+						 0, 0, item.numberOfInstances);
+#endif // !GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		previous = &item;
 	}
 }
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void OpenGLLayer::DrawIndirect(const DrawArea& drawArea,
+							   const RasterTests& rasterTests,
+							   const VertexBufferID vertexBuffer,
+							   const ShadingParameters& shadingParameters,
+							   const StorageBufferID arguments,
+							   int offset)
+{
+	ASSERT(vertexBuffer.index >= 0 && m_VBOs.size > vertexBuffer.index);
+	ASSERT(arguments.index >= 0 && m_SSBOs.size > arguments.index);
+	ASSERT(offset >= 0 && offset % 4 == 0);
+	BindVertexBuffer(vertexBuffer);
+	BindShader(shadingParameters.shader);
+	BindUniforms(shadingParameters.uniforms.elt, shadingParameters.uniforms.size);
+	BindFrameBuffer(drawArea.frameBuffer);
+
+	SetRasterizerState(drawArea.viewport,
+		shadingParameters.polygonMode,
+		rasterTests,
+		shadingParameters.blendingMode);
+
+	SetCapability(Capability::TextureCubeMapSeamless, true);
+
+	const VBOInfo& vboInfo = m_VBOs[vertexBuffer.index];
+	ASSERT(vboInfo.indexed);
+
+	// Like ComputeIndirect, it is up to the caller to insert a
+	// Barrier::IndirectArguments if a shader wrote the arguments. The
+	// number of instances is only known by the GPU, so it isn't counted.
+	BindBufferObject(BufferTarget::DrawIndirect, m_SSBOs[arguments.index].storageBuffer);
+	GL_CHECK(glDrawElementsIndirect(vboInfo.primitiveType, vboInfo.indexType, (const void*)(size_t)offset));
+	COUNT_FRAME_STAT(numberOfDraws, 1);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 
 #if GFX_ENABLE_COMPUTE_SHADERS
 void OpenGLLayer::Compute(const ShaderID shader,
@@ -1305,22 +3497,155 @@ void OpenGLLayer::Compute(const ShaderID shader,
 	BindUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size);
 
 	GL_CHECK(glDispatchCompute(x, y, z));
+	COUNT_FRAME_STAT(numberOfDispatches, 1);
 }
 #endif // GFX_ENABLE_COMPUTE_SHADERS
 
-//void OpenGLLayer::EndFrame()
-//{
-//#if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
-//	if (uniformBindingsAvoided != 0 ||
-//		uniformBindingsUpdated != 0 ||
-//		uniformBindingsSet != 0)
-//	{
-//		LOG_DEBUG("avoided: %d, updated: %d, set: %d", uniformBindingsAvoided, uniformBindingsUpdated, uniformBindingsSet);
-//		uniformBindingsAvoided = 0;
-//		uniformBindingsUpdated = 0;
-//		uniformBindingsSet = 0;
-//	}
-//#endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
-//}
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void OpenGLLayer::ComputeIndirect(const ShaderID shader,
+								  const ComputeParameters& computeParameters,
+								  const StorageBufferID arguments,
+								  int offset)
+{
+	ASSERT(arguments.index >= 0 && m_SSBOs.size > arguments.index);
+	ASSERT(offset >= 0 && offset % 4 == 0);
+	BindShader(shader);
+	BindUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size);
+
+	// The arguments aren't read back: if a shader wrote them, it is up to
+	// the caller to insert a Barrier::IndirectArguments before.
+	BindBufferObject(BufferTarget::DispatchIndirect, m_SSBOs[arguments.index].storageBuffer);
+	GL_CHECK(glDispatchComputeIndirect((GLintptr)offset));
+	COUNT_FRAME_STAT(numberOfDispatches, 1);
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void OpenGLLayer::InsertMemoryBarrier(int barriers)
+{
+	ASSERT(barriers != 0);
+	GL_CHECK(glMemoryBarrier((GLbitfield)barriers));
+
+	// What was written so far is visible, so BindStorageBuffer and
+	// ReadStorageBuffer don't need to insert a barrier of their own.
+	if ((barriers & Barrier::StorageBuffer) != 0)
+	{
+		for (int i = 0; i < m_SSBOs.size; ++i)
+		{
+			m_SSBOs[i].writing = false;
+		}
+	}
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+void OpenGLLayer::EndFrame()
+{
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+	if (m_uniformRingOffset > 0)
+	{
+		RecycleUniformRing();
+	}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
+#if GFX_ENABLE_GPU_PROFILING
+	ASSERT(m_numberOfOpenGpuScopes == 0);
+	m_currentGpuFrame = (m_currentGpuFrame + 1) % (GFX_GPU_PROFILING_LATENCY + 1);
+	ReadGpuFrame(m_gpuFrames[m_currentGpuFrame]);
+	m_gpuFrames[m_currentGpuFrame].frame = ++m_frame;
+#endif // GFX_ENABLE_GPU_PROFILING
+
+#if DEBUG
+	ValidateStateShadow();
+#endif // DEBUG
+
+#if GFX_ENABLE_FRAME_STATS
+	// The counters start over, the resource counts carry on.
+	m_lastFrameStats = m_frameStats;
+	m_frameStats = FrameStats();
+	m_frameStats.numberOfVertexBuffers = m_lastFrameStats.numberOfVertexBuffers;
+	m_frameStats.numberOfTextures = m_lastFrameStats.numberOfTextures;
+	m_frameStats.numberOfShaders = m_lastFrameStats.numberOfShaders;
+	m_frameStats.numberOfFrameBuffers = m_lastFrameStats.numberOfFrameBuffers;
+	m_frameStats.numberOfUniformBuffers = m_lastFrameStats.numberOfUniformBuffers;
+	m_frameStats.numberOfStorageBuffers = m_lastFrameStats.numberOfStorageBuffers;
+#endif // GFX_ENABLE_FRAME_STATS
+}
+
+#if GFX_ENABLE_GPU_PROFILING
+void OpenGLLayer::BeginGpuScope(const char* name)
+{
+	ASSERT(name != nullptr);
+	ASSERT(m_numberOfOpenGpuScopes < GFX_MAX_GPU_SCOPES);
+
+	// Scopes beyond the capacity of the frame are still balanced, but
+	// not measured.
+	int index = -1;
+	GpuFrame& gpuFrame = m_gpuFrames[m_currentGpuFrame];
+	if (m_useTimerQueries && gpuFrame.numberOfScopes < GFX_MAX_GPU_SCOPES)
+	{
+		index = gpuFrame.numberOfScopes++;
+		GpuScope& scope = gpuFrame.scopes[index];
+		scope.name = name;
+		scope.depth = m_numberOfOpenGpuScopes;
+		GL_CHECK(glQueryCounter(scope.queries[0], GL_TIMESTAMP));
+	}
+	m_openGpuScopes[m_numberOfOpenGpuScopes++] = index;
+}
+
+void OpenGLLayer::EndGpuScope()
+{
+	ASSERT(m_numberOfOpenGpuScopes > 0);
+
+	const int index = m_openGpuScopes[--m_numberOfOpenGpuScopes];
+	if (index >= 0)
+	{
+		GpuScope& scope = m_gpuFrames[m_currentGpuFrame].scopes[index];
+		GL_CHECK(glQueryCounter(scope.queries[1], GL_TIMESTAMP));
+	}
+}
+
+// Passes the timings of a frame to the profiler if the GPU is done with
+// it, or drops them; either way the slot is free for the next frame.
+void OpenGLLayer::ReadGpuFrame(GpuFrame& gpuFrame)
+{
+	bool available = true;
+	for (int i = 0; available && i < gpuFrame.numberOfScopes; ++i)
+	{
+		for (int j = 0; available && j < 2; ++j)
+		{
+			GLint queryAvailable = GL_FALSE;
+			GL_CHECK(glGetQueryObjectiv(gpuFrame.scopes[i].queries[j], GL_QUERY_RESULT_AVAILABLE, &queryAvailable));
+			available = (queryAvailable != GL_FALSE);
+		}
+	}
+
+	if (!available)
+	{
+		m_gpuProfiler.DropFrame();
+	}
+	else
+	{
+		for (int i = 0; i < gpuFrame.numberOfScopes; ++i)
+		{
+			const GpuScope& scope = gpuFrame.scopes[i];
+			GLuint64 start = 0;
+			GLuint64 end = 0;
+			GL_CHECK(glGetQueryObjectui64v(scope.queries[0], GL_QUERY_RESULT, &start));
+			GL_CHECK(glGetQueryObjectui64v(scope.queries[1], GL_QUERY_RESULT, &end));
+			m_gpuProfiler.AddScope(scope.name, scope.depth, gpuFrame.frame,
+								   m_gpuClockOffset + (long long)(start / 1000),
+								   m_gpuClockOffset + (long long)(end / 1000));
+		}
+	}
+	gpuFrame.numberOfScopes = 0;
+}
+#endif // GFX_ENABLE_GPU_PROFILING
+
+#if GFX_COUNT_DRIVER_CALLS
+int OpenGLLayer::GetNumberOfDriverCalls()
+{
+	return numberOfDriverCalls;
+}
+#endif // GFX_COUNT_DRIVER_CALLS
 
 #endif // GFX_MULTI_API || GFX_OPENGL_ONLY
@@ -4,9 +4,18 @@
 // FIXME: ideally Gfx should not have dependency over Engine.
 #include "gfx/BlendingMode.hpp"
 #include "gfx/DrawArea.hpp"
+#if GFX_ENABLE_FRAME_STATS
+#include "gfx/FrameStats.hpp"
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+#include "gfx/GpuProfiler.hpp"
+#endif // GFX_ENABLE_GPU_PROFILING
 #include "gfx/IGraphicLayer.hpp"
 #include "gfx/PolygonMode.hpp"
 #include "gfx/RasterTests.hpp"
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+#include "gfx/Uniform.hpp"
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 #include <GL/gl.h>
 
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
@@ -18,6 +27,9 @@
 namespace Gfx
 {
 	struct BlendingMode;
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+	class ProgramBinaryCache;
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
 	struct Uniform;
 
 	/// <summary>
@@ -41,6 +53,24 @@ namespace Gfx
 												 int vertexDataSize, const void* vertexData,
 												 int indexDataSize, const void* indexData,
 												 VertexIndexType::Enum indexType);
+		void					UpdateVertexBufferRange(const VertexBufferID id,
+														int offset, int size,
+														const void* data);
+		void					UpdateIndexBufferRange(const VertexBufferID id,
+													   int offset, int size,
+													   const void* data);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		void					CopyVertexBufferRange(const VertexBufferID source,
+													  int sourceOffset,
+													  const VertexBufferID destination,
+													  int destinationOffset,
+													  int size);
+		void					CopyIndexBufferRange(const VertexBufferID source,
+													 int sourceOffset,
+													 const VertexBufferID destination,
+													 int destinationOffset,
+													 int size);
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
 
 		TextureID				CreateTexture();
 		void					DestroyTexture(const TextureID id);
@@ -52,6 +82,40 @@ namespace Gfx
 											const void* data,
 											const TextureSampling& textureSampling);
 		void					GenerateMipMaps(const TextureID id);
+#if GFX_ENABLE_TEXTURE_ARRAYS
+		void					LoadTextureArray(const TextureID id,
+												 int width, int height,
+												 int numberOfLayers,
+												 TextureFormat::Enum textureFormat,
+												 const TextureSampling& textureSampling);
+		void					LoadTextureLayer(const TextureID id, int layer, const void* data);
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+		void					AllocateTexture(const TextureID id,
+												int width, int height,
+												int numberOfLevels,
+												TextureFormat::Enum textureFormat,
+												const TextureSampling& textureSampling);
+		void					LoadTextureLevel(const TextureID id, int level, const void* data);
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+		void					LoadCompressedTexture(const TextureID id,
+													  int width, int height,
+													  TextureFormat::Enum textureFormat,
+													  int lodLevel,
+													  int dataSize, const void* data,
+													  const TextureSampling& textureSampling);
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		void*					MapTextureUpload(const TextureID id, int size);
+		void					LoadTextureAsync(const TextureID id,
+												 int width, int height,
+												 TextureType::Enum textureType,
+												 TextureFormat::Enum textureFormat,
+												 int side, int lodLevel,
+												 const TextureSampling& textureSampling);
+		bool					IsTextureReady(const TextureID id);
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
 
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		UniformBufferID			CreateUniformBuffer();
@@ -72,32 +136,218 @@ namespace Gfx
 												  void* dest);
 #endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const StorageBufferID id,
+												int offset, int size);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		ReadbackID				RequestReadback(const FrameBufferID id,
+												int x, int y,
+												int width, int height);
+		bool					TryGetReadback(const ReadbackID id, void* dest);
+#endif // GFX_ENABLE_ASYNC_READBACK
+
 		ShaderID				CreateShader();
 		void					DestroyShader(const ShaderID id);
 		void					LoadShader(const ShaderID id,
 										   const ShaderStage* shaderStages,
 										   int numberOfStages);
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		void					LoadShaderAsync(const ShaderID id,
+												const ShaderStage* shaderStages,
+												int numberOfStages);
+		bool					IsShaderReady(const ShaderID id);
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
 
 		FrameBufferID			CreateFrameBuffer(const TextureID* textures,
 												  int numberOfTextures,
 												  int side, int lodLevel);
+		void					LoadFrameBuffer(const FrameBufferID id,
+												const TextureID* textures,
+												int numberOfTextures,
+												int side, int lodLevel);
 		void					DestroyFrameBuffer(const FrameBufferID id);
 		void					ClearFrameBuffer(const FrameBufferID frameBuffer,
 												 float r, float g, float b,
 												 bool clearDepth);
+#if GFX_ENABLE_RENDER_PASSES
+		void					BeginRenderPass(const FrameBufferID id,
+												const LoadOp::Enum* loadOps,
+												const ClearValue* clearValues,
+												int numberOfAttachments);
+		void					EndRenderPass(const StoreOp::Enum* storeOps,
+											  int numberOfAttachments);
+#endif // GFX_ENABLE_RENDER_PASSES
 
 		void					Draw(const DrawArea& drawArea,
 									 const RasterTests& rasterTests,
 									 const Geometry& geometry,
 									 const ShadingParameters& shadingParameters);
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		void					Draw(const DrawArea& drawArea,
+									 const RasterTests& rasterTests,
+									 const DrawBatch& batch,
+									 const ShadingParameters& shadingParameters);
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+		void					SubmitDraws(const DrawItem* items, int count);
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					DrawIndirect(const DrawArea& drawArea,
+											 const RasterTests& rasterTests,
+											 const VertexBufferID vertexBuffer,
+											 const ShadingParameters& shadingParameters,
+											 const StorageBufferID arguments,
+											 int offset);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
 #if GFX_ENABLE_COMPUTE_SHADERS
 		void					Compute(const ShaderID shader,
 										const ComputeParameters& computeParameters,
 										int x, int y = 1, int z = 1);
 #endif // GFX_ENABLE_COMPUTE_SHADERS
-		void					EndFrame() {}
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					ComputeIndirect(const ShaderID shader,
+												const ComputeParameters& computeParameters,
+												const StorageBufferID arguments,
+												int offset);
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		void					InsertMemoryBarrier(int barriers);
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+#if GFX_ENABLE_FRAME_STATS
+		const FrameStats&		GetFrameStats() const { return m_lastFrameStats; }
+#endif // GFX_ENABLE_FRAME_STATS
+#if GFX_ENABLE_GPU_PROFILING
+		void					BeginGpuScope(const char* name);
+		void					EndGpuScope();
+		GpuProfiler&			GetGpuProfiler() { return m_gpuProfiler; }
+#endif // GFX_ENABLE_GPU_PROFILING
+		void					EndFrame();
+
+#if GFX_COUNT_DRIVER_CALLS
+		/// <summary>
+		/// Number of OpenGL calls made so far, by all the layers.
+		/// </summary>
+		static int				GetNumberOfDriverCalls();
+#endif // GFX_COUNT_DRIVER_CALLS
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+		/// <summary>
+		/// Makes LoadShader and LoadShaderAsync look for the linked
+		/// program in the cache before compiling, and add it after.
+		/// Ignored if the driver doesn't support program binaries. The
+		/// cache must outlive the layer, or be unset with nullptr.
+		/// </summary>
+		void					SetProgramBinaryCache(ProgramBinaryCache* cache);
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
 
 	private:
+		// Binding points whose state is shadowed.
+		struct BufferTarget
+		{
+			enum Enum {
+				Array,
+				CopyRead,
+				CopyWrite,
+				DispatchIndirect,
+				DrawIndirect,
+				ElementArray, // Part of the vertex array object state.
+				PixelPack, // Only bound while reading back, see RequestReadback.
+				PixelUnpack, // Only bound while uploading, see LoadTextureAsync.
+				ShaderStorage,
+				Uniform,
+				Count
+			};
+		};
+
+		struct TextureTarget
+		{
+			enum Enum {
+				Texture2D,
+				CubeMap,
+#if GFX_ENABLE_TEXTURE_ARRAYS
+				Texture2DArray,
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+				Count
+			};
+		};
+
+		struct Capability
+		{
+			enum Enum {
+				Blend,
+				ClipDistance0,
+				CullFace,
+				DepthTest,
+				ScissorTest,
+				StencilTest,
+				TextureCubeMapSeamless,
+				Count
+			};
+		};
+
+		// These methods only call OpenGL when the state differs from its
+		// shadow.
+		void					BindBufferObject(BufferTarget::Enum target, GLuint buffer);
+		void					BindTextureObject(int slot, GLenum type, GLuint texture);
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+		void					BindVertexArrayObject(GLuint vertexArray, GLuint indexBuffer);
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+		void					SetCapability(Capability::Enum capability, bool enabled);
+
+		// With direct state access, these methods edit buffers without
+		// binding them; otherwise the buffer is left bound to target.
+		void					GenerateBufferObject(GLuint* buffer);
+		void					LoadBufferObject(BufferTarget::Enum target, GLuint buffer,
+												 GLsizeiptr size, const void* data, GLenum usage);
+		void					UpdateBufferObject(BufferTarget::Enum target, GLuint buffer,
+												   GLintptr offset, GLsizeiptr size, const void* data);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK
+		void					CopyBufferObject(GLuint source, GLintptr sourceOffset,
+												 GLuint destination, GLintptr destinationOffset,
+												 GLsizeiptr size);
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET || GFX_ENABLE_ASYNC_READBACK
+
+		// When hasData is true and a pixel unpack buffer is bound, data
+		// is an offset in that buffer.
+		void					LoadTextureImage(const TextureID id,
+												 int width, int height,
+												 TextureType::Enum textureType,
+												 TextureFormat::Enum textureFormat,
+												 int side, int lodLevel,
+												 const void* data, bool hasData,
+												 const TextureSampling& textureSampling);
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+		bool					LoadTextureDirect(const TextureID id,
+												  int width, int height,
+												  GLenum internalFormat, GLenum format, GLenum type,
+												  int lodLevel,
+												  const void* data, bool hasData,
+												  const TextureSampling& textureSampling);
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		void					RetireTextureUpload(int upload);
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#if GFX_ENABLE_ASYNC_READBACK
+		int						ReserveReadback(int size);
+		int						FindReadback(const ReadbackID id) const;
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+		// Texture objects can't be specified again when their storage
+		// is immutable, nor bound to another target than the first one;
+		// the texture then gets a new object.
+		bool					HasImmutableStorage(const TextureID id) const;
+		void					ReplaceTextureObject(const TextureID id);
+
+		// OpenGL unbinds objects when they are deleted, and may reuse
+		// their names.
+		void					OnBufferObjectDeleted(GLuint buffer);
+		void					OnTextureObjectDeleted(GLuint texture);
+
+#if DEBUG
+		void					ValidateStateShadow();
+#endif // DEBUG
+
 		// These methods are private so from the outside the API looks stateless.
 		void					SetRasterizerState(const Viewport& viewport,
 												   const PolygonMode::Enum polygonMode,
@@ -105,6 +355,20 @@ namespace Gfx
 												   const BlendingMode& blendingMode);
 		void					BindFrameBuffer(const FrameBufferID framebuffer);
 		void					BindShader(const ShaderID id);
+		void					ReleaseShader(const ShaderID id);
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		void					FinishLoadingShader(const ShaderID id);
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+		void					QueryUniformBlock(const ShaderID id);
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+		unsigned long long		ComputeProgramKey(const ShaderStage* shaderStages,
+												  int numberOfStages) const;
+		bool					LoadProgramBinary(const ShaderID id, unsigned long long key);
+		void					StoreProgramBinary(const ShaderID id, unsigned long long key,
+												   int compileTime);
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
 #if GFX_ENABLE_STORAGE_BUFFER_OBJECT
 		void					BindStorageBuffer(const StorageBufferID id,
 												  GLuint program,
@@ -120,7 +384,16 @@ namespace Gfx
 												  const char* name);
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		void					BindUniforms(const Uniform* uniforms, int numberOfUniforms);
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+		bool					SetBlockUniform(const ShaderID id, const Uniform& uniform);
+		void					BindUniformBlock(const ShaderID id);
+		void					RecycleUniformRing();
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 		void					BindVertexBuffer(const VertexBufferID id);
+		void					DrawVertexBuffer(const VertexBufferID id,
+												 int numberOfIndices,
+												 int firstIndexOffset, int baseVertex,
+												 int numberOfInstances);
 
 	private:
 		struct FBOInfo
@@ -128,6 +401,11 @@ namespace Gfx
 			GLuint	frameBuffer;
 			int		width;
 			int		height;
+#if GFX_ENABLE_RENDER_PASSES
+			// Attachment of each texture, in the order of creation.
+			GLenum	attachments[MaxFrameBufferAttachments];
+			int		numberOfAttachments;
+#endif // GFX_ENABLE_RENDER_PASSES
 		};
 		Container::Array<FBOInfo>	m_FBOs;
 
@@ -135,6 +413,18 @@ namespace Gfx
 		{
 			GLuint	program;
 			GLuint	shaders[2];
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+			// Set by LoadShaderAsync, until the compilation and link
+			// results are checked.
+			bool		pending;
+			int			numberOfStages;
+			const char*	sourceInfo[2];
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+			// Where to store the program once linked, or 0.
+			unsigned long long binaryKey;
+			long long	submitTime; // In microseconds.
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
 #if GFX_SKIP_REDUNDANT_UNIFORM_BINDING
 #if GFX_HASH_UNIFORM_VALUE
 			Container::HashTable<const char*, unsigned int> currentUniforms;
@@ -142,6 +432,28 @@ namespace Gfx
 			Container::HashTable<const char*, Uniform> currentUniforms;
 #endif // !GFX_HASH_UNIFORM_VALUE
 #endif // GFX_SKIP_REDUNDANT_UNIFORM_BINDING
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+			// Layout of the DrawUniforms block, queried when the shader
+			// is loaded. blockSize is 0 if the shader has no such block.
+			struct BlockUniform
+			{
+				char		name[32]; // Without the "[0]" of arrays.
+				const char*	lastName; // Saves a string comparison when the same pointer is used again.
+				int			offset;
+				int			arrayStride; // 0 if not an array.
+				int			arraySize;
+				int			components; // Per array element.
+				UniformType::Enum type;
+			};
+			Container::Array<BlockUniform> blockUniforms;
+			Container::Array<unsigned char> blockData;
+			int		blockSize;
+
+			// Where the block was last copied in the ring.
+			int		blockRingOffset;
+			int		blockRingGeneration;
+			bool	blockChanged;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
 		};
 		Container::Array<ShaderInfo> m_shaders;
 
@@ -162,9 +474,66 @@ namespace Gfx
 			int		height;
 			GLenum	type;
 			GLenum	format;
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+			// Immutable storage, allocated by LoadTextureDirect.
+			// storageLevels is 0 if the texture has none.
+			int		storageLevels;
+			int		storageWidth;
+			int		storageHeight;
+			GLenum	storageFormat;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+			int		pendingUpload; // Index in m_textureUploads, or -1.
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+#if GFX_ENABLE_TEXTURE_ARRAYS || GFX_ENABLE_TEXTURE_STORAGE
+			// Type of the data, for LoadTextureLayer and LoadTextureLevel.
+			GLenum	dataType;
+#endif // GFX_ENABLE_TEXTURE_ARRAYS || GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_TEXTURE_ARRAYS
+			int		numberOfLayers; // Set by LoadTextureArray.
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+#if GFX_ENABLE_TEXTURE_STORAGE
+			// Levels allocated by AllocateTexture or LoadTextureArray,
+			// or 0. The storage is immutable if the driver supports it.
+			int		numberOfLevels;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
 		};
 		Container::Array<TextureInfo> m_textures;
 
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+		// Ring of pixel buffer objects. A buffer is mapped by
+		// MapTextureUpload, then unmapped and copied to its texture by
+		// LoadTextureAsync, and reused once the fence of the copy has
+		// signalled.
+		struct TextureUpload
+		{
+			GLuint		buffer;
+			int			capacity;
+			TextureID	texture;
+			GLsync		fence;
+			bool		mapped;
+		};
+		TextureUpload				m_textureUploads[GFX_TEXTURE_UPLOAD_BUFFERS];
+		int							m_nextTextureUpload;
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_ASYNC_READBACK
+		// Ring of staging buffers. The data is copied to a buffer by
+		// RequestReadback, which inserts a fence after the copy, and is
+		// mapped by TryGetReadback once the fence has signalled.
+		struct Readback
+		{
+			GLuint		buffer;
+			int			capacity;
+			int			size;
+			int			request; // Index of the ReadbackID, or -1 if the buffer is free.
+			GLsync		fence;
+		};
+		Readback					m_readbacks[GFX_READBACK_BUFFERS];
+		int							m_nextReadback;
+		int							m_numberOfReadbackRequests;
+#endif // GFX_ENABLE_ASYNC_READBACK
+
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		struct UBOInfo
 		{
@@ -174,6 +543,14 @@ namespace Gfx
 		Container::Array<UBOInfo>	m_UBOs;
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 
+#if GFX_ENABLE_UNIFORM_BUFFER_RING
+		GLuint						m_uniformRing;
+		int							m_uniformRingOffset;
+		int							m_uniformRingAlignment;
+		int							m_uniformRingGeneration; // Incremented when the ring is recycled.
+		int							m_uniformRingBoundOffset;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_RING
+
 		struct VBOInfo
 		{
 			const VertexAttribute* vertexAttributes;
@@ -183,28 +560,120 @@ namespace Gfx
 			GLenum	primitiveType;
 			GLuint	vertexBuffer;
 			GLuint	indexBuffer;
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+			GLuint	vertexArray;
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+			int		vertexBufferCapacity; // Allocated size in bytes.
+			int		indexBufferCapacity;
 			GLenum	indexType;
 			bool	indexed;
 		};
 		Container::Array<VBOInfo>	m_VBOs;
 
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+		// Same layout as expected by glMultiDrawElementsIndirect.
+		struct DrawElementsIndirectCommand
+		{
+			GLuint	count;
+			GLuint	instanceCount;
+			GLuint	firstIndex;
+			GLint	baseVertex;
+			GLuint	baseInstance;
+		};
+		Container::Array<DrawElementsIndirectCommand> m_indirectCommands;
+		GLuint						m_indirectBuffer;
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
 		Viewport					m_currentViewport;
 		RasterTests					m_currentRasterTests;
 		BlendingMode				m_currentBlendingMode;
 		PolygonMode::Enum			m_currentPolygonMode;
 
-		FrameBufferID				m_currentFrameBuffer;
 		ShaderID					m_currentShader;
 #if GFX_ENABLE_STORAGE_BUFFER_OBJECT
 		StorageBufferID				m_currentSSBOs[GFX_MAX_STORAGE_BUFFER_BINDINGS];
 #endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
-		TextureID					m_currentTextures[GFX_MAX_TEXTURE_SLOTS];
 #if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		UniformBufferID				m_currentUBOs[GFX_MAX_UNIFORM_BUFFER_SLOTS];
 #endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
 		VertexBufferID				m_currentVBO;
 
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+		GLuint						m_defaultVertexArray;
+#else // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
 		bool						m_enabledVertexAttributes[GFX_MAX_VERTEX_ATTRIBUTES];
+#endif // !GFX_ENABLE_VERTEX_ARRAY_OBJECT
+
+		// Shadow of the OpenGL state, so resources can be loaded without
+		// querying and restoring the previous bindings.
+		GLuint						m_boundBuffers[BufferTarget::Count];
+		GLuint						m_boundTextures[GFX_MAX_TEXTURE_SLOTS][TextureTarget::Count];
+		int							m_activeTextureSlot;
+		GLuint						m_boundProgram;
+		GLuint						m_boundFrameBuffer;
+#if GFX_ENABLE_VERTEX_ARRAY_OBJECT
+		GLuint						m_boundVertexArray;
+#endif // GFX_ENABLE_VERTEX_ARRAY_OBJECT
+		bool						m_enabledCapabilities[Capability::Count];
+
+#if GFX_ENABLE_DIRECT_STATE_ACCESS
+		bool						m_useDirectStateAccess;
+#endif // GFX_ENABLE_DIRECT_STATE_ACCESS
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+		bool						m_parallelShaderCompile;
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+#if GFX_ENABLE_TEXTURE_STORAGE
+		bool						m_useTextureStorage;
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+#if GFX_ENABLE_RENDER_PASSES
+		bool						m_useInvalidateFramebuffer;
+		bool						m_inRenderPass;
+		FrameBufferID				m_renderPassFrameBuffer;
+#endif // GFX_ENABLE_RENDER_PASSES
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+		ProgramBinaryCache*			m_programBinaryCache;
+		unsigned long long			m_driverHash; // Part of the program keys.
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+#if GFX_ENABLE_FRAME_STATS
+		FrameStats					m_frameStats; // Of the frame in progress.
+		FrameStats					m_lastFrameStats;
+#endif // GFX_ENABLE_FRAME_STATS
+
+#if GFX_ENABLE_GPU_PROFILING
+		// Each scope writes a GL_TIMESTAMP query when it begins and when
+		// it ends. The queries of a frame are read back when its slot of
+		// the ring comes up again, GFX_GPU_PROFILING_LATENCY frames
+		// later.
+		struct GpuScope
+		{
+			const char*	name;
+			int			depth;
+			GLuint		queries[2];
+		};
+		struct GpuFrame
+		{
+			GpuScope	scopes[GFX_MAX_GPU_SCOPES];
+			int			numberOfScopes;
+			int			frame;
+		};
+		void						ReadGpuFrame(GpuFrame& gpuFrame);
+
+		GpuFrame					m_gpuFrames[GFX_GPU_PROFILING_LATENCY + 1];
+		int							m_currentGpuFrame;
+		int							m_frame;
+
+		// Scopes begun and not ended yet, as indices in the current
+		// frame, or -1 for those ignored.
+		int							m_openGpuScopes[GFX_MAX_GPU_SCOPES];
+		int							m_numberOfOpenGpuScopes;
+
+		// CPU time in microseconds, minus GPU time.
+		long long					m_gpuClockOffset;
+
+		bool						m_useTimerQueries;
+		GpuProfiler					m_gpuProfiler;
+#endif // GFX_ENABLE_GPU_PROFILING
 	};
 }
 
@@ -88,11 +88,12 @@ const TextureFormatConversion Gfx::textureFormatLUT[] = {
 	{ TextureFormat::Compressed,	GL_COMPRESSED_RGBA,						GL_RGBA,	GL_ZERO,	},
 // 	{ ,								GL_COMPRESSED_SRGB,						GL_RGB,		,			},
 // 	{ ,								GL_COMPRESSED_SRGB_ALPHA,				GL_RGBA,	,			},
-// 	{ ,								GL_COMPRESSED_RED_RGTC1,				GL_RED,		,			},
+	{ TextureFormat::BC1,			GL_COMPRESSED_RGB_S3TC_DXT1_EXT,		GL_RGB,		GL_ZERO,	},
+	{ TextureFormat::BC4,			GL_COMPRESSED_RED_RGTC1,				GL_RED,		GL_ZERO,	},
 // 	{ ,								GL_COMPRESSED_SIGNED_RED_RGTC1,			GL_RED,		,			},
-// 	{ ,								GL_COMPRESSED_RG_RGTC2,					GL_RG,		,			},
+	{ TextureFormat::BC5,			GL_COMPRESSED_RG_RGTC2,					GL_RG,		GL_ZERO,	},
 // 	{ ,								GL_COMPRESSED_SIGNED_RG_RGTC2,			GL_RG,		,			},
-// 	{ ,								GL_COMPRESSED_RGBA_BPTC_UNORM,			GL_RGBA,	,			},
+	{ TextureFormat::BC7,			GL_COMPRESSED_RGBA_BPTC_UNORM_ARB,		GL_RGBA,	GL_ZERO,	},
 // 	{ ,								GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,	GL_RGBA,	,			},
 // 	{ ,								GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,	GL_RGB,		,			},
 // 	{ ,								GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,	GL_RGB,		,			},
@@ -136,6 +137,23 @@ const TextureFormatConversion Gfx::textureFormatLUT[] = {
 	//   GL_UNSIGNED_INT_2_10_10_10_REV
 };
 
+int Gfx::getImageSize(GLenum format, GLenum type, int width, int height)
+{
+	int pixelSize = 0;
+	switch (type)
+	{
+	// Packed types: the size is for all the components.
+	case GL_UNSIGNED_SHORT_5_5_5_1: pixelSize = 2; break;
+	case GL_UNSIGNED_INT_24_8: pixelSize = 4; break;
+	case GL_UNSIGNED_INT_10F_11F_11F_REV: pixelSize = 4; break;
+	default:
+		pixelSize = (type == GL_FLOAT ? 4 : type == GL_HALF_FLOAT || type == GL_UNSIGNED_SHORT ? 2 : 1);
+		pixelSize *= (format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1);
+		break;
+	}
+	return pixelSize * width * height;
+}
+
 const VertexAttributeTypeConversion Gfx::vertexAttributeTypeLUT[] = {
 	{ VertexAttributeType::Byte,			GL_BYTE,			sizeof(char),			},
 	{ VertexAttributeType::UnsignedByte,	GL_UNSIGNED_BYTE,	sizeof(unsigned char),	},
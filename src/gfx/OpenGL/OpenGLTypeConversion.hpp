@@ -39,6 +39,15 @@ namespace Gfx
 		return textureFormatLUT[format].glenum_type;
 	}
 
+	// Size in bytes of the pixel data of an image, as given to
+	// glTexImage2D.
+	int getImageSize(GLenum format, GLenum type, int width, int height);
+
+	inline int getTextureImageSize(const TextureFormat::Enum& format, int width, int height)
+	{
+		return getImageSize(getTextureFormat_FormatGLenum(format), getTextureFormat_TypeGLenum(format), width, height);
+	}
+
 	// glVertexAttribPointer
 	struct VertexAttributeTypeConversion
 	{
@@ -0,0 +1,318 @@
+#include "ProgramBinaryCache.hpp"
+
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include <cstdio>
+#include <cstring>
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+// Beyond this, the least recently used binaries are evicted even if the
+// size limit isn't reached.
+#define MAX_CACHE_ENTRIES 4096
+
+#define INDEX_FILE_NAME "index.txt"
+#define INDEX_VERSION 1
+
+// Written at the beginning of each binary file, to detect truncated or
+// foreign files.
+#define BINARY_FILE_MAGIC 0x31434250 // "PBC1"
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::ProgramBinaryCache::Entry>;
+
+#endif
+
+struct BinaryFileHeader
+{
+	unsigned int	magic;
+	unsigned int	format;
+	int				size;
+};
+
+ProgramBinaryCache::ProgramBinaryCache():
+	m_size(0),
+	m_lastUse(0),
+	m_buffer(nullptr),
+	m_bufferCapacity(0),
+	m_hits(0),
+	m_misses(0),
+	m_rejected(0),
+	m_evictions(0),
+	m_timeSaved(0)
+{
+	m_directory[0] = '\0';
+}
+
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+	delete[] m_buffer;
+}
+
+void ProgramBinaryCache::Init(const char* directory)
+{
+	ASSERT(strlen(directory) + 1 < sizeof(m_directory));
+	strncpy(m_directory, directory, sizeof(m_directory) - 1);
+	m_directory[sizeof(m_directory) - 1] = '\0';
+
+	m_entries.init(MAX_CACHE_ENTRIES);
+	m_size = 0;
+	m_lastUse = 0;
+
+	char fileName[320];
+	snprintf(fileName, sizeof(fileName), "%s/" INDEX_FILE_NAME, m_directory);
+	FILE* file = fopen(fileName, "r");
+	if (file == nullptr)
+	{
+		LOG_INFO("No program binary cache index in %s, starting empty.", m_directory);
+		return;
+	}
+
+	int version = 0;
+	if (fscanf(file, "ProgramBinaryCache %d %u\n", &version, &m_lastUse) != 2 ||
+		version != INDEX_VERSION)
+	{
+		LOG_WARNING("Program binary cache index %s is from another version, ignoring it.", fileName);
+		m_lastUse = 0;
+		fclose(file);
+		return;
+	}
+
+	Entry entry;
+	while (m_entries.size < MAX_CACHE_ENTRIES &&
+		   fscanf(file, "%llx %d %d %u\n", &entry.key, &entry.size, &entry.compileTime, &entry.lastUse) == 4)
+	{
+		m_entries.add(entry);
+		m_size += entry.size;
+	}
+	fclose(file);
+
+	LOG_INFO("Program binary cache: %d binaries, %d bytes.", m_entries.size, m_size);
+
+	// In case the limit was lowered since the index was written.
+	EvictLeastRecentlyUsed(GFX_PROGRAM_BINARY_CACHE_SIZE, MAX_CACHE_ENTRIES);
+}
+
+void ProgramBinaryCache::Shutdown()
+{
+	char fileName[320];
+	snprintf(fileName, sizeof(fileName), "%s/" INDEX_FILE_NAME, m_directory);
+	FILE* file = fopen(fileName, "w");
+	if (file == nullptr)
+	{
+		LOG_ERROR("Could not write program binary cache index %s.", fileName);
+		return;
+	}
+
+	fprintf(file, "ProgramBinaryCache %d %u\n", INDEX_VERSION, m_lastUse);
+	for (int i = 0; i < m_entries.size; ++i)
+	{
+		const Entry& entry = m_entries[i];
+		fprintf(file, "%016llx %d %d %u\n", entry.key, entry.size, entry.compileTime, entry.lastUse);
+	}
+	fclose(file);
+}
+
+// 64 bits FNV-1a. Keys are compared without the data they come from, so
+// 32 bits would make collisions too likely.
+unsigned long long ProgramBinaryCache::Hash(const void* data, int size, unsigned long long seed)
+{
+	unsigned long long hash = (seed != 0 ? seed : 0xcbf29ce484222325ull);
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (int i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+const void* ProgramBinaryCache::Find(unsigned long long key, int* size, unsigned int* format)
+{
+	const int index = FindEntry(key);
+	if (index < 0)
+	{
+		++m_misses;
+		return nullptr;
+	}
+
+	char fileName[320];
+	GetFileName(key, fileName, sizeof(fileName));
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+	{
+		// Removed from outside; forget about it.
+		RemoveEntry(index);
+		++m_misses;
+		return nullptr;
+	}
+
+	BinaryFileHeader header;
+	bool valid = (fread(&header, sizeof(header), 1, file) == 1 &&
+				  header.magic == BINARY_FILE_MAGIC &&
+				  header.size == m_entries[index].size);
+	if (valid)
+	{
+		if (m_bufferCapacity < header.size)
+		{
+			delete[] m_buffer;
+			m_buffer = new char[header.size];
+			m_bufferCapacity = header.size;
+		}
+		valid = (fread(m_buffer, header.size, 1, file) == 1);
+	}
+	fclose(file);
+
+	if (!valid)
+	{
+		LOG_WARNING("Program binary %s is corrupted.", fileName);
+		RemoveEntry(index);
+		++m_misses;
+		return nullptr;
+	}
+
+	m_entries[index].lastUse = ++m_lastUse;
+	*size = header.size;
+	*format = header.format;
+	return m_buffer;
+}
+
+void ProgramBinaryCache::ReportLoaded(unsigned long long key, int loadTime)
+{
+	const int index = FindEntry(key);
+	ASSERT(index >= 0);
+
+	++m_hits;
+	if (m_entries[index].compileTime > loadTime)
+	{
+		m_timeSaved += m_entries[index].compileTime - loadTime;
+	}
+}
+
+void ProgramBinaryCache::ReportRejected(unsigned long long key)
+{
+	const int index = FindEntry(key);
+	ASSERT(index >= 0);
+
+	++m_misses;
+	++m_rejected;
+	RemoveEntry(index);
+}
+
+void ProgramBinaryCache::Store(unsigned long long key, unsigned int format,
+							   const void* data, int size, int compileTime)
+{
+	ASSERT(size > 0);
+	if (size > GFX_PROGRAM_BINARY_CACHE_SIZE)
+	{
+		return;
+	}
+
+	char fileName[320];
+	GetFileName(key, fileName, sizeof(fileName));
+	FILE* file = fopen(fileName, "wb");
+	if (file == nullptr)
+	{
+		LOG_ERROR("Could not write program binary %s.", fileName);
+		return;
+	}
+	const BinaryFileHeader header = { BINARY_FILE_MAGIC, format, size };
+	const bool written = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+						  fwrite(data, size, 1, file) == 1);
+	fclose(file);
+	if (!written)
+	{
+		LOG_ERROR("Could not write program binary %s.", fileName);
+		remove(fileName);
+		return;
+	}
+
+	int index = FindEntry(key);
+	if (index < 0)
+	{
+		EvictLeastRecentlyUsed(GFX_PROGRAM_BINARY_CACHE_SIZE, MAX_CACHE_ENTRIES - 1);
+		Entry& newEntry = m_entries.getNew();
+		newEntry.key = key;
+		newEntry.size = 0;
+		index = m_entries.size - 1;
+	}
+
+	Entry& entry = m_entries[index];
+	m_size += size - entry.size;
+	entry.size = size;
+	entry.compileTime = compileTime;
+	entry.lastUse = ++m_lastUse;
+
+	// Being the most recently used, the new binary goes last.
+	EvictLeastRecentlyUsed(GFX_PROGRAM_BINARY_CACHE_SIZE, MAX_CACHE_ENTRIES);
+}
+
+ProgramBinaryCache::Stats ProgramBinaryCache::GetStats() const
+{
+	Stats stats;
+	stats.numberOfEntries = m_entries.size;
+	stats.size = m_size;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.rejected = m_rejected;
+	stats.evictions = m_evictions;
+	stats.hitRate = (m_hits + m_misses > 0 ? float(m_hits) / float(m_hits + m_misses) : 0.f);
+	stats.timeSaved = double(m_timeSaved) / 1000.;
+	return stats;
+}
+
+int ProgramBinaryCache::FindEntry(unsigned long long key) const
+{
+	for (int i = 0; i < m_entries.size; ++i)
+	{
+		if (m_entries[i].key == key)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Removes the entry and its file.
+void ProgramBinaryCache::RemoveEntry(int index)
+{
+	char fileName[320];
+	GetFileName(m_entries[index].key, fileName, sizeof(fileName));
+	remove(fileName);
+
+	m_size -= m_entries[index].size;
+	m_entries.remove(index);
+}
+
+void ProgramBinaryCache::EvictLeastRecentlyUsed(int maxSize, int maxEntries)
+{
+	while ((m_size > maxSize || m_entries.size > maxEntries) && m_entries.size > 0)
+	{
+		int oldest = 0;
+		for (int i = 1; i < m_entries.size; ++i)
+		{
+			if (m_entries[i].lastUse < m_entries[oldest].lastUse)
+			{
+				oldest = i;
+			}
+		}
+		RemoveEntry(oldest);
+		++m_evictions;
+	}
+}
+
+void ProgramBinaryCache::GetFileName(unsigned long long key, char* fileName, int maxLength) const
+{
+	snprintf(fileName, maxLength, "%s/%016llx.bin", m_directory, key);
+}
+
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
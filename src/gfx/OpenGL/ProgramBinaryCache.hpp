@@ -0,0 +1,126 @@
+#pragma once
+
+#include "gfx/GraphicLayerConfig.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_PROGRAM_BINARY_CACHE
+
+namespace Gfx
+{
+	/// <summary>
+	/// Keeps linked program binaries in a directory, so the shaders of
+	/// the next launch don't need to be compiled again.
+	///
+	/// The cache only stores opaque blobs; OpenGLLayer computes the keys
+	/// and talks to the driver. The total size of the binaries is kept
+	/// under GFX_PROGRAM_BINARY_CACHE_SIZE by removing the least
+	/// recently used ones.
+	/// </summary>
+	class ProgramBinaryCache
+	{
+	public:
+		struct Stats
+		{
+			int		numberOfEntries;
+			int		size; // In bytes.
+
+			int		hits;
+			int		misses; // Including the rejected binaries.
+			int		rejected; // Found, but refused by the driver.
+			int		evictions;
+
+			// Ratio of the lookups that avoided a compilation, from 0
+			// to 1.
+			float	hitRate;
+
+			// Compilation time of the hits, minus the time it took to
+			// load their binary, in milliseconds.
+			double	timeSaved;
+		};
+
+		ProgramBinaryCache();
+		~ProgramBinaryCache();
+
+		/// <summary>
+		/// Reads the index of the cache. The directory must exist; it is
+		/// considered empty if it has no index yet.
+		/// </summary>
+		void				Init(const char* directory);
+
+		/// <summary>
+		/// Writes the index, so the binaries can be found next time.
+		/// </summary>
+		void				Shutdown();
+
+		/// <summary>
+		/// Computes a 64 bits hash of a buffer, to build keys. The seed
+		/// is either 0 or the hash of the previous buffers of the key.
+		/// </summary>
+		static unsigned long long Hash(const void* data, int size, unsigned long long seed);
+
+		/// <summary>
+		/// Reads the binary of a key, counting a miss if it's not found.
+		/// </summary>
+		/// <returns>The binary data, valid until the next call, or
+		/// nullptr.</returns>
+		const void*			Find(unsigned long long key, int* size, unsigned int* format);
+
+		/// <summary>
+		/// Counts a hit, once the driver has accepted a binary returned
+		/// by Find.
+		/// </summary>
+		///
+		/// <param name="loadTime">Time it took to load the binary, in
+		///     microseconds.</param>
+		void				ReportLoaded(unsigned long long key, int loadTime);
+
+		/// <summary>
+		/// Counts a miss and removes the binary, when the driver refused
+		/// a binary returned by Find.
+		/// </summary>
+		void				ReportRejected(unsigned long long key);
+
+		/// <summary>
+		/// Adds or replaces the binary of a key.
+		/// </summary>
+		///
+		/// <param name="compileTime">Time it took to compile and link
+		///     the program, in microseconds. It is what a hit saves.</param>
+		void				Store(unsigned long long key, unsigned int format,
+								  const void* data, int size, int compileTime);
+
+		Stats				GetStats() const;
+
+	private:
+		struct Entry
+		{
+			unsigned long long key;
+			int				size;
+			int				compileTime; // In microseconds.
+			unsigned int	lastUse;
+		};
+
+		int					FindEntry(unsigned long long key) const;
+		void				RemoveEntry(int index);
+		void				EvictLeastRecentlyUsed(int maxSize, int maxEntries);
+		void				GetFileName(unsigned long long key, char* fileName, int maxLength) const;
+
+		char				m_directory[256];
+		Container::Array<Entry> m_entries;
+		int					m_size;
+		unsigned int		m_lastUse;
+
+		// Returned by Find.
+		char*				m_buffer;
+		int					m_bufferCapacity;
+
+		int					m_hits;
+		int					m_misses;
+		int					m_rejected;
+		int					m_evictions;
+		long long			m_timeSaved; // In microseconds.
+	};
+}
+
+#endif // GFX_ENABLE_PROGRAM_BINARY_CACHE
@@ -0,0 +1,903 @@
+#include "RecordingLayer.hpp"
+
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+#include "engine/debug/Debug.hpp"
+#include "engine/noise/Hash.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+#include "gfx/DrawArea.hpp"
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+#include "gfx/DrawBatch.hpp"
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+#if GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/DrawItem.hpp"
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+#include "gfx/Geometry.hpp"
+#include "gfx/ShadingParameters.hpp"
+#include <chrono>
+#include <cstdio>
+
+#if GFX_MULTI_API
+
+// Maximum number of distinct raster tests and blending modes that are
+// numbered; the following ones are all recorded as -1.
+#define MAX_NUMBERED_STATES 256
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::RecordingLayer::Call>;
+template class Container::Array<Gfx::RasterTests>;
+template class Container::Array<Gfx::BlendingMode>;
+
+#endif
+
+//
+// How calls are written in a trace.
+//
+
+#define ARG(i) (1 << (i))
+
+struct CallDescription
+{
+	const char*	arguments[RecordingLayer::MaxArguments];
+	int			hashedArguments; // Written in hexadecimal.
+};
+
+static const CallDescription callDescriptions[] = {
+	{ { "result" }, 0 }, // CreateRenderingContext
+	{ {}, 0 }, // DestroyRenderingContext
+	{ { "id" }, 0 }, // CreateVertexBuffer
+	{ { "id" }, 0 }, // DestroyVertexBuffer
+	{ { "id", "primitiveType", "vertexDataSize", "indexDataSize", "data" }, ARG(4) }, // LoadVertexBuffer
+	{ { "id", "offset", "size", "data" }, ARG(3) }, // UpdateVertexBufferRange
+	{ { "id", "offset", "size", "data" }, ARG(3) }, // UpdateIndexBufferRange
+	{ { "source", "sourceOffset", "destination", "destinationOffset", "size" }, 0 }, // CopyVertexBufferRange
+	{ { "source", "sourceOffset", "destination", "destinationOffset", "size" }, 0 }, // CopyIndexBufferRange
+	{ { "id" }, 0 }, // CreateTexture
+	{ { "id" }, 0 }, // DestroyTexture
+	{ { "id", "width", "height", "format", "lodLevel" }, 0 }, // LoadTexture
+	{ { "id" }, 0 }, // GenerateMipMaps
+	{ { "id", "width", "height", "numberOfLayers", "format" }, 0 }, // LoadTextureArray
+	{ { "id", "layer" }, 0 }, // LoadTextureLayer
+	{ { "id", "width", "height", "numberOfLevels", "format" }, 0 }, // AllocateTexture
+	{ { "id", "level" }, 0 }, // LoadTextureLevel
+	{ { "id", "width", "height", "lodLevel", "data" }, ARG(4) }, // LoadCompressedTexture
+	{ { "id", "size" }, 0 }, // MapTextureUpload
+	{ { "id", "width", "height", "format", "lodLevel" }, 0 }, // LoadTextureAsync
+	{ { "id", "result" }, 0 }, // IsTextureReady
+	{ { "id" }, 0 }, // CreateUniformBuffer
+	{ { "id" }, 0 }, // DestroyUniformBuffer
+	{ { "id", "size", "data" }, ARG(2) }, // LoadUniformBuffer
+	{ { "id" }, 0 }, // CreateStorageBuffer
+	{ { "id" }, 0 }, // DestroyStorageBuffer
+	{ { "id", "size", "data" }, ARG(2) }, // LoadStorageBuffer
+	{ { "id", "size", "data" }, ARG(2) }, // ReadStorageBuffer
+	{ { "id" }, 0 }, // CreateShader
+	{ { "id" }, 0 }, // DestroyShader
+	{ { "id", "numberOfStages", "sources" }, ARG(2) }, // LoadShader
+	{ { "id", "numberOfStages", "sources" }, ARG(2) }, // LoadShaderAsync
+	{ { "id", "result" }, 0 }, // IsShaderReady
+	{ { "id", "numberOfTextures", "texture", "side", "lodLevel" }, 0 }, // CreateFrameBuffer
+	{ { "id" }, 0 }, // DestroyFrameBuffer
+	{ { "id", "color", "clearDepth" }, ARG(1) }, // ClearFrameBuffer
+	{ { "frameBuffer", "vertexBuffer", "shader", "numberOfIndices", "state" }, ARG(4) }, // Draw
+	{ { "frameBuffer", "vertexBuffer", "shader", "numberOfItems", "state" }, ARG(4) }, // DrawBatch
+	{ { "shader", "x", "y", "z", "uniforms" }, ARG(4) }, // Compute
+	{ { "name" }, ARG(0) }, // BeginGpuScope
+	{ {}, 0 }, // EndGpuScope
+	{ {}, 0 }, // EndFrame
+	{ { "numberOfItems", "numberOfShaders", "numberOfStates", "items" }, ARG(3) }, // SubmitDraws
+	{ { "shader", "arguments", "offset", "uniforms" }, ARG(3) }, // ComputeIndirect
+	{ { "barriers" }, ARG(0) }, // InsertMemoryBarrier
+	{ { "id", "offset", "size", "result" }, 0 }, // RequestReadback
+	{ { "frameBuffer", "width", "height", "result" }, 0 }, // RequestFrameBufferReadback
+	{ { "id", "result" }, 0 }, // TryGetReadback
+	{ { "frameBuffer", "vertexBuffer", "shader", "arguments", "state" }, ARG(4) }, // DrawIndirect
+	{ { "id", "numberOfTextures", "texture", "side", "lodLevel" }, 0 }, // LoadFrameBuffer
+	{ { "frameBuffer", "numberOfAttachments", "loadOps", "clearValues" }, ARG(2) | ARG(3) }, // BeginRenderPass
+	{ { "numberOfAttachments", "storeOps" }, ARG(1) }, // EndRenderPass
+};
+
+static_assert(sizeof(callDescriptions) / sizeof(callDescriptions[0]) == RecordingLayer::CallType::Count,
+			  "Each call type should have a description.");
+
+//
+// Helpers.
+//
+
+static long long getNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int hashData(const void* data, int size)
+{
+	return (data != nullptr && size > 0 ? (int)Noise::Hash::get32(data, size) : 0);
+}
+
+static int combineHashes(int hash, int value)
+{
+	return (int)Noise::Hash::get32(hash, value);
+}
+
+static int hashUniforms(const Uniform* uniforms, int numberOfUniforms)
+{
+	int hash = numberOfUniforms;
+	for (int i = 0; i < numberOfUniforms; ++i)
+	{
+		const Uniform& uniform = uniforms[i];
+		hash = combineHashes(hash, (int)Noise::Hash::get32(uniform.name));
+		hash = combineHashes(hash, uniform.type);
+		switch (uniform.type)
+		{
+		case UniformType::Float:
+			hash = combineHashes(hash, hashData(uniform.fValue, uniform.size * sizeof(float)));
+			break;
+		case UniformType::Int:
+			hash = combineHashes(hash, hashData(uniform.iValue, uniform.size * sizeof(int)));
+			break;
+		case UniformType::Sampler:
+			hash = combineHashes(hash, uniform.textureId.index);
+			break;
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+		case UniformType::UniformBuffer:
+			hash = combineHashes(hash, uniform.uniformBufferId.index);
+			break;
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		case UniformType::StorageBufferInput:
+		case UniformType::StorageBufferOutput:
+			hash = combineHashes(hash, uniform.storageBufferId.index);
+			break;
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+		}
+	}
+	return hash;
+}
+
+static int hashShaderStages(const ShaderStage* shaderStages, int numberOfStages)
+{
+	int hash = numberOfStages;
+	for (int i = 0; i < numberOfStages; ++i)
+	{
+		hash = combineHashes(hash, shaderStages[i].shaderType);
+		hash = combineHashes(hash, (int)Noise::Hash::get32(shaderStages[i].source));
+	}
+	return hash;
+}
+
+//
+// Recording.
+//
+
+RecordingLayer::RecordingLayer(IGraphicLayer* layer):
+	m_layer(layer),
+	m_calls(GFX_MAX_RECORDED_CALLS),
+	m_droppedCalls(0),
+	m_rasterTests(MAX_NUMBERED_STATES),
+	m_blendingModes(MAX_NUMBERED_STATES)
+{
+	ASSERT(layer != nullptr);
+}
+
+void RecordingLayer::Record(CallType::Enum type, long long duration,
+							int a, int b, int c, int d, int e)
+{
+	if (m_calls.size >= GFX_MAX_RECORDED_CALLS)
+	{
+		++m_droppedCalls;
+		return;
+	}
+
+	Call& call = m_calls.getNew();
+	call.type = type;
+	call.arguments[0] = a;
+	call.arguments[1] = b;
+	call.arguments[2] = c;
+	call.arguments[3] = d;
+	call.arguments[4] = e;
+	call.duration = duration;
+}
+
+int RecordingLayer::GetRasterTestsNumber(const RasterTests& rasterTests)
+{
+	for (int i = 0; i < m_rasterTests.size; ++i)
+	{
+		if (m_rasterTests[i] == rasterTests)
+		{
+			return i;
+		}
+	}
+	if (m_rasterTests.size >= MAX_NUMBERED_STATES)
+	{
+		return -1;
+	}
+	m_rasterTests.add(rasterTests);
+	return m_rasterTests.size - 1;
+}
+
+int RecordingLayer::GetBlendingModeNumber(const BlendingMode& blendingMode)
+{
+	for (int i = 0; i < m_blendingModes.size; ++i)
+	{
+		if (m_blendingModes[i] == blendingMode)
+		{
+			return i;
+		}
+	}
+	if (m_blendingModes.size >= MAX_NUMBERED_STATES)
+	{
+		return -1;
+	}
+	m_blendingModes.add(blendingMode);
+	return m_blendingModes.size - 1;
+}
+
+int RecordingLayer::HashShadingParameters(const DrawArea& drawArea,
+										  const RasterTests& rasterTests,
+										  const ShadingParameters& shadingParameters)
+{
+	int hash = (int)Noise::Hash::get32(drawArea.viewport.x, drawArea.viewport.y,
+									   drawArea.viewport.width, drawArea.viewport.height);
+	hash = combineHashes(hash, GetRasterTestsNumber(rasterTests));
+	hash = combineHashes(hash, GetBlendingModeNumber(shadingParameters.blendingMode));
+	hash = combineHashes(hash, shadingParameters.polygonMode);
+	hash = combineHashes(hash, shadingParameters.numberOfInstances);
+	return combineHashes(hash, hashUniforms(shadingParameters.uniforms.elt, shadingParameters.uniforms.size));
+}
+
+void RecordingLayer::ClearTrace()
+{
+	m_calls.clear();
+	m_droppedCalls = 0;
+}
+
+bool RecordingLayer::WriteTrace(const char* fileName, bool includeTimings) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == nullptr)
+	{
+		LOG_ERROR("Could not write call trace %s.", fileName);
+		return false;
+	}
+
+	for (int i = 0; i < m_calls.size; ++i)
+	{
+		const Call& call = m_calls[i];
+		const CallDescription& description = callDescriptions[call.type];
+		fprintf(file, "%s", GetCallName(call.type));
+		for (int j = 0; j < MaxArguments && description.arguments[j] != nullptr; ++j)
+		{
+			if ((description.hashedArguments & ARG(j)) != 0)
+			{
+				fprintf(file, " %s=%08x", description.arguments[j], (unsigned int)call.arguments[j]);
+			}
+			else
+			{
+				fprintf(file, " %s=%d", description.arguments[j], call.arguments[j]);
+			}
+		}
+		if (includeTimings)
+		{
+			fprintf(file, " (%lld ns)", call.duration);
+		}
+		fprintf(file, "\n");
+	}
+	if (m_droppedCalls > 0)
+	{
+		fprintf(file, "(%d calls not recorded)\n", m_droppedCalls);
+	}
+	fclose(file);
+
+	LOG_INFO("Call trace written to %s: %d calls.", fileName, m_calls.size);
+	return true;
+}
+
+//
+// Forwarded calls.
+//
+
+bool RecordingLayer::CreateRenderingContext()
+{
+	const long long start = getNanoseconds();
+	const bool result = m_layer->CreateRenderingContext();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateRenderingContext, duration, result);
+	return result;
+}
+
+void RecordingLayer::DestroyRenderingContext()
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyRenderingContext();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyRenderingContext, duration);
+}
+
+VertexBufferID RecordingLayer::CreateVertexBuffer()
+{
+	const long long start = getNanoseconds();
+	const VertexBufferID id = m_layer->CreateVertexBuffer();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateVertexBuffer, duration, id.index);
+	return id;
+}
+
+void RecordingLayer::DestroyVertexBuffer(const VertexBufferID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyVertexBuffer(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyVertexBuffer, duration, id.index);
+}
+
+void RecordingLayer::LoadVertexBuffer(const VertexBufferID id,
+									  PrimitiveType::Enum primitiveType,
+									  const VertexAttribute* vertexAttributes,
+									  int numberOfAttributes, int stride,
+									  int vertexDataSize, const void* vertexData,
+									  int indexDataSize, const void* indexData,
+									  VertexIndexType::Enum indexType)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadVertexBuffer(id, primitiveType, vertexAttributes, numberOfAttributes, stride,
+							  vertexDataSize, vertexData, indexDataSize, indexData, indexType);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadVertexBuffer, duration, id.index, primitiveType, vertexDataSize, indexDataSize,
+		   combineHashes(hashData(vertexData, vertexDataSize), hashData(indexData, indexDataSize)));
+}
+
+void RecordingLayer::UpdateVertexBufferRange(const VertexBufferID id,
+											 int offset, int size,
+											 const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->UpdateVertexBufferRange(id, offset, size, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::UpdateVertexBufferRange, duration, id.index, offset, size, hashData(data, size));
+}
+
+void RecordingLayer::UpdateIndexBufferRange(const VertexBufferID id,
+											int offset, int size,
+											const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->UpdateIndexBufferRange(id, offset, size, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::UpdateIndexBufferRange, duration, id.index, offset, size, hashData(data, size));
+}
+
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+void RecordingLayer::CopyVertexBufferRange(const VertexBufferID source,
+										   int sourceOffset,
+										   const VertexBufferID destination,
+										   int destinationOffset,
+										   int size)
+{
+	const long long start = getNanoseconds();
+	m_layer->CopyVertexBufferRange(source, sourceOffset, destination, destinationOffset, size);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CopyVertexBufferRange, duration, source.index, sourceOffset, destination.index, destinationOffset, size);
+}
+
+void RecordingLayer::CopyIndexBufferRange(const VertexBufferID source,
+										  int sourceOffset,
+										  const VertexBufferID destination,
+										  int destinationOffset,
+										  int size)
+{
+	const long long start = getNanoseconds();
+	m_layer->CopyIndexBufferRange(source, sourceOffset, destination, destinationOffset, size);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CopyIndexBufferRange, duration, source.index, sourceOffset, destination.index, destinationOffset, size);
+}
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+
+TextureID RecordingLayer::CreateTexture()
+{
+	const long long start = getNanoseconds();
+	const TextureID id = m_layer->CreateTexture();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateTexture, duration, id.index);
+	return id;
+}
+
+void RecordingLayer::DestroyTexture(const TextureID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyTexture(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyTexture, duration, id.index);
+}
+
+void RecordingLayer::LoadTexture(const TextureID id,
+								 int width, int height,
+								 TextureType::Enum textureType,
+								 TextureFormat::Enum textureFormat,
+								 int side, int lodLevel,
+								 const void* data,
+								 const TextureSampling& textureSampling)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadTexture(id, width, height, textureType, textureFormat, side, lodLevel, data, textureSampling);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadTexture, duration, id.index, width, height, textureFormat, lodLevel);
+}
+
+void RecordingLayer::GenerateMipMaps(const TextureID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->GenerateMipMaps(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::GenerateMipMaps, duration, id.index);
+}
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+void RecordingLayer::LoadTextureArray(const TextureID id,
+									  int width, int height,
+									  int numberOfLayers,
+									  TextureFormat::Enum textureFormat,
+									  const TextureSampling& textureSampling)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadTextureArray(id, width, height, numberOfLayers, textureFormat, textureSampling);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadTextureArray, duration, id.index, width, height, numberOfLayers, textureFormat);
+}
+
+void RecordingLayer::LoadTextureLayer(const TextureID id, int layer, const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadTextureLayer(id, layer, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadTextureLayer, duration, id.index, layer);
+}
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
+
+#if GFX_ENABLE_TEXTURE_STORAGE
+void RecordingLayer::AllocateTexture(const TextureID id,
+									 int width, int height,
+									 int numberOfLevels,
+									 TextureFormat::Enum textureFormat,
+									 const TextureSampling& textureSampling)
+{
+	const long long start = getNanoseconds();
+	m_layer->AllocateTexture(id, width, height, numberOfLevels, textureFormat, textureSampling);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::AllocateTexture, duration, id.index, width, height, numberOfLevels, textureFormat);
+}
+
+void RecordingLayer::LoadTextureLevel(const TextureID id, int level, const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadTextureLevel(id, level, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadTextureLevel, duration, id.index, level);
+}
+#endif // GFX_ENABLE_TEXTURE_STORAGE
+
+#if GFX_ENABLE_COMPRESSED_TEXTURES
+void RecordingLayer::LoadCompressedTexture(const TextureID id,
+										   int width, int height,
+										   TextureFormat::Enum textureFormat,
+										   int lodLevel,
+										   int dataSize, const void* data,
+										   const TextureSampling& textureSampling)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadCompressedTexture(id, width, height, textureFormat, lodLevel, dataSize, data, textureSampling);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadCompressedTexture, duration, id.index, width, height, lodLevel, hashData(data, dataSize));
+}
+#endif // GFX_ENABLE_COMPRESSED_TEXTURES
+
+#if GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+void* RecordingLayer::MapTextureUpload(const TextureID id, int size)
+{
+	const long long start = getNanoseconds();
+	void* buffer = m_layer->MapTextureUpload(id, size);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::MapTextureUpload, duration, id.index, size);
+	return buffer;
+}
+
+void RecordingLayer::LoadTextureAsync(const TextureID id,
+									  int width, int height,
+									  TextureType::Enum textureType,
+									  TextureFormat::Enum textureFormat,
+									  int side, int lodLevel,
+									  const TextureSampling& textureSampling)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadTextureAsync(id, width, height, textureType, textureFormat, side, lodLevel, textureSampling);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadTextureAsync, duration, id.index, width, height, textureFormat, lodLevel);
+}
+
+bool RecordingLayer::IsTextureReady(const TextureID id)
+{
+	const long long start = getNanoseconds();
+	const bool result = m_layer->IsTextureReady(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::IsTextureReady, duration, id.index, result);
+	return result;
+}
+#endif // GFX_ENABLE_ASYNC_TEXTURE_UPLOAD
+
+#if GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+UniformBufferID RecordingLayer::CreateUniformBuffer()
+{
+	const long long start = getNanoseconds();
+	const UniformBufferID id = m_layer->CreateUniformBuffer();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateUniformBuffer, duration, id.index);
+	return id;
+}
+
+void RecordingLayer::DestroyUniformBuffer(const UniformBufferID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyUniformBuffer(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyUniformBuffer, duration, id.index);
+}
+
+void RecordingLayer::LoadUniformBuffer(const UniformBufferID id,
+									   int size,
+									   const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadUniformBuffer(id, size, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadUniformBuffer, duration, id.index, size, hashData(data, size));
+}
+#endif // GFX_ENABLE_UNIFORM_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+StorageBufferID RecordingLayer::CreateStorageBuffer()
+{
+	const long long start = getNanoseconds();
+	const StorageBufferID id = m_layer->CreateStorageBuffer();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateStorageBuffer, duration, id.index);
+	return id;
+}
+
+void RecordingLayer::DestroyStorageBuffer(const StorageBufferID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyStorageBuffer(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyStorageBuffer, duration, id.index);
+}
+
+void RecordingLayer::LoadStorageBuffer(const StorageBufferID id, size_t size, const void* data)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadStorageBuffer(id, size, data);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadStorageBuffer, duration, id.index, (int)size, hashData(data, (int)size));
+}
+
+void RecordingLayer::ReadStorageBuffer(const StorageBufferID id, size_t size, void* dest)
+{
+	const long long start = getNanoseconds();
+	m_layer->ReadStorageBuffer(id, size, dest);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::ReadStorageBuffer, duration, id.index, (int)size, hashData(dest, (int)size));
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_ASYNC_READBACK
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+ReadbackID RecordingLayer::RequestReadback(const StorageBufferID id, int offset, int size)
+{
+	const long long start = getNanoseconds();
+	const ReadbackID result = m_layer->RequestReadback(id, offset, size);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::RequestReadback, duration, id.index, offset, size, result.index);
+	return result;
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+ReadbackID RecordingLayer::RequestReadback(const FrameBufferID id,
+										   int x, int y,
+										   int width, int height)
+{
+	const long long start = getNanoseconds();
+	const ReadbackID result = m_layer->RequestReadback(id, x, y, width, height);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::RequestFrameBufferReadback, duration, id.index, width, height, result.index);
+	return result;
+}
+
+bool RecordingLayer::TryGetReadback(const ReadbackID id, void* dest)
+{
+	const long long start = getNanoseconds();
+	const bool result = m_layer->TryGetReadback(id, dest);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::TryGetReadback, duration, id.index, result);
+	return result;
+}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
+ShaderID RecordingLayer::CreateShader()
+{
+	const long long start = getNanoseconds();
+	const ShaderID id = m_layer->CreateShader();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateShader, duration, id.index);
+	return id;
+}
+
+void RecordingLayer::DestroyShader(const ShaderID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyShader(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyShader, duration, id.index);
+}
+
+void RecordingLayer::LoadShader(const ShaderID id,
+								const ShaderStage* shaderStages,
+								int numberOfStages)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadShader(id, shaderStages, numberOfStages);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadShader, duration, id.index, numberOfStages, hashShaderStages(shaderStages, numberOfStages));
+}
+
+#if GFX_ENABLE_ASYNC_SHADER_COMPILATION
+void RecordingLayer::LoadShaderAsync(const ShaderID id,
+									 const ShaderStage* shaderStages,
+									 int numberOfStages)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadShaderAsync(id, shaderStages, numberOfStages);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadShaderAsync, duration, id.index, numberOfStages, hashShaderStages(shaderStages, numberOfStages));
+}
+
+bool RecordingLayer::IsShaderReady(const ShaderID id)
+{
+	const long long start = getNanoseconds();
+	const bool result = m_layer->IsShaderReady(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::IsShaderReady, duration, id.index, result);
+	return result;
+}
+#endif // GFX_ENABLE_ASYNC_SHADER_COMPILATION
+
+FrameBufferID RecordingLayer::CreateFrameBuffer(const TextureID* textures,
+												int numberOfTextures,
+												int side, int lodLevel)
+{
+	const long long start = getNanoseconds();
+	const FrameBufferID id = m_layer->CreateFrameBuffer(textures, numberOfTextures, side, lodLevel);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::CreateFrameBuffer, duration, id.index, numberOfTextures,
+		   (numberOfTextures > 0 ? textures[0].index : -1), side, lodLevel);
+	return id;
+}
+
+void RecordingLayer::LoadFrameBuffer(const FrameBufferID id,
+									 const TextureID* textures,
+									 int numberOfTextures,
+									 int side, int lodLevel)
+{
+	const long long start = getNanoseconds();
+	m_layer->LoadFrameBuffer(id, textures, numberOfTextures, side, lodLevel);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::LoadFrameBuffer, duration, id.index, numberOfTextures,
+		   (numberOfTextures > 0 ? textures[0].index : -1), side, lodLevel);
+}
+
+void RecordingLayer::DestroyFrameBuffer(const FrameBufferID id)
+{
+	const long long start = getNanoseconds();
+	m_layer->DestroyFrameBuffer(id);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::DestroyFrameBuffer, duration, id.index);
+}
+
+void RecordingLayer::ClearFrameBuffer(const FrameBufferID frameBuffer,
+									  float r, float g, float b,
+									  bool clearDepth)
+{
+	const long long start = getNanoseconds();
+	m_layer->ClearFrameBuffer(frameBuffer, r, g, b, clearDepth);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::ClearFrameBuffer, duration, frameBuffer.index, (int)Noise::Hash::get32(r, g, b), clearDepth);
+}
+
+#if GFX_ENABLE_RENDER_PASSES
+void RecordingLayer::BeginRenderPass(const FrameBufferID id,
+									 const LoadOp::Enum* loadOps,
+									 const ClearValue* clearValues,
+									 int numberOfAttachments)
+{
+	const long long start = getNanoseconds();
+	m_layer->BeginRenderPass(id, loadOps, clearValues, numberOfAttachments);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::BeginRenderPass, duration, id.index, numberOfAttachments,
+		   hashData(loadOps, numberOfAttachments * sizeof(LoadOp::Enum)),
+		   hashData(clearValues, numberOfAttachments * sizeof(ClearValue)));
+}
+
+void RecordingLayer::EndRenderPass(const StoreOp::Enum* storeOps,
+								   int numberOfAttachments)
+{
+	const long long start = getNanoseconds();
+	m_layer->EndRenderPass(storeOps, numberOfAttachments);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::EndRenderPass, duration, numberOfAttachments,
+		   hashData(storeOps, numberOfAttachments * sizeof(StoreOp::Enum)));
+}
+#endif // GFX_ENABLE_RENDER_PASSES
+
+void RecordingLayer::Draw(const DrawArea& drawArea,
+						  const RasterTests& rasterTests,
+						  const Geometry& geometry,
+						  const ShadingParameters& shadingParameters)
+{
+	const long long start = getNanoseconds();
+	m_layer->Draw(drawArea, rasterTests, geometry, shadingParameters);
+	const long long duration = getNanoseconds() - start;
+
+	int state = HashShadingParameters(drawArea, rasterTests, shadingParameters);
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	state = combineHashes(state, (int)Noise::Hash::get32(geometry.firstIndexOffset, geometry.baseVertex));
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+	Record(CallType::Draw, duration, drawArea.frameBuffer.index, geometry.vertexBuffer.index,
+		   shadingParameters.shader.index, geometry.numberOfIndices, state);
+}
+
+#if GFX_ENABLE_MULTI_DRAW_INDIRECT
+void RecordingLayer::Draw(const DrawArea& drawArea,
+						  const RasterTests& rasterTests,
+						  const DrawBatch& batch,
+						  const ShadingParameters& shadingParameters)
+{
+	const long long start = getNanoseconds();
+	m_layer->Draw(drawArea, rasterTests, batch, shadingParameters);
+	const long long duration = getNanoseconds() - start;
+
+	int state = HashShadingParameters(drawArea, rasterTests, shadingParameters);
+	state = combineHashes(state, hashData(batch.items.elt, batch.items.size * sizeof(DrawBatch::Item)));
+	Record(CallType::DrawBatch, duration, drawArea.frameBuffer.index, batch.vertexBuffer.index,
+		   shadingParameters.shader.index, batch.items.size, state);
+}
+#endif // GFX_ENABLE_MULTI_DRAW_INDIRECT
+
+#if GFX_ENABLE_SUBMIT_DRAWS
+// Recorded as a single call: the number of shader and state changes
+// between consecutive items tells how well the items were sorted.
+void RecordingLayer::SubmitDraws(const DrawItem* items, int count)
+{
+	const long long start = getNanoseconds();
+	m_layer->SubmitDraws(items, count);
+	const long long duration = getNanoseconds() - start;
+
+	int numberOfShaders = 0;
+	int numberOfStates = 0;
+	int stateHash = 0;
+	int hash = count;
+	for (int i = 0; i < count; ++i)
+	{
+		const DrawItem& item = items[i];
+		if (i == 0 || item.shader != items[i - 1].shader)
+		{
+			++numberOfShaders;
+		}
+		if (i == 0 || item.state != items[i - 1].state)
+		{
+			const DrawState& state = *item.state;
+			stateHash = (int)Noise::Hash::get32(state.drawArea.viewport.x, state.drawArea.viewport.y,
+												state.drawArea.viewport.width, state.drawArea.viewport.height);
+			stateHash = combineHashes(stateHash, state.drawArea.frameBuffer.index);
+			stateHash = combineHashes(stateHash, GetRasterTestsNumber(state.rasterTests));
+			stateHash = combineHashes(stateHash, GetBlendingModeNumber(state.blendingMode));
+			stateHash = combineHashes(stateHash, state.polygonMode);
+			++numberOfStates;
+		}
+		hash = combineHashes(hash, stateHash);
+		hash = combineHashes(hash, (int)Noise::Hash::get32(item.shader.index, item.vertexBuffer.index,
+														   item.numberOfIndices, item.numberOfInstances));
+#if GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		hash = combineHashes(hash, (int)Noise::Hash::get32(item.firstIndexOffset, item.baseVertex));
+#endif // GFX_ENABLE_VERTEX_BUFFER_OFFSET
+		hash = combineHashes(hash, hashUniforms(item.uniforms, item.numberOfUniforms));
+	}
+	Record(CallType::SubmitDraws, duration, count, numberOfShaders, numberOfStates, hash);
+}
+#endif // GFX_ENABLE_SUBMIT_DRAWS
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void RecordingLayer::DrawIndirect(const DrawArea& drawArea,
+								  const RasterTests& rasterTests,
+								  const VertexBufferID vertexBuffer,
+								  const ShadingParameters& shadingParameters,
+								  const StorageBufferID arguments,
+								  int offset)
+{
+	const long long start = getNanoseconds();
+	m_layer->DrawIndirect(drawArea, rasterTests, vertexBuffer, shadingParameters, arguments, offset);
+	const long long duration = getNanoseconds() - start;
+
+	int state = HashShadingParameters(drawArea, rasterTests, shadingParameters);
+	state = combineHashes(state, offset);
+	Record(CallType::DrawIndirect, duration, drawArea.frameBuffer.index, vertexBuffer.index,
+		   shadingParameters.shader.index, arguments.index, state);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_COMPUTE_SHADERS
+void RecordingLayer::Compute(const ShaderID shader,
+							 const ComputeParameters& computeParameters,
+							 int x, int y, int z)
+{
+	const long long start = getNanoseconds();
+	m_layer->Compute(shader, computeParameters, x, y, z);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::Compute, duration, shader.index, x, y, z, hashUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size));
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS
+
+#if GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void RecordingLayer::ComputeIndirect(const ShaderID shader,
+									 const ComputeParameters& computeParameters,
+									 const StorageBufferID arguments,
+									 int offset)
+{
+	const long long start = getNanoseconds();
+	m_layer->ComputeIndirect(shader, computeParameters, arguments, offset);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::ComputeIndirect, duration, shader.index, arguments.index, offset,
+		   hashUniforms(computeParameters.uniforms.elt, computeParameters.uniforms.size));
+}
+#endif // GFX_ENABLE_COMPUTE_SHADERS && GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_STORAGE_BUFFER_OBJECT
+void RecordingLayer::InsertMemoryBarrier(int barriers)
+{
+	const long long start = getNanoseconds();
+	m_layer->InsertMemoryBarrier(barriers);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::InsertMemoryBarrier, duration, barriers);
+}
+#endif // GFX_ENABLE_STORAGE_BUFFER_OBJECT
+
+#if GFX_ENABLE_GPU_PROFILING
+void RecordingLayer::BeginGpuScope(const char* name)
+{
+	const long long start = getNanoseconds();
+	m_layer->BeginGpuScope(name);
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::BeginGpuScope, duration, (int)Noise::Hash::get32(name));
+}
+
+void RecordingLayer::EndGpuScope()
+{
+	const long long start = getNanoseconds();
+	m_layer->EndGpuScope();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::EndGpuScope, duration);
+}
+#endif // GFX_ENABLE_GPU_PROFILING
+
+void RecordingLayer::EndFrame()
+{
+	const long long start = getNanoseconds();
+	m_layer->EndFrame();
+	const long long duration = getNanoseconds() - start;
+	Record(CallType::EndFrame, duration);
+}
+
+#endif // GFX_MULTI_API
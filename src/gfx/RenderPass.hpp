@@ -0,0 +1,44 @@
+#pragma once
+
+namespace Gfx
+{
+	// Maximum number of attachments of a frame buffer: the color ones,
+	// and depth and stencil.
+	static const int MaxFrameBufferAttachments = 6;
+
+	/// <summary>
+	/// What a render pass does with the content of an attachment when it
+	/// begins, for IGraphicLayer::BeginRenderPass().
+	/// </summary>
+	struct LoadOp
+	{
+		enum Enum {
+			Load,		// Kept from before the pass.
+			Clear,		// Cleared to the clear value of the attachment.
+			DontCare,	// Undefined; the pass overwrites all of it.
+		};
+	};
+
+	/// <summary>
+	/// What a render pass does with the content of an attachment when it
+	/// ends, for IGraphicLayer::EndRenderPass().
+	/// </summary>
+	struct StoreOp
+	{
+		enum Enum {
+			Store,		// Kept for the following passes.
+			DontCare,	// Discarded, like a depth buffer nothing reads.
+		};
+	};
+
+	/// <summary>
+	/// Value an attachment is cleared to with LoadOp::Clear: the color
+	/// for a color attachment, the depth and stencil otherwise.
+	/// </summary>
+	struct ClearValue
+	{
+		float		color[4];
+		float		depth;
+		int			stencil;
+	};
+}
@@ -0,0 +1,285 @@
+#include "RenderTargetPool.hpp"
+
+#include "IGraphicLayerImplementations.hpp"
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::RenderTargetPool::TargetInfo>;
+
+#endif
+
+const RenderTargetID RenderTargetID::InvalidID = { -1 };
+
+// Size of a pixel as the driver is likely to store it; depth is
+// typically padded to 32 bits.
+static int bytesPerPixel(TextureFormat::Enum textureFormat)
+{
+	switch (textureFormat)
+	{
+	case TextureFormat::Stencil:	return 1;
+	case TextureFormat::Depth:		return 4;
+	case TextureFormat::D24S8:		return 4;
+	case TextureFormat::R8:			return 1;
+	case TextureFormat::RG8:		return 2;
+	case TextureFormat::RGB5_A1:	return 2;
+	case TextureFormat::RGBA8:		return 4;
+	case TextureFormat::RGBA16:		return 8;
+	case TextureFormat::R16f:		return 2;
+	case TextureFormat::RG16f:		return 4;
+	case TextureFormat::RGBA16f:	return 8;
+	case TextureFormat::R32f:		return 4;
+	case TextureFormat::RG32f:		return 8;
+	case TextureFormat::RGBA32f:	return 16;
+	case TextureFormat::R11G11B10f:	return 4;
+	default:
+		// Compressed formats can't be rendered to.
+		ASSERT(false);
+		return 0;
+	}
+}
+
+RenderTargetPool::RenderTargetPool():
+	m_gfxLayer(nullptr),
+	m_framesBeforeRelease(0),
+	m_numberOfFreeFrameBuffers(0),
+	m_numberOfFreeTextures(0),
+	m_frame(0),
+	m_memory(0),
+	m_peakMemory(0),
+	m_numberOfAcquisitions(0),
+	m_numberOfReuses(0)
+{
+}
+
+void RenderTargetPool::Init(IGraphicLayer* gfxLayer,
+							int framesBeforeRelease,
+							const TextureSampling& textureSampling)
+{
+	ASSERT(gfxLayer != nullptr);
+	ASSERT(m_gfxLayer == nullptr);
+	ASSERT(framesBeforeRelease > 0);
+
+	m_gfxLayer = gfxLayer;
+	m_framesBeforeRelease = framesBeforeRelease;
+	m_textureSampling = textureSampling;
+	m_targets.init(GFX_MAX_POOLED_RENDER_TARGETS);
+	m_numberOfFreeFrameBuffers = 0;
+	m_numberOfFreeTextures = 0;
+	m_frame = 0;
+	m_memory = 0;
+	m_peakMemory = 0;
+	m_numberOfAcquisitions = 0;
+	m_numberOfReuses = 0;
+}
+
+void RenderTargetPool::Shutdown()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	for (int i = 0; i < m_targets.size; ++i)
+	{
+		const TargetInfo& target = m_targets[i];
+		if (target.frameBuffer != FrameBufferID::InvalidID)
+		{
+			m_gfxLayer->DestroyFrameBuffer(target.frameBuffer);
+			for (int j = 0; j < target.numberOfTextures; ++j)
+			{
+				m_gfxLayer->DestroyTexture(target.textures[j]);
+			}
+		}
+	}
+	m_targets.clear();
+	m_memory = 0;
+
+	for (int i = 0; i < m_numberOfFreeFrameBuffers; ++i)
+	{
+		m_gfxLayer->DestroyFrameBuffer(m_freeFrameBuffers[i]);
+	}
+	for (int i = 0; i < m_numberOfFreeTextures; ++i)
+	{
+		m_gfxLayer->DestroyTexture(m_freeTextures[i]);
+	}
+	m_numberOfFreeFrameBuffers = 0;
+	m_numberOfFreeTextures = 0;
+	m_gfxLayer = nullptr;
+}
+
+RenderTargetID RenderTargetPool::Acquire(int width, int height,
+										 TextureFormat::Enum textureFormat,
+										 int numberOfTextures)
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(width > 0 && height > 0);
+	ASSERT(numberOfTextures > 0 && numberOfTextures <= MaxTextures);
+	ASSERT(textureFormat > TextureFormat::D24S8 || numberOfTextures == 1);
+
+	++m_numberOfAcquisitions;
+
+	// A target of the same kind that isn't in use, or else a slot of an
+	// evicted target.
+	int freeSlot = -1;
+	for (int i = 0; i < m_targets.size; ++i)
+	{
+		TargetInfo& target = m_targets[i];
+		if (target.frameBuffer == FrameBufferID::InvalidID)
+		{
+			freeSlot = (freeSlot < 0 ? i : freeSlot);
+			continue;
+		}
+		if (!target.inUse &&
+			target.width == width &&
+			target.height == height &&
+			target.format == textureFormat &&
+			target.numberOfTextures == numberOfTextures)
+		{
+			target.inUse = true;
+			target.lastFrame = m_frame;
+			++m_numberOfReuses;
+
+			RenderTargetID id = { i };
+			return id;
+		}
+	}
+
+	if (freeSlot < 0)
+	{
+		if (m_targets.size >= GFX_MAX_POOLED_RENDER_TARGETS)
+		{
+			return RenderTargetID::InvalidID;
+		}
+		m_targets.getNew();
+		freeSlot = m_targets.size - 1;
+	}
+
+	TargetInfo& target = m_targets[freeSlot];
+	for (int i = 0; i < numberOfTextures; ++i)
+	{
+		target.textures[i] = (m_numberOfFreeTextures > 0 ?
+							  m_freeTextures[--m_numberOfFreeTextures] :
+							  m_gfxLayer->CreateTexture());
+		m_gfxLayer->LoadTexture(target.textures[i], width, height,
+								TextureType::Texture2D, textureFormat,
+								0, 0, nullptr, m_textureSampling);
+	}
+	if (m_numberOfFreeFrameBuffers > 0)
+	{
+		target.frameBuffer = m_freeFrameBuffers[--m_numberOfFreeFrameBuffers];
+		m_gfxLayer->LoadFrameBuffer(target.frameBuffer, target.textures, numberOfTextures, 0, 0);
+	}
+	else
+	{
+		target.frameBuffer = m_gfxLayer->CreateFrameBuffer(target.textures, numberOfTextures, 0, 0);
+	}
+	target.numberOfTextures = numberOfTextures;
+	target.width = width;
+	target.height = height;
+	target.format = textureFormat;
+	target.memory = (long long)width * height * bytesPerPixel(textureFormat) * numberOfTextures;
+	target.lastFrame = m_frame;
+	target.inUse = true;
+
+	m_memory += target.memory;
+	m_peakMemory = (m_memory > m_peakMemory ? m_memory : m_peakMemory);
+
+	RenderTargetID id = { freeSlot };
+	return id;
+}
+
+void RenderTargetPool::Release(const RenderTargetID id)
+{
+	ASSERT(id.index >= 0 && id.index < m_targets.size);
+	ASSERT(m_targets[id.index].inUse);
+
+	m_targets[id.index].inUse = false;
+}
+
+FrameBufferID RenderTargetPool::GetFrameBuffer(const RenderTargetID id) const
+{
+	ASSERT(id.index >= 0 && id.index < m_targets.size);
+	ASSERT(m_targets[id.index].inUse);
+
+	return m_targets[id.index].frameBuffer;
+}
+
+TextureID RenderTargetPool::GetTexture(const RenderTargetID id, int index) const
+{
+	ASSERT(id.index >= 0 && id.index < m_targets.size);
+	ASSERT(m_targets[id.index].inUse);
+	ASSERT(index >= 0 && index < m_targets[id.index].numberOfTextures);
+
+	return m_targets[id.index].textures[index];
+}
+
+void RenderTargetPool::EndFrame()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	for (int i = 0; i < m_targets.size; ++i)
+	{
+		TargetInfo& target = m_targets[i];
+		if (target.frameBuffer == FrameBufferID::InvalidID)
+		{
+			continue;
+		}
+		ASSERT(!target.inUse);
+		if (!target.inUse && m_frame - target.lastFrame >= m_framesBeforeRelease)
+		{
+			EvictTarget(target);
+		}
+	}
+
+	// Trailing slots are dropped, so the search stays short.
+	while (m_targets.size > 0 && m_targets.last().frameBuffer == FrameBufferID::InvalidID)
+	{
+		m_targets.pop();
+	}
+	++m_frame;
+}
+
+RenderTargetPool::Stats RenderTargetPool::GetStats() const
+{
+	Stats stats;
+	stats.numberOfTargets = 0;
+	stats.numberOfTargetsInUse = 0;
+	for (int i = 0; i < m_targets.size; ++i)
+	{
+		if (m_targets[i].frameBuffer != FrameBufferID::InvalidID)
+		{
+			++stats.numberOfTargets;
+			stats.numberOfTargetsInUse += (m_targets[i].inUse ? 1 : 0);
+		}
+	}
+	stats.memory = m_memory;
+	stats.peakMemory = m_peakMemory;
+	stats.numberOfAcquisitions = m_numberOfAcquisitions;
+	stats.numberOfReuses = m_numberOfReuses;
+	return stats;
+}
+
+// Releases the memory of a target, and keeps its ids for the next
+// ones. The frame buffer is loaded again with the shrunk textures, so it
+// doesn't keep their previous storage referenced.
+void RenderTargetPool::EvictTarget(TargetInfo& target)
+{
+	for (int i = 0; i < target.numberOfTextures; ++i)
+	{
+		m_gfxLayer->LoadTexture(target.textures[i], 1, 1,
+								TextureType::Texture2D, target.format,
+								0, 0, nullptr, m_textureSampling);
+		m_freeTextures[m_numberOfFreeTextures++] = target.textures[i];
+	}
+	m_gfxLayer->LoadFrameBuffer(target.frameBuffer, target.textures, target.numberOfTextures, 0, 0);
+	m_freeFrameBuffers[m_numberOfFreeFrameBuffers++] = target.frameBuffer;
+	m_memory -= target.memory;
+	target.frameBuffer = FrameBufferID::InvalidID;
+	target.inUse = false;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+#include "ResourceID.hpp"
+#include "TextureFormat.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Identifier of a render target acquired from a RenderTargetPool.
+	/// </summary>
+	struct RenderTargetID
+	{
+		int index;
+
+		static const RenderTargetID InvalidID;
+	};
+
+	inline
+	bool operator == (const RenderTargetID lhs, const RenderTargetID rhs)
+	{
+		return lhs.index == rhs.index;
+	}
+
+	inline
+	bool operator != (const RenderTargetID lhs, const RenderTargetID rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	/// <summary>
+	/// Hands out frame buffers and their textures for intermediate
+	/// results that only live for a pass or two, like the steps of a
+	/// post-processing chain.
+	///
+	/// A target is acquired by size, format and number of textures, and
+	/// released once the last pass reading it is submitted; a later
+	/// pass asking for the same kind of target gets it back rather than
+	/// a new one. A chain then only needs as many targets as are alive
+	/// at the same time, instead of one per pass.
+	///
+	/// Targets that stay unused for a few frames are evicted, so a
+	/// change of resolution doesn't keep the old ones. Their textures
+	/// are shrunk rather than destroyed, and their ids and the frame
+	/// buffer's are loaded again for the next new targets: the layer
+	/// doesn't reuse the ids of destroyed resources, so its tables would
+	/// otherwise grow with each change.
+	/// </summary>
+	class RenderTargetPool
+	{
+	public:
+		// Maximum number of textures of a target, as color attachments.
+		static const int MaxTextures = 4;
+
+		struct Stats
+		{
+			int			numberOfTargets; // In use or not.
+			int			numberOfTargetsInUse;
+
+			// Estimated sizes in bytes of the textures of the targets,
+			// and the maximum it reached since Init().
+			long long	memory;
+			long long	peakMemory;
+
+			// Since Init(); a reuse is an acquisition that didn't need
+			// a new target.
+			int			numberOfAcquisitions;
+			int			numberOfReuses;
+		};
+
+		RenderTargetPool();
+
+		/// <summary>
+		/// Sets the parameters of the targets, which are created on
+		/// demand.
+		/// </summary>
+		///
+		/// <param name="framesBeforeRelease">Number of frames a target
+		///     is kept without being acquired, before it is evicted.</param>
+		/// <param name="textureSampling">Sampling of the textures, when
+		///     the following passes read them.</param>
+		void				Init(IGraphicLayer* gfxLayer,
+								 int framesBeforeRelease,
+								 const TextureSampling& textureSampling);
+		void				Shutdown();
+
+		/// <summary>
+		/// Gets a target that isn't in use, creating it if needed. Its
+		/// content is undefined, so the pass should clear or overwrite
+		/// it.
+		/// </summary>
+		///
+		/// <param name="textureFormat">Format of all the textures. A
+		///     depth or stencil format gives a target without color.</param>
+		/// <param name="numberOfTextures">Number of color attachments,
+		///     up to MaxTextures.</param>
+		/// <returns>The target, or RenderTargetID::InvalidID if
+		///     GFX_MAX_POOLED_RENDER_TARGETS are alive.</returns>
+		RenderTargetID		Acquire(int width, int height,
+									TextureFormat::Enum textureFormat,
+									int numberOfTextures = 1);
+
+		/// <summary>
+		/// Gives the target back to the pool. The passes already
+		/// submitted can still read it, since the driver orders them
+		/// before the next pass writing it.
+		/// </summary>
+		void				Release(const RenderTargetID id);
+
+		FrameBufferID		GetFrameBuffer(const RenderTargetID id) const;
+		TextureID			GetTexture(const RenderTargetID id, int index = 0) const;
+
+		/// <summary>
+		/// Evicts the targets that haven't been acquired for
+		/// framesBeforeRelease frames. All the targets should have been
+		/// released by then.
+		/// </summary>
+		void				EndFrame();
+
+		Stats				GetStats() const;
+
+	private:
+		// No pool copy.
+		RenderTargetPool(const RenderTargetPool& src);
+		RenderTargetPool& operator = (const RenderTargetPool& src);
+
+		struct TargetInfo
+		{
+			FrameBufferID		frameBuffer; // InvalidID once evicted.
+			TextureID			textures[MaxTextures];
+			int					numberOfTextures;
+			int					width;
+			int					height;
+			TextureFormat::Enum	format;
+			long long			memory;
+			int					lastFrame; // Last frame it was acquired.
+			bool				inUse;
+		};
+
+		void				EvictTarget(TargetInfo& target);
+
+		IGraphicLayer*		m_gfxLayer;
+		int					m_framesBeforeRelease;
+		TextureSampling		m_textureSampling;
+
+		Container::Array<TargetInfo> m_targets;
+
+		// Ids of the evicted targets, for the next ones.
+		FrameBufferID		m_freeFrameBuffers[GFX_MAX_POOLED_RENDER_TARGETS];
+		TextureID			m_freeTextures[GFX_MAX_POOLED_RENDER_TARGETS * MaxTextures];
+		int					m_numberOfFreeFrameBuffers;
+		int					m_numberOfFreeTextures;
+
+		int					m_frame;
+		long long			m_memory;
+		long long			m_peakMemory;
+		int					m_numberOfAcquisitions;
+		int					m_numberOfReuses;
+	};
+}
@@ -3,6 +3,9 @@
 namespace Gfx
 {
 	const FrameBufferID FrameBufferID::InvalidID = { -1 };
+#if GFX_ENABLE_ASYNC_READBACK
+	const ReadbackID ReadbackID::InvalidID = { -1 };
+#endif // GFX_ENABLE_ASYNC_READBACK
 	const ShaderID ShaderID::InvalidID = { -1 };
 #if GFX_ENABLE_STORAGE_BUFFER_OBJECT
 	const StorageBufferID StorageBufferID::InvalidID = { -1 };
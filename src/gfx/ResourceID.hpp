@@ -11,6 +11,18 @@ namespace Gfx
 		static const FrameBufferID InvalidID;
 	};
 
+#if GFX_ENABLE_ASYNC_READBACK
+	/// <summary>
+	/// Ticket of an asynchronous readback, valid until the data is
+	/// retrieved. See IGraphicLayer::RequestReadback().
+	/// </summary>
+	struct ReadbackID
+	{
+		int index; // Number of the request.
+		static const ReadbackID InvalidID;
+	};
+#endif // GFX_ENABLE_ASYNC_READBACK
+
 	struct ShaderID
 	{
 		int index;
@@ -57,6 +69,20 @@ namespace Gfx
 		return !(lhs == rhs);
 	}
 
+#if GFX_ENABLE_ASYNC_READBACK
+	inline
+	bool operator == (const ReadbackID lhs, const ReadbackID rhs)
+	{
+		return (memcmp(&lhs, &rhs, sizeof(rhs)) == 0);
+	}
+
+	inline
+	bool operator != (const ReadbackID lhs, const ReadbackID rhs)
+	{
+		return !(lhs == rhs);
+	}
+#endif // GFX_ENABLE_ASYNC_READBACK
+
 	inline
 	bool operator == (const ShaderID lhs, const ShaderID rhs)
 	{
@@ -0,0 +1,154 @@
+#include "ScaledRenderTarget.hpp"
+
+#include "Geometry.hpp"
+#include "IGraphicLayerImplementations.hpp"
+#include "RasterTests.hpp"
+#include "ShadingParameters.hpp"
+#include "Uniform.hxx"
+#include "VertexAttribute.hpp"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+using namespace Gfx;
+
+// Without vertex array objects, the layer keeps a pointer to the
+// attributes, so they must outlive the vertex buffer.
+static const VertexAttribute attributes[] = {
+	{ "position", 2, VertexAttributeType::Float },
+};
+
+// A triangle covering the destination, with coordinates in texels of
+// the corner the scene was rendered to. The bilinear filtering is done
+// by hand, with the texels clamped to the corner: the sampler of a
+// render target can blend in texels further than the four nearest ones,
+// even at level 0, and what lies beyond the corner is left from earlier
+// frames.
+static const char* upscaleVertexShaderSource = R"(
+    #version 330 core
+    in vec2 position;
+    uniform ivec2 size;
+    out vec2 texel;
+    void main() {
+        texel = (0.5 * position + 0.5) * vec2(size);
+        gl_Position = vec4(position, 0.0, 1.0);
+    }
+)";
+static const char* upscaleFragmentShaderSource = R"(
+    #version 330 core
+    uniform sampler2D scene;
+    uniform ivec2 size;
+    in vec2 texel;
+    out vec4 color;
+    vec4 fetch(ivec2 p) {
+        return texelFetch(scene, clamp(p, ivec2(0), size - 1), 0);
+    }
+    void main() {
+        vec2 p = texel - 0.5;
+        ivec2 i = ivec2(floor(p));
+        vec2 f = p - vec2(i);
+        color = mix(mix(fetch(i), fetch(i + ivec2(1, 0)), f.x),
+                    mix(fetch(i + ivec2(0, 1)), fetch(i + ivec2(1, 1)), f.x), f.y);
+    }
+)";
+
+ScaledRenderTarget::ScaledRenderTarget():
+	m_gfxLayer(nullptr),
+	m_color(TextureID::InvalidID),
+	m_depth(TextureID::InvalidID),
+	m_frameBuffer(FrameBufferID::InvalidID),
+	m_shader(ShaderID::InvalidID),
+	m_triangle(VertexBufferID::InvalidID),
+	m_maxWidth(0),
+	m_maxHeight(0)
+{
+}
+
+void ScaledRenderTarget::Init(IGraphicLayer* gfxLayer,
+							  int maxWidth, int maxHeight,
+							  TextureFormat::Enum colorFormat)
+{
+	ASSERT(gfxLayer != nullptr);
+	ASSERT(m_gfxLayer == nullptr);
+	ASSERT(maxWidth > 0 && maxHeight > 0);
+	ASSERT(colorFormat > TextureFormat::D24S8);
+
+	m_gfxLayer = gfxLayer;
+	m_maxWidth = maxWidth;
+	m_maxHeight = maxHeight;
+
+	const TextureSampling sampling = {
+		TextureFilter::Linear,
+		TextureFilter::Linear,
+		1.f,
+		TextureWrap::ClampToEdge,
+		TextureWrap::ClampToEdge,
+		TextureWrap::ClampToEdge,
+	};
+	m_color = m_gfxLayer->CreateTexture();
+	m_depth = m_gfxLayer->CreateTexture();
+	m_gfxLayer->LoadTexture(m_color, maxWidth, maxHeight, TextureType::Texture2D, colorFormat,
+							0, 0, nullptr, sampling);
+	m_gfxLayer->LoadTexture(m_depth, maxWidth, maxHeight, TextureType::Texture2D, TextureFormat::Depth,
+							0, 0, nullptr, sampling);
+	const TextureID textures[] = { m_color, m_depth };
+	m_frameBuffer = m_gfxLayer->CreateFrameBuffer(textures, 2, 0, 0);
+
+	const ShaderStage shaderStages[] = {
+		{ ShaderType::VertexShader, upscaleVertexShaderSource, __FILE__ },
+		{ ShaderType::FragmentShader, upscaleFragmentShaderSource, __FILE__ },
+	};
+	m_shader = m_gfxLayer->CreateShader();
+	m_gfxLayer->LoadShader(m_shader, shaderStages, 2);
+
+	const float vertices[] = { -1.f, -1.f, 3.f, -1.f, -1.f, 3.f };
+	const unsigned short indices[] = { 0, 1, 2 };
+	m_triangle = m_gfxLayer->CreateVertexBuffer();
+	m_gfxLayer->LoadVertexBuffer(m_triangle, PrimitiveType::Triangles,
+								 attributes, 1, 2 * sizeof(float),
+								 sizeof(vertices), vertices,
+								 sizeof(indices), indices, VertexIndexType::UInt16);
+}
+
+void ScaledRenderTarget::Shutdown()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	m_gfxLayer->DestroyVertexBuffer(m_triangle);
+	m_gfxLayer->DestroyShader(m_shader);
+	m_gfxLayer->DestroyFrameBuffer(m_frameBuffer);
+	m_gfxLayer->DestroyTexture(m_depth);
+	m_gfxLayer->DestroyTexture(m_color);
+	m_triangle = VertexBufferID::InvalidID;
+	m_shader = ShaderID::InvalidID;
+	m_frameBuffer = FrameBufferID::InvalidID;
+	m_depth = TextureID::InvalidID;
+	m_color = TextureID::InvalidID;
+	m_gfxLayer = nullptr;
+}
+
+DrawArea ScaledRenderTarget::GetDrawArea(int width, int height) const
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(width > 0 && width <= m_maxWidth);
+	ASSERT(height > 0 && height <= m_maxHeight);
+
+	const DrawArea drawArea = { m_frameBuffer, { 0, 0, width, height } };
+	return drawArea;
+}
+
+void ScaledRenderTarget::Upscale(const DrawArea& destination, int width, int height)
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(width > 0 && width <= m_maxWidth);
+	ASSERT(height > 0 && height <= m_maxHeight);
+
+	ShadingParameters shadingParameters;
+	shadingParameters.shader = m_shader;
+	shadingParameters.uniforms.add(Uniform::Sampler1("scene", m_color));
+	shadingParameters.uniforms.add(Uniform::Int2("size", width, height));
+
+	Geometry geometry = Geometry();
+	geometry.vertexBuffer = m_triangle;
+	geometry.numberOfIndices = 3;
+	m_gfxLayer->Draw(destination, RasterTests::NoDepthTest, geometry, shadingParameters);
+}
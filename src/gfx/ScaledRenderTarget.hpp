@@ -0,0 +1,69 @@
+#pragma once
+
+#include "DrawArea.hpp"
+#include "GraphicLayerConfig.hpp"
+#include "ResourceID.hpp"
+#include "TextureFormat.hpp"
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Render target for a scene rendered at a resolution that changes
+	/// from frame to frame, like with dynamic resolution.
+	///
+	/// The textures have the size of the largest resolution, and the
+	/// scene is rendered to the bottom left corner of them, through the
+	/// viewport, so a change of resolution doesn't create new textures.
+	/// Upscale() then stretches that corner over the destination.
+	/// </summary>
+	class ScaledRenderTarget
+	{
+	public:
+		ScaledRenderTarget();
+
+		/// <summary>
+		/// Creates the color and depth textures at the largest size,
+		/// and the upscaling shader.
+		/// </summary>
+		void				Init(IGraphicLayer* gfxLayer,
+								 int maxWidth, int maxHeight,
+								 TextureFormat::Enum colorFormat);
+		void				Shutdown();
+
+		/// <summary>
+		/// Area to render the scene at a given size: the frame buffer,
+		/// with a viewport of that size in its bottom left corner.
+		/// Clearing the frame buffer clears the whole textures, but
+		/// only the corner is read.
+		/// </summary>
+		DrawArea			GetDrawArea(int width, int height) const;
+
+		/// <summary>
+		/// Draws the corner the scene was rendered to at that size over
+		/// the destination, with bilinear filtering. The texels beyond
+		/// the corner are never sampled, whatever they contain.
+		/// </summary>
+		void				Upscale(const DrawArea& destination, int width, int height);
+
+		FrameBufferID		GetFrameBuffer() const { return m_frameBuffer; }
+		TextureID			GetColorTexture() const { return m_color; }
+		int					GetMaxWidth() const { return m_maxWidth; }
+		int					GetMaxHeight() const { return m_maxHeight; }
+
+	private:
+		// No target copy.
+		ScaledRenderTarget(const ScaledRenderTarget& src);
+		ScaledRenderTarget& operator = (const ScaledRenderTarget& src);
+
+		IGraphicLayer*		m_gfxLayer;
+		TextureID			m_color;
+		TextureID			m_depth;
+		FrameBufferID		m_frameBuffer;
+		ShaderID			m_shader;
+		VertexBufferID		m_triangle;
+		int					m_maxWidth;
+		int					m_maxHeight;
+	};
+}
@@ -0,0 +1,169 @@
+#include "TextureArrayAllocator.hpp"
+
+#include "IGraphicLayerImplementations.hpp"
+#include "engine/container/Array.hxx"
+#include "engine/debug/Assert.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+
+using namespace Gfx;
+
+#ifndef _WIN32
+
+// Type instantiation, to force the compiler to put methods in this
+// compilation unit; clang++ is stricter on this kind of stuff than
+// vc++ it seems.
+
+template class Container::Array<Gfx::TextureArrayAllocator::ArrayInfo>;
+
+#endif
+
+const TextureLayerID TextureLayerID::InvalidID = { { -1 }, -1 };
+
+TextureArrayAllocator::TextureArrayAllocator():
+	m_gfxLayer(nullptr),
+	m_layersPerArray(0)
+{
+}
+
+void TextureArrayAllocator::Init(IGraphicLayer* gfxLayer,
+								 int layersPerArray,
+								 const TextureSampling& textureSampling)
+{
+	ASSERT(gfxLayer != nullptr);
+	ASSERT(m_gfxLayer == nullptr);
+	ASSERT(layersPerArray > 0);
+
+	m_gfxLayer = gfxLayer;
+	m_layersPerArray = layersPerArray;
+	m_textureSampling = textureSampling;
+	m_arrays.init(GFX_MAX_TEXTURE_ARRAYS);
+	m_nextFreeLayer.init(GFX_MAX_TEXTURE_ARRAYS * layersPerArray);
+}
+
+void TextureArrayAllocator::Shutdown()
+{
+	ASSERT(m_gfxLayer != nullptr);
+
+	for (int i = 0; i < m_arrays.size; ++i)
+	{
+		m_gfxLayer->DestroyTexture(m_arrays[i].texture);
+	}
+	m_arrays.clear();
+	m_nextFreeLayer.clear();
+	m_gfxLayer = nullptr;
+}
+
+TextureLayerID TextureArrayAllocator::Allocate(int width, int height,
+											   TextureFormat::Enum textureFormat,
+											   const void* data)
+{
+	ASSERT(m_gfxLayer != nullptr);
+	ASSERT(width * height > 0);
+	ASSERT(data != nullptr);
+
+	int arrayIndex = FindArray(width, height, textureFormat);
+	if (arrayIndex < 0)
+	{
+		if (m_arrays.size >= GFX_MAX_TEXTURE_ARRAYS)
+		{
+			return TextureLayerID::InvalidID;
+		}
+
+		ArrayInfo& newArray = m_arrays.getNew();
+		newArray.texture = m_gfxLayer->CreateTexture();
+		newArray.width = width;
+		newArray.height = height;
+		newArray.format = textureFormat;
+		newArray.usedLayers = 0;
+		newArray.firstFreeLayer = -1;
+		newArray.firstUnusedLayer = 0;
+		m_gfxLayer->LoadTextureArray(newArray.texture, width, height, m_layersPerArray,
+									 textureFormat, m_textureSampling);
+		for (int i = 0; i < m_layersPerArray; ++i)
+		{
+			m_nextFreeLayer.add(-1);
+		}
+		arrayIndex = m_arrays.size - 1;
+	}
+
+	// Freed layers are reused first, so the arrays stay compact.
+	ArrayInfo& array = m_arrays[arrayIndex];
+	TextureLayerID id;
+	id.texture = array.texture;
+	if (array.firstFreeLayer >= 0)
+	{
+		id.layer = array.firstFreeLayer;
+		array.firstFreeLayer = m_nextFreeLayer[arrayIndex * m_layersPerArray + id.layer];
+	}
+	else
+	{
+		ASSERT(array.firstUnusedLayer < m_layersPerArray);
+		id.layer = array.firstUnusedLayer++;
+	}
+	++array.usedLayers;
+
+	m_gfxLayer->LoadTextureLayer(array.texture, id.layer, data);
+	if (m_textureSampling.minifyingFilter != TextureFilter::Nearest &&
+		m_textureSampling.minifyingFilter != TextureFilter::Linear)
+	{
+		m_gfxLayer->GenerateMipMaps(array.texture);
+	}
+	return id;
+}
+
+void TextureArrayAllocator::Free(const TextureLayerID id)
+{
+	int arrayIndex = -1;
+	for (int i = 0; i < m_arrays.size; ++i)
+	{
+		if (m_arrays[i].texture == id.texture)
+		{
+			arrayIndex = i;
+			break;
+		}
+	}
+	ASSERT(arrayIndex >= 0);
+	ASSERT(id.layer >= 0 && id.layer < m_arrays[arrayIndex].firstUnusedLayer);
+
+	ArrayInfo& array = m_arrays[arrayIndex];
+	ASSERT(array.usedLayers > 0);
+	m_nextFreeLayer[arrayIndex * m_layersPerArray + id.layer] = array.firstFreeLayer;
+	array.firstFreeLayer = id.layer;
+	--array.usedLayers;
+}
+
+TextureArrayAllocator::Stats TextureArrayAllocator::GetStats() const
+{
+	Stats stats;
+	stats.numberOfArrays = m_arrays.size;
+	stats.numberOfTextures = 0;
+	for (int i = 0; i < m_arrays.size; ++i)
+	{
+		stats.numberOfTextures += m_arrays[i].usedLayers;
+	}
+	stats.layerCapacity = m_arrays.size * m_layersPerArray;
+	stats.utilization = (stats.layerCapacity > 0 ? (float)stats.numberOfTextures / (float)stats.layerCapacity : 0.f);
+	return stats;
+}
+
+// Returns an array of that size and format with a layer available, or
+// -1.
+int TextureArrayAllocator::FindArray(int width, int height, TextureFormat::Enum textureFormat) const
+{
+	for (int i = 0; i < m_arrays.size; ++i)
+	{
+		const ArrayInfo& array = m_arrays[i];
+		if (array.width == width &&
+			array.height == height &&
+			array.format == textureFormat &&
+			array.usedLayers < m_layersPerArray)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
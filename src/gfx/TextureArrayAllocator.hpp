@@ -0,0 +1,131 @@
+#pragma once
+
+#include "GraphicLayerConfig.hpp"
+#include "ResourceID.hpp"
+#include "TextureFormat.hpp"
+#include "engine/container/Array.hpp"
+// FIXME: ideally Gfx should not have dependency over Engine.
+
+#if GFX_ENABLE_TEXTURE_ARRAYS
+
+namespace Gfx
+{
+	class IGraphicLayer;
+
+	/// <summary>
+	/// Identifier of a texture allocated in a TextureArrayAllocator: the
+	/// texture array it was put in, and its layer in the array.
+	///
+	/// A shader binds the array with a sampler2DArray uniform, and gets
+	/// the layer with the other parameters of the material, as the
+	/// third texture coordinate:
+	///     texture(textures, vec3(uv, layer))
+	/// </summary>
+	struct TextureLayerID
+	{
+		TextureID texture;
+		int layer;
+
+		static const TextureLayerID InvalidID;
+	};
+
+	inline
+	bool operator == (const TextureLayerID lhs, const TextureLayerID rhs)
+	{
+		return lhs.texture == rhs.texture && lhs.layer == rhs.layer;
+	}
+
+	inline
+	bool operator != (const TextureLayerID lhs, const TextureLayerID rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	/// <summary>
+	/// Packs textures of the same size and format as layers of shared
+	/// texture arrays, creating a new array when the others are full.
+	///
+	/// Materials using textures of the same array bind the same
+	/// texture, and only differ by the layer index, so they can be
+	/// drawn without rebinding and put in the same DrawBatch.
+	/// </summary>
+	class TextureArrayAllocator
+	{
+	public:
+		struct Stats
+		{
+			int		numberOfArrays;
+			int		numberOfTextures;
+			int		layerCapacity; // Layers of all the arrays.
+
+			// Ratio of the layers in use, from 0 to 1.
+			float	utilization;
+		};
+
+		TextureArrayAllocator();
+
+		/// <summary>
+		/// Sets the parameters of the arrays, which are created on
+		/// demand.
+		/// </summary>
+		///
+		/// <param name="layersPerArray">Number of layers of each array;
+		///     at most GL_MAX_ARRAY_TEXTURE_LAYERS, which is 256 or
+		///     more.</param>
+		/// <param name="textureSampling">Sampling of all the arrays.</param>
+		void				Init(IGraphicLayer* gfxLayer,
+								 int layersPerArray,
+								 const TextureSampling& textureSampling);
+		void				Shutdown();
+
+		/// <summary>
+		/// Puts a texture in an array of its size and format, and loads
+		/// its data. The mipmaps of the whole array are generated again
+		/// if the sampling uses them, so textures are better allocated
+		/// at loading time.
+		/// </summary>
+		/// <returns>The texture, or TextureLayerID::InvalidID if all
+		/// the arrays are in use.</returns>
+		TextureLayerID		Allocate(int width, int height,
+									 TextureFormat::Enum textureFormat,
+									 const void* data);
+
+		/// <summary>
+		/// Makes the layer available to other textures. The array is
+		/// kept, even when it is empty.
+		/// </summary>
+		void				Free(const TextureLayerID id);
+
+		Stats				GetStats() const;
+
+	private:
+		struct ArrayInfo
+		{
+			TextureID		texture;
+			int				width;
+			int				height;
+			TextureFormat::Enum format;
+			int				usedLayers;
+
+			// Layers freed, linked through m_nextFreeLayer, or -1.
+			int				firstFreeLayer;
+
+			// Layers from this one have never been used.
+			int				firstUnusedLayer;
+		};
+
+		int					FindArray(int width, int height, TextureFormat::Enum textureFormat) const;
+
+		IGraphicLayer*		m_gfxLayer;
+		int					m_layersPerArray;
+		TextureSampling		m_textureSampling;
+
+		Container::Array<ArrayInfo> m_arrays;
+
+		// For each layer of each array, the next free layer of the
+		// array, or -1. Indexed by array * m_layersPerArray + layer.
+		Container::Array<int> m_nextFreeLayer;
+	};
+}
+
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
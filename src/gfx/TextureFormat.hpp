@@ -35,6 +35,13 @@ namespace Gfx
 
 			// Compressed formats
 			Compressed,
+
+			// Block compressed formats, loaded with LoadCompressedTexture.
+			// See Texture::BlockFormat for the encoder.
+			BC1,
+			BC4,
+			BC5,
+			BC7,
 		};
 	};
 
@@ -43,6 +50,9 @@ namespace Gfx
 		enum Enum {
 			Texture2D = GL_TEXTURE_2D,
 			CubeMap = GL_TEXTURE_CUBE_MAP,
+#if GFX_ENABLE_TEXTURE_ARRAYS
+			Texture2DArray = GL_TEXTURE_2D_ARRAY,
+#endif // GFX_ENABLE_TEXTURE_ARRAYS
 		};
 	};
 
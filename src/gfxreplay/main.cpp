@@ -0,0 +1,172 @@
+#include "engine/debug/Debug.hpp"
+#include "gfx/CallType.hpp"
+#include "gfx/CaptureReplay.hpp"
+#include "gfx/OpenGL/OpenGLLayer.hpp"
+#include "platform/Platform.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <GL/gl.h>
+
+//
+// Plays a capture made with Gfx::CaptureLayer in a loop, and reports
+// the CPU time of its frames and of each type of call.
+//
+// Usage: gfxreplay <capture> [loops] [first frame]
+//
+// The calls before the first frame are played once; by default only the
+// last frame is looped. The frames are first played to measure them as a
+// whole, then again to time each call, since timing the calls has a
+// cost of its own. The GPU is waited for between loops, outside of the
+// measures.
+//
+
+#define DEFAULT_NUMBER_OF_LOOPS 100
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct FrameTimes
+{
+	double		total; // In microseconds.
+	double		min;
+	double		max;
+};
+
+static int Replay(const char* fileName, int numberOfLoops, int firstFrame)
+{
+	Gfx::CaptureReplay replay;
+	if (!replay.Load(fileName))
+	{
+		fprintf(stderr, "Could not load capture %s.\n", fileName);
+		return -1;
+	}
+	if (firstFrame >= replay.GetNumberOfFrames())
+	{
+		fprintf(stderr, "The capture only has %d frames.\n", replay.GetNumberOfFrames());
+		return -1;
+	}
+
+	platform::Platform platform("GfxReplay",
+								1024, 768, 0, 0, 1920, 1080, false);
+
+	Gfx::IGraphicLayer* gfxLayer = new Gfx::OpenGLLayer();
+	if (!gfxLayer->CreateRenderingContext())
+	{
+#if _HAS_EXCEPTIONS
+		Debug::TerminateOnFatalError("Could not load graphics API.");
+#endif
+		return -1;
+	}
+
+	replay.Begin(gfxLayer, firstFrame);
+	glFinish();
+
+	const int numberOfFrames = replay.GetNumberOfFrames() - replay.GetFirstFrame();
+	FrameTimes* frameTimes = new FrameTimes[numberOfFrames];
+	for (int i = 0; i < numberOfFrames; ++i)
+	{
+		frameTimes[i].total = 0.;
+		frameTimes[i].min = 1e30;
+		frameTimes[i].max = 0.;
+	}
+
+	// The window can be closed before the end.
+	int frameLoops = 0;
+	for (; frameLoops < numberOfLoops && platform.HandleMessages(); ++frameLoops)
+	{
+		for (int i = 0; i < numberOfFrames; ++i)
+		{
+			const Clock::time_point start = Clock::now();
+			replay.PlayFrame(replay.GetFirstFrame() + i);
+			const double time = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+			FrameTimes& times = frameTimes[i];
+			times.total += time;
+			times.min = (time < times.min ? time : times.min);
+			times.max = (time > times.max ? time : times.max);
+			platform.SwapBuffers();
+		}
+		replay.EndLoop();
+		glFinish();
+	}
+
+	Gfx::CaptureReplay::CallTimings timings;
+	timings.Clear();
+	int callLoops = 0;
+	for (; callLoops < numberOfLoops && platform.HandleMessages(); ++callLoops)
+	{
+		for (int i = 0; i < numberOfFrames; ++i)
+		{
+			replay.PlayFrame(replay.GetFirstFrame() + i, &timings);
+			platform.SwapBuffers();
+		}
+		replay.EndLoop();
+		glFinish();
+	}
+
+	replay.End();
+	gfxLayer->DestroyRenderingContext();
+	delete gfxLayer;
+	if (frameLoops == 0 || callLoops == 0)
+	{
+		delete[] frameTimes;
+		return -1;
+	}
+
+	printf("Frame        average (us)    min (us)    max (us)\n");
+	for (int i = 0; i < numberOfFrames; ++i)
+	{
+		const FrameTimes& times = frameTimes[i];
+		printf("%5d      %12.1f %11.1f %11.1f\n", replay.GetFirstFrame() + i,
+			   times.total / frameLoops, times.min, times.max);
+	}
+	delete[] frameTimes;
+
+	printf("\nCall                     count/loop   total (us)  average (us)\n");
+	for (int i = 0; i < Gfx::CallType::Count; ++i)
+	{
+		if (timings.count[i] > 0)
+		{
+			const double total = timings.duration[i] * 0.001 / callLoops;
+			printf("%-24s %11.1f %11.1f %13.3f\n", Gfx::GetCallName((Gfx::CallType::Enum)i),
+				   (double)timings.count[i] / callLoops, total,
+				   timings.duration[i] * 0.001 / timings.count[i]);
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: gfxreplay <capture> [loops] [first frame]\n");
+		return -1;
+	}
+	const char* fileName = argv[1];
+	const int numberOfLoops = (argc > 2 ? atoi(argv[2]) : DEFAULT_NUMBER_OF_LOOPS);
+	const int firstFrame = (argc > 3 ? atoi(argv[3]) : -1);
+	if (numberOfLoops <= 0)
+	{
+		fprintf(stderr, "The number of loops should be positive.\n");
+		return -1;
+	}
+
+	int result = 0;
+
+#if _HAS_EXCEPTIONS
+	try
+	{
+		result = Replay(fileName, numberOfLoops, firstFrame);
+	}
+	catch (std::exception* e)
+	{
+		fprintf(stderr, "%s\n", e->what());
+		result = -1;
+	}
+#else // !_HAS_EXCEPTIONS
+	result = Replay(fileName, numberOfLoops, firstFrame);
+#endif // !_HAS_EXCEPTIONS
+
+	return result;
+}